@@ -1,11 +1,16 @@
 #include "Application.h"
 #include "Renderer.h"
 #include "Input.h"
+#include "CPUProfiler.h"
+#include "FramePacer.h"
 
 #include "glfw3.h"
 
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 
 #include "glm.hpp"
 #include "glm\include\gtc\quaternion.hpp"
@@ -19,6 +24,10 @@
 #include "RenderObject.h"
 #include "SubScene.h"
 #include "LightingManager.h"
+#include "GBufferPass.h"
+#include "FrustumCuller.h"
+#include "GPUCuller.h"
+#include "TransformHierarchy.h"
 
 #include "Camera.h"
 
@@ -77,6 +86,12 @@ int Application::Init()
 
 void Application::Run() 
 {
+	CPU_PROFILE_THREAD("Main");
+
+#if CPU_PROFILER_ENABLED
+	CPUProfiler::BeginCapture();
+#endif
+
 	Scene* scene = m_renderer->GetScene();
 	SubScene* subScene = scene->GetPrimarySubScene();
 
@@ -84,23 +99,46 @@ void Application::Run()
 	Shader* modelShader = new Shader(m_renderer, "Shaders/SPIR-V/model_pbr_vert.spv", "Shaders/SPIR-V/model_pbr_frag.spv");
 	Shader* texturelessShader = new Shader(m_renderer, "Shaders/SPIR-V/vert_model_notex.spv", "Shaders/SPIR-V/frag_model_notex.spv");
 
-	// Load textures.
-	Texture* spinnerPaintDiffuse = new Texture(m_renderer, "Assets/Objects/Spinner/paint2048/m_spinner_paint_diffuse.tga");
-	Texture* spinnerPaintNormal = new Texture(m_renderer, "Assets/Objects/Spinner/paint2048/m_spinner_paint_normal.tga");
-	Texture* spinnerPaintSpecular = new Texture(m_renderer, "Assets/Objects/Spinner/paint2048/m_spinner_paint_specular.tga");
-	Texture* spinnerPaintRoughness = new Texture(m_renderer, "Assets/Objects/Spinner/paint2048/m_spinner_paint_roughness.tga");
-
-	Texture* spinnerGlassDiffuse = new Texture(m_renderer, "Assets/Objects/Spinner/glass2048/m_spinner_glass_diffuse.tga");
-	Texture* spinnerGlassNormal = new Texture(m_renderer, "Assets/Objects/Spinner/glass2048/m_spinner_glass_normal.tga");
-	Texture* spinnerGlassEmissive = new Texture(m_renderer, "Assets/Objects/Spinner/glass2048/m_spinner_glass_emissive.tga");
-	Texture* spinnerGlassRoughness = new Texture(m_renderer, "Assets/Objects/Spinner/glass2048/m_spinner_glass_roughness.tga");
-	Texture* spinnerGlassSpecular = new Texture(m_renderer, "Assets/Objects/Spinner/glass2048/m_spinner_glass_specular.tga");
-
-	Texture* spinnerDetailsDiffuse = new Texture(m_renderer, "Assets/Objects/Spinner/details2048/m_spinner_details_diffuse.tga");
-	Texture* spinnerDetailsNormal = new Texture(m_renderer, "Assets/Objects/Spinner/details2048/m_spinner_details_normal.tga");
-	Texture* spinnerDetailsEmissive = new Texture(m_renderer, "Assets/Objects/Spinner/details2048/m_spinner_details_emissive.tga");
-	Texture* spinnerDetailsRoughness = new Texture(m_renderer, "Assets/Objects/Spinner/details2048/m_spinner_details_roughness.tga");
-	Texture* spinnerDetailsSpecular = new Texture(m_renderer, "Assets/Objects/Spinner/details2048/m_spinner_details_specular.tga");
+	// Load textures, decoded in parallel.
+	const char* texturePaths[] = 
+	{
+		"Assets/Objects/Spinner/paint2048/m_spinner_paint_diffuse.tga",
+		"Assets/Objects/Spinner/paint2048/m_spinner_paint_normal.tga",
+		"Assets/Objects/Spinner/paint2048/m_spinner_paint_specular.tga",
+		"Assets/Objects/Spinner/paint2048/m_spinner_paint_roughness.tga",
+
+		"Assets/Objects/Spinner/glass2048/m_spinner_glass_diffuse.tga",
+		"Assets/Objects/Spinner/glass2048/m_spinner_glass_normal.tga",
+		"Assets/Objects/Spinner/glass2048/m_spinner_glass_emissive.tga",
+		"Assets/Objects/Spinner/glass2048/m_spinner_glass_roughness.tga",
+		"Assets/Objects/Spinner/glass2048/m_spinner_glass_specular.tga",
+
+		"Assets/Objects/Spinner/details2048/m_spinner_details_diffuse.tga",
+		"Assets/Objects/Spinner/details2048/m_spinner_details_normal.tga",
+		"Assets/Objects/Spinner/details2048/m_spinner_details_emissive.tga",
+		"Assets/Objects/Spinner/details2048/m_spinner_details_roughness.tga",
+		"Assets/Objects/Spinner/details2048/m_spinner_details_specular.tga"
+	};
+
+	Texture* textures[sizeof(texturePaths) / sizeof(const char*)];
+	Texture::LoadBatch(m_renderer, texturePaths, sizeof(texturePaths) / sizeof(const char*), textures);
+
+	Texture* spinnerPaintDiffuse = textures[0];
+	Texture* spinnerPaintNormal = textures[1];
+	Texture* spinnerPaintSpecular = textures[2];
+	Texture* spinnerPaintRoughness = textures[3];
+
+	Texture* spinnerGlassDiffuse = textures[4];
+	Texture* spinnerGlassNormal = textures[5];
+	Texture* spinnerGlassEmissive = textures[6];
+	Texture* spinnerGlassRoughness = textures[7];
+	Texture* spinnerGlassSpecular = textures[8];
+
+	Texture* spinnerDetailsDiffuse = textures[9];
+	Texture* spinnerDetailsNormal = textures[10];
+	Texture* spinnerDetailsEmissive = textures[11];
+	Texture* spinnerDetailsRoughness = textures[12];
+	Texture* spinnerDetailsSpecular = textures[13];
 
 	// Construct materials
 	Material* spinnerPaintMat = new Material
@@ -147,6 +185,24 @@ void Application::Run()
 	RenderObject* spinnerDetailsObj = new RenderObject(scene, spinnerDetailsMesh, spinnerDetailsMat, &RenderObject::m_defaultInstanceAttributes, 10);
 	RenderObject* spinnerGlassObj = new RenderObject(scene, spinnerGlassMesh, spinnerGlassMat, &RenderObject::m_defaultInstanceAttributes, 10);
 	RenderObject* spinnerPaintObj = new RenderObject(scene, spinnerPaintMesh, spinnerPaintMat, &RenderObject::m_defaultInstanceAttributes, 10);
+
+	// Submit all asset uploads queued while loading.
+	UploadContext* uploadContext = m_renderer->GetUploadContext();
+	uploadContext->Submit();
+
+	std::cout << "Upload Context: " << uploadContext->UploadCount() << " uploads (" << uploadContext->UploadedBytes() / (1024 * 1024) << "MiB) in " << uploadContext->SubmissionCount() << " queue submissions.\n";
+
+	// Display device memory usage and pipeline creation cost after loading.
+	m_renderer->GetMemoryAllocator()->PrintStats();
+	m_renderer->GetPipelineCache()->PrintStats("Startup");
+
+#if CPU_PROFILER_ENABLED
+	CPUProfiler::EndCapture();
+	CPUProfiler::WriteChromeTrace(CPU_TRACE_STARTUP_PATH);
+#endif
+
+	// Frames left in the current CPU trace capture.
+	uint32_t nCPUTraceFrames = 0;
 	
 	// Time variables.
 	float fDeltaTime = 0.0f;	
@@ -157,11 +213,16 @@ void Application::Run()
 	
 	Instance ins;
 
-	// Scale down spinner instances.
-	ins.m_modelMat = glm::scale(glm::mat4(), glm::vec3(0.01f, 0.01f, 0.01f));
-
 	ins.m_modelMat = glm::mat4();
-	floorObj->SetInstance(0, ins);
+	floorObj->SetInstance(floorObj->InstanceAt(0), ins);
+
+	// Spinner instances are transformed by a scaled down root node, rotated each frame. Each part of the spinner is a child of the root.
+	TransformHierarchy transforms;
+	TransformHandle spinnerNode = transforms.AddNode(glm::vec3(0.0f), glm::quat(), glm::vec3(0.01f));
+
+	transforms.BindInstance(transforms.AddNode(spinnerNode, glm::vec3(0.0f)), spinnerDetailsObj, spinnerDetailsObj->InstanceAt(0));
+	transforms.BindInstance(transforms.AddNode(spinnerNode, glm::vec3(0.0f)), spinnerGlassObj, spinnerGlassObj->InstanceAt(0));
+	transforms.BindInstance(transforms.AddNode(spinnerNode, glm::vec3(0.0f)), spinnerPaintObj, spinnerPaintObj->InstanceAt(0));
 
 	// Model matrix for new object instances.
 	glm::mat4 instanceModelMat;
@@ -180,10 +241,25 @@ void Application::Run()
 	lightManager->AddPointLight({ glm::vec4(-1.0f, 3.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 1.0f), 5.0f });
 	//lightManager->AddPointLight({ glm::vec4(-5.0f, 2.0f, 5.0f, 1.0f), glm::vec3(1.0f), 5.0f });
 
+	FramePacer framePacer(m_renderer, FRAMERATE_CAP);
+
 	while(!glfwWindowShouldClose(m_window)) 
 	{
-		// Time
-		auto startTime = std::chrono::high_resolution_clock::now();
+		// Wait until the frame is due & the GPU is ready for it, so input below is sampled as late as possible before rendering.
+		fDeltaTime = framePacer.WaitForNextFrame();
+		fElapsedTime += fDeltaTime;
+
+		CPU_PROFILE_FRAME();
+
+		// Finish the CPU trace capture once enough frames are recorded.
+		if(nCPUTraceFrames > 0 && --nCPUTraceFrames == 0)
+		{
+			CPUProfiler::EndCapture();
+			CPUProfiler::WriteChromeTrace(CPU_TRACE_PATH);
+		}
+
+		// Poll events.
+		glfwPollEvents();
 
 		// Quit if escape is pressed.
 		if (m_input->GetKey(GLFW_KEY_ESCAPE))
@@ -195,9 +271,6 @@ void Application::Run()
 
 		camera.Update(fDeltaTime, m_input, m_window);
 
-		// Poll events.
-		glfwPollEvents();
-
 		// Fullscreen
 		if (m_input->GetKey(GLFW_KEY_F11) && !m_input->GetKey(GLFW_KEY_F11, INPUTSTATE_PREVIOUS))
 		{
@@ -226,12 +299,121 @@ void Application::Run()
 			m_input->ResetStates();
 		}
 
+		// Run the command recording benchmark if B is pressed.
+		if (m_input->GetKey(GLFW_KEY_B) && !m_input->GetKey(GLFW_KEY_B, INPUTSTATE_PREVIOUS))
+			RecordingBenchmark(scene, planeMesh, floorMat);
+
+		// Run the job system throughput benchmark if J is pressed.
+		if (m_input->GetKey(GLFW_KEY_J) && !m_input->GetKey(GLFW_KEY_J, INPUTSTATE_PREVIOUS))
+			JobSystemBenchmark();
+
+		// Run the frustum culling benchmark if K is pressed.
+		if (m_input->GetKey(GLFW_KEY_K) && !m_input->GetKey(GLFW_KEY_K, INPUTSTATE_PREVIOUS))
+			CullingBenchmark();
+
+		// Run the mesh LOD benchmark if M is pressed.
+		if (m_input->GetKey(GLFW_KEY_M) && !m_input->GetKey(GLFW_KEY_M, INPUTSTATE_PREVIOUS))
+			LODBenchmark();
+
+		// Run the transform hierarchy benchmark if T is pressed.
+		if (m_input->GetKey(GLFW_KEY_T) && !m_input->GetKey(GLFW_KEY_T, INPUTSTATE_PREVIOUS))
+			TransformBenchmark();
+
+		// Toggle mesh LOD selection if N is pressed.
+		if (m_input->GetKey(GLFW_KEY_N) && !m_input->GetKey(GLFW_KEY_N, INPUTSTATE_PREVIOUS))
+		{
+			FrustumCuller* culler = subScene->GetFrustumCuller();
+			culler->SetLODSelection(!culler->IsLODSelection());
+
+			std::cout << "LOD Selection: " << (culler->IsLODSelection() ? "Enabled" : "Disabled") << "\n";
+		}
+
+		// Toggle frustum culling if V is pressed.
+		if (m_input->GetKey(GLFW_KEY_V) && !m_input->GetKey(GLFW_KEY_V, INPUTSTATE_PREVIOUS))
+		{
+			FrustumCuller* culler = subScene->GetFrustumCuller();
+			culler->SetEnabled(!culler->IsEnabled());
+
+			std::cout << "Frustum Culling: " << (culler->IsEnabled() ? "Enabled" : "Disabled") << "\n";
+		}
+
+		// Toggle GPU culling & indirect draws if O is pressed.
+		if (m_input->GetKey(GLFW_KEY_O) && !m_input->GetKey(GLFW_KEY_O, INPUTSTATE_PREVIOUS))
+		{
+			bool bGPUCulling = !subScene->IsGPUCulling();
+			subScene->SetGPUCulling(bGPUCulling);
+
+			if (bGPUCulling && !subScene->IsGPUCulling())
+			{
+				subScene->SetGPUCulling(false);
+				std::cout << "GPU Culling Warning: The culling shader is unavailable, instances are culled on the CPU.\n";
+			}
+			else
+				std::cout << "GPU Culling: " << (bGPUCulling ? "Enabled" : "Disabled") << "\n";
+		}
+
+		// Toggle occlusion culling of GPU culled instances if H is pressed.
+		if (m_input->GetKey(GLFW_KEY_H) && !m_input->GetKey(GLFW_KEY_H, INPUTSTATE_PREVIOUS))
+		{
+			bool bOcclusion = !subScene->IsOcclusionCulling();
+			subScene->SetOcclusionCulling(bOcclusion);
+
+			if (bOcclusion && !subScene->IsOcclusionCulling())
+			{
+				subScene->SetOcclusionCulling(false);
+				std::cout << "Occlusion Culling Warning: Requires GPU culling, a depth attachment & the occlusion culling shaders.\n";
+			}
+			else
+				std::cout << "Occlusion Culling: " << (bOcclusion ? "Enabled" : "Disabled") << "\n";
+		}
+
+		// Dump the GPU profiler history if P is pressed.
+		if (m_input->GetKey(GLFW_KEY_P) && !m_input->GetKey(GLFW_KEY_P, INPUTSTATE_PREVIOUS))
+		{
+			m_renderer->GetGPUProfiler()->WriteCSV(GPU_PROFILE_CSV_PATH);
+			m_renderer->GetGPUProfiler()->WriteJSON(GPU_PROFILE_JSON_PATH);
+		}
+
+		// Capture a CPU trace of the following frames if C is pressed.
+		if (nCPUTraceFrames == 0 && m_input->GetKey(GLFW_KEY_C) && !m_input->GetKey(GLFW_KEY_C, INPUTSTATE_PREVIOUS))
+		{
+			CPUProfiler::BeginCapture();
+			nCPUTraceFrames = CPU_TRACE_FRAMES + 1;
+
+			std::cout << "CPU Profiler: Capturing " << CPU_TRACE_FRAMES << " frames.\n";
+		}
+
+		// Toggle dynamic resolution if R is pressed, rendering at the swap chain's size while it is off.
+		if (m_input->GetKey(GLFW_KEY_R) && !m_input->GetKey(GLFW_KEY_R, INPUTSTATE_PREVIOUS))
+		{
+			DynamicResolution* dynamicResolution = subScene->GetDynamicResolution();
+			dynamicResolution->SetEnabled(!dynamicResolution->IsEnabled());
+
+			if (!dynamicResolution->IsEnabled())
+				dynamicResolution->SetScale(1.0f);
+
+			std::cout << "Dynamic Resolution: " << (dynamicResolution->IsEnabled() ? "Enabled" : "Disabled") << "\n";
+		}
+
+		// Toggle the frame rate cap if U is pressed.
+		if (m_input->GetKey(GLFW_KEY_U) && !m_input->GetKey(GLFW_KEY_U, INPUTSTATE_PREVIOUS))
+		{
+			framePacer.SetTargetFrameRate(framePacer.TargetFrameTime() > 0.0 ? 0.0f : FRAMERATE_CAP);
+
+			std::cout << "Frame Pacer: " << (framePacer.TargetFrameTime() > 0.0 ? "Capped" : "Uncapped") << "\n";
+		}
+
+		// Toggle the low latency mode if L is pressed.
+		if (m_input->GetKey(GLFW_KEY_L) && !m_input->GetKey(GLFW_KEY_L, INPUTSTATE_PREVIOUS))
+		{
+			bool bLowLatency = framePacer.LatencyMode() != FRAME_PACER_LATENCY_LOW;
+			framePacer.SetLatencyMode(bLowLatency ? FRAME_PACER_LATENCY_LOW : FRAME_PACER_LATENCY_DEFAULT);
+
+			std::cout << "Frame Pacer: Low Latency " << (bLowLatency ? "Enabled" : "Disabled") << "\n";
+		}
+
 		// Rotate spinner model.
-		glm::mat4 spinnerScaleMat = glm::scale(glm::mat4(), glm::vec3(0.01f));
-		ins.m_modelMat = glm::rotate(spinnerScaleMat, -fElapsedTime * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f));
-		spinnerDetailsObj->SetInstance(0, ins);
-		spinnerGlassObj->SetInstance(0, ins);
-		spinnerPaintObj->SetInstance(0, ins);
+		transforms.SetRotation(spinnerNode, glm::angleAxis(-fElapsedTime * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f)));
 
 		// Draw...
 		m_renderer->Begin();
@@ -243,12 +425,18 @@ void Application::Run()
 
 			instanceModelMat = glm::translate(instanceModelMat, glm::vec3(-3.0f, 0.0f, 0.0f));
 
-			Instance newInstance = { instanceModelMat * glm::scale(glm::mat4(), glm::vec3(0.01f)) };
-			spinnerDetailsObj->AddInstance(newInstance);
-			spinnerGlassObj->AddInstance(newInstance);
-			spinnerPaintObj->AddInstance(newInstance);
+			// The new instances' model matrices are written by the hierarchy on the update below.
+			Instance newInstance = { glm::mat4() };
+			TransformHandle newNode = transforms.AddNode(glm::vec3(instanceModelMat[3]), glm::quat(), glm::vec3(0.01f));
+
+			transforms.BindInstance(transforms.AddNode(newNode, glm::vec3(0.0f)), spinnerDetailsObj, spinnerDetailsObj->AddInstance(newInstance));
+			transforms.BindInstance(transforms.AddNode(newNode, glm::vec3(0.0f)), spinnerGlassObj, spinnerGlassObj->AddInstance(newInstance));
+			transforms.BindInstance(transforms.AddNode(newNode, glm::vec3(0.0f)), spinnerPaintObj, spinnerPaintObj->AddInstance(newInstance));
 		}
 
+		// Write world matrices of modified transforms to their instances.
+		transforms.Update(m_renderer->GetJobSystem());
+
 		glm::mat4 viewMat = camera.GetViewMatrix();
 		glm::vec3 v4ViewPos = camera.GetPosition();
 
@@ -262,32 +450,37 @@ void Application::Run()
 
 		m_input->EndFrame();
 
-		// End time...
-		std::chrono::steady_clock::time_point endTime;
-		long long timeDuration;
-
-		// Reset deltatime.
-		fDeltaTime = 0.0f;
-
-		// Framerate limitation...
-		// Wait for deltatime to reach value based upon frame cap.
-		while(fDeltaTime < (1000.0f / FRAMERATE_CAP) / 1000.0f) 
-		{
-			endTime = std::chrono::high_resolution_clock::now();
-			timeDuration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
-
-			fDeltaTime = static_cast<float>(timeDuration) / 1000000.0f;
-		}
-
-		// Get deltatime and add to elapsed time.
-		fElapsedTime += fDeltaTime;
-
 		// Display frametime and FPS.
 		if(fDebugDisplayTime <= 0.0f) 
 		{
 			std::cout << "Frametime: " << fDeltaTime * 1000.0f << "ms\n";
 			std::cout << "Elapsed Time: " << fElapsedTime << "s\n";
 			std::cout << "FPS: " << (int)ceilf((1.0f / fDeltaTime)) << "\n";
+			std::cout << "Upload Arena: " << m_renderer->GetUploadArena()->StagedBytes() << " bytes staged, " << m_renderer->GetUploadArena()->CopyCommandCount() << " copy commands\n";
+			std::cout << "G-Buffer Recording: " << subScene->GetGBufferPass()->RecordTime() << "ms on " << m_renderer->RecordingThreadCount() << " threads\n";
+
+			DrawListStats bindStats = subScene->GBufferBindStats();
+			std::cout << "G-Buffer Binds: " << bindStats.m_nPipelineBinds << " pipeline, " << bindStats.m_nDescriptorBinds << " descriptor, " << bindStats.m_nVertexBufferBinds << " vertex buffer, "
+				<< bindStats.m_nIndexBufferBinds << " index buffer, " << bindStats.m_nSkippedBinds << " redundant skipped\n";
+			std::cout << "Render Scale: " << subScene->GetDynamicResolution()->Scale() << ", GPU Time: " << subScene->GetDynamicResolution()->GPUTime() << "ms\n";
+
+			if(subScene->IsGPUCulling())
+			{
+				// Visible counts stay on the GPU, only the CPU cost of writing draws & submitting the dispatch is known.
+				GPUCuller* gpuCuller = subScene->GetGPUCuller();
+				std::cout << "GPU Culling: " << gpuCuller->DrawCount() << " indirect draws, " << gpuCuller->SlotCount() << " instance slots, " << gpuCuller->CullTime() << "ms CPU\n";
+
+				if (subScene->IsOcclusionCulling())
+					std::cout << "Occlusion Culling: " << gpuCuller->OccludedInstanceCount() << " instances, " << gpuCuller->OccludedTriangleCount() << " triangles occluded\n";
+			}
+			else
+			{
+				FrustumCuller* culler = subScene->GetFrustumCuller();
+				std::cout << "Frustum Culling: " << culler->VisibleCount(CULL_VIEW_CAMERA) << "/" << culler->InstanceCount() << " instances visible, " << culler->VisibleCount(CULL_VIEW_SHADOW) << " in shadow map, " << culler->CullTime() << "ms\n";
+				std::cout << "LOD Selection: " << culler->VisibleTriangleCount(CULL_VIEW_CAMERA) << " triangles drawn for the camera\n";
+			}
+			m_renderer->GetGPUProfiler()->PrintSummary();
+			framePacer.PrintStats();
 
 			fDebugDisplayTime = DEBUG_DISPLAY_TIME;
 		}
@@ -359,6 +552,328 @@ void Application::CreateWindow(const unsigned int& nWidth, const unsigned int& n
 	glfwSetFramebufferSizeCallback(m_window, &WindowResizeCallback);
 }
 
+void Application::RecordingBenchmark(Scene* scene, Mesh* mesh, Material* material)
+{
+	GBufferPass* gPass = scene->GetPrimarySubScene()->GetGBufferPass();
+	uint32_t nPrevThreadCount = m_renderer->RecordingThreadCount();
+
+	// Draw every temporary object regardless of the camera, so recording always covers the same draws.
+	SubScene* subScene = scene->GetPrimarySubScene();
+	FrustumCuller* culler = subScene->GetFrustumCuller();
+	bool bPrevCullingEnabled = culler->IsEnabled();
+	bool bPrevGPUCulling = subScene->IsGPUCulling();
+	culler->SetEnabled(false);
+	subScene->SetGPUCulling(false);
+
+	std::cout << "Recording Benchmark: Recording " << RECORDING_BENCHMARK_OBJECT_COUNT << " extra draws over " << RECORDING_BENCHMARK_FRAMES << " frames...\n";
+
+	// Spread the temporary objects out so they are all visibly drawn.
+	DynamicArray<RenderObject*> objects(RECORDING_BENCHMARK_OBJECT_COUNT);
+	for (uint32_t i = 0; i < RECORDING_BENCHMARK_OBJECT_COUNT; ++i)
+	{
+		RenderObject* obj = new RenderObject(scene, mesh, material, &RenderObject::m_defaultInstanceAttributes, 1);
+
+		Instance ins = { glm::translate(glm::mat4(), glm::vec3((float)(i % 64) * 2.0f - 64.0f, -1.0f, (float)(i / 64) * -2.0f)) };
+		obj->SetInstance(obj->InstanceAt(0), ins);
+
+		objects.Push(obj);
+	}
+
+	const uint32_t threadCounts[] = { 1, 2, 4, 8 };
+	double dSingleThreadTime = 0.0;
+
+	for (uint32_t i = 0; i < sizeof(threadCounts) / sizeof(uint32_t); ++i)
+	{
+		m_renderer->SetRecordingThreadCount(threadCounts[i]);
+
+		// Let instance uploads & worker pools settle before measuring.
+		for (uint32_t j = 0; j < RECORDING_BENCHMARK_WARMUP_FRAMES; ++j)
+		{
+			m_renderer->Begin();
+			m_renderer->End();
+		}
+
+		double dTotalTime = 0.0;
+
+		for (uint32_t j = 0; j < RECORDING_BENCHMARK_FRAMES; ++j)
+		{
+			m_renderer->Begin();
+			m_renderer->End();
+
+			dTotalTime += gPass->RecordTime();
+		}
+
+		double dAverageTime = dTotalTime / RECORDING_BENCHMARK_FRAMES;
+
+		if (i == 0)
+			dSingleThreadTime = dAverageTime;
+
+		std::cout << "Recording Benchmark: " << threadCounts[i] << " threads (" << std::min(threadCounts[i], m_renderer->GetJobSystem()->ThreadCount()) << " available): " << dAverageTime << "ms, " << dSingleThreadTime / dAverageTime << "x speedup\n";
+	}
+
+	m_renderer->SetRecordingThreadCount(nPrevThreadCount);
+	culler->SetEnabled(bPrevCullingEnabled);
+	subScene->SetGPUCulling(bPrevGPUCulling);
+
+	for (uint32_t i = 0; i < objects.Count(); ++i)
+		delete objects[i];
+}
+
+void Application::JobSystemBenchmark()
+{
+	JobSystem* jobSystem = m_renderer->GetJobSystem();
+
+	uint64_t nPrevStolenCount = jobSystem->StolenJobCount();
+
+	// Individually queued empty jobs, measures queueing, stealing & completion overhead.
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	JobCounter counter;
+	for (uint32_t i = 0; i < JOB_BENCHMARK_JOB_COUNT; ++i)
+		jobSystem->Run([]() {}, &counter);
+
+	jobSystem->Wait(&counter);
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	double dJobTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+	// Parallel-for over a small amount of work per element.
+	std::atomic<uint64_t> nSum(0);
+
+	startTime = std::chrono::high_resolution_clock::now();
+
+	jobSystem->ParallelFor(JOB_BENCHMARK_JOB_COUNT, JOB_BENCHMARK_BATCH_SIZE, [&](uint32_t nStart, uint32_t nEnd)
+	{
+		uint64_t nLocalSum = 0;
+
+		for (uint32_t i = nStart; i < nEnd; ++i)
+			nLocalSum += i;
+
+		nSum += nLocalSum;
+	});
+
+	endTime = std::chrono::high_resolution_clock::now();
+	double dForTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+	std::cout << "Job Benchmark: " << JOB_BENCHMARK_JOB_COUNT << " jobs on " << jobSystem->ThreadCount() << " threads in " << dJobTime << "ms (" 
+		<< JOB_BENCHMARK_JOB_COUNT / (dJobTime * 1000.0) << " million jobs/s), " << jobSystem->StolenJobCount() - nPrevStolenCount << " stolen\n";
+	std::cout << "Job Benchmark: Parallel-for over " << JOB_BENCHMARK_JOB_COUNT << " elements in batches of " << JOB_BENCHMARK_BATCH_SIZE << " took " << dForTime << "ms\n";
+}
+
+void Application::CullingBenchmark()
+{
+	JobSystem* jobSystem = m_renderer->GetJobSystem();
+
+	// Generate bounds in a deterministic grid around a camera at the origin looking down -Z, so about a quarter of the instances are visible.
+	InstanceBounds bounds;
+	bounds.Resize(CULLING_BENCHMARK_INSTANCE_COUNT);
+
+	MeshBounds meshBounds = { glm::vec3(0.0f), glm::vec3(0.5f) };
+
+	for (uint32_t i = 0; i < CULLING_BENCHMARK_INSTANCE_COUNT; ++i)
+	{
+		glm::vec3 v3Position((float)(i % 64) * 4.0f - 128.0f, (float)((i / 64) % 32) * 4.0f - 64.0f, (float)(i / 2048) * -4.0f + 32.0f);
+		bounds.Set(i, meshBounds, glm::rotate(glm::translate(glm::mat4(), v3Position), (float)i, glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+
+	Frustum frustum = Frustum::FromMatrix(glm::perspective(glm::radians(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 1000.0f));
+
+	// Kernels write every lane before compacting, so leave room for a whole SIMD iteration past the end of the range.
+	std::vector<uint32_t> indices(bounds.Capacity() + CULL_SIMD_WIDTH);
+	uint32_t nScalarCount = 0;
+	uint32_t nSIMDCount = 0;
+	std::atomic<uint32_t> nParallelCount(0);
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < CULLING_BENCHMARK_ITERATIONS; ++i)
+		nScalarCount = FrustumCuller::CullBoundsScalar(frustum, bounds, 0, CULLING_BENCHMARK_INSTANCE_COUNT, indices.data());
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	double dScalarTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / (1000.0 * CULLING_BENCHMARK_ITERATIONS);
+
+	startTime = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < CULLING_BENCHMARK_ITERATIONS; ++i)
+		nSIMDCount = FrustumCuller::CullBounds(frustum, bounds, 0, CULLING_BENCHMARK_INSTANCE_COUNT, indices.data());
+
+	endTime = std::chrono::high_resolution_clock::now();
+	double dSIMDTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / (1000.0 * CULLING_BENCHMARK_ITERATIONS);
+
+	startTime = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < CULLING_BENCHMARK_ITERATIONS; ++i)
+	{
+		nParallelCount = 0;
+
+		// Each batch writes its indices at its own start, as the culler does with visible instances.
+		jobSystem->ParallelFor(CULLING_BENCHMARK_INSTANCE_COUNT, CULL_BATCH_SIZE, [&](uint32_t nStart, uint32_t nEnd)
+		{
+			nParallelCount += FrustumCuller::CullBounds(frustum, bounds, nStart, nEnd, &indices[nStart]);
+		});
+	}
+
+	endTime = std::chrono::high_resolution_clock::now();
+	double dParallelTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / (1000.0 * CULLING_BENCHMARK_ITERATIONS);
+
+	std::cout << "Culling Benchmark: " << CULLING_BENCHMARK_INSTANCE_COUNT << " instances, " << nScalarCount << " visible\n";
+	std::cout << "Culling Benchmark: Scalar: " << dScalarTime << "ms, SIMD (" << CULL_SIMD_WIDTH << " wide): " << dSIMDTime << "ms (" << dScalarTime / dSIMDTime << "x), SIMD on " 
+		<< jobSystem->ThreadCount() << " threads: " << dParallelTime << "ms (" << dScalarTime / dParallelTime << "x)\n";
+
+	if (nSIMDCount != nScalarCount || nParallelCount != nScalarCount)
+		std::cout << "Culling Benchmark Warning: Kernel results differ, scalar: " << nScalarCount << ", SIMD: " << nSIMDCount << ", parallel: " << nParallelCount << "\n";
+}
+
+void Application::LODBenchmark()
+{
+	// Generates the LODs on the first run & stores them in the mesh cache.
+	Mesh* mesh = new Mesh(m_renderer, LOD_BENCHMARK_MESH_PATH, true);
+
+	// Selection uses the distance to the nearest point of the instance's bounds, as the culler does.
+	float fRadius = glm::length(mesh->Bounds().m_v3Extents) * LOD_BENCHMARK_SCALE;
+
+	// Pixels per world space unit at a distance of one, at the window's height & the subscene's 45 degree vertical field of view.
+	float fProjectionScale = 0.5f * static_cast<float>(WINDOW_HEIGHT) / std::tan(glm::radians(45.0f) * 0.5f);
+
+	std::cout << "LOD Benchmark: " << mesh->GetName() << ", " << mesh->LODCount() << " LODs, " << LOD_PIXEL_ERROR_THRESHOLD << " pixel error threshold at " << WINDOW_HEIGHT << "p\n";
+
+	uint32_t nFullTriangleCount = mesh->GetLOD(0).m_nIndexCount / 3;
+	uint64_t nTotalFullTriangles = 0;
+	uint64_t nTotalLODTriangles = 0;
+
+	for (float fDistance = LOD_BENCHMARK_MIN_DISTANCE; fDistance <= LOD_BENCHMARK_MAX_DISTANCE; fDistance *= 2.0f)
+	{
+		uint32_t nLevel = mesh->SelectLOD(fDistance - fRadius, LOD_BENCHMARK_SCALE, fProjectionScale, LOD_PIXEL_ERROR_THRESHOLD);
+		uint32_t nTriangleCount = mesh->GetLOD(nLevel).m_nIndexCount / 3;
+
+		nTotalFullTriangles += nFullTriangleCount;
+		nTotalLODTriangles += nTriangleCount;
+
+		std::cout << "LOD Benchmark: Distance " << fDistance << ": LOD " << nLevel << ", " << nTriangleCount << "/" << nFullTriangleCount << " triangles (" 
+			<< 100.0 * nTriangleCount / nFullTriangleCount << "%)\n";
+	}
+
+	std::cout << "LOD Benchmark: One instance at each distance: " << nTotalLODTriangles << "/" << nTotalFullTriangles << " triangles (" << 100.0 * nTotalLODTriangles / nTotalFullTriangles << "%)\n";
+
+	delete mesh;
+}
+
+void Application::TransformBenchmark()
+{
+	JobSystem* jobSystem = m_renderer->GetJobSystem();
+
+	// Generate deterministic local transforms, a third of the nodes are roots each with a child & a grandchild.
+	const uint32_t nRootCount = TRANSFORM_BENCHMARK_NODE_COUNT / 3;
+	const uint32_t nNodeCount = nRootCount * 3;
+
+	std::vector<uint32_t> parents(nNodeCount);
+	std::vector<glm::vec3> positions(nNodeCount);
+	std::vector<glm::quat> rotations(nNodeCount);
+	std::vector<glm::vec3> scales(nNodeCount);
+
+	TransformHierarchy hierarchy;
+	std::vector<TransformHandle> handles(nNodeCount);
+
+	for (uint32_t i = 0; i < nNodeCount; ++i)
+	{
+		uint32_t nRoot = i % nRootCount;
+		uint32_t nDepth = i / nRootCount;
+
+		parents[i] = nDepth == 0 ? UINT32_MAX : i - nRootCount;
+		positions[i] = nDepth == 0 ? glm::vec3((float)(nRoot % 256) * 4.0f, 0.0f, (float)(nRoot / 256) * 4.0f) : glm::vec3(0.0f, 1.0f, 0.5f);
+		rotations[i] = glm::angleAxis((float)i, glm::normalize(glm::vec3(1.0f, (float)(i % 7), 2.0f)));
+		scales[i] = glm::vec3(1.0f + (float)(i % 3) * 0.25f);
+
+		handles[i] = nDepth == 0 ? hierarchy.AddNode(positions[i], rotations[i], scales[i]) : hierarchy.AddNode(handles[parents[i]], positions[i], rotations[i], scales[i]);
+	}
+
+	// Sort the hierarchy before timing.
+	hierarchy.Update();
+
+	std::vector<glm::mat4> worldMatrices(nNodeCount);
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < TRANSFORM_BENCHMARK_ITERATIONS; ++i)
+	{
+		for (uint32_t j = 0; j < nNodeCount; ++j)
+		{
+			glm::mat4 localMat = glm::scale(glm::translate(glm::mat4(), positions[j]) * glm::mat4_cast(rotations[j]), scales[j]);
+			worldMatrices[j] = parents[j] == UINT32_MAX ? localMat : worldMatrices[parents[j]] * localMat;
+		}
+	}
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	double dScalarTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / (1000.0 * TRANSFORM_BENCHMARK_ITERATIONS);
+
+	// Modifying every root modifies every node, the cost of marking them is included.
+	startTime = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < TRANSFORM_BENCHMARK_ITERATIONS; ++i)
+	{
+		for (uint32_t j = 0; j < nRootCount; ++j)
+			hierarchy.SetPosition(handles[j], positions[j]);
+
+		hierarchy.Update();
+	}
+
+	endTime = std::chrono::high_resolution_clock::now();
+	double dSIMDTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / (1000.0 * TRANSFORM_BENCHMARK_ITERATIONS);
+
+	startTime = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < TRANSFORM_BENCHMARK_ITERATIONS; ++i)
+	{
+		for (uint32_t j = 0; j < nRootCount; ++j)
+			hierarchy.SetPosition(handles[j], positions[j]);
+
+		hierarchy.Update(jobSystem);
+	}
+
+	endTime = std::chrono::high_resolution_clock::now();
+	double dParallelTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / (1000.0 * TRANSFORM_BENCHMARK_ITERATIONS);
+
+	// Modify a fraction of the roots, spread across the hierarchy. Their descendants are recomputed with them.
+	uint32_t nPartialStride = std::max(1u, (uint32_t)(1.0f / TRANSFORM_BENCHMARK_PARTIAL_FRACTION));
+	uint32_t nPartialCount = 0;
+
+	startTime = std::chrono::high_resolution_clock::now();
+
+	for (uint32_t i = 0; i < TRANSFORM_BENCHMARK_ITERATIONS; ++i)
+	{
+		nPartialCount = 0;
+
+		for (uint32_t j = i % nPartialStride; j < nRootCount; j += nPartialStride, ++nPartialCount)
+			hierarchy.SetRotation(handles[j], rotations[j]);
+
+		hierarchy.Update(jobSystem);
+	}
+
+	endTime = std::chrono::high_resolution_clock::now();
+	double dPartialTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / (1000.0 * TRANSFORM_BENCHMARK_ITERATIONS);
+
+	float fMaxError = 0.0f;
+
+	for (uint32_t i = 0; i < nNodeCount; ++i)
+	{
+		const glm::mat4& worldMat = hierarchy.WorldMatrix(handles[i]);
+
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			glm::vec4 v4Difference = glm::abs(worldMat[c] - worldMatrices[i][c]);
+			fMaxError = std::max(fMaxError, std::max(std::max(v4Difference.x, v4Difference.y), std::max(v4Difference.z, v4Difference.w)));
+		}
+	}
+
+	std::cout << "Transform Benchmark: " << nNodeCount << " nodes, " << hierarchy.LevelCount() << " levels\n";
+	std::cout << "Transform Benchmark: Scalar: " << dScalarTime << "ms, SIMD (" << TRANSFORM_SIMD_WIDTH << " wide): " << dSIMDTime << "ms (" << dScalarTime / dSIMDTime << "x), SIMD on "
+		<< jobSystem->ThreadCount() << " threads: " << dParallelTime << "ms (" << dScalarTime / dParallelTime << "x)\n";
+	std::cout << "Transform Benchmark: " << nPartialCount * 3 << " nodes modified: " << dPartialTime << "ms (" << dScalarTime / dPartialTime << "x)\n";
+
+	if (fMaxError > 1e-3f)
+		std::cout << "Transform Benchmark Warning: World matrices differ from the scalar results by up to " << fMaxError << "\n";
+}
+
 void Application::ErrorCallBack(int error, const char* desc)
 {
 	std::cout << "GLFW Error: " << desc << "\n";
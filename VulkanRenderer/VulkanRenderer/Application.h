@@ -4,13 +4,50 @@ struct GLFWwindow;
 
 class Renderer;
 class Input;
+class Scene;
+class Mesh;
+class Material;
 
 #define DEBUG_DISPLAY_TIME 2.0f
 
 #define WINDOW_WIDTH 1280
 #define WINDOW_HEIGHT 720
 
-#define FRAMERATE_CAP 10000.0f
+// Frames per second the frame pacer caps to, toggled by pressing U.
+#define FRAMERATE_CAP 60.0f
+
+// Command recording scaling benchmark, run by pressing B.
+#define RECORDING_BENCHMARK_OBJECT_COUNT 2048
+#define RECORDING_BENCHMARK_WARMUP_FRAMES 16
+#define RECORDING_BENCHMARK_FRAMES 256
+
+// Job system throughput benchmark, run by pressing J.
+#define JOB_BENCHMARK_JOB_COUNT (1024 * 1024)
+#define JOB_BENCHMARK_BATCH_SIZE 256
+
+// Frustum culling kernel benchmark, run by pressing K.
+#define CULLING_BENCHMARK_INSTANCE_COUNT 100000
+#define CULLING_BENCHMARK_ITERATIONS 64
+
+// Mesh LOD triangle count over distance benchmark, run by pressing M. Distances double from the minimum up to the maximum.
+#define LOD_BENCHMARK_MESH_PATH "Assets/Objects/Stanford/Dragon.obj"
+#define LOD_BENCHMARK_SCALE 1.0f
+#define LOD_BENCHMARK_MIN_DISTANCE 4.0f
+#define LOD_BENCHMARK_MAX_DISTANCE 256.0f
+
+// Transform hierarchy world matrix benchmark, run by pressing T. Nodes are split evenly between roots, children & grandchildren.
+#define TRANSFORM_BENCHMARK_NODE_COUNT 100000
+#define TRANSFORM_BENCHMARK_ITERATIONS 64
+#define TRANSFORM_BENCHMARK_PARTIAL_FRACTION 0.01f
+
+// GPU profiler history dumps, written by pressing P.
+#define GPU_PROFILE_CSV_PATH "gpu_profile.csv"
+#define GPU_PROFILE_JSON_PATH "gpu_profile.json"
+
+// CPU profiler traces. Startup loading is always captured, C captures the following frames.
+#define CPU_TRACE_STARTUP_PATH "cpu_trace_startup.json"
+#define CPU_TRACE_PATH "cpu_trace.json"
+#define CPU_TRACE_FRAMES 120
 
 class Application
 {
@@ -28,6 +65,36 @@ private:
 
 	static void CreateWindow(const unsigned int& nWidth, const unsigned int& nHeight, bool bFullScreen = false);
 
+	/*
+	Description: Measure G-Buffer command recording time with 1, 2, 4 & 8 recording threads, using a temporary set of render objects.
+	Param:
+	    Scene* scene: The scene to add the temporary objects to.
+		Mesh* mesh: Mesh of the temporary objects.
+		Material* material: Material of the temporary objects.
+	*/
+	static void RecordingBenchmark(Scene* scene, Mesh* mesh, Material* material);
+
+	/*
+	Description: Measure job system throughput with empty jobs & a parallel-for.
+	*/
+	static void JobSystemBenchmark();
+
+	/*
+	Description: Measure the frustum culling kernels over a set of generated bounds, scalar & SIMD on one thread & SIMD across the job system.
+	*/
+	static void CullingBenchmark();
+
+	/*
+	Description: Print the triangles of a mesh drawn at the selected LOD over a range of camera distances, against the full detail mesh.
+	*/
+	static void LODBenchmark();
+
+	/*
+	Description: Measure world matrix updates of a generated transform hierarchy, scalar on one thread against SIMD on one thread & across the job system,
+	             & SIMD with a fraction of the nodes modified.
+	*/
+	static void TransformBenchmark();
+
 	// GLFW Callbacks
 	static void ErrorCallBack(int error, const char* desc);
 	static void KeyCallBack(GLFWwindow* window, int key, int scancode, int action, int mods);
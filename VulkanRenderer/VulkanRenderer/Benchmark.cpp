@@ -0,0 +1,551 @@
+#include "Benchmark.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "SubScene.h"
+#include "LightingManager.h"
+#include "Shader.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "RenderObject.h"
+#include "GPUCuller.h"
+#include "CPUProfiler.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+#include "glm.hpp"
+#include "glm/include/ext.hpp"
+
+// Meshes drawn with the same instance transforms.
+struct BenchmarkModel
+{
+	const char* m_szMeshPaths[3];
+	uint32_t m_nMeshCount;
+	float m_fScale; // Brings the models to similar sizes.
+	bool m_bGenerateLODs;
+};
+
+static const BenchmarkModel s_models[] =
+{
+	{ { "Assets/Objects/Spinner/low_details.obj", "Assets/Objects/Spinner/low_glass.obj", "Assets/Objects/Spinner/low_paint.obj" }, 3, 0.01f, false },
+	{ { "Assets/Objects/Stanford/Bunny.obj" }, 1, 0.1f, true },
+	{ { "Assets/Objects/Stanford/Dragon.obj" }, 1, 0.1f, true }
+};
+
+#define BENCHMARK_MODEL_COUNT static_cast<uint32_t>(sizeof(s_models) / sizeof(BenchmarkModel))
+
+// Material tints & point light colors.
+static const glm::vec3 s_palette[] =
+{
+	glm::vec3(1.0f, 0.3f, 0.3f),
+	glm::vec3(0.3f, 1.0f, 0.3f),
+	glm::vec3(0.3f, 0.3f, 1.0f),
+	glm::vec3(1.0f, 1.0f, 0.3f),
+	glm::vec3(0.3f, 1.0f, 1.0f),
+	glm::vec3(1.0f, 0.3f, 1.0f),
+	glm::vec3(1.0f, 1.0f, 1.0f)
+};
+
+#define BENCHMARK_PALETTE_SIZE static_cast<uint32_t>(sizeof(s_palette) / sizeof(glm::vec3))
+
+BenchmarkParams::BenchmarkParams()
+{
+	m_nInstanceCount = BENCHMARK_DEFAULT_INSTANCES;
+	m_nPointLightCount = BENCHMARK_DEFAULT_POINT_LIGHTS;
+	m_nMaterialCount = BENCHMARK_DEFAULT_MATERIALS;
+	m_nWarmupFrames = BENCHMARK_DEFAULT_WARMUP_FRAMES;
+	m_nFrameCount = BENCHMARK_DEFAULT_FRAMES;
+	m_nWidth = WINDOW_WIDTH;
+	m_nHeight = WINDOW_HEIGHT;
+	m_bGPUCulling = false;
+	m_bOcclusionCulling = true;
+	m_bLODSelection = true;
+	m_szOutputPath = BENCHMARK_DEFAULT_OUTPUT_PATH;
+	m_szImagePath = nullptr;
+}
+
+Benchmark::Benchmark(Renderer* renderer, const BenchmarkParams& params)
+{
+	m_renderer = renderer;
+	m_params = params;
+	m_shader = nullptr;
+	m_fSceneRadius = 0.0f;
+	m_nAssetUploadBytes = 0;
+
+	// Render at the full output size, so results don't depend on how the render scale settles.
+	DynamicResolution* dynamicResolution = m_renderer->GetScene()->GetPrimarySubScene()->GetDynamicResolution();
+	dynamicResolution->SetEnabled(false);
+	dynamicResolution->SetScale(1.0f);
+
+	m_renderer->GetScene()->GetPrimarySubScene()->SetGPUCulling(m_params.m_bGPUCulling);
+	m_renderer->GetScene()->GetPrimarySubScene()->SetOcclusionCulling(m_params.m_bOcclusionCulling);
+	m_renderer->GetScene()->GetPrimarySubScene()->GetFrustumCuller()->SetLODSelection(m_params.m_bLODSelection);
+
+	CreateScene();
+}
+
+Benchmark::~Benchmark()
+{
+	for (uint32_t i = 0; i < m_objects.size(); ++i)
+		delete m_objects[i];
+
+	for (uint32_t i = 0; i < m_meshes.size(); ++i)
+		delete m_meshes[i];
+
+	for (uint32_t i = 0; i < m_materials.size(); ++i)
+		delete m_materials[i];
+
+	delete m_shader;
+}
+
+bool Benchmark::Run()
+{
+	std::cout << "Benchmark: " << m_params.m_nInstanceCount << " instances, " << m_params.m_nPointLightCount << " point lights & " << m_params.m_nMaterialCount << " materials at "
+		<< m_params.m_nWidth << "x" << m_params.m_nHeight << ", " << m_params.m_nWarmupFrames << " warmup & " << m_params.m_nFrameCount << " measured frames...\n";
+
+	SubScene* subScene = m_renderer->GetScene()->GetPrimarySubScene();
+	GPUProfiler* profiler = m_renderer->GetGPUProfiler();
+	UploadArena* uploadArena = m_renderer->GetUploadArena();
+	const uint32_t nFrameScope = subScene->FrameProfilerScope();
+
+	std::vector<double> cpuTimes;
+	std::vector<double> waitTimes;
+	std::vector<double> gpuTimes;
+	cpuTimes.reserve(m_params.m_nFrameCount);
+	waitTimes.reserve(m_params.m_nFrameCount);
+	gpuTimes.reserve(m_params.m_nFrameCount);
+
+	double dDrawCalls = 0.0;
+	double dUploadBytes = 0.0;
+	double dOccludedInstances = 0.0;
+	double dOccludedTriangles = 0.0;
+	double dCameraTriangles = 0.0;
+	double dStateBinds = 0.0;
+	double dSkippedBinds = 0.0;
+
+	// GPU times are read back MAX_FRAMES_IN_FLIGHT frames late, extra frames are rendered to read back the end of the measured window.
+	const uint32_t nMeasureStart = m_params.m_nWarmupFrames;
+	const uint32_t nMeasureEnd = nMeasureStart + m_params.m_nFrameCount;
+	const uint32_t nTotalFrames = nMeasureEnd + MAX_FRAMES_IN_FLIGHT;
+
+	for (uint32_t i = 0; i < nTotalFrames; ++i)
+	{
+		CPU_PROFILE_FRAME();
+
+		// Only the last frame is copied to host memory, after the measured window so the copy isn't measured.
+		if (m_params.m_szImagePath && i == nTotalFrames - 1)
+			m_renderer->SetOutputReadback(true);
+
+		// Wait for the frame-in-flight Begin() reuses first, so GPU bound frames don't inflate the CPU frame time. The wait is measured separately.
+		auto waitStartTime = std::chrono::steady_clock::now();
+
+		m_renderer->WaitForFrame(false);
+
+		auto startTime = std::chrono::steady_clock::now();
+
+		m_renderer->Begin();
+		UpdateCamera(i);
+		m_renderer->End();
+
+		auto endTime = std::chrono::steady_clock::now();
+
+		if(i >= nMeasureStart && i < nMeasureEnd)
+		{
+			cpuTimes.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count() / 1000000.0);
+			waitTimes.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(startTime - waitStartTime).count() / 1000000.0);
+
+			dDrawCalls += subScene->DrawCallCount();
+			dUploadBytes += static_cast<double>(uploadArena->WrittenBytes());
+
+			DrawListStats bindStats = subScene->GBufferBindStats();
+			dStateBinds += bindStats.m_nPipelineBinds + bindStats.m_nDescriptorBinds + bindStats.m_nVertexBufferBinds + bindStats.m_nIndexBufferBinds;
+			dSkippedBinds += bindStats.m_nSkippedBinds;
+
+			// Occlusion counts are read back when the frame index is reused, so they trail by MAX_FRAMES_IN_FLIGHT frames like the GPU times.
+			if (subScene->IsOcclusionCulling())
+			{
+				dOccludedInstances += subScene->GetGPUCuller()->OccludedInstanceCount();
+				dOccludedTriangles += subScene->GetGPUCuller()->OccludedTriangleCount();
+			}
+
+			// Visible counts of GPU culling stay on the GPU.
+			if (!subScene->IsGPUCulling())
+				dCameraTriangles += static_cast<double>(subScene->GetFrustumCuller()->VisibleTriangleCount(CULL_VIEW_CAMERA));
+		}
+
+		// Begin() read back the frame scope of the frame rendered MAX_FRAMES_IN_FLIGHT frames ago.
+		if (nFrameScope != GPU_PROFILER_INVALID_SCOPE && i >= nMeasureStart + MAX_FRAMES_IN_FLIGHT)
+			gpuTimes.push_back(profiler->LastTime(nFrameScope));
+	}
+
+	m_renderer->WaitGraphicsIdle();
+
+	FrameTimeStats cpuStats = ComputeStats(cpuTimes);
+	FrameTimeStats waitStats = ComputeStats(waitTimes);
+	FrameTimeStats gpuStats = ComputeStats(gpuTimes);
+
+	dDrawCalls /= m_params.m_nFrameCount;
+	dUploadBytes /= m_params.m_nFrameCount;
+	dOccludedInstances /= m_params.m_nFrameCount;
+	dOccludedTriangles /= m_params.m_nFrameCount;
+	dCameraTriangles /= m_params.m_nFrameCount;
+	dStateBinds /= m_params.m_nFrameCount;
+	dSkippedBinds /= m_params.m_nFrameCount;
+
+	std::cout << "Benchmark: CPU frame time p50: " << cpuStats.m_dP50 << "ms, p95: " << cpuStats.m_dP95 << "ms, p99: " << cpuStats.m_dP99 << "ms\n";
+	std::cout << "Benchmark: Frame-in-flight wait p50: " << waitStats.m_dP50 << "ms, p95: " << waitStats.m_dP95 << "ms, p99: " << waitStats.m_dP99 << "ms\n";
+
+	if(!gpuTimes.empty())
+		std::cout << "Benchmark: GPU frame time p50: " << gpuStats.m_dP50 << "ms, p95: " << gpuStats.m_dP95 << "ms, p99: " << gpuStats.m_dP99 << "ms\n";
+	else
+		std::cout << "Benchmark Warning: GPU timestamps are unsupported, GPU frame times are not reported.\n";
+
+	std::cout << "Benchmark: " << dDrawCalls << " draw calls & " << dUploadBytes << " upload bytes per frame\n";
+	std::cout << "Benchmark: " << dStateBinds << " G-Buffer state binds per frame, " << dSkippedBinds << " redundant binds skipped\n";
+
+	if (subScene->IsOcclusionCulling())
+		std::cout << "Benchmark: " << dOccludedInstances << " instances & " << dOccludedTriangles << " triangles occluded per frame\n";
+
+	if (!subScene->IsGPUCulling())
+		std::cout << "Benchmark: " << dCameraTriangles << " camera triangles per frame, LOD selection " << (subScene->GetFrustumCuller()->IsLODSelection() ? "enabled" : "disabled") << "\n";
+
+	bool bWritten = WriteJSON(cpuStats, waitStats, gpuTimes.empty() ? nullptr : &gpuStats, dDrawCalls, dUploadBytes, dStateBinds, dSkippedBinds, dOccludedInstances, dOccludedTriangles,
+		subScene->IsGPUCulling() ? nullptr : &dCameraTriangles);
+
+	if (m_params.m_szImagePath)
+	{
+		bWritten = WriteImage() && bWritten;
+		m_renderer->SetOutputReadback(false);
+	}
+
+	return bWritten;
+}
+
+bool Benchmark::ParseArgs(int argc, char** argv, BenchmarkParams& outParams)
+{
+	bool bBenchmark = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* szArg = argv[i];
+
+		if(std::strcmp(szArg, "--benchmark") == 0)
+		{
+			bBenchmark = true;
+			continue;
+		}
+
+		const char* szValue = std::strchr(szArg, '=');
+
+		if(!szValue)
+		{
+			std::cout << "Benchmark Warning: Ignoring unknown argument: " << szArg << "\n";
+			continue;
+		}
+
+		std::string key(szArg, szValue - szArg);
+		++szValue;
+
+		uint32_t nValue = static_cast<uint32_t>(std::strtoul(szValue, nullptr, 10));
+
+		if (key == "instances")
+			outParams.m_nInstanceCount = nValue;
+		else if (key == "lights")
+			outParams.m_nPointLightCount = nValue;
+		else if (key == "materials")
+			outParams.m_nMaterialCount = nValue;
+		else if (key == "warmup")
+			outParams.m_nWarmupFrames = nValue;
+		else if (key == "frames")
+			outParams.m_nFrameCount = nValue;
+		else if (key == "width")
+			outParams.m_nWidth = nValue;
+		else if (key == "height")
+			outParams.m_nHeight = nValue;
+		else if (key == "gpuculling")
+			outParams.m_bGPUCulling = nValue != 0;
+		else if (key == "occlusion")
+			outParams.m_bOcclusionCulling = nValue != 0;
+		else if (key == "lods")
+			outParams.m_bLODSelection = nValue != 0;
+		else if (key == "out")
+			outParams.m_szOutputPath = szValue;
+		else if (key == "image")
+			outParams.m_szImagePath = szValue;
+		else
+			std::cout << "Benchmark Warning: Ignoring unknown argument: " << szArg << "\n";
+	}
+
+	if(outParams.m_nPointLightCount > MAX_POINT_LIGHT_COUNT)
+	{
+		std::cout << "Benchmark Warning: Point light count is clamped to MAX_POINT_LIGHT_COUNT (" << MAX_POINT_LIGHT_COUNT << ").\n";
+		outParams.m_nPointLightCount = MAX_POINT_LIGHT_COUNT;
+	}
+
+	outParams.m_nInstanceCount = std::max(outParams.m_nInstanceCount, 1u);
+	outParams.m_nMaterialCount = std::max(outParams.m_nMaterialCount, 1u);
+	outParams.m_nFrameCount = std::max(outParams.m_nFrameCount, 1u);
+	outParams.m_nWidth = std::max(outParams.m_nWidth, 1u);
+	outParams.m_nHeight = std::max(outParams.m_nHeight, 1u);
+
+	return bBenchmark;
+}
+
+inline void Benchmark::CreateScene()
+{
+	Scene* scene = m_renderer->GetScene();
+	UploadContext* uploadContext = m_renderer->GetUploadContext();
+
+	VkDeviceSize nStartUploadBytes = uploadContext->UploadedBytes();
+
+	m_shader = new Shader(m_renderer, "Shaders/SPIR-V/vert_model_notex.spv", "Shaders/SPIR-V/frag_model_notex.spv");
+
+	// Materials only differ by tint, but each has its own pipeline data & descriptors.
+	for (uint32_t i = 0; i < m_params.m_nMaterialCount; ++i)
+	{
+		Material* material = new Material(m_renderer, m_shader, {}, {});
+
+		const glm::vec3& v3Tint = s_palette[i % BENCHMARK_PALETTE_SIZE];
+		float fTint[4] = { v3Tint.r, v3Tint.g, v3Tint.b, 1.0f };
+		material->SetFloat4("_ColorTint", fTint);
+
+		m_materials.push_back(material);
+	}
+
+	uint32_t nMeshStarts[BENCHMARK_MODEL_COUNT];
+
+	for (uint32_t i = 0; i < BENCHMARK_MODEL_COUNT; ++i)
+	{
+		nMeshStarts[i] = static_cast<uint32_t>(m_meshes.size());
+
+		for (uint32_t j = 0; j < s_models[i].m_nMeshCount; ++j)
+			m_meshes.push_back(new Mesh(m_renderer, s_models[i].m_szMeshPaths[j], s_models[i].m_bGenerateLODs));
+	}
+
+	// Instances are laid out on a square grid centered on the origin.
+	const uint32_t nGridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(m_params.m_nInstanceCount))));
+	const float fGridExtent = nGridSize * BENCHMARK_GRID_SPACING;
+	const float fGridOffset = (nGridSize - 1) * BENCHMARK_GRID_SPACING * 0.5f;
+
+	m_fSceneRadius = std::max(fGridExtent * 0.75f, BENCHMARK_GRID_SPACING * 2.0f);
+
+	// Instance i uses model i % model count & material (i / model count) % material count, so every combination is drawn.
+	// Each combination is a render object per mesh of the model, holding all of the combination's instances.
+	const uint32_t nMaterialCount = m_params.m_nMaterialCount;
+	std::vector<std::vector<Instance>> combinations(BENCHMARK_MODEL_COUNT * nMaterialCount);
+
+	for (uint32_t i = 0; i < m_params.m_nInstanceCount; ++i)
+	{
+		uint32_t nModel = i % BENCHMARK_MODEL_COUNT;
+		uint32_t nMaterial = (i / BENCHMARK_MODEL_COUNT) % nMaterialCount;
+
+		glm::vec3 v3Position((i % nGridSize) * BENCHMARK_GRID_SPACING - fGridOffset, 0.0f, (i / nGridSize) * BENCHMARK_GRID_SPACING - fGridOffset);
+
+		// Rotate by the golden angle, so neighbouring instances face different directions.
+		glm::mat4 modelMat = glm::translate(glm::mat4(), v3Position);
+		modelMat = glm::rotate(modelMat, static_cast<float>(i) * 2.39996f, glm::vec3(0.0f, 1.0f, 0.0f));
+		modelMat = glm::scale(modelMat, glm::vec3(s_models[nModel].m_fScale));
+
+		combinations[nModel * nMaterialCount + nMaterial].push_back({ modelMat });
+	}
+
+	for (uint32_t i = 0; i < combinations.size(); ++i)
+	{
+		std::vector<Instance>& instances = combinations[i];
+
+		if (instances.empty())
+			continue;
+
+		uint32_t nModel = i / nMaterialCount;
+		Material* material = m_materials[i % nMaterialCount];
+
+		for (uint32_t j = 0; j < s_models[nModel].m_nMeshCount; ++j)
+		{
+			RenderObject* obj = new RenderObject(scene, m_meshes[nMeshStarts[nModel] + j], material, &RenderObject::m_defaultInstanceAttributes, static_cast<uint32_t>(instances.size()));
+
+			// Render objects are created with a single instance.
+			obj->SetInstance(obj->InstanceAt(0), instances[0]);
+
+			for (uint32_t k = 1; k < instances.size(); ++k)
+				obj->AddInstance(instances[k]);
+
+			m_objects.push_back(obj);
+		}
+	}
+
+	// Lights are spread evenly over the instance grid, above the instances.
+	LightingManager* lightManager = scene->GetPrimarySubScene()->GetLightingManager();
+
+	lightManager->AddDirLight({ glm::normalize(glm::vec4(0.0f, -1.0f, 1.0f, 0.0f)), glm::vec4(0.2f, 0.2f, 0.4f, 1.0f) });
+
+	const uint32_t nLightGridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(m_params.m_nPointLightCount))));
+	const float fLightSpacing = nLightGridSize > 0 ? fGridExtent / nLightGridSize : 0.0f;
+
+	for (uint32_t i = 0; i < m_params.m_nPointLightCount; ++i)
+	{
+		glm::vec4 v4Position
+		(
+			((i % nLightGridSize) + 0.5f) * fLightSpacing - fGridExtent * 0.5f,
+			2.0f,
+			((i / nLightGridSize) + 0.5f) * fLightSpacing - fGridExtent * 0.5f,
+			1.0f
+		);
+
+		lightManager->AddPointLight({ v4Position, s_palette[i % BENCHMARK_PALETTE_SIZE], fLightSpacing * 1.5f });
+	}
+
+	// Submit all asset uploads queued while loading.
+	uploadContext->Submit();
+
+	m_nAssetUploadBytes = uploadContext->UploadedBytes() - nStartUploadBytes;
+
+	std::cout << "Benchmark: Created " << m_objects.size() << " render objects.\n";
+}
+
+inline void Benchmark::UpdateCamera(uint32_t nFrame)
+{
+	// Orbit the scene center, the path only depends on the frame number.
+	float fAngle = static_cast<float>(nFrame % BENCHMARK_CAMERA_PATH_FRAMES) / BENCHMARK_CAMERA_PATH_FRAMES * glm::two_pi<float>();
+
+	glm::vec3 v3Position(std::cos(fAngle) * m_fSceneRadius, m_fSceneRadius * 0.5f, std::sin(fAngle) * m_fSceneRadius);
+	glm::mat4 viewMat = glm::lookAt(v3Position, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	m_renderer->GetScene()->GetPrimarySubScene()->UpdateCameraView(viewMat, glm::vec4(v3Position, 1.0f));
+}
+
+Benchmark::FrameTimeStats Benchmark::ComputeStats(std::vector<double>& samples)
+{
+	FrameTimeStats stats = {};
+
+	if (samples.empty())
+		return stats;
+
+	std::sort(samples.begin(), samples.end());
+
+	double dTotal = 0.0;
+	for (uint32_t i = 0; i < samples.size(); ++i)
+		dTotal += samples[i];
+
+	// Nearest-rank percentile, always an actual sample.
+	auto percentile = [&](double dPercent)
+	{
+		size_t nRank = static_cast<size_t>(std::ceil(dPercent / 100.0 * samples.size()));
+		return samples[std::max<size_t>(nRank, 1) - 1];
+	};
+
+	stats.m_dMean = dTotal / samples.size();
+	stats.m_dP50 = percentile(50.0);
+	stats.m_dP95 = percentile(95.0);
+	stats.m_dP99 = percentile(99.0);
+	stats.m_dMax = samples.back();
+
+	return stats;
+}
+
+bool Benchmark::WriteImage() const
+{
+	VkExtent3D extents = m_renderer->SwapChainImageExtents();
+
+	// HEADLESS_OUTPUT_FORMAT texels, four bytes each.
+	std::vector<uint8_t> pixels(static_cast<size_t>(extents.width) * extents.height * 4);
+
+	if(!m_renderer->ReadOutput(pixels.data()))
+	{
+		std::cout << "Benchmark Warning: The output image of the last frame was not read back.\n";
+		return false;
+	}
+
+	std::ofstream outStream(m_params.m_szImagePath, std::ios::out | std::ios::binary);
+
+	if(!outStream.good())
+	{
+		std::cout << "Benchmark Warning: Failed to open: " << m_params.m_szImagePath << " for writing.\n";
+		return false;
+	}
+
+	outStream << "P6\n" << extents.width << " " << extents.height << "\n255\n";
+
+	// PPM holds RGB only, drop the alpha channel.
+	std::vector<uint8_t> row(static_cast<size_t>(extents.width) * 3);
+
+	for (uint32_t y = 0; y < extents.height; ++y)
+	{
+		const uint8_t* texels = &pixels[static_cast<size_t>(y) * extents.width * 4];
+
+		for (uint32_t x = 0; x < extents.width; ++x)
+		{
+			row[x * 3] = texels[x * 4];
+			row[x * 3 + 1] = texels[x * 4 + 1];
+			row[x * 3 + 2] = texels[x * 4 + 2];
+		}
+
+		outStream.write(reinterpret_cast<const char*>(row.data()), row.size());
+	}
+
+	std::cout << "Benchmark: Wrote the output image of the last frame to: " << m_params.m_szImagePath << "\n";
+
+	return true;
+}
+
+bool Benchmark::WriteJSON(const FrameTimeStats& cpuStats, const FrameTimeStats& waitStats, const FrameTimeStats* gpuStats, double dDrawCalls, double dUploadBytes, double dStateBinds, double dSkippedBinds, double dOccludedInstances, double dOccludedTriangles, const double* cameraTriangles) const
+{
+	std::ofstream outStream(m_params.m_szOutputPath, std::ios::out);
+
+	if(!outStream.good())
+	{
+		std::cout << "Benchmark Warning: Failed to open: " << m_params.m_szOutputPath << " for writing.\n";
+		return false;
+	}
+
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(m_renderer->GetPhysDevice(), &deviceProperties);
+
+	auto writeStats = [&](const FrameTimeStats& stats)
+	{
+		outStream << "{ \"mean\": " << stats.m_dMean << ", \"p50\": " << stats.m_dP50 << ", \"p95\": " << stats.m_dP95 << ", \"p99\": " << stats.m_dP99 << ", \"max\": " << stats.m_dMax << " }";
+	};
+
+	outStream << "{\n\t\"config\": { \"instances\": " << m_params.m_nInstanceCount << ", \"pointLights\": " << m_params.m_nPointLightCount << ", \"materials\": " << m_params.m_nMaterialCount
+		<< ", \"warmupFrames\": " << m_params.m_nWarmupFrames << ", \"frames\": " << m_params.m_nFrameCount << ", \"width\": " << m_params.m_nWidth << ", \"height\": " << m_params.m_nHeight
+		<< ", \"gpuCulling\": " << (m_renderer->GetScene()->GetPrimarySubScene()->IsGPUCulling() ? "true" : "false")
+		<< ", \"occlusionCulling\": " << (m_renderer->GetScene()->GetPrimarySubScene()->IsOcclusionCulling() ? "true" : "false")
+		<< ", \"lodSelection\": " << (m_renderer->GetScene()->GetPrimarySubScene()->GetFrustumCuller()->IsLODSelection() ? "true" : "false") << " },\n";
+
+	outStream << "\t\"device\": \"" << deviceProperties.deviceName << "\",\n";
+	outStream << "\t\"renderObjects\": " << m_objects.size() << ",\n";
+
+	outStream << "\t\"cpuFrameMs\": ";
+	writeStats(cpuStats);
+
+	outStream << ",\n\t\"frameWaitMs\": ";
+	writeStats(waitStats);
+
+	outStream << ",\n\t\"gpuFrameMs\": ";
+	if (gpuStats)
+		writeStats(*gpuStats);
+	else
+		outStream << "null";
+
+	outStream << ",\n\t\"drawCallsPerFrame\": " << dDrawCalls;
+	outStream << ",\n\t\"uploadBytesPerFrame\": " << dUploadBytes;
+	outStream << ",\n\t\"stateBindsPerFrame\": " << dStateBinds;
+	outStream << ",\n\t\"skippedBindsPerFrame\": " << dSkippedBinds;
+	outStream << ",\n\t\"occludedInstancesPerFrame\": " << dOccludedInstances;
+	outStream << ",\n\t\"occludedTrianglesPerFrame\": " << dOccludedTriangles;
+
+	outStream << ",\n\t\"cameraTrianglesPerFrame\": ";
+	if (cameraTriangles)
+		outStream << *cameraTriangles;
+	else
+		outStream << "null";
+	outStream << ",\n\t\"assetUploadBytes\": " << m_nAssetUploadBytes << "\n}\n";
+
+	std::cout << "Benchmark: Wrote results to: " << m_params.m_szOutputPath << "\n";
+	return true;
+}
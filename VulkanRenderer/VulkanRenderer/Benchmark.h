@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/*
+Description: Deterministic scripted benchmark. Builds a parameterized scene & drives a fixed camera path through a warmup & a measured window,
+             then writes CPU & GPU frame time percentiles, draw calls & upload bytes as JSON, so runs can be diffed against a stored baseline.
+             CPU frame times exclude waits on earlier frames-in-flight, which are reported separately.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+class Mesh;
+class Material;
+class RenderObject;
+
+struct Shader;
+
+// Defaults of the benchmark parameters, each can be overridden on the command line.
+#define BENCHMARK_DEFAULT_INSTANCES 1024
+#define BENCHMARK_DEFAULT_POINT_LIGHTS 256
+#define BENCHMARK_DEFAULT_MATERIALS 8
+#define BENCHMARK_DEFAULT_WARMUP_FRAMES 120
+#define BENCHMARK_DEFAULT_FRAMES 1000
+#define BENCHMARK_DEFAULT_OUTPUT_PATH "benchmark.json"
+
+// Distance between instances on the scene grid.
+#define BENCHMARK_GRID_SPACING 3.0f
+
+// Frames the camera takes to complete one orbit of the scene.
+#define BENCHMARK_CAMERA_PATH_FRAMES 600
+
+struct BenchmarkParams
+{
+	BenchmarkParams();
+
+	uint32_t m_nInstanceCount; // Mesh instances, spread across the Spinner, Bunny & Dragon models.
+	uint32_t m_nPointLightCount;
+	uint32_t m_nMaterialCount;
+	uint32_t m_nWarmupFrames;
+	uint32_t m_nFrameCount; // Frames in the measured window.
+	uint32_t m_nWidth;
+	uint32_t m_nHeight;
+	bool m_bGPUCulling; // Cull instances on the compute queue & draw indirectly, instead of culling on the CPU.
+	bool m_bOcclusionCulling; // Cull occluded instances while GPU culling.
+	bool m_bLODSelection; // Draw CPU culled Bunny & Dragon instances at the LOD selected for their distance.
+	const char* m_szOutputPath;
+	const char* m_szImagePath; // The output image of the last frame is read back & written here as a binary PPM, nullptr to skip it.
+};
+
+class Benchmark
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer to benchmark, should be used for nothing else since point lights cannot be removed from its scene.
+		const BenchmarkParams& params: Scene size, frame counts & output path.
+	*/
+	Benchmark(Renderer* renderer, const BenchmarkParams& params);
+
+	~Benchmark();
+
+	/*
+	Description: Render the warmup & measured frames & write the results, returns whether or not the results (& the output image if requested) were written.
+	Return Type: bool
+	*/
+	bool Run();
+
+	/*
+	Description: Parse benchmark command line arguments, returns whether or not --benchmark was passed.
+	             Parameters are overridden with key=value arguments: instances, lights, materials, warmup, frames, width, height, gpuculling, occlusion, lods, out & image.
+	Return Type: bool
+	Param:
+	    int argc: Argument count from main().
+		char** argv: Arguments from main().
+		BenchmarkParams& outParams: Parameters to override, values not passed are left untouched.
+	*/
+	static bool ParseArgs(int argc, char** argv, BenchmarkParams& outParams);
+
+private:
+
+	struct FrameTimeStats
+	{
+		double m_dMean;
+		double m_dP50;
+		double m_dP95;
+		double m_dP99;
+		double m_dMax;
+	};
+
+	// Load meshes & create materials, render objects & lights.
+	inline void CreateScene();
+
+	// Set the camera view for the provided frame of the camera path.
+	inline void UpdateCamera(uint32_t nFrame);
+
+	// Get the mean, maximum & nearest-rank percentiles of the samples, which are sorted in place.
+	static FrameTimeStats ComputeStats(std::vector<double>& samples);
+
+	// Read back the output image of the last submitted frame & write it to the image path.
+	bool WriteImage() const;
+
+	bool WriteJSON(const FrameTimeStats& cpuStats, const FrameTimeStats& waitStats, const FrameTimeStats* gpuStats, double dDrawCalls, double dUploadBytes, double dStateBinds, double dSkippedBinds, double dOccludedInstances, double dOccludedTriangles, const double* cameraTriangles) const;
+
+	Renderer* m_renderer;
+	BenchmarkParams m_params;
+
+	// ---------------------------------------------------------------------------------
+	// Scene
+
+	Shader* m_shader;
+	std::vector<Mesh*> m_meshes;
+	std::vector<Material*> m_materials;
+	std::vector<RenderObject*> m_objects;
+	float m_fSceneRadius;
+	uint64_t m_nAssetUploadBytes; // Bytes uploaded by the upload context while building the scene.
+};
@@ -0,0 +1,173 @@
+#include "CPUProfiler.h"
+#include <mutex>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+struct CPUProfileEvent
+{
+	const char* m_szName;
+	int64_t m_nStart;
+	int64_t m_nEnd;
+};
+
+// Only written by its own thread. The count is published with release ordering, so readers never see events which are still being written.
+struct CPUProfilerThreadBuffer
+{
+	CPUProfileEvent m_events[CPU_PROFILER_EVENTS_PER_THREAD];
+	std::atomic<uint32_t> m_nCount;
+	std::atomic<uint32_t> m_nDroppedCount;
+	std::string m_name;
+	uint32_t m_nThreadID;
+};
+
+// Buffers are registered once per thread & live until exit, so traces can still be exported after a thread has finished.
+struct CPUProfilerRegistry
+{
+	~CPUProfilerRegistry()
+	{
+		for (uint32_t i = 0; i < m_buffers.size(); ++i)
+			delete m_buffers[i];
+	}
+
+	std::mutex m_mutex;
+	std::vector<CPUProfilerThreadBuffer*> m_buffers;
+};
+
+static CPUProfilerRegistry s_registry;
+static thread_local CPUProfilerThreadBuffer* t_buffer = nullptr;
+
+std::atomic<bool> CPUProfiler::m_bCapturing(false);
+int64_t CPUProfiler::m_nCaptureStart = 0;
+int64_t CPUProfiler::m_nLastFrameMark = -1;
+
+void CPUProfiler::BeginCapture()
+{
+	std::lock_guard<std::mutex> lock(s_registry.m_mutex);
+
+	for (uint32_t i = 0; i < s_registry.m_buffers.size(); ++i)
+	{
+		s_registry.m_buffers[i]->m_nCount.store(0, std::memory_order_relaxed);
+		s_registry.m_buffers[i]->m_nDroppedCount.store(0, std::memory_order_relaxed);
+	}
+
+	m_nCaptureStart = Now();
+	m_nLastFrameMark = -1;
+
+	m_bCapturing.store(true);
+}
+
+void CPUProfiler::EndCapture()
+{
+	m_bCapturing.store(false);
+}
+
+bool CPUProfiler::WriteChromeTrace(const char* szFilePath)
+{
+	std::ofstream outStream(szFilePath, std::ios::out);
+
+	if(!outStream.good())
+	{
+		std::cout << "CPU Profiler Warning: Failed to open: " << szFilePath << " for writing.\n";
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(s_registry.m_mutex);
+
+	uint64_t nEventCount = 0;
+	uint64_t nDroppedCount = 0;
+
+	// Fixed notation, so long captures don't lose precision to exponents.
+	outStream << std::fixed << std::setprecision(3);
+
+	outStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	for (uint32_t i = 0; i < s_registry.m_buffers.size(); ++i)
+	{
+		CPUProfilerThreadBuffer* buffer = s_registry.m_buffers[i];
+
+		// Thread names are metadata events.
+		std::string name = buffer->m_name.empty() ? "Thread " + std::to_string(buffer->m_nThreadID) : buffer->m_name;
+		outStream << (i > 0 ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->m_nThreadID << ",\"args\":{\"name\":\"" << name << "\"}}";
+
+		uint32_t nCount = buffer->m_nCount.load(std::memory_order_acquire);
+
+		// Complete events, timestamps & durations in microseconds from the start of the capture.
+		for (uint32_t j = 0; j < nCount; ++j)
+		{
+			const CPUProfileEvent& event = buffer->m_events[j];
+
+			outStream << ",\n{\"name\":\"" << event.m_szName << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->m_nThreadID
+				<< ",\"ts\":" << (event.m_nStart - m_nCaptureStart) / 1000.0 << ",\"dur\":" << (event.m_nEnd - event.m_nStart) / 1000.0 << "}";
+		}
+
+		nEventCount += nCount;
+		nDroppedCount += buffer->m_nDroppedCount.load(std::memory_order_relaxed);
+	}
+
+	outStream << "\n]}\n";
+
+	std::cout << "CPU Profiler: Wrote " << nEventCount << " events on " << s_registry.m_buffers.size() << " threads to: " << szFilePath << "\n";
+
+	if (nDroppedCount > 0)
+		std::cout << "CPU Profiler Warning: " << nDroppedCount << " events were dropped, CPU_PROFILER_EVENTS_PER_THREAD is too small for the capture.\n";
+
+	return true;
+}
+
+void CPUProfiler::MarkFrame()
+{
+	int64_t nNow = Now();
+
+	if (IsCapturing() && m_nLastFrameMark >= 0)
+		Record("Frame", m_nLastFrameMark, nNow);
+
+	m_nLastFrameMark = nNow;
+}
+
+void CPUProfiler::SetThreadName(const char* szName)
+{
+	GetThreadBuffer()->m_name = szName;
+}
+
+void CPUProfiler::Record(const char* szName, int64_t nStart, int64_t nEnd)
+{
+	CPUProfilerThreadBuffer* buffer = GetThreadBuffer();
+
+	uint32_t nIndex = buffer->m_nCount.load(std::memory_order_relaxed);
+
+	if(nIndex >= CPU_PROFILER_EVENTS_PER_THREAD)
+	{
+		buffer->m_nDroppedCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	CPUProfileEvent& event = buffer->m_events[nIndex];
+	event.m_szName = szName;
+	event.m_nStart = nStart;
+	event.m_nEnd = nEnd;
+
+	buffer->m_nCount.store(nIndex + 1, std::memory_order_release);
+}
+
+CPUProfilerThreadBuffer* CPUProfiler::GetThreadBuffer()
+{
+	if (t_buffer)
+		return t_buffer;
+
+	CPUProfilerThreadBuffer* buffer = new CPUProfilerThreadBuffer;
+	buffer->m_nCount = 0;
+	buffer->m_nDroppedCount = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(s_registry.m_mutex);
+
+		buffer->m_nThreadID = static_cast<uint32_t>(s_registry.m_buffers.size());
+		s_registry.m_buffers.push_back(buffer);
+	}
+
+	t_buffer = buffer;
+	return buffer;
+}
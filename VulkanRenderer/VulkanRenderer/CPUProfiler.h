@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+Description: Lightweight CPU instrumentation. Scoped zones are recorded into lock-free per-thread event buffers while a capture is running,
+             captures are exported as Chrome trace-event JSON, which can be opened in chrome://tracing or Perfetto.
+Author: Nic Van Zuylen
+*/
+
+// Set to 0 to compile all zones, frame markers & thread names out.
+#ifndef CPU_PROFILER_ENABLED
+#define CPU_PROFILER_ENABLED 1
+#endif
+
+// Events each thread may record per capture, further events are dropped.
+#define CPU_PROFILER_EVENTS_PER_THREAD (64 * 1024)
+
+#if CPU_PROFILER_ENABLED
+
+#define CPU_PROFILER_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILER_CONCAT(a, b) CPU_PROFILER_CONCAT_INNER(a, b)
+
+// Time the rest of the enclosing scope. The name is not copied, so it should be a string literal.
+#define CPU_PROFILE_ZONE(szName) CPUProfileZone CPU_PROFILER_CONCAT(cpuProfileZone, __LINE__)(szName)
+
+// End the current frame & start the next, frames show up as zones on the calling thread.
+#define CPU_PROFILE_FRAME() CPUProfiler::MarkFrame()
+
+// Name the calling thread in exported traces.
+#define CPU_PROFILE_THREAD(szName) CPUProfiler::SetThreadName(szName)
+
+#else
+
+#define CPU_PROFILE_ZONE(szName)
+#define CPU_PROFILE_FRAME()
+#define CPU_PROFILE_THREAD(szName)
+
+#endif
+
+struct CPUProfilerThreadBuffer;
+
+class CPUProfiler
+{
+public:
+
+	/*
+	Description: Start recording zones on all threads, discarding the previous capture. No zones may be open on other threads, e.g. call between frames.
+	*/
+	static void BeginCapture();
+
+	/*
+	Description: Stop recording zones. No zones may be open on other threads, e.g. call between frames.
+	*/
+	static void EndCapture();
+
+	/*
+	Description: Get whether or not zones are currently being recorded.
+	Return Type: bool
+	*/
+	static inline bool IsCapturing()
+	{
+		return m_bCapturing.load(std::memory_order_relaxed);
+	}
+
+	/*
+	Description: Write the last capture as Chrome trace-event JSON, must not be called while capturing.
+	Return Type: bool
+	Param:
+	    const char* szFilePath: Path of the file to write.
+	*/
+	static bool WriteChromeTrace(const char* szFilePath);
+
+	/*
+	Description: End the current frame & start the next. Use CPU_PROFILE_FRAME() instead, so it is compiled out with the profiler.
+	*/
+	static void MarkFrame();
+
+	/*
+	Description: Name the calling thread in exported traces. Use CPU_PROFILE_THREAD() instead, so it is compiled out with the profiler.
+	Param:
+	    const char* szName: Name of the thread, copied.
+	*/
+	static void SetThreadName(const char* szName);
+
+	/*
+	Description: Record a completed zone on the calling thread's buffer.
+	Param:
+	    const char* szName: Name of the zone, must outlive the capture.
+		int64_t nStart: Start time, from Now().
+		int64_t nEnd: End time, from Now().
+	*/
+	static void Record(const char* szName, int64_t nStart, int64_t nEnd);
+
+	/*
+	Description: Get the current time in nanoseconds, on the clock zones are timed with.
+	Return Type: int64_t
+	*/
+	static inline int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+
+	// Get the calling thread's buffer, registering it on first use.
+	static CPUProfilerThreadBuffer* GetThreadBuffer();
+
+	static std::atomic<bool> m_bCapturing;
+	static int64_t m_nCaptureStart;
+	static int64_t m_nLastFrameMark;
+};
+
+// Records the lifetime of the zone as a zone event if a capture is running when it is created.
+class CPUProfileZone
+{
+public:
+
+	inline CPUProfileZone(const char* szName)
+	{
+		m_szName = szName;
+		m_nStart = CPUProfiler::IsCapturing() ? CPUProfiler::Now() : -1;
+	}
+
+	inline ~CPUProfileZone()
+	{
+		if (m_nStart >= 0)
+			CPUProfiler::Record(m_szName, m_nStart, CPUProfiler::Now());
+	}
+
+private:
+
+	const char* m_szName;
+	int64_t m_nStart;
+};
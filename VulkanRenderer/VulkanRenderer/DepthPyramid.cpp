@@ -0,0 +1,402 @@
+#include "DepthPyramid.h"
+#include "Renderer.h"
+#include "RendererHelper.h"
+#include "Texture.h"
+#include "PipelineCache.h"
+#include "CPUProfiler.h"
+
+#include <iostream>
+#include <algorithm>
+
+DepthPyramid::DepthPyramid(Renderer* renderer)
+{
+	m_renderer = renderer;
+
+	m_shaderModule = VK_NULL_HANDLE;
+	m_setLayout = VK_NULL_HANDLE;
+	m_pipelineLayout = VK_NULL_HANDLE;
+	m_pipeline = VK_NULL_HANDLE;
+	m_sampler = VK_NULL_HANDLE;
+
+	m_depthTexture = nullptr;
+	m_nDepthWidth = 0;
+	m_nDepthHeight = 0;
+	m_depthView = VK_NULL_HANDLE;
+
+	m_image = VK_NULL_HANDLE;
+	m_imageMemory = {};
+	m_imageView = VK_NULL_HANDLE;
+	m_nWidth = 0;
+	m_nHeight = 0;
+
+	m_descPool = VK_NULL_HANDLE;
+
+	m_nBuildWidth = 0;
+	m_nBuildHeight = 0;
+
+	CreatePipeline();
+}
+
+DepthPyramid::~DepthPyramid()
+{
+	VkDevice device = m_renderer->GetDevice();
+
+	DestroyImage();
+
+	if (m_pipeline)
+		vkDestroyPipeline(device, m_pipeline, nullptr);
+
+	if (m_pipelineLayout)
+		vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+
+	if (m_setLayout)
+		vkDestroyDescriptorSetLayout(device, m_setLayout, nullptr);
+
+	if (m_shaderModule)
+		vkDestroyShaderModule(device, m_shaderModule, nullptr);
+
+	if (m_sampler)
+		vkDestroySampler(device, m_sampler, nullptr);
+}
+
+bool DepthPyramid::IsAvailable() const
+{
+	return m_pipeline != VK_NULL_HANDLE;
+}
+
+bool DepthPyramid::Build(VkCommandBuffer cmdBuf, Texture* depthTexture, uint32_t nRenderWidth, uint32_t nRenderHeight)
+{
+	CPU_PROFILE_ZONE("DepthPyramid::Build");
+
+	// The attachment is re-created on resize, while previous frames may still be sampling the pyramid & its views.
+	bool bRecreated = depthTexture != m_depthTexture || static_cast<uint32_t>(depthTexture->GetWidth()) != m_nDepthWidth || static_cast<uint32_t>(depthTexture->GetHeight()) != m_nDepthHeight;
+
+	if (bRecreated)
+	{
+		vkDeviceWaitIdle(m_renderer->GetDevice());
+
+		DestroyImage();
+		CreateImage(depthTexture);
+	}
+
+	// Every level is rewritten, so the previous contents are discarded. Waits on the previous frame's reads.
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.pNext = nullptr;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = m_image;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, static_cast<uint32_t>(m_levelViews.size()), 0, 1 };
+
+	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+
+	// The first level covers half the rendered area, rounded down like the levels' sizes.
+	LevelSizes sizes = {};
+	sizes.m_nSrcWidth = static_cast<int32_t>(std::min(nRenderWidth, m_nDepthWidth));
+	sizes.m_nSrcHeight = static_cast<int32_t>(std::min(nRenderHeight, m_nDepthHeight));
+	sizes.m_nDstWidth = std::max(sizes.m_nSrcWidth / 2, 1);
+	sizes.m_nDstHeight = std::max(sizes.m_nSrcHeight / 2, 1);
+
+	m_nBuildWidth = static_cast<uint32_t>(sizes.m_nDstWidth);
+	m_nBuildHeight = static_cast<uint32_t>(sizes.m_nDstHeight);
+
+	// Each level reads the previous level, so wait for its writes before the next dispatch & the pyramid's readers.
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	for (uint32_t i = 0; i < m_levelSets.size(); ++i)
+	{
+		vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_levelSets[i], 0, nullptr);
+		vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(LevelSizes), &sizes);
+
+		vkCmdDispatch(cmdBuf, (sizes.m_nDstWidth + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE, (sizes.m_nDstHeight + DEPTH_PYRAMID_GROUP_SIZE - 1) / DEPTH_PYRAMID_GROUP_SIZE, 1);
+
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		sizes.m_nSrcWidth = sizes.m_nDstWidth;
+		sizes.m_nSrcHeight = sizes.m_nDstHeight;
+		sizes.m_nDstWidth = std::max(sizes.m_nDstWidth / 2, 1);
+		sizes.m_nDstHeight = std::max(sizes.m_nDstHeight / 2, 1);
+	}
+
+	return bRecreated;
+}
+
+void DepthPyramid::ReleaseDepthTexture()
+{
+	m_depthTexture = nullptr;
+}
+
+VkImageView DepthPyramid::ImageView() const
+{
+	return m_imageView;
+}
+
+VkSampler DepthPyramid::GetSampler() const
+{
+	return m_sampler;
+}
+
+uint32_t DepthPyramid::LevelCount() const
+{
+	return static_cast<uint32_t>(m_levelViews.size());
+}
+
+void DepthPyramid::BuildSize(uint32_t& nOutWidth, uint32_t& nOutHeight) const
+{
+	nOutWidth = m_nBuildWidth;
+	nOutHeight = m_nBuildHeight;
+}
+
+inline void DepthPyramid::CreatePipeline()
+{
+	VkDevice device = m_renderer->GetDevice();
+
+	m_shaderModule = RendererHelper::CreateShaderModule(device, DEPTH_PYRAMID_SHADER_PATH);
+
+	if (!m_shaderModule)
+	{
+		std::cout << "Depth Pyramid Warning: Failed to open downsampling shader file at: " << DEPTH_PYRAMID_SHADER_PATH << ", occlusion culling is unavailable." << std::endl;
+		return;
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Set layout
+
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+
+	// Source depth.
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[0].pImmutableSamplers = nullptr;
+
+	// Destination level.
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].pImmutableSamplers = nullptr;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.flags = 0;
+	layoutInfo.bindingCount = 2;
+	layoutInfo.pBindings = bindings;
+	layoutInfo.pNext = nullptr;
+
+	RENDERER_SAFECALL(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_setLayout), "Depth Pyramid Error: Failed to create downsampling set layout.");
+
+	// ---------------------------------------------------------------------------------
+	// Pipeline
+
+	VkPushConstantRange pushRange = {};
+	pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushRange.offset = 0;
+	pushRange.size = sizeof(LevelSizes);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &m_setLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+
+	RENDERER_SAFECALL(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout), "Depth Pyramid Error: Failed to create downsampling pipeline layout.");
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = m_shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = m_pipelineLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	m_renderer->GetPipelineCache()->CreateComputePipelines(&pipelineInfo, 1, &m_pipeline);
+
+	// ---------------------------------------------------------------------------------
+	// Sampler
+
+	// Texels are fetched at explicit levels, filtering would blend depths of neighbouring areas.
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.0f;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+	RENDERER_SAFECALL(vkCreateSampler(device, &samplerInfo, nullptr, &m_sampler), "Depth Pyramid Error: Failed to create sampler.");
+}
+
+inline void DepthPyramid::CreateImage(Texture* depthTexture)
+{
+	VkDevice device = m_renderer->GetDevice();
+
+	m_depthTexture = depthTexture;
+	m_nDepthWidth = static_cast<uint32_t>(depthTexture->GetWidth());
+	m_nDepthHeight = static_cast<uint32_t>(depthTexture->GetHeight());
+
+	m_nWidth = std::max(m_nDepthWidth / 2, 1u);
+	m_nHeight = std::max(m_nDepthHeight / 2, 1u);
+
+	// Halve down to a single texel.
+	uint32_t nLevelCount = 1;
+	while ((std::max(m_nWidth, m_nHeight) >> nLevelCount) > 0)
+		++nLevelCount;
+
+	// ---------------------------------------------------------------------------------
+	// Image
+
+	VkImageCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	createInfo.imageType = VK_IMAGE_TYPE_2D;
+	createInfo.extent = { m_nWidth, m_nHeight, 1 };
+	createInfo.mipLevels = nLevelCount;
+	createInfo.arrayLayers = 1;
+	createInfo.format = VK_FORMAT_R32_SFLOAT;
+	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	createInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	createInfo.flags = 0;
+
+	RENDERER_SAFECALL(vkCreateImage(device, &createInfo, nullptr, &m_image), "Depth Pyramid Error: Failed to create pyramid image.");
+	m_renderer->AllocateImageMemory(m_image, VK_IMAGE_TILING_OPTIMAL, m_imageMemory);
+
+	// ---------------------------------------------------------------------------------
+	// Views
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = m_image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = VK_FORMAT_R32_SFLOAT;
+	viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, nLevelCount, 0, 1 };
+
+	RENDERER_SAFECALL(vkCreateImageView(device, &viewInfo, nullptr, &m_imageView), "Depth Pyramid Error: Failed to create pyramid image view.");
+
+	m_levelViews.resize(nLevelCount);
+
+	for (uint32_t i = 0; i < nLevelCount; ++i)
+	{
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+
+		RENDERER_SAFECALL(vkCreateImageView(device, &viewInfo, nullptr, &m_levelViews[i]), "Depth Pyramid Error: Failed to create pyramid level view.");
+	}
+
+	// Samplers can't read depth & stencil aspects at once.
+	m_renderer->CreateImageView(depthTexture->ImageHandle(), m_depthView, depthTexture->Format(), VK_IMAGE_ASPECT_DEPTH_BIT);
+
+	// ---------------------------------------------------------------------------------
+	// Descriptors
+
+	VkDescriptorPoolSize poolSizes[2] = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[0].descriptorCount = nLevelCount;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[1].descriptorCount = nLevelCount;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = nLevelCount;
+	poolCreateInfo.poolSizeCount = 2;
+	poolCreateInfo.pPoolSizes = poolSizes;
+	poolCreateInfo.flags = 0;
+	poolCreateInfo.pNext = nullptr;
+
+	RENDERER_SAFECALL(vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &m_descPool), "Depth Pyramid Error: Failed to create descriptor pool.");
+
+	std::vector<VkDescriptorSetLayout> setLayouts(nLevelCount, m_setLayout);
+	m_levelSets.resize(nLevelCount);
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_descPool;
+	allocInfo.descriptorSetCount = nLevelCount;
+	allocInfo.pSetLayouts = setLayouts.data();
+	allocInfo.pNext = nullptr;
+
+	RENDERER_SAFECALL(vkAllocateDescriptorSets(device, &allocInfo, m_levelSets.data()), "Depth Pyramid Error: Failed to allocate descriptor sets.");
+
+	for (uint32_t i = 0; i < nLevelCount; ++i)
+	{
+		// The first level reads the depth attachment, every other level the level before it.
+		VkDescriptorImageInfo srcInfo = {};
+		srcInfo.sampler = m_sampler;
+		srcInfo.imageView = i == 0 ? m_depthView : m_levelViews[i - 1];
+		srcInfo.imageLayout = i == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo dstInfo = {};
+		dstInfo.sampler = VK_NULL_HANDLE;
+		dstInfo.imageView = m_levelViews[i];
+		dstInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet writes[2] = {};
+
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = m_levelSets[i];
+		writes[0].dstBinding = 0;
+		writes[0].dstArrayElement = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &srcInfo;
+
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = m_levelSets[i];
+		writes[1].dstBinding = 1;
+		writes[1].dstArrayElement = 0;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &dstInfo;
+
+		vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+	}
+}
+
+inline void DepthPyramid::DestroyImage()
+{
+	if (!m_image)
+		return;
+
+	VkDevice device = m_renderer->GetDevice();
+
+	vkDestroyDescriptorPool(device, m_descPool, nullptr);
+	m_descPool = VK_NULL_HANDLE;
+	m_levelSets.clear();
+
+	for (uint32_t i = 0; i < m_levelViews.size(); ++i)
+		vkDestroyImageView(device, m_levelViews[i], nullptr);
+
+	m_levelViews.clear();
+
+	vkDestroyImageView(device, m_imageView, nullptr);
+	vkDestroyImageView(device, m_depthView, nullptr);
+	vkDestroyImage(device, m_image, nullptr);
+	m_renderer->FreeMemory(m_imageMemory);
+
+	m_imageView = VK_NULL_HANDLE;
+	m_depthView = VK_NULL_HANDLE;
+	m_image = VK_NULL_HANDLE;
+	m_depthTexture = nullptr;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "Renderer.h"
+
+/*
+Description: Hierarchical depth (Hi-Z) pyramid of a depth attachment. Each level stores the furthest depth of the texels it covers, so a screen space rectangle
+             can be tested for occlusion with four texel reads at the level matching its size. Built from the rendered area of the depth attachment with a compute shader, one dispatch per level.
+Author: Nic Van Zuylen
+*/
+
+class Texture;
+
+#define DEPTH_PYRAMID_SHADER_PATH "Shaders/SPIR-V/depth_pyramid_comp.spv"
+
+// Must match the local size of the downsampling shader.
+#define DEPTH_PYRAMID_GROUP_SIZE 8
+
+class DepthPyramid
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer, the pyramid is built on its graphics queue.
+	*/
+	DepthPyramid(Renderer* renderer);
+
+	~DepthPyramid();
+
+	/*
+	Description: Get whether or not the downsampling shader was loaded, the pyramid can't be built without it.
+	Return Type: bool
+	*/
+	bool IsAvailable() const;
+
+	/*
+	Description: Record the build of the pyramid from the rendered area of a depth attachment, which must be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+	             Compute shaders may sample the pyramid in VK_IMAGE_LAYOUT_GENERAL directly after. The pyramid is re-created when the depth attachment changes, waiting for the device to be idle.
+	Return Type: bool
+	Param:
+	    VkCommandBuffer cmdBuf: The command buffer to record to.
+		Texture* depthTexture: The depth attachment, its first level is half the attachment's size.
+		uint32_t nRenderWidth: Width of the rendered area of the depth attachment.
+		uint32_t nRenderHeight: Height of the rendered area of the depth attachment.
+	*/
+	bool Build(VkCommandBuffer cmdBuf, Texture* depthTexture, uint32_t nRenderWidth, uint32_t nRenderHeight);
+
+	/*
+	Description: Forget the depth attachment of the last build once it is destroyed, so the next build re-creates the pyramid even if a new attachment is allocated at the same address.
+	*/
+	void ReleaseDepthTexture();
+
+	/*
+	Description: Get the view of all levels of the pyramid, VK_NULL_HANDLE before the first build.
+	Return Type: VkImageView
+	*/
+	VkImageView ImageView() const;
+
+	/*
+	Description: Get the nearest, clamped sampler to read the pyramid with.
+	Return Type: VkSampler
+	*/
+	VkSampler GetSampler() const;
+
+	uint32_t LevelCount() const;
+
+	/*
+	Description: Get the size of the area of the first level covering the rendered area of the last build. Each following level covers half the size, rounded down.
+	Param:
+	    uint32_t& nOutWidth: Width of the area.
+		uint32_t& nOutHeight: Height of the area.
+	*/
+	void BuildSize(uint32_t& nOutWidth, uint32_t& nOutHeight) const;
+
+private:
+
+	// Push constants of the downsampling shader.
+	struct LevelSizes
+	{
+		int32_t m_nSrcWidth;
+		int32_t m_nSrcHeight;
+		int32_t m_nDstWidth;
+		int32_t m_nDstHeight;
+	};
+
+	// ---------------------------------------------------------------------------------
+	// Constructor extensions
+
+	inline void CreatePipeline();
+
+	// ---------------------------------------------------------------------------------
+	// Private runtime functions
+
+	// Create the pyramid image, views & descriptor sets for the provided depth attachment.
+	inline void CreateImage(Texture* depthTexture);
+
+	inline void DestroyImage();
+
+	Renderer* m_renderer;
+
+	VkShaderModule m_shaderModule;
+	VkDescriptorSetLayout m_setLayout;
+	VkPipelineLayout m_pipelineLayout;
+	VkPipeline m_pipeline;
+	VkSampler m_sampler;
+
+	// ---------------------------------------------------------------------------------
+	// Pyramid
+
+	Texture* m_depthTexture; // Depth attachment the pyramid was created for.
+	uint32_t m_nDepthWidth;
+	uint32_t m_nDepthHeight;
+	VkImageView m_depthView; // Depth aspect only, for sampling.
+
+	VkImage m_image;
+	MemAllocation m_imageMemory;
+	VkImageView m_imageView;
+	std::vector<VkImageView> m_levelViews;
+	uint32_t m_nWidth;
+	uint32_t m_nHeight;
+
+	VkDescriptorPool m_descPool;
+	std::vector<VkDescriptorSet> m_levelSets; // Reads the depth attachment or previous level & writes the level.
+
+	uint32_t m_nBuildWidth;
+	uint32_t m_nBuildHeight;
+};
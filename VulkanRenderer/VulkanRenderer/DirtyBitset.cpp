@@ -0,0 +1,167 @@
+#include "DirtyBitset.h"
+
+#include <algorithm>
+
+#define DIRTY_BITSET_WORD_BITS 64u
+
+DirtyBitset::DirtyBitset()
+{
+	m_nCount = 0;
+	m_nFirstWord = UINT32_MAX;
+	m_nLastWord = 0;
+}
+
+DirtyBitset::~DirtyBitset()
+{
+
+}
+
+void DirtyBitset::Resize(uint32_t nCount)
+{
+	uint32_t nWordCount = (nCount + DIRTY_BITSET_WORD_BITS - 1) / DIRTY_BITSET_WORD_BITS;
+
+	m_words.resize(nWordCount, 0);
+	m_nCount = nCount;
+
+	// Clear marks of elements past the end sharing the last word, so growing again leaves them unmarked.
+	if (nCount % DIRTY_BITSET_WORD_BITS != 0)
+		m_words.back() &= (1ull << (nCount % DIRTY_BITSET_WORD_BITS)) - 1;
+
+	if (nWordCount == 0 || m_nFirstWord >= nWordCount)
+	{
+		m_nFirstWord = UINT32_MAX;
+		m_nLastWord = 0;
+	}
+	else
+		m_nLastWord = std::min(m_nLastWord, nWordCount - 1);
+}
+
+void DirtyBitset::Mark(uint32_t nIndex)
+{
+	uint32_t nWord = nIndex / DIRTY_BITSET_WORD_BITS;
+
+	m_words[nWord] |= 1ull << (nIndex % DIRTY_BITSET_WORD_BITS);
+
+	m_nFirstWord = std::min(m_nFirstWord, nWord);
+	m_nLastWord = std::max(m_nLastWord, nWord);
+}
+
+void DirtyBitset::MarkRange(uint32_t nStart, uint32_t nEnd)
+{
+	nEnd = std::min(nEnd, m_nCount);
+
+	if (nStart >= nEnd)
+		return;
+
+	uint32_t nFirstWord = nStart / DIRTY_BITSET_WORD_BITS;
+	uint32_t nLastWord = (nEnd - 1) / DIRTY_BITSET_WORD_BITS;
+
+	for (uint32_t i = nFirstWord; i <= nLastWord; ++i)
+	{
+		// Bits of the range within this word.
+		uint32_t nLow = i == nFirstWord ? nStart % DIRTY_BITSET_WORD_BITS : 0;
+		uint32_t nHigh = i == nLastWord ? (nEnd - 1) % DIRTY_BITSET_WORD_BITS : DIRTY_BITSET_WORD_BITS - 1;
+
+		uint64_t nMask = (~0ull >> (DIRTY_BITSET_WORD_BITS - 1 - nHigh)) & (~0ull << nLow);
+		m_words[i] |= nMask;
+	}
+
+	m_nFirstWord = std::min(m_nFirstWord, nFirstWord);
+	m_nLastWord = std::max(m_nLastWord, nLastWord);
+}
+
+bool DirtyBitset::IsMarked(uint32_t nIndex) const
+{
+	return (m_words[nIndex / DIRTY_BITSET_WORD_BITS] >> (nIndex % DIRTY_BITSET_WORD_BITS)) & 1ull;
+}
+
+bool DirtyBitset::Any() const
+{
+	return m_nFirstWord <= m_nLastWord;
+}
+
+void DirtyBitset::TakeRanges(uint32_t nEnd, uint32_t nMergeGap, std::vector<DirtyRange>& outRanges)
+{
+	outRanges.clear();
+
+	if (!Any())
+		return;
+
+	nEnd = std::min(nEnd, m_nCount);
+
+	DirtyRange range = {};
+	bool bInRange = false;
+
+	// Append the current range, merging it into the previous range if the gap between them is small enough.
+	auto closeRange = [&](uint32_t nRangeEnd)
+	{
+		range.m_nEnd = nRangeEnd;
+		bInRange = false;
+
+		if (!outRanges.empty() && range.m_nStart - outRanges.back().m_nEnd <= nMergeGap)
+			outRanges.back().m_nEnd = range.m_nEnd;
+		else
+			outRanges.push_back(range);
+	};
+
+	for (uint32_t i = m_nFirstWord; i <= m_nLastWord; ++i)
+	{
+		uint64_t nWord = m_words[i];
+		m_words[i] = 0;
+
+		uint32_t nBase = i * DIRTY_BITSET_WORD_BITS;
+
+		if (nBase >= nEnd)
+			continue;
+
+		// Whole words are skipped or taken at once, only words mixing marked & unmarked bits are walked.
+		if (nWord == 0)
+		{
+			if (bInRange)
+				closeRange(nBase);
+
+			continue;
+		}
+
+		if (nWord == ~0ull && nBase + DIRTY_BITSET_WORD_BITS <= nEnd)
+		{
+			if (!bInRange)
+			{
+				range.m_nStart = nBase;
+				bInRange = true;
+			}
+
+			continue;
+		}
+
+		uint32_t nBitCount = std::min(DIRTY_BITSET_WORD_BITS, nEnd - nBase);
+
+		for (uint32_t b = 0; b < nBitCount; ++b)
+		{
+			bool bMarked = (nWord >> b) & 1ull;
+
+			if (bMarked && !bInRange)
+			{
+				range.m_nStart = nBase + b;
+				bInRange = true;
+			}
+			else if (!bMarked && bInRange)
+				closeRange(nBase + b);
+		}
+	}
+
+	if (bInRange)
+		closeRange(std::min((m_nLastWord + 1) * DIRTY_BITSET_WORD_BITS, nEnd));
+
+	m_nFirstWord = UINT32_MAX;
+	m_nLastWord = 0;
+}
+
+void DirtyBitset::Clear()
+{
+	for (uint32_t i = m_nFirstWord; i <= m_nLastWord && i < m_words.size(); ++i)
+		m_words[i] = 0;
+
+	m_nFirstWord = UINT32_MAX;
+	m_nLastWord = 0;
+}
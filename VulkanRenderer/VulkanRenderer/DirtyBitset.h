@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+/*
+Description: A bit per element marking elements modified since they were last consumed, such as instances yet to be uploaded.
+             Marked bits are coalesced into ranges when taken, & only the span of words holding marks is scanned or cleared.
+Author: Nic Van Zuylen
+*/
+
+// A run of marked elements, from the start up to but not including the end.
+struct DirtyRange
+{
+	uint32_t m_nStart;
+	uint32_t m_nEnd;
+};
+
+class DirtyBitset
+{
+public:
+
+	DirtyBitset();
+
+	~DirtyBitset();
+
+	/*
+	Description: Resize the bitset, keeping the marks of elements within the new size. New elements are unmarked.
+	Param:
+	    uint32_t nCount: Amount of elements.
+	*/
+	void Resize(uint32_t nCount);
+
+	/*
+	Description: Mark a single element.
+	Param:
+	    uint32_t nIndex: Index of the element.
+	*/
+	void Mark(uint32_t nIndex);
+
+	/*
+	Description: Mark a range of elements.
+	Param:
+	    uint32_t nStart: Index of the first element.
+		uint32_t nEnd: End of the range, clamped to the size of the bitset.
+	*/
+	void MarkRange(uint32_t nStart, uint32_t nEnd);
+
+	/*
+	Description: Get whether or not an element is marked.
+	Return Type: bool
+	Param:
+	    uint32_t nIndex: Index of the element.
+	*/
+	bool IsMarked(uint32_t nIndex) const;
+
+	/*
+	Description: Get whether or not any element is marked.
+	Return Type: bool
+	*/
+	bool Any() const;
+
+	/*
+	Description: Gather the marked elements into ranges & clear all marks.
+	Param:
+	    uint32_t nEnd: Marks at or beyond this index are cleared without being gathered.
+		uint32_t nMergeGap: Ranges separated by this many unmarked elements or fewer are merged into one.
+		std::vector<DirtyRange>& outRanges: Cleared & filled with the ranges, in ascending order.
+	*/
+	void TakeRanges(uint32_t nEnd, uint32_t nMergeGap, std::vector<DirtyRange>& outRanges);
+
+	/*
+	Description: Clear all marks.
+	*/
+	void Clear();
+
+private:
+
+	std::vector<uint64_t> m_words;
+	uint32_t m_nCount;
+
+	// Span of words which may hold marks, empty when the first is beyond the last.
+	uint32_t m_nFirstWord;
+	uint32_t m_nLastWord;
+};
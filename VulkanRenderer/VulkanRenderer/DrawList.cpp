@@ -0,0 +1,326 @@
+#include "DrawList.h"
+#include "Material.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ---------------------------------------------------------------------------------
+// Stats
+
+void DrawListStats::Add(const DrawListStats& other)
+{
+	m_nPipelineBinds += other.m_nPipelineBinds;
+	m_nDescriptorBinds += other.m_nDescriptorBinds;
+	m_nVertexBufferBinds += other.m_nVertexBufferBinds;
+	m_nIndexBufferBinds += other.m_nIndexBufferBinds;
+	m_nSkippedBinds += other.m_nSkippedBinds;
+}
+
+// ---------------------------------------------------------------------------------
+// Draw list
+
+DrawList::DrawList(Renderer* renderer)
+{
+	m_renderer = renderer;
+	m_bMultiDraw = false;
+
+	// Created on the first build of each frame with direct draws, sized to its commands.
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		m_commandBuffers[i] = VK_NULL_HANDLE;
+		m_nCommandCapacities[i] = 0;
+	}
+}
+
+DrawList::~DrawList()
+{
+	m_renderer->WaitGraphicsIdle();
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		if (!m_commandBuffers[i])
+			continue;
+
+		vkDestroyBuffer(m_renderer->GetDevice(), m_commandBuffers[i], nullptr);
+		m_renderer->FreeMemory(m_commandMemories[i]);
+	}
+}
+
+void DrawList::Clear()
+{
+	m_records.clear();
+	m_keys.clear();
+	m_batches.clear();
+	m_commands.clear();
+}
+
+void DrawList::Add(uint64_t nKey, const DrawRecord& record)
+{
+	m_keys.push_back({ nKey, static_cast<uint32_t>(m_records.size()) });
+	m_records.push_back(record);
+}
+
+void DrawList::Build(const uint32_t& nFrameIndex)
+{
+	m_bMultiDraw = m_renderer->MultiDrawIndirectSupported();
+
+	Sort();
+	Batch();
+
+	// Without multi-draw indirect direct draws are recorded from the commands on the CPU.
+	if (!m_bMultiDraw || m_commands.empty())
+		return;
+
+	// Grow this frame's command buffer to fit, the frame's previous GPU work is complete so it is no longer in use.
+	uint32_t nCommandCount = static_cast<uint32_t>(m_commands.size());
+	uint32_t& nCapacity = m_nCommandCapacities[nFrameIndex];
+
+	if (!m_commandBuffers[nFrameIndex] || nCommandCount > nCapacity)
+	{
+		if (m_commandBuffers[nFrameIndex])
+		{
+			vkDestroyBuffer(m_renderer->GetDevice(), m_commandBuffers[nFrameIndex], nullptr);
+			m_renderer->FreeMemory(m_commandMemories[nFrameIndex]);
+		}
+
+		nCapacity = std::max(std::max(nCommandCount, nCapacity * 2), DRAW_LIST_MIN_COMMAND_CAPACITY);
+
+		m_renderer->CreateBuffer(static_cast<VkDeviceSize>(nCapacity) * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			m_renderer->GetUploadArena()->PerFrameMemoryFlags(), m_commandBuffers[nFrameIndex], m_commandMemories[nFrameIndex]);
+	}
+
+	m_renderer->GetUploadArena()->Write(m_commandBuffers[nFrameIndex], m_commandMemories[nFrameIndex], 0, m_commands.data(), nCommandCount * sizeof(VkDrawIndexedIndirectCommand), true);
+}
+
+inline void DrawList::Sort()
+{
+	uint32_t nCount = static_cast<uint32_t>(m_keys.size());
+
+	if (nCount < 2)
+		return;
+
+	m_sortScratch.resize(nCount);
+
+	// Histograms of every 8-bit digit, from a single pass over the keys.
+	uint32_t nHistograms[sizeof(uint64_t)][256];
+	std::memset(nHistograms, 0, sizeof(nHistograms));
+
+	for (const DrawKey& key : m_keys)
+	{
+		for (uint32_t d = 0; d < sizeof(uint64_t); ++d)
+			++nHistograms[d][(key.m_nKey >> (d * 8)) & 0xFF];
+	}
+
+	DrawKey* src = m_keys.data();
+	DrawKey* dst = m_sortScratch.data();
+
+	// Least significant digit first, each pass is stable so earlier passes order keys sharing the later digits.
+	for (uint32_t d = 0; d < sizeof(uint64_t); ++d)
+	{
+		uint32_t* nOffsets = nHistograms[d];
+		uint32_t nShift = d * 8;
+
+		// Every key shares this digit, so the pass wouldn't move anything. Most keys leave high ID bits & some depth bits unused.
+		if (nOffsets[(src[0].m_nKey >> nShift) & 0xFF] == nCount)
+			continue;
+
+		uint32_t nOffset = 0;
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t nDigitCount = nOffsets[i];
+			nOffsets[i] = nOffset;
+			nOffset += nDigitCount;
+		}
+
+		for (uint32_t i = 0; i < nCount; ++i)
+			dst[nOffsets[(src[i].m_nKey >> nShift) & 0xFF]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if (src != m_keys.data())
+		m_keys.swap(m_sortScratch);
+}
+
+inline void DrawList::Batch()
+{
+	m_batches.clear();
+	m_commands.clear();
+
+	for (uint32_t i = 0; i < m_keys.size(); ++i)
+	{
+		const DrawRecord& draw = m_records[m_keys[i].m_nRecord];
+
+		if (!m_batches.empty())
+		{
+			DrawBatch& batch = m_batches.back();
+
+			if (batch.m_nDrawCount < DRAW_LIST_MAX_BATCH_DRAWS && CanMerge(m_records[m_keys[i - 1].m_nRecord], draw))
+			{
+				if (!draw.m_indirectBuffer)
+					m_commands.push_back(draw.m_command);
+
+				++batch.m_nDrawCount;
+				continue;
+			}
+		}
+
+		DrawBatch batch = { i, 1, draw.m_nIndirectOffset };
+
+		if (!draw.m_indirectBuffer)
+		{
+			batch.m_nCommandOffset = m_commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+			m_commands.push_back(draw.m_command);
+		}
+
+		m_batches.push_back(batch);
+	}
+}
+
+bool DrawList::CanMerge(const DrawRecord& last, const DrawRecord& draw)
+{
+	if (draw.m_pipeline != last.m_pipeline || draw.m_layout != last.m_layout || draw.m_material != last.m_material)
+		return false;
+
+	if (draw.m_vertexBuffer != last.m_vertexBuffer || draw.m_indexBuffer != last.m_indexBuffer || draw.m_instanceBuffer != last.m_instanceBuffer || draw.m_nInstanceOffset != last.m_nInstanceOffset)
+		return false;
+
+	// Direct draws' commands are gathered in order, indirect draws must already be consecutive in the same buffer.
+	if (!draw.m_indirectBuffer)
+		return !last.m_indirectBuffer;
+
+	return draw.m_indirectBuffer == last.m_indirectBuffer && draw.m_nIndirectOffset == last.m_nIndirectOffset + sizeof(VkDrawIndexedIndirectCommand);
+}
+
+void DrawList::Record(VkCommandBuffer cmdBuffer, uint32_t nStart, uint32_t nEnd, VkDescriptorSet mvpUBOSet, const uint32_t& nFrameIndex, DrawListStats& outStats) const
+{
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+	Material* boundMaterial = nullptr;
+	VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+	VkBuffer boundInstanceBuffer = VK_NULL_HANDLE;
+	VkDeviceSize nBoundInstanceOffset = 0;
+
+	for (uint32_t i = nStart; i < nEnd; ++i)
+	{
+		const DrawBatch& batch = m_batches[i];
+		const DrawRecord& draw = m_records[m_keys[batch.m_nFirstDraw].m_nRecord];
+
+		// Every draw after the first shares all of the batch's binds.
+		outStats.m_nSkippedBinds += (batch.m_nDrawCount - 1) * 4;
+
+		if (draw.m_pipeline != boundPipeline)
+		{
+			vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.m_pipeline);
+
+			boundPipeline = draw.m_pipeline;
+			++outStats.m_nPipelineBinds;
+		}
+		else
+			++outStats.m_nSkippedBinds;
+
+		// Early & late pipelines of an object share a layout, other pipelines rebind even if their layouts are compatible.
+		if (draw.m_material != boundMaterial || draw.m_layout != boundLayout)
+		{
+			VkPipelineLayout layout = draw.m_layout;
+			draw.m_material->UseDescriptorSet(cmdBuffer, layout, mvpUBOSet, nFrameIndex);
+
+			boundMaterial = draw.m_material;
+			boundLayout = draw.m_layout;
+			++outStats.m_nDescriptorBinds;
+		}
+		else
+			++outStats.m_nSkippedBinds;
+
+		if (draw.m_vertexBuffer != boundVertexBuffer)
+		{
+			// Bind the geometry pool block's vertices, along with the instance buffer.
+			VkBuffer vertBuffers[] = { draw.m_vertexBuffer, draw.m_instanceBuffer };
+			VkDeviceSize offsets[] = { 0, draw.m_nInstanceOffset };
+
+			vkCmdBindVertexBuffers(cmdBuffer, 0, 2, vertBuffers, offsets);
+
+			boundVertexBuffer = draw.m_vertexBuffer;
+			boundInstanceBuffer = draw.m_instanceBuffer;
+			nBoundInstanceOffset = draw.m_nInstanceOffset;
+			++outStats.m_nVertexBufferBinds;
+		}
+		else if (draw.m_instanceBuffer != boundInstanceBuffer || draw.m_nInstanceOffset != nBoundInstanceOffset)
+		{
+			// Same vertices, only the instance buffer moved.
+			vkCmdBindVertexBuffers(cmdBuffer, 1, 1, &draw.m_instanceBuffer, &draw.m_nInstanceOffset);
+
+			boundInstanceBuffer = draw.m_instanceBuffer;
+			nBoundInstanceOffset = draw.m_nInstanceOffset;
+			++outStats.m_nVertexBufferBinds;
+		}
+		else
+			++outStats.m_nSkippedBinds;
+
+		if (draw.m_indexBuffer != boundIndexBuffer)
+		{
+			vkCmdBindIndexBuffer(cmdBuffer, draw.m_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+			boundIndexBuffer = draw.m_indexBuffer;
+			++outStats.m_nIndexBufferBinds;
+		}
+		else
+			++outStats.m_nSkippedBinds;
+
+		VkBuffer indirectBuffer = draw.m_indirectBuffer ? draw.m_indirectBuffer : m_commandBuffers[nFrameIndex];
+
+		if (m_bMultiDraw)
+		{
+			vkCmdDrawIndexedIndirect(cmdBuffer, indirectBuffer, batch.m_nCommandOffset, batch.m_nDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+			continue;
+		}
+
+		// Without multi-draw indirect each draw of the batch is its own command.
+		for (uint32_t j = 0; j < batch.m_nDrawCount; ++j)
+		{
+			VkDeviceSize nCommandOffset = batch.m_nCommandOffset + j * sizeof(VkDrawIndexedIndirectCommand);
+
+			if (draw.m_indirectBuffer)
+				vkCmdDrawIndexedIndirect(cmdBuffer, indirectBuffer, nCommandOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+			else
+			{
+				const VkDrawIndexedIndirectCommand& command = m_commands[nCommandOffset / sizeof(VkDrawIndexedIndirectCommand)];
+				vkCmdDrawIndexed(cmdBuffer, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+			}
+		}
+	}
+}
+
+uint32_t DrawList::Count() const
+{
+	return static_cast<uint32_t>(m_keys.size());
+}
+
+uint32_t DrawList::BatchCount() const
+{
+	return static_cast<uint32_t>(m_batches.size());
+}
+
+uint32_t DrawList::DrawCallCount() const
+{
+	return m_bMultiDraw ? BatchCount() : Count();
+}
+
+uint64_t DrawList::MakeKey(uint32_t nPipelineID, uint32_t nMaterialID, float fDistance, uint32_t nMeshID, uint32_t nSubDraw)
+{
+	// The bits of a non-negative float order the same as its value, so the top bits of the distance are a logarithmic depth bucket.
+	uint32_t nDistanceBits;
+	fDistance = std::max(fDistance, 0.0f);
+	std::memcpy(&nDistanceBits, &fDistance, sizeof(uint32_t));
+
+	uint64_t nDepth = nDistanceBits >> (32 - DRAW_KEY_DEPTH_BITS - 1); // Skip the sign bit, which is always clear.
+
+	uint64_t nKey = nPipelineID & ((1u << DRAW_KEY_PIPELINE_BITS) - 1);
+	nKey = (nKey << DRAW_KEY_MATERIAL_BITS) | (nMaterialID & ((1u << DRAW_KEY_MATERIAL_BITS) - 1));
+	nKey = (nKey << DRAW_KEY_DEPTH_BITS) | nDepth;
+	nKey = (nKey << DRAW_KEY_MESH_BITS) | (nMeshID & ((1u << DRAW_KEY_MESH_BITS) - 1));
+	nKey = (nKey << DRAW_KEY_SUBDRAW_BITS) | (nSubDraw & ((1u << DRAW_KEY_SUBDRAW_BITS) - 1));
+
+	return nKey;
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include "MemoryAllocator.h"
+#include "Renderer.h"
+
+/*
+Description: Flat list of draw records built each frame, sorted by 64-bit keys & replayed into command buffers. Keys order draws by pipeline, material,
+             distance & mesh, so replaying the sorted list binds each piece of state once per run of draws sharing it, drawing front to back within a material.
+             Runs of draws sharing all state are merged into batches, each drawn by a single multi-draw indirect command when supported.
+             Binds redundant with the state already bound are skipped & counted.
+Author: Nic Van Zuylen
+*/
+
+class Material;
+
+// Bits of each sort key field, from the most to the least significant.
+#define DRAW_KEY_PIPELINE_BITS 12
+#define DRAW_KEY_MATERIAL_BITS 12
+#define DRAW_KEY_DEPTH_BITS 16
+#define DRAW_KEY_MESH_BITS 16
+#define DRAW_KEY_SUBDRAW_BITS 8
+
+// Most draws merged into a single batch, within the guaranteed maxDrawIndirectCount of devices supporting multi-draw indirect.
+#define DRAW_LIST_MAX_BATCH_DRAWS 65535u
+
+// Smallest capacity in commands of the per-frame command buffers, which grow to fit the direct draws.
+#define DRAW_LIST_MIN_COMMAND_CAPACITY 256u
+
+// A single draw & the state it is drawn with.
+struct DrawRecord
+{
+	VkPipeline m_pipeline;
+	VkPipelineLayout m_layout;
+	Material* m_material;
+
+	VkBuffer m_vertexBuffer;
+	VkBuffer m_indexBuffer;
+	VkBuffer m_instanceBuffer;
+	VkDeviceSize m_nInstanceOffset; // Offset in bytes of the instance buffer binding.
+
+	VkBuffer m_indirectBuffer; // If not null the draw is indirect, reading its command from the buffer instead.
+	VkDeviceSize m_nIndirectOffset;
+
+	VkDrawIndexedIndirectCommand m_command; // Counts & offsets of direct draws.
+};
+
+// Binds issued while recording a range of a draw list, & binds skipped as redundant with the state already bound.
+struct DrawListStats
+{
+	uint32_t m_nPipelineBinds;
+	uint32_t m_nDescriptorBinds;
+	uint32_t m_nVertexBufferBinds;
+	uint32_t m_nIndexBufferBinds;
+	uint32_t m_nSkippedBinds;
+
+	void Add(const DrawListStats& other);
+};
+
+class DrawList
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer, whose upload arena writes the commands of direct draws.
+	*/
+	DrawList(Renderer* renderer);
+
+	~DrawList();
+
+	/*
+	Description: Remove all draws, keeping allocations for the next frame.
+	*/
+	void Clear();
+
+	/*
+	Description: Add a draw to the list.
+	Param:
+	    uint64_t nKey: Sort key of the draw, from MakeKey().
+		const DrawRecord& record: The draw.
+	*/
+	void Add(uint64_t nKey, const DrawRecord& record);
+
+	/*
+	Description: Sort the draws by key, merge runs of draws sharing all state into batches & write the commands of direct draws to the frame's command buffer.
+	             Must be called on the main thread, since the upload arena is not thread safe.
+	Param:
+	    const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+	*/
+	void Build(const uint32_t& nFrameIndex);
+
+	/*
+	Description: Record a range of the batches, binding pipelines, descriptor sets, vertex & index buffers only when they differ from the bound state.
+	             Nothing is assumed bound at the start of the range, so ranges may be recorded to separate command buffers.
+	Param:
+	    VkCommandBuffer cmdBuffer: The command buffer to record to.
+		uint32_t nStart: Index of the first batch to record.
+		uint32_t nEnd: End of the range.
+		VkDescriptorSet mvpUBOSet: The MVP matrix UBO descriptor set of the frame, bound alongside each material's descriptor set.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+		DrawListStats& outStats: Binds of the range are added to these stats.
+	*/
+	void Record(VkCommandBuffer cmdBuffer, uint32_t nStart, uint32_t nEnd, VkDescriptorSet mvpUBOSet, const uint32_t& nFrameIndex, DrawListStats& outStats) const;
+
+	/*
+	Description: Get the amount of draws in the list.
+	Return Type: uint32_t
+	*/
+	uint32_t Count() const;
+
+	/*
+	Description: Get the amount of batches of the last build, the items Record() ranges cover.
+	Return Type: uint32_t
+	*/
+	uint32_t BatchCount() const;
+
+	/*
+	Description: Get the amount of draw commands recorded for the last build, one per batch with multi-draw indirect or one per draw without.
+	Return Type: uint32_t
+	*/
+	uint32_t DrawCallCount() const;
+
+	/*
+	Description: Pack the state & distance of a draw into a sort key. IDs are truncated to their field, which only costs extra binds when two collide.
+	Return Type: uint64_t
+	Param:
+	    uint32_t nPipelineID: ID of the draw's pipeline.
+		uint32_t nMaterialID: ID of the draw's material, materials sharing a pipeline each bind their own descriptor set.
+		float fDistance: Distance from the view to the draw's nearest instance, closer draws sort first within a material.
+		uint32_t nMeshID: ID of the draw's mesh.
+		uint32_t nSubDraw: Orders draws of the same object, such as its LODs.
+	*/
+	static uint64_t MakeKey(uint32_t nPipelineID, uint32_t nMaterialID, float fDistance, uint32_t nMeshID, uint32_t nSubDraw);
+
+private:
+
+	struct DrawKey
+	{
+		uint64_t m_nKey;
+		uint32_t m_nRecord; // Index of the record within the unsorted records.
+	};
+
+	// A run of sorted draws sharing all state. Commands are consecutive, in the first draw's indirect buffer or the frame's command buffer for direct draws.
+	struct DrawBatch
+	{
+		uint32_t m_nFirstDraw; // Index of the first sorted draw, whose state the batch is drawn with.
+		uint32_t m_nDrawCount;
+		VkDeviceSize m_nCommandOffset;
+	};
+
+	// Radix sort the keys, draws with equal keys keep the order they were added in.
+	inline void Sort();
+
+	// Merge the sorted draws into batches & gather the commands of direct draws.
+	inline void Batch();
+
+	// Whether or not a draw may follow the last draw of a batch with the same binds & its command directly after the batch's commands.
+	static bool CanMerge(const DrawRecord& last, const DrawRecord& draw);
+
+	Renderer* m_renderer;
+	bool m_bMultiDraw;
+
+	std::vector<DrawRecord> m_records;
+	std::vector<DrawKey> m_keys;
+	std::vector<DrawKey> m_sortScratch;
+	std::vector<DrawBatch> m_batches;
+	std::vector<VkDrawIndexedIndirectCommand> m_commands; // Commands of direct draws, in sorted order.
+
+	VkBuffer m_commandBuffers[MAX_FRAMES_IN_FLIGHT];
+	MemAllocation m_commandMemories[MAX_FRAMES_IN_FLIGHT];
+	uint32_t m_nCommandCapacities[MAX_FRAMES_IN_FLIGHT];
+};
+
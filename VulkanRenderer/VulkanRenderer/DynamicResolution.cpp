@@ -0,0 +1,115 @@
+#include "DynamicResolution.h"
+#include "GPUProfiler.h"
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution::DynamicResolution(GPUProfiler* profiler, float fMinScale, float fMaxScale, double dTargetTime)
+{
+	m_profiler = profiler;
+	m_nProfilerScope = GPU_PROFILER_INVALID_SCOPE;
+	m_nReadbackCount = 0;
+
+	m_fMinScale = fMinScale;
+	m_fMaxScale = fMaxScale;
+	m_fScale = std::min(std::max(1.0f, m_fMinScale), m_fMaxScale);
+	m_dTargetTime = dTargetTime;
+	m_dGPUTime = 0.0;
+	m_nCooldown = 0;
+	m_bEnabled = true;
+}
+
+DynamicResolution::~DynamicResolution()
+{
+
+}
+
+void DynamicResolution::SetProfilerScope(uint32_t nScope)
+{
+	m_nProfilerScope = nScope;
+	m_nReadbackCount = m_profiler->ReadbackCount();
+}
+
+void DynamicResolution::BeginFrame()
+{
+	if (m_nProfilerScope == GPU_PROFILER_INVALID_SCOPE || m_profiler->ReadbackCount() == m_nReadbackCount)
+		return;
+
+	m_nReadbackCount = m_profiler->ReadbackCount();
+
+	// The profiler read back the frame scope of this frame index's previous submission, which may not have recorded it.
+	double dGPUTime = m_profiler->Sample(m_nProfilerScope, 0);
+
+	if (dGPUTime >= 0.0)
+		Update(dGPUTime);
+}
+
+float DynamicResolution::Scale() const
+{
+	return m_fScale;
+}
+
+void DynamicResolution::SetScale(float fScale)
+{
+	m_fScale = std::min(std::max(fScale, m_fMinScale), m_fMaxScale);
+	m_nCooldown = DYNAMIC_RESOLUTION_COOLDOWN_FRAMES;
+}
+
+double DynamicResolution::GPUTime() const
+{
+	return m_dGPUTime;
+}
+
+void DynamicResolution::SetEnabled(bool bEnabled)
+{
+	m_bEnabled = bEnabled;
+}
+
+bool DynamicResolution::IsEnabled() const
+{
+	return m_bEnabled;
+}
+
+bool DynamicResolution::IsSupported() const
+{
+	return m_nProfilerScope != GPU_PROFILER_INVALID_SCOPE;
+}
+
+inline void DynamicResolution::Update(double dGPUTime)
+{
+	// Smooth out single frame spikes, so they don't cause the scale to oscillate.
+	if (m_dGPUTime <= 0.0)
+		m_dGPUTime = dGPUTime;
+	else
+		m_dGPUTime += (dGPUTime - m_dGPUTime) * DYNAMIC_RESOLUTION_SMOOTHING;
+
+	if (!m_bEnabled || m_dGPUTime <= 0.0)
+		return;
+
+	if(m_nCooldown > 0)
+	{
+		--m_nCooldown;
+		return;
+	}
+
+	double dRatio = m_dTargetTime / m_dGPUTime;
+
+	if (std::abs(dRatio - 1.0) <= DYNAMIC_RESOLUTION_TOLERANCE)
+		return;
+
+	// GPU time is roughly proportional to the pixel count, which is proportional to the square of the scale.
+	float fIdealScale = m_fScale * static_cast<float>(std::sqrt(dRatio));
+	float fNewScale = m_fScale + (fIdealScale - m_fScale) * DYNAMIC_RESOLUTION_RATE;
+
+	// Always move at least one step towards the ideal scale, otherwise small corrections would round away.
+	if (std::abs(fNewScale - m_fScale) < DYNAMIC_RESOLUTION_STEP)
+		fNewScale = m_fScale + (fIdealScale > m_fScale ? DYNAMIC_RESOLUTION_STEP : -DYNAMIC_RESOLUTION_STEP);
+
+	fNewScale = std::round(fNewScale / DYNAMIC_RESOLUTION_STEP) * DYNAMIC_RESOLUTION_STEP;
+	fNewScale = std::min(std::max(fNewScale, m_fMinScale), m_fMaxScale);
+
+	if (fNewScale != m_fScale)
+	{
+		m_fScale = fNewScale;
+		m_nCooldown = DYNAMIC_RESOLUTION_COOLDOWN_FRAMES;
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+
+/*
+Description: Dynamic resolution controller. Reads each frame's GPU time from a GPU profiler scope and adjusts the render scale towards a target frame time.
+Author: Nic Van Zuylen
+*/
+
+class GPUProfiler;
+
+// Weight of each new GPU time sample in the smoothed GPU time.
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.1
+
+// Fraction of the target time the smoothed GPU time may differ by before the scale is adjusted.
+#define DYNAMIC_RESOLUTION_TOLERANCE 0.1
+
+// Fraction of the distance to the ideal scale moved in each adjustment.
+#define DYNAMIC_RESOLUTION_RATE 0.25f
+
+// Scales are multiples of this, so a scale of exactly 1.0 is reachable.
+#define DYNAMIC_RESOLUTION_STEP 0.05f
+
+// Frames to wait after an adjustment before adjusting again, for the change to show up in the measured GPU time.
+#define DYNAMIC_RESOLUTION_COOLDOWN_FRAMES 8
+
+class DynamicResolution
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    GPUProfiler* profiler: The profiler the frame's GPU time is measured by.
+		float fMinScale: Lowest render scale.
+		float fMaxScale: Highest render scale.
+		double dTargetTime: GPU frame time in milliseconds to adjust towards.
+	*/
+	DynamicResolution(GPUProfiler* profiler, float fMinScale, float fMaxScale, double dTargetTime);
+
+	~DynamicResolution();
+
+	/*
+	Description: Set the profiler scope covering the whole frame, whose GPU time is adjusted towards the target.
+	Param:
+	    uint32_t nScope: The scope, the scale is never adjusted if it is GPU_PROFILER_INVALID_SCOPE.
+	*/
+	void SetProfilerScope(uint32_t nScope);
+
+	/*
+	Description: Read the GPU time of the frame scope if the profiler has read back a new frame since the last call, & adjust the render scale.
+	             Call once the profiler's BeginFrame() has been recorded for the frame.
+	*/
+	void BeginFrame();
+
+	/*
+	Description: Get the current render scale, relative to the output size.
+	Return Type: float
+	*/
+	float Scale() const;
+
+	/*
+	Description: Set the render scale, clamped to the scale range. Intended for fixed scales while the controller is disabled.
+	Param:
+	    float fScale: The new render scale.
+	*/
+	void SetScale(float fScale);
+
+	/*
+	Description: Get the smoothed GPU frame time in milliseconds, zero if it hasn't been measured.
+	Return Type: double
+	*/
+	double GPUTime() const;
+
+	/*
+	Description: Enable or disable adjustment of the render scale, the GPU time is still measured while disabled.
+	Param:
+	    bool bEnabled: Whether or not to adjust the render scale.
+	*/
+	void SetEnabled(bool bEnabled);
+
+	bool IsEnabled() const;
+
+	/*
+	Description: Get whether or not the frame's GPU time is measured, the scale is never adjusted otherwise.
+	Return Type: bool
+	*/
+	bool IsSupported() const;
+
+private:
+
+	// Update the smoothed GPU time with a new sample & adjust the render scale.
+	inline void Update(double dGPUTime);
+
+	GPUProfiler* m_profiler;
+	uint32_t m_nProfilerScope;
+	uint64_t m_nReadbackCount; // Profiler readback count when the frame time was last read, so each frame is only sampled once.
+
+	float m_fScale;
+	float m_fMinScale;
+	float m_fMaxScale;
+	double m_dTargetTime;
+	double m_dGPUTime;
+	uint32_t m_nCooldown;
+	bool m_bEnabled;
+};
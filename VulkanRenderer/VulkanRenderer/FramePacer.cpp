@@ -0,0 +1,210 @@
+#include "FramePacer.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <mmsystem.h>
+
+#pragma comment(lib, "winmm.lib")
+
+// Not defined by Windows SDKs older than 10.0.17134.
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+#include "Renderer.h"
+#include "CPUProfiler.h"
+
+#include <iostream>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+FramePacer::FramePacer(Renderer* renderer, float fTargetFrameRate)
+{
+	m_renderer = renderer;
+	m_eLatencyMode = FRAME_PACER_LATENCY_DEFAULT;
+	m_bFirstFrame = true;
+	m_timer = nullptr;
+	m_bTimerPeriodSet = false;
+
+	m_nHistoryHead = 0;
+	m_nHistoryCount = 0;
+
+	for (uint32_t i = 0; i < FRAME_PACER_HISTORY_FRAMES; ++i)
+		m_intervals[i] = 0.0;
+
+	m_spinThreshold = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(FRAME_PACER_SPIN_THRESHOLD_MS));
+
+#ifdef _WIN32
+	// Sleep() & regular waitable timers are only as precise as the system timer resolution, 15.6ms by default.
+	m_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+	if(!m_timer)
+	{
+		// Raise the system timer resolution instead, so sleep_until() wakes up within about a period of its deadline & only the last couple of milliseconds are spun.
+		m_bTimerPeriodSet = timeBeginPeriod(FRAME_PACER_TIMER_PERIOD_MS) == TIMERR_NOERROR;
+		m_spinThreshold = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(FRAME_PACER_COARSE_SPIN_THRESHOLD_MS));
+
+		std::cout << "Frame Pacer Warning: High resolution timers are unavailable, raising the system timer resolution to " << FRAME_PACER_TIMER_PERIOD_MS << "ms.\n";
+	}
+#endif
+
+	SetTargetFrameRate(fTargetFrameRate);
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if (m_timer)
+		CloseHandle(m_timer);
+
+	if (m_bTimerPeriodSet)
+		timeEndPeriod(FRAME_PACER_TIMER_PERIOD_MS);
+#endif
+}
+
+void FramePacer::SetTargetFrameRate(float fTargetFrameRate)
+{
+	if (fTargetFrameRate > 0.0f)
+		m_targetFrameTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / fTargetFrameRate));
+	else
+		m_targetFrameTime = std::chrono::steady_clock::duration::zero();
+
+	// Reschedule from the last frame, so the new frame time applies to the next frame.
+	m_nextFrameTime = m_lastFrameTime + m_targetFrameTime;
+}
+
+void FramePacer::SetLatencyMode(EFramePacerLatencyMode eMode)
+{
+	m_eLatencyMode = eMode;
+}
+
+EFramePacerLatencyMode FramePacer::LatencyMode() const
+{
+	return m_eLatencyMode;
+}
+
+float FramePacer::WaitForNextFrame()
+{
+	CPU_PROFILE_ZONE("FramePacer::WaitForNextFrame");
+
+	// Let the GPU catch up first, so the sleep covers the remaining time & Begin() won't block once input is sampled.
+	m_renderer->WaitForFrame(m_eLatencyMode == FRAME_PACER_LATENCY_LOW);
+
+	if (!m_bFirstFrame && m_targetFrameTime.count() > 0)
+		WaitUntil(m_nextFrameTime);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	// Schedule from the due time rather than the actual start, so wake-up latency doesn't accumulate.
+	// Frames running more than a whole frame late are rescheduled from now, instead of rushing the following frames to catch up.
+	m_nextFrameTime = m_bFirstFrame ? now + m_targetFrameTime : m_nextFrameTime + m_targetFrameTime;
+
+	if (m_nextFrameTime < now)
+		m_nextFrameTime = now + m_targetFrameTime;
+
+	float fDeltaTime = 0.0f;
+
+	if(!m_bFirstFrame)
+	{
+		double dInterval = std::chrono::duration<double, std::milli>(now - m_lastFrameTime).count();
+
+		// The history fills from the start, so the first m_nHistoryCount intervals are always the written ones.
+		m_intervals[m_nHistoryHead] = dInterval;
+		m_nHistoryHead = (m_nHistoryHead + 1) % FRAME_PACER_HISTORY_FRAMES;
+		m_nHistoryCount = std::min<uint32_t>(m_nHistoryCount + 1, FRAME_PACER_HISTORY_FRAMES);
+
+		fDeltaTime = static_cast<float>(dInterval / 1000.0);
+	}
+
+	m_lastFrameTime = now;
+	m_bFirstFrame = false;
+
+	return fDeltaTime;
+}
+
+double FramePacer::TargetFrameTime() const
+{
+	return std::chrono::duration<double, std::milli>(m_targetFrameTime).count();
+}
+
+double FramePacer::AverageFrameTime() const
+{
+	if (m_nHistoryCount == 0)
+		return 0.0;
+
+	double dTotal = 0.0;
+	for (uint32_t i = 0; i < m_nHistoryCount; ++i)
+		dTotal += m_intervals[i];
+
+	return dTotal / m_nHistoryCount;
+}
+
+double FramePacer::Jitter() const
+{
+	if (m_nHistoryCount == 0)
+		return 0.0;
+
+	double dAverage = AverageFrameTime();
+	double dVariance = 0.0;
+
+	for (uint32_t i = 0; i < m_nHistoryCount; ++i)
+		dVariance += (m_intervals[i] - dAverage) * (m_intervals[i] - dAverage);
+
+	return std::sqrt(dVariance / m_nHistoryCount);
+}
+
+double FramePacer::MaxDeviation() const
+{
+	double dReference = m_targetFrameTime.count() > 0 ? TargetFrameTime() : AverageFrameTime();
+	double dMaxDeviation = 0.0;
+
+	for (uint32_t i = 0; i < m_nHistoryCount; ++i)
+		dMaxDeviation = std::max(dMaxDeviation, std::abs(m_intervals[i] - dReference));
+
+	return dMaxDeviation;
+}
+
+void FramePacer::PrintStats() const
+{
+	std::cout << "Frame Pacer: Target: ";
+
+	if (m_targetFrameTime.count() > 0)
+		std::cout << TargetFrameTime() << "ms";
+	else
+		std::cout << "Uncapped";
+
+	std::cout << ", Average: " << AverageFrameTime() << "ms, Jitter: " << Jitter() << "ms, Max Deviation: " << MaxDeviation() << "ms, Low Latency: " << (m_eLatencyMode == FRAME_PACER_LATENCY_LOW ? "On" : "Off") << "\n";
+}
+
+inline void FramePacer::WaitUntil(std::chrono::steady_clock::time_point deadline)
+{
+	std::chrono::steady_clock::time_point sleepDeadline = deadline - m_spinThreshold;
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	if(now < sleepDeadline)
+	{
+#ifdef _WIN32
+		if(m_timer)
+		{
+			// Negative due times are relative, in 100ns units.
+			LARGE_INTEGER dueTime;
+			dueTime.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(sleepDeadline - now).count() / 100);
+
+			if (SetWaitableTimerEx(m_timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+				WaitForSingleObject(m_timer, INFINITE);
+		}
+		else
+			std::this_thread::sleep_until(sleepDeadline);
+#else
+		std::this_thread::sleep_until(sleepDeadline);
+#endif
+	}
+
+	// Spin for the remainder, yielding to any other ready threads.
+	while (std::chrono::steady_clock::now() < deadline)
+		std::this_thread::yield();
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+
+/*
+Description: Paces frames to a target frame time. Sleeps on a high resolution timer until shortly before the next frame is due & spins for the remainder,
+             so a capped application leaves the CPU idle between frames. Measures the jitter of frame intervals.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+
+// Time before a frame is due at which the pacer stops sleeping & spins, covering the timer's wake-up latency.
+#define FRAME_PACER_SPIN_THRESHOLD_MS 1.0
+
+// Spin threshold used when no high resolution timer is available on Windows. The system timer resolution is raised to
+// FRAME_PACER_TIMER_PERIOD_MS for the pacer's lifetime, so sleeps wake up to about one period late.
+#define FRAME_PACER_COARSE_SPIN_THRESHOLD_MS 2.0
+
+// System timer resolution requested with timeBeginPeriod() when no high resolution timer is available on Windows.
+#define FRAME_PACER_TIMER_PERIOD_MS 1
+
+// Amount of frame intervals jitter is measured over.
+#define FRAME_PACER_HISTORY_FRAMES 256
+
+enum EFramePacerLatencyMode
+{
+	FRAME_PACER_LATENCY_DEFAULT, // Wait for the frame-in-flight about to be reused, the CPU may run up to MAX_FRAMES_IN_FLIGHT - 1 frames ahead of the GPU.
+	FRAME_PACER_LATENCY_LOW // Wait for the previously submitted frame, so input is sampled once the GPU has caught up & no frames are queued ahead of it.
+};
+
+class FramePacer
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer whose frames are paced.
+		float fTargetFrameRate: Frames per second to pace to, 0 for uncapped.
+	*/
+	FramePacer(Renderer* renderer, float fTargetFrameRate);
+
+	~FramePacer();
+
+	/*
+	Description: Set the frames per second to pace to.
+	Param:
+	    float fTargetFrameRate: Frames per second, 0 for uncapped.
+	*/
+	void SetTargetFrameRate(float fTargetFrameRate);
+
+	void SetLatencyMode(EFramePacerLatencyMode eMode);
+
+	EFramePacerLatencyMode LatencyMode() const;
+
+	/*
+	Description: Wait until the next frame is due & the GPU is ready to accept it, returns the time in seconds since the previous frame started.
+	             Call right before sampling input for the frame, as late as possible ahead of Renderer::Begin().
+	Return Type: float
+	*/
+	float WaitForNextFrame();
+
+	// ---------------------------------------------------------------------------------
+	// Results
+
+	/*
+	Description: Get the target frame time in milliseconds, 0 if uncapped.
+	Return Type: double
+	*/
+	double TargetFrameTime() const;
+
+	/*
+	Description: Get the average frame interval in milliseconds over the history.
+	Return Type: double
+	*/
+	double AverageFrameTime() const;
+
+	/*
+	Description: Get the jitter in milliseconds, the standard deviation of frame intervals over the history.
+	Return Type: double
+	*/
+	double Jitter() const;
+
+	/*
+	Description: Get the largest deviation in milliseconds of a frame interval in the history from the target, or the average if uncapped.
+	Return Type: double
+	*/
+	double MaxDeviation() const;
+
+	/*
+	Description: Print the target & average frame time, jitter & latency mode.
+	*/
+	void PrintStats() const;
+
+private:
+
+	// Sleep until shortly before the deadline, then spin until it is reached.
+	inline void WaitUntil(std::chrono::steady_clock::time_point deadline);
+
+	Renderer* m_renderer;
+	EFramePacerLatencyMode m_eLatencyMode;
+
+	std::chrono::steady_clock::duration m_targetFrameTime; // Zero if uncapped.
+	std::chrono::steady_clock::duration m_spinThreshold;
+	std::chrono::steady_clock::time_point m_nextFrameTime;
+	std::chrono::steady_clock::time_point m_lastFrameTime;
+	bool m_bFirstFrame;
+
+	void* m_timer; // High resolution waitable timer, null if unavailable.
+	bool m_bTimerPeriodSet; // Whether or not the system timer resolution was raised & must be restored.
+
+	double m_intervals[FRAME_PACER_HISTORY_FRAMES]; // Frame intervals in milliseconds.
+	uint32_t m_nHistoryHead; // Index the next interval is written to, replacing the oldest once the history is full.
+	uint32_t m_nHistoryCount;
+};
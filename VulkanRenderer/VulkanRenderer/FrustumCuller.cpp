@@ -0,0 +1,624 @@
+#include "FrustumCuller.h"
+#include "Renderer.h"
+#include "RenderObject.h"
+#include "SubScene.h"
+#include "Mesh.h"
+#include "JobSystem.h"
+#include "UploadArena.h"
+#include "CPUProfiler.h"
+
+#include <immintrin.h>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+
+// ---------------------------------------------------------------------------------
+// Box & plane test
+
+// Lane-wise arithmetic, so the box & plane test is written once for scalar, SSE & AVX lanes.
+static inline float LaneAdd(float a, float b) { return a + b; }
+static inline float LaneMul(float a, float b) { return a * b; }
+static inline __m128 LaneAdd(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+static inline __m128 LaneMul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+
+#ifdef __AVX__
+static inline __m256 LaneAdd(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+static inline __m256 LaneMul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+#endif
+
+// A frustum plane broadcast across every lane.
+template<typename Lane>
+struct PlaneLanes
+{
+	Lane m_x, m_y, m_z, m_w;
+	Lane m_absX, m_absY, m_absZ; // Absolute normal.
+};
+
+/*
+Description: Get the signed distance of the box corner furthest along the plane's normal, negative if the whole box is behind the plane.
+             Extents are the box's half size projected onto each world axis, so projecting them onto the absolute normal gives the box's radius along it.
+             The culling shaders' frustum tests (gpu_cull_comp & gpu_cull_late_comp) follow this function.
+Return Type: Lane
+*/
+template<typename Lane>
+static inline Lane BoxPlaneDistance(const PlaneLanes<Lane>& plane, Lane centerX, Lane centerY, Lane centerZ, Lane extentsX, Lane extentsY, Lane extentsZ)
+{
+	Lane dist = LaneAdd(LaneAdd(LaneMul(plane.m_x, centerX), LaneMul(plane.m_y, centerY)), LaneAdd(LaneMul(plane.m_z, centerZ), plane.m_w));
+	Lane radius = LaneAdd(LaneAdd(LaneMul(plane.m_absX, extentsX), LaneMul(plane.m_absY, extentsY)), LaneMul(plane.m_absZ, extentsZ));
+
+	return LaneAdd(dist, radius);
+}
+
+// ---------------------------------------------------------------------------------
+// Frustum
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProj)
+{
+	// Rows of the matrix, glm matrices are column major.
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; ++i)
+		rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+
+	Frustum frustum;
+
+	// Clip space bounds are -w to w on every axis, so each plane is the W row plus or minus another row.
+	frustum.m_planes[0] = rows[3] + rows[0]; // Left
+	frustum.m_planes[1] = rows[3] - rows[0]; // Right
+	frustum.m_planes[2] = rows[3] + rows[1]; // Bottom
+	frustum.m_planes[3] = rows[3] - rows[1]; // Top
+	frustum.m_planes[4] = rows[3] + rows[2]; // Near
+	frustum.m_planes[5] = rows[3] - rows[2]; // Far
+
+	for (int i = 0; i < 6; ++i)
+		frustum.m_planes[i] /= glm::length(glm::vec3(frustum.m_planes[i]));
+
+	return frustum;
+}
+
+// ---------------------------------------------------------------------------------
+// Instance bounds
+
+InstanceBounds::InstanceBounds()
+{
+	m_data = nullptr;
+	m_nCapacity = 0;
+
+	m_centerX = nullptr;
+	m_centerY = nullptr;
+	m_centerZ = nullptr;
+	m_extentsX = nullptr;
+	m_extentsY = nullptr;
+	m_extentsZ = nullptr;
+}
+
+InstanceBounds::~InstanceBounds()
+{
+	if (m_data)
+		_mm_free(m_data);
+}
+
+void InstanceBounds::Resize(uint32_t nCount)
+{
+	float* oldData = m_data;
+	uint32_t nOldCapacity = m_nCapacity;
+
+	// Padding is zero filled, so the kernels never read uninitialized floats past the last instance.
+	m_nCapacity = ((nCount + CULL_SIMD_WIDTH - 1) / CULL_SIMD_WIDTH) * CULL_SIMD_WIDTH;
+	m_data = static_cast<float*>(_mm_malloc(sizeof(float) * m_nCapacity * 6, 32));
+	std::memset(m_data, 0, sizeof(float) * m_nCapacity * 6);
+
+	// Keep the bounds of instances within both capacities, each of the six arrays starts at a new offset.
+	if (oldData)
+	{
+		uint32_t nKeepCount = std::min(nOldCapacity, m_nCapacity);
+
+		for (uint32_t i = 0; i < 6; ++i)
+			std::memcpy(&m_data[i * m_nCapacity], &oldData[i * nOldCapacity], sizeof(float) * nKeepCount);
+
+		_mm_free(oldData);
+	}
+
+	m_centerX = m_data;
+	m_centerY = m_centerX + m_nCapacity;
+	m_centerZ = m_centerY + m_nCapacity;
+	m_extentsX = m_centerZ + m_nCapacity;
+	m_extentsY = m_extentsX + m_nCapacity;
+	m_extentsZ = m_extentsY + m_nCapacity;
+}
+
+void InstanceBounds::Set(uint32_t nIndex, const MeshBounds& meshBounds, const glm::mat4& modelMat)
+{
+	glm::vec4 v4Center = modelMat * glm::vec4(meshBounds.m_v3Center, 1.0f);
+	const glm::vec3& e = meshBounds.m_v3Extents;
+
+	m_centerX[nIndex] = v4Center.x;
+	m_centerY[nIndex] = v4Center.y;
+	m_centerZ[nIndex] = v4Center.z;
+
+	// Extents of the transformed box projected onto each world axis.
+	m_extentsX[nIndex] = std::abs(modelMat[0][0]) * e.x + std::abs(modelMat[1][0]) * e.y + std::abs(modelMat[2][0]) * e.z;
+	m_extentsY[nIndex] = std::abs(modelMat[0][1]) * e.x + std::abs(modelMat[1][1]) * e.y + std::abs(modelMat[2][1]) * e.z;
+	m_extentsZ[nIndex] = std::abs(modelMat[0][2]) * e.x + std::abs(modelMat[1][2]) * e.y + std::abs(modelMat[2][2]) * e.z;
+}
+
+uint32_t InstanceBounds::Capacity() const
+{
+	return m_nCapacity;
+}
+
+// ---------------------------------------------------------------------------------
+// Frustum culler
+
+FrustumCuller::FrustumCuller(Renderer* renderer)
+{
+	m_renderer = renderer;
+	m_bEnabled = true;
+	m_bLODSelection = true;
+
+	m_nInstanceCount = 0;
+	m_dCullTime = 0.0;
+
+	for (uint32_t i = 0; i < CULL_VIEW_COUNT; ++i)
+	{
+		m_nVisibleCounts[i] = 0;
+		m_nVisibleTriangleCounts[i] = 0;
+
+		// Created on the first cull of each frame, sized to the visible instances.
+		for (uint32_t j = 0; j < MAX_FRAMES_IN_FLIGHT; ++j)
+		{
+			m_instanceBuffers[i][j] = VK_NULL_HANDLE;
+			m_nInstanceCapacities[i][j] = 0;
+		}
+	}
+}
+
+FrustumCuller::~FrustumCuller()
+{
+	m_renderer->WaitGraphicsIdle();
+
+	for (uint32_t i = 0; i < CULL_VIEW_COUNT; ++i)
+	{
+		for (uint32_t j = 0; j < MAX_FRAMES_IN_FLIGHT; ++j)
+		{
+			if (!m_instanceBuffers[i][j])
+				continue;
+
+			vkDestroyBuffer(m_renderer->GetDevice(), m_instanceBuffers[i][j], nullptr);
+			m_renderer->FreeMemory(m_instanceMemories[i][j]);
+		}
+	}
+}
+
+void FrustumCuller::Cull(const DynamicArray<PipelineData*>& pipelines, const Frustum* frusta, uint32_t nViewMask, const LODView& lodView, const uint32_t& nFrameIndex)
+{
+	CPU_PROFILE_ZONE("FrustumCuller::Cull");
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Split the instances of every object into batches.
+	m_objects.clear();
+	m_batches.clear();
+	m_nInstanceCount = 0;
+
+	for (uint32_t i = 0; i < pipelines.Count(); ++i)
+	{
+		const PipelineData& data = *pipelines[i];
+
+		for (uint32_t j = 0; j < data.m_renderObjects.Count(); ++j)
+		{
+			RenderObject* obj = data.m_renderObjects[j];
+			obj->m_gpuCuller = nullptr; // Draw from the object's own instance buffers.
+			obj->m_nLateVisibleCount = 0; // Every visible instance is drawn in the early phase.
+			m_objects.push_back(obj);
+
+			for (uint32_t nStart = 0; nStart < obj->m_nInstanceCount; nStart += CULL_BATCH_SIZE)
+				m_batches.push_back({ obj, nStart, std::min(nStart + CULL_BATCH_SIZE, obj->m_nInstanceCount), {}, FLT_MAX });
+
+			m_nInstanceCount += obj->m_nInstanceCount;
+		}
+	}
+
+	// Most objects have few instances, so give each job enough batches to cover about CULL_BATCH_SIZE instances.
+	uint32_t nBatchCount = static_cast<uint32_t>(m_batches.size());
+	uint32_t nBatchesPerJob = nBatchCount > 0 ? std::max<uint32_t>(static_cast<uint32_t>((static_cast<uint64_t>(nBatchCount) * CULL_BATCH_SIZE) / std::max(m_nInstanceCount, 1u)), 1u) : 1;
+
+	m_renderer->GetJobSystem()->ParallelFor(nBatchCount, nBatchesPerJob, [&](uint32_t nStart, uint32_t nEnd)
+	{
+		for (uint32_t i = nStart; i < nEnd; ++i)
+			CullBatchRange(m_batches[i], frusta, nViewMask, lodView);
+	});
+
+	// Close the gaps between the visible instances of each batch.
+	for (uint32_t i = 0; i < CULL_VIEW_COUNT; ++i)
+		m_nVisibleCounts[i] = 0;
+
+	m_lodObjects.clear();
+
+	uint32_t nBatchIndex = 0;
+	for (RenderObject* obj : m_objects)
+	{
+		uint32_t nVisibleCounts[CULL_VIEW_COUNT] = {};
+		obj->m_fViewDistance = FLT_MAX;
+
+		for (; nBatchIndex < nBatchCount && m_batches[nBatchIndex].m_object == obj; ++nBatchIndex)
+		{
+			CullBatch& batch = m_batches[nBatchIndex];
+
+			for (uint32_t v = 0; v < CULL_VIEW_COUNT; ++v)
+			{
+				if (nVisibleCounts[v] != batch.m_nStart)
+				{
+					std::memmove(&obj->m_visibleInstances[v][nVisibleCounts[v]], &obj->m_visibleInstances[v][batch.m_nStart], sizeof(Instance) * batch.m_nVisibleCounts[v]);
+
+					if (v == CULL_VIEW_CAMERA && obj->m_visibleLODs)
+						std::memmove(&obj->m_visibleLODs[nVisibleCounts[v]], &obj->m_visibleLODs[batch.m_nStart], batch.m_nVisibleCounts[v]);
+				}
+
+				nVisibleCounts[v] += batch.m_nVisibleCounts[v];
+			}
+
+			obj->m_fViewDistance = std::min(obj->m_fViewDistance, batch.m_fViewDistance);
+		}
+
+		// Every visible instance is drawn at full detail, unless grouped by LOD below. Objects' visible instances follow each other in the view's instance buffer.
+		for (uint32_t v = 0; v < CULL_VIEW_COUNT; ++v)
+		{
+			obj->m_nVisibleCounts[v] = nVisibleCounts[v];
+			obj->m_nVisibleOffsets[v] = m_nVisibleCounts[v];
+			m_nVisibleCounts[v] += nVisibleCounts[v];
+
+			std::memset(obj->m_nLODVisibleCounts[v], 0, sizeof(obj->m_nLODVisibleCounts[v]));
+			obj->m_nLODVisibleCounts[v][0] = nVisibleCounts[v];
+		}
+
+		if (m_bLODSelection && obj->m_visibleLODs && nVisibleCounts[CULL_VIEW_CAMERA] > 0)
+			m_lodObjects.push_back(obj);
+
+		obj->m_modifiedBounds.Clear();
+	}
+
+	// Group the visible camera instances of objects with LODs, an object per job.
+	m_renderer->GetJobSystem()->ParallelFor(static_cast<uint32_t>(m_lodObjects.size()), 1, [&](uint32_t nStart, uint32_t nEnd)
+	{
+		for (uint32_t i = nStart; i < nEnd; ++i)
+			GroupByLOD(m_lodObjects[i]);
+	});
+
+	// Triangles of the visible instances at their LODs.
+	for (uint32_t v = 0; v < CULL_VIEW_COUNT; ++v)
+	{
+		m_nVisibleTriangleCounts[v] = 0;
+
+		for (RenderObject* obj : m_objects)
+		{
+			for (uint32_t l = 0; l < obj->m_mesh->LODCount(); ++l)
+				m_nVisibleTriangleCounts[v] += static_cast<uint64_t>(obj->m_nLODVisibleCounts[v][l]) * (obj->m_mesh->GetLOD(l).m_nIndexCount / 3);
+		}
+	}
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_dCullTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+	// Grow this frame's instance buffers to fit the visible instances, the frame's previous GPU work is complete so they are no longer in use.
+	for (uint32_t v = 0; v < CULL_VIEW_COUNT; ++v)
+	{
+		uint32_t& nCapacity = m_nInstanceCapacities[v][nFrameIndex];
+
+		if (m_instanceBuffers[v][nFrameIndex] && m_nVisibleCounts[v] <= nCapacity)
+			continue;
+
+		if (m_instanceBuffers[v][nFrameIndex])
+		{
+			vkDestroyBuffer(m_renderer->GetDevice(), m_instanceBuffers[v][nFrameIndex], nullptr);
+			m_renderer->FreeMemory(m_instanceMemories[v][nFrameIndex]);
+		}
+
+		nCapacity = std::max(std::max(m_nVisibleCounts[v], nCapacity * 2), CULL_INSTANCE_BUFFER_MIN_CAPACITY);
+
+		m_renderer->CreateBuffer(static_cast<VkDeviceSize>(nCapacity) * sizeof(Instance), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			m_renderer->GetUploadArena()->PerFrameMemoryFlags(), m_instanceBuffers[v][nFrameIndex], m_instanceMemories[v][nFrameIndex]);
+	}
+
+	// Write the visible instances to this frame's instance buffers, on this thread since the upload arena is not thread safe.
+	UploadArena* uploadArena = m_renderer->GetUploadArena();
+
+	for (RenderObject* obj : m_objects)
+	{
+		for (uint32_t v = 0; v < CULL_VIEW_COUNT; ++v)
+		{
+			if (obj->m_nVisibleCounts[v] > 0)
+				uploadArena->Write(m_instanceBuffers[v][nFrameIndex], m_instanceMemories[v][nFrameIndex], static_cast<VkDeviceSize>(obj->m_nVisibleOffsets[v]) * sizeof(Instance),
+					obj->m_visibleInstances[v], sizeof(Instance) * obj->m_nVisibleCounts[v], true);
+		}
+	}
+}
+
+void FrustumCuller::SetEnabled(bool bEnabled)
+{
+	m_bEnabled = bEnabled;
+}
+
+bool FrustumCuller::IsEnabled() const
+{
+	return m_bEnabled;
+}
+
+void FrustumCuller::SetLODSelection(bool bEnabled)
+{
+	m_bLODSelection = bEnabled;
+}
+
+bool FrustumCuller::IsLODSelection() const
+{
+	return m_bLODSelection;
+}
+
+VkBuffer FrustumCuller::InstanceBuffer(ECullView eView, const uint32_t& nFrameIndex) const
+{
+	return m_instanceBuffers[eView][nFrameIndex];
+}
+
+uint32_t FrustumCuller::InstanceCount() const
+{
+	return m_nInstanceCount;
+}
+
+uint32_t FrustumCuller::VisibleCount(ECullView eView) const
+{
+	return m_nVisibleCounts[eView];
+}
+
+uint64_t FrustumCuller::VisibleTriangleCount(ECullView eView) const
+{
+	return m_nVisibleTriangleCounts[eView];
+}
+
+double FrustumCuller::CullTime() const
+{
+	return m_dCullTime;
+}
+
+uint32_t FrustumCuller::CullBounds(const Frustum& frustum, const InstanceBounds& bounds, uint32_t nStart, uint32_t nEnd, uint32_t* outIndices)
+{
+	uint32_t nVisibleCount = 0;
+
+#ifdef __AVX__
+	// Plane components & absolute normals, broadcast across all lanes.
+	PlaneLanes<__m256> planes[6];
+
+	for (int p = 0; p < 6; ++p)
+	{
+		const glm::vec4& plane = frustum.m_planes[p];
+
+		planes[p].m_x = _mm256_set1_ps(plane.x);
+		planes[p].m_y = _mm256_set1_ps(plane.y);
+		planes[p].m_z = _mm256_set1_ps(plane.z);
+		planes[p].m_w = _mm256_set1_ps(plane.w);
+		planes[p].m_absX = _mm256_set1_ps(std::abs(plane.x));
+		planes[p].m_absY = _mm256_set1_ps(std::abs(plane.y));
+		planes[p].m_absZ = _mm256_set1_ps(std::abs(plane.z));
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (uint32_t i = nStart; i < nEnd; i += 8)
+	{
+		__m256 centerX = _mm256_load_ps(&bounds.m_centerX[i]);
+		__m256 centerY = _mm256_load_ps(&bounds.m_centerY[i]);
+		__m256 centerZ = _mm256_load_ps(&bounds.m_centerZ[i]);
+		__m256 extentsX = _mm256_load_ps(&bounds.m_extentsX[i]);
+		__m256 extentsY = _mm256_load_ps(&bounds.m_extentsY[i]);
+		__m256 extentsZ = _mm256_load_ps(&bounds.m_extentsZ[i]);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p)
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(BoxPlaneDistance(planes[p], centerX, centerY, centerZ, extentsX, extentsY, extentsZ), zero, _CMP_GE_OQ));
+
+		uint32_t nMask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+
+		// Mask out lanes past the end of the range.
+		if (nEnd - i < 8)
+			nMask &= (1u << (nEnd - i)) - 1u;
+
+		// Write every lane's index & only advance past visible ones.
+		for (uint32_t l = 0; l < 8; ++l)
+		{
+			outIndices[nVisibleCount] = i + l;
+			nVisibleCount += (nMask >> l) & 1u;
+		}
+	}
+#else
+	// Plane components & absolute normals, broadcast across all lanes.
+	PlaneLanes<__m128> planes[6];
+
+	for (int p = 0; p < 6; ++p)
+	{
+		const glm::vec4& plane = frustum.m_planes[p];
+
+		planes[p].m_x = _mm_set1_ps(plane.x);
+		planes[p].m_y = _mm_set1_ps(plane.y);
+		planes[p].m_z = _mm_set1_ps(plane.z);
+		planes[p].m_w = _mm_set1_ps(plane.w);
+		planes[p].m_absX = _mm_set1_ps(std::abs(plane.x));
+		planes[p].m_absY = _mm_set1_ps(std::abs(plane.y));
+		planes[p].m_absZ = _mm_set1_ps(std::abs(plane.z));
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = nStart; i < nEnd; i += 4)
+	{
+		__m128 centerX = _mm_load_ps(&bounds.m_centerX[i]);
+		__m128 centerY = _mm_load_ps(&bounds.m_centerY[i]);
+		__m128 centerZ = _mm_load_ps(&bounds.m_centerZ[i]);
+		__m128 extentsX = _mm_load_ps(&bounds.m_extentsX[i]);
+		__m128 extentsY = _mm_load_ps(&bounds.m_extentsY[i]);
+		__m128 extentsZ = _mm_load_ps(&bounds.m_extentsZ[i]);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (int p = 0; p < 6; ++p)
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(BoxPlaneDistance(planes[p], centerX, centerY, centerZ, extentsX, extentsY, extentsZ), zero));
+
+		uint32_t nMask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+
+		// Mask out lanes past the end of the range.
+		if (nEnd - i < 4)
+			nMask &= (1u << (nEnd - i)) - 1u;
+
+		// Write every lane's index & only advance past visible ones.
+		for (uint32_t l = 0; l < 4; ++l)
+		{
+			outIndices[nVisibleCount] = i + l;
+			nVisibleCount += (nMask >> l) & 1u;
+		}
+	}
+#endif
+
+	return nVisibleCount;
+}
+
+uint32_t FrustumCuller::CullBoundsScalar(const Frustum& frustum, const InstanceBounds& bounds, uint32_t nStart, uint32_t nEnd, uint32_t* outIndices)
+{
+	uint32_t nVisibleCount = 0;
+
+	PlaneLanes<float> planes[6];
+
+	for (int p = 0; p < 6; ++p)
+	{
+		const glm::vec4& plane = frustum.m_planes[p];
+		planes[p] = { plane.x, plane.y, plane.z, plane.w, std::abs(plane.x), std::abs(plane.y), std::abs(plane.z) };
+	}
+
+	for (uint32_t i = nStart; i < nEnd; ++i)
+	{
+		bool bInside = true;
+
+		for (int p = 0; p < 6 && bInside; ++p)
+			bInside = BoxPlaneDistance(planes[p], bounds.m_centerX[i], bounds.m_centerY[i], bounds.m_centerZ[i], bounds.m_extentsX[i], bounds.m_extentsY[i], bounds.m_extentsZ[i]) >= 0.0f;
+
+		if (bInside)
+			outIndices[nVisibleCount++] = i;
+	}
+
+	return nVisibleCount;
+}
+
+inline void FrustumCuller::CullBatchRange(CullBatch& batch, const Frustum* frusta, uint32_t nViewMask, const LODView& lodView)
+{
+	RenderObject* obj = batch.m_object;
+
+	// Recompute bounds of modified instances.
+	if(obj->m_modifiedBounds.Any())
+	{
+		const MeshBounds& meshBounds = obj->m_mesh->Bounds();
+
+		for (uint32_t i = batch.m_nStart; i < batch.m_nEnd; ++i)
+		{
+			if (obj->m_modifiedBounds.IsMarked(i))
+				obj->m_bounds.Set(i, meshBounds, obj->m_instanceArray[i].m_modelMat);
+		}
+	}
+
+	uint32_t nCount = batch.m_nEnd - batch.m_nStart;
+	uint32_t indices[CULL_BATCH_SIZE];
+
+	for (uint32_t v = 0; v < CULL_VIEW_COUNT; ++v)
+	{
+		// Skipped views have no visible instances, so they are neither compacted nor uploaded.
+		if (!(nViewMask & CULL_VIEW_BIT(v)))
+		{
+			batch.m_nVisibleCounts[v] = 0;
+			continue;
+		}
+
+		Instance* visibleInstances = &obj->m_visibleInstances[v][batch.m_nStart];
+		uint32_t nVisibleCount = 0;
+
+		if(!m_bEnabled)
+		{
+			std::memcpy(visibleInstances, &obj->m_instanceArray[batch.m_nStart], sizeof(Instance) * nCount);
+
+			for (uint32_t i = 0; i < nCount; ++i)
+				indices[i] = batch.m_nStart + i;
+
+			nVisibleCount = nCount;
+		}
+		else
+		{
+			nVisibleCount = CullBounds(frusta[v], obj->m_bounds, batch.m_nStart, batch.m_nEnd, indices);
+
+			for (uint32_t i = 0; i < nVisibleCount; ++i)
+				visibleInstances[i] = obj->m_instanceArray[indices[i]];
+		}
+
+		batch.m_nVisibleCounts[v] = nVisibleCount;
+
+		if (v != CULL_VIEW_CAMERA)
+			continue;
+
+		// Select the LOD of each visible camera instance from the error of its levels projected at the distance to its bounds, the nearest distance also orders the object's draws.
+		const Mesh* mesh = obj->m_mesh;
+		const InstanceBounds& bounds = obj->m_bounds;
+		uint8_t* visibleLODs = m_bLODSelection && obj->m_visibleLODs ? &obj->m_visibleLODs[batch.m_nStart] : nullptr;
+		float fViewDistance = FLT_MAX;
+
+		for (uint32_t i = 0; i < nVisibleCount; ++i)
+		{
+			uint32_t nIndex = indices[i];
+
+			glm::vec3 v3Center(bounds.m_centerX[nIndex], bounds.m_centerY[nIndex], bounds.m_centerZ[nIndex]);
+			glm::vec3 v3Extents(bounds.m_extentsX[nIndex], bounds.m_extentsY[nIndex], bounds.m_extentsZ[nIndex]);
+
+			float fDistance = glm::length(v3Center - lodView.m_v3Position) - glm::length(v3Extents);
+			fViewDistance = std::min(fViewDistance, fDistance);
+
+			if (!visibleLODs)
+				continue;
+
+			const glm::mat4& modelMat = obj->m_instanceArray[nIndex].m_modelMat;
+			float fScale = std::sqrt(std::max(std::max(glm::dot(modelMat[0], modelMat[0]), glm::dot(modelMat[1], modelMat[1])), glm::dot(modelMat[2], modelMat[2])));
+
+			visibleLODs[i] = static_cast<uint8_t>(mesh->SelectLOD(fDistance, fScale, lodView.m_fProjectionScale, LOD_PIXEL_ERROR_THRESHOLD));
+		}
+
+		batch.m_fViewDistance = fViewDistance;
+	}
+}
+
+inline void FrustumCuller::GroupByLOD(RenderObject* obj)
+{
+	uint32_t nVisibleCount = obj->m_nVisibleCounts[CULL_VIEW_CAMERA];
+	uint32_t* nLODCounts = obj->m_nLODVisibleCounts[CULL_VIEW_CAMERA];
+
+	const uint8_t* visibleLODs = obj->m_visibleLODs;
+	const Instance* visibleInstances = obj->m_visibleInstances[CULL_VIEW_CAMERA];
+
+	// Counting sort, keeping instances of the same LOD in order.
+	std::memset(nLODCounts, 0, sizeof(uint32_t) * MESH_MAX_LODS);
+
+	for (uint32_t i = 0; i < nVisibleCount; ++i)
+		++nLODCounts[visibleLODs[i]];
+
+	uint32_t nOffsets[MESH_MAX_LODS];
+	uint32_t nOffset = 0;
+
+	for (uint32_t l = 0; l < MESH_MAX_LODS; ++l)
+	{
+		nOffsets[l] = nOffset;
+		nOffset += nLODCounts[l];
+	}
+
+	// All visible instances share a LOD, they are already grouped.
+	if (nLODCounts[visibleLODs[0]] == nVisibleCount)
+		return;
+
+	for (uint32_t i = 0; i < nVisibleCount; ++i)
+		obj->m_groupedInstances[nOffsets[visibleLODs[i]]++] = visibleInstances[i];
+
+	// The grouped instances become the visible instances, & the old array is the next cull's scratch space.
+	std::swap(obj->m_visibleInstances[CULL_VIEW_CAMERA], obj->m_groupedInstances);
+}
@@ -0,0 +1,255 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include "DynamicArray.h"
+#include "Renderer.h"
+#include "glm.hpp"
+
+/*
+Description: Frustum culling of render object instances. Instance bounds are kept as world space AABBs in a structure of arrays layout & tested with SSE or AVX kernels,
+             spread across the renderer's job system. Visible instances are compacted into a shared instance buffer per view, so draws only cover visible instances.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+class RenderObject;
+
+struct PipelineData;
+
+// Views instances are culled for, render objects keep visible instances & instance buffers for each.
+enum ECullView
+{
+	CULL_VIEW_CAMERA,
+	CULL_VIEW_SHADOW,
+	CULL_VIEW_COUNT
+};
+
+// Masks of the views to cull, views outside the mask are skipped & have no visible instances.
+#define CULL_VIEW_BIT(eView) (1u << (eView))
+#define CULL_VIEW_MASK_ALL ((1u << CULL_VIEW_COUNT) - 1)
+
+// Phases of two-phase occlusion culling. The late phase re-tests the camera's instances against depth of the early phase's draws, only GPU culling has a late phase.
+enum ECullPhase
+{
+	CULL_PHASE_EARLY,
+	CULL_PHASE_LATE
+};
+
+// Instances processed by the kernels per iteration, bounds arrays are padded to a multiple of this.
+#ifdef __AVX__
+#define CULL_SIMD_WIDTH 8
+#else
+#define CULL_SIMD_WIDTH 4
+#endif
+
+// Amount of instances culled per job.
+#define CULL_BATCH_SIZE 2048
+
+// Smallest capacity in instances of the per-view instance buffers, which grow to fit the visible instances.
+#define CULL_INSTANCE_BUFFER_MIN_CAPACITY 1024u
+
+// Largest error in pixels of the mesh LOD selected for a camera instance.
+#define LOD_PIXEL_ERROR_THRESHOLD 1.0f
+
+struct Frustum
+{
+	/*
+	Description: Extract the planes of a view projection matrix's frustum.
+	Return Type: Frustum
+	Param:
+	    const glm::mat4& viewProj: Projection matrix multiplied by the view matrix.
+	*/
+	static Frustum FromMatrix(const glm::mat4& viewProj);
+
+	glm::vec4 m_planes[6]; // Normalized, inward facing planes. XYZ is the normal & W the distance, points are inside where dot(normal, point) + distance >= 0.
+};
+
+// View mesh LODs of camera instances are selected for, & whose distance to visible instances orders draws.
+struct LODView
+{
+	glm::vec3 m_v3Position;
+	float m_fProjectionScale; // Pixels per world space unit at a distance of one, half the viewport height times the projection's Y scale.
+};
+
+// Mesh space bounding box of a mesh.
+struct MeshBounds
+{
+	glm::vec3 m_v3Center;
+	glm::vec3 m_v3Extents; // Half size of the box on each axis.
+};
+
+// World space AABBs of instances, as a structure of arrays.
+class InstanceBounds
+{
+public:
+
+	InstanceBounds();
+
+	~InstanceBounds();
+
+	InstanceBounds(const InstanceBounds&) = delete;
+	InstanceBounds& operator=(const InstanceBounds&) = delete;
+
+	/*
+	Description: Resize the arrays, keeping the bounds of instances within the new size.
+	Param:
+	    uint32_t nCount: Amount of instances, the arrays are padded up to a multiple of CULL_SIMD_WIDTH.
+	*/
+	void Resize(uint32_t nCount);
+
+	/*
+	Description: Set the bounds of an instance to the AABB of transformed mesh bounds.
+	Param:
+	    uint32_t nIndex: Index of the instance.
+		const MeshBounds& meshBounds: Mesh space bounds of the instance's mesh.
+		const glm::mat4& modelMat: Model matrix of the instance.
+	*/
+	void Set(uint32_t nIndex, const MeshBounds& meshBounds, const glm::mat4& modelMat);
+
+	uint32_t Capacity() const;
+
+	float* m_centerX;
+	float* m_centerY;
+	float* m_centerZ;
+	float* m_extentsX;
+	float* m_extentsY;
+	float* m_extentsZ;
+
+private:
+
+	float* m_data; // All six arrays in one allocation.
+	uint32_t m_nCapacity;
+};
+
+class FrustumCuller
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer, whose job system & upload arena are used.
+	*/
+	FrustumCuller(Renderer* renderer);
+
+	~FrustumCuller();
+
+	/*
+	Description: Cull the instances of all render objects of the provided pipelines for each view, & write the visible instances to the view's instance buffer of the frame.
+	             Each object's visible instances are contiguous, starting at its visible offset.
+	             Visible camera instances of meshes with LODs are grouped by the LOD selected for them.
+	Param:
+	    const DynamicArray<PipelineData*>& pipelines: Pipelines of the render objects to cull.
+		const Frustum* frusta: Frustum of each view, CULL_VIEW_COUNT in size.
+		uint32_t nViewMask: Views to cull, such as CULL_VIEW_MASK_ALL. Views outside the mask are skipped, since nothing draws them this frame.
+		const LODView& lodView: The camera, for LOD selection.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+	*/
+	void Cull(const DynamicArray<PipelineData*>& pipelines, const Frustum* frusta, uint32_t nViewMask, const LODView& lodView, const uint32_t& nFrameIndex);
+
+	/*
+	Description: Enable or disable culling, while disabled all instances are treated as visible.
+	Param:
+	    bool bEnabled: Whether or not to cull.
+	*/
+	void SetEnabled(bool bEnabled);
+
+	bool IsEnabled() const;
+
+	/*
+	Description: Enable or disable LOD selection, while disabled every instance is drawn at full detail.
+	Param:
+	    bool bEnabled: Whether or not to select LODs.
+	*/
+	void SetLODSelection(bool bEnabled);
+
+	bool IsLODSelection() const;
+
+	// ---------------------------------------------------------------------------------
+	// Results of the last Cull() call.
+
+	uint32_t InstanceCount() const;
+
+	uint32_t VisibleCount(ECullView eView) const;
+
+	/*
+	Description: Get the amount of triangles drawn for the visible instances of a view, at their selected LODs.
+	Return Type: uint64_t
+	Param:
+	    ECullView eView: The view to get the triangle count of.
+	*/
+	uint64_t VisibleTriangleCount(ECullView eView) const;
+
+	/*
+	Description: Get the instance buffer holding the visible instances of every object for a view, written by the last cull of the frame.
+	Return Type: VkBuffer
+	Param:
+	    ECullView eView: The view of the instances.
+		const uint32_t& nFrameIndex: Index of the frame-in-flight.
+	*/
+	VkBuffer InstanceBuffer(ECullView eView, const uint32_t& nFrameIndex) const;
+
+	/*
+	Description: Get the CPU time in milliseconds spent culling & compacting, excluding uploads.
+	Return Type: double
+	*/
+	double CullTime() const;
+
+	// ---------------------------------------------------------------------------------
+	// Kernels
+
+	/*
+	Description: Test a range of bounds against a frustum with the SIMD kernel & write the indices of visible bounds, returns the amount of visible bounds.
+	Return Type: uint32_t
+	Param:
+	    const Frustum& frustum: The frustum to test against.
+		const InstanceBounds& bounds: The bounds to test.
+		uint32_t nStart: First index of the range, must be a multiple of CULL_SIMD_WIDTH.
+		uint32_t nEnd: End of the range.
+		uint32_t* outIndices: Visible indices in ascending order, must fit nEnd - nStart indices rounded up to CULL_SIMD_WIDTH.
+	*/
+	static uint32_t CullBounds(const Frustum& frustum, const InstanceBounds& bounds, uint32_t nStart, uint32_t nEnd, uint32_t* outIndices);
+
+	/*
+	Description: Scalar reference of CullBounds(), with the same results.
+	Return Type: uint32_t
+	*/
+	static uint32_t CullBoundsScalar(const Frustum& frustum, const InstanceBounds& bounds, uint32_t nStart, uint32_t nEnd, uint32_t* outIndices);
+
+private:
+
+	// A range of one render object's instances, culled by a single job.
+	struct CullBatch
+	{
+		RenderObject* m_object;
+		uint32_t m_nStart;
+		uint32_t m_nEnd;
+		uint32_t m_nVisibleCounts[CULL_VIEW_COUNT];
+		float m_fViewDistance; // Distance from the camera to the nearest visible camera instance's bounds.
+	};
+
+	// Cull a batch for each view of the mask, writing its visible instances to the object's visible instance arrays starting at the batch start, & selecting LODs of & the nearest distance to its visible camera instances.
+	inline void CullBatchRange(CullBatch& batch, const Frustum* frusta, uint32_t nViewMask, const LODView& lodView);
+
+	// Reorder an object's compacted visible camera instances by LOD, so each LOD is drawn from a contiguous range.
+	inline void GroupByLOD(RenderObject* obj);
+
+	Renderer* m_renderer;
+	bool m_bEnabled;
+	bool m_bLODSelection;
+
+	std::vector<RenderObject*> m_objects;
+	std::vector<RenderObject*> m_lodObjects; // Objects whose visible camera instances need grouping by LOD.
+	std::vector<CullBatch> m_batches;
+
+	// Visible instances of every object for each view, written each frame so every frame-in-flight has its own.
+	VkBuffer m_instanceBuffers[CULL_VIEW_COUNT][MAX_FRAMES_IN_FLIGHT];
+	MemAllocation m_instanceMemories[CULL_VIEW_COUNT][MAX_FRAMES_IN_FLIGHT];
+	uint32_t m_nInstanceCapacities[CULL_VIEW_COUNT][MAX_FRAMES_IN_FLIGHT];
+
+	uint32_t m_nInstanceCount;
+	uint32_t m_nVisibleCounts[CULL_VIEW_COUNT];
+	uint64_t m_nVisibleTriangleCounts[CULL_VIEW_COUNT];
+	double m_dCullTime;
+};
@@ -2,13 +2,14 @@
 #include "RenderObject.h"
 #include "SubScene.h"
 #include "Material.h"
+#include "CPUProfiler.h"
 
 VkCommandBufferInheritanceInfo GBufferPass::m_inheritanceInfo =
 {
 	VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
 	nullptr,
 	VK_NULL_HANDLE,
-	G_BUFFER_SUBPASS_INDEX,
+	0,
 	VK_NULL_HANDLE,
 	VK_FALSE,
 	0,
@@ -23,15 +24,18 @@ VkCommandBufferBeginInfo GBufferPass::m_beginInfo =
 	&GBufferPass::m_inheritanceInfo
 }; 
 
-GBufferPass::GBufferPass(Renderer* renderer, DynamicArray<PipelineData*>* pipelines, VkCommandPool cmdPool, VkRenderPass pass, VkDescriptorSet* mvpUBOSets, uint32_t nQueueFamilyIndex)
-	: RenderModule(renderer, cmdPool, pass, nQueueFamilyIndex, false)
+GBufferPass::GBufferPass(Renderer* renderer, DynamicArray<PipelineData*>* pipelines, VkCommandPool cmdPool, VkRenderPass pass, uint32_t nSubpassIndex, VkDescriptorSet* mvpUBOSets, uint32_t nQueueFamilyIndex,
+	ECullPhase ePhase)
+	: RenderModule(renderer, cmdPool, pass, nSubpassIndex, nQueueFamilyIndex, false), m_drawList(renderer)
 {
 	m_renderer = renderer;
 	m_pipelines = pipelines;
+	m_ePhase = ePhase;
+	m_bindStats = {};
 	m_nQueueFamilyIndex = nQueueFamilyIndex;
 	std::memcpy(m_mvpUBODescSets, mvpUBOSets, sizeof(VkDescriptorSet) * MAX_FRAMES_IN_FLIGHT);
 
-	m_inheritanceInfo.renderPass = m_renderPass;
+	CreateWorkerCmdBuffers();
 }
 
 GBufferPass::~GBufferPass()
@@ -41,46 +45,71 @@ GBufferPass::~GBufferPass()
 
 void GBufferPass::RecordCommandBuffer(const uint32_t& nPresentImageIndex, const uint32_t& nFrameIndex, const VkFramebuffer& framebuffer, const VkCommandBuffer transferCmdBuf)
 {
-	// Set inheritence framebuffer & render pass.
+	CPU_PROFILE_ZONE("GBufferPass::RecordCommandBuffer");
+
+	// Set inheritence framebuffer, render pass & subpass.
 	m_inheritanceInfo.framebuffer = framebuffer;
 	m_inheritanceInfo.renderPass = m_renderPass;
-
-	VkCommandBuffer cmdBuf = m_cmdBuffers[nFrameIndex];
-
-	// Begin recording...
-	RENDERER_SAFECALL(vkBeginCommandBuffer(cmdBuf, &m_beginInfo), "GBufferPass Error: Failed to begin recording of draw commands.");
+	m_inheritanceInfo.subpass = m_nSubpassIndex;
 
 	DynamicArray<PipelineData*>& pipelines = *m_pipelines;
 
-	// Iterate through all pipelines for the subscene and draw their renderobjects.
+	// Flatten all pipelines for the subscene into a single draw list, and write per-frame data on this thread since the upload arena is not thread safe.
+	m_drawList.Clear();
+
 	for (uint32_t i = 0; i < pipelines.Count(); ++i)
 	{
-		PipelineData& data = *pipelines[i];
+		PipelineData* data = pipelines[i];
 
-		// Bind pipelines...
-		vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, data.m_handle);
+		// Properties are written once per frame, by the early phase.
+		if (m_ePhase == CULL_PHASE_EARLY)
+		{
+			for (uint32_t j = 0; j < data->m_materials.Count(); ++j)
+				data->m_materials[j]->UpdateProperties(nFrameIndex);
+		}
 
-		data.m_material->UseDescriptorSet(cmdBuf, transferCmdBuf, data.m_layout, m_mvpUBODescSets[nFrameIndex], nFrameIndex);
+		VkPipeline pipeline = m_ePhase == CULL_PHASE_LATE ? data->m_lateHandle : data->m_handle;
 
-		for (uint32_t j = 0; j < data.m_renderObjects.Count(); ++j)
+		for (uint32_t j = 0; j < data->m_renderObjects.Count(); ++j)
 		{
-			RenderObject& obj = *data.m_renderObjects[j];
+			RenderObject* obj = data->m_renderObjects[j];
 
-			// Request instance data update for next frame & draw current state of the renderobject.
-			obj.UpdateInstanceData(transferCmdBuf);
-			obj.CommandDraw(cmdBuf);
+			// Skip objects with every instance culled.
+			if (obj->VisibleInstanceCount(CULL_VIEW_CAMERA, m_ePhase) > 0)
+				obj->AddDraws(m_drawList, pipeline, i, CULL_VIEW_CAMERA, nFrameIndex, m_ePhase);
 		}
 	}
 
-	// End recording...
-	RENDERER_SAFECALL(vkEndCommandBuffer(cmdBuf), "GBufferPass Error: Failed to end recording of draw commands.");
+	// Group draws by state, front to back within each material, & merge draws sharing all state into multi-draw batches.
+	m_drawList.Build(nFrameIndex);
+
+	m_nDrawCallCount = m_drawList.DrawCallCount();
+	m_bindStats = {};
+
+	// Record the draw list's batches across the worker threads.
+	RecordParallel(nFrameIndex, m_drawList.BatchCount(), m_beginInfo, [&](VkCommandBuffer cmdBuf, uint32_t nStart, uint32_t nEnd)
+	{
+		// Pipelines use dynamic viewport & scissor state, set it to the current output size.
+		RecordViewportState(cmdBuf);
+
+		DrawListStats stats = {};
+		m_drawList.Record(cmdBuf, nStart, nEnd, m_mvpUBODescSets[nFrameIndex], nFrameIndex, stats);
+
+		std::lock_guard<std::mutex> lock(m_bindStatsMutex);
+		m_bindStats.Add(stats);
+	});
 }
 
 void GBufferPass::OnOutputResize(const RenderModuleResizeData& resizeData)
 {
-	// Update render pass handle.
-	m_renderPass = resizeData.m_renderPass;
+	// Update output size.
+	RenderModule::OnOutputResize(resizeData);
 
 	// Update MVP UBO descriptor sets.
 	std::memcpy(m_mvpUBODescSets, resizeData.m_mvpUBOSets, sizeof(VkDescriptorSet) * MAX_FRAMES_IN_FLIGHT);
 }
+
+const DrawListStats& GBufferPass::BindStats() const
+{
+	return m_bindStats;
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include "RenderModule.h"
+#include "FrustumCuller.h"
+#include "DrawList.h"
+#include <mutex>
 
 class RenderObject;
 
@@ -9,7 +12,8 @@ class GBufferPass : public RenderModule
 {
 public:
 
-	GBufferPass(Renderer* renderer, DynamicArray<PipelineData*>* pipelines, VkCommandPool cmdPool, VkRenderPass pass, VkDescriptorSet* mvpUBOSets, uint32_t nQueueFamilyIndex);
+	GBufferPass(Renderer* renderer, DynamicArray<PipelineData*>* pipelines, VkCommandPool cmdPool, VkRenderPass pass, uint32_t nSubpassIndex, VkDescriptorSet* mvpUBOSets, uint32_t nQueueFamilyIndex,
+		ECullPhase ePhase = CULL_PHASE_EARLY);
 
 	~GBufferPass();
 
@@ -17,6 +21,12 @@ public:
 
 	void OnOutputResize(const RenderModuleResizeData& resizeData) override;
 
+	/*
+	Description: Get the binds issued & skipped while recording the last frame's draw list.
+	Return Type: const DrawListStats&
+	*/
+	const DrawListStats& BindStats() const;
+
 private:
 
 	// ---------------------------------------------------------------------------------
@@ -34,6 +44,10 @@ private:
 	// Scene data
 
 	DynamicArray<PipelineData*>* m_pipelines;
+	DrawList m_drawList; // Sorted draws of the current frame, partitioned across recording threads.
+	DrawListStats m_bindStats;
+	std::mutex m_bindStatsMutex;
+	ECullPhase m_ePhase; // Occlusion culling phase whose visible instances are drawn.
 
 	// ---------------------------------------------------------------------------------
 };
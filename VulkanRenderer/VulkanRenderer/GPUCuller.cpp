@@ -0,0 +1,744 @@
+#include "GPUCuller.h"
+#include "Renderer.h"
+#include "RenderObject.h"
+#include "SubScene.h"
+#include "Mesh.h"
+#include "Texture.h"
+#include "DepthPyramid.h"
+#include "RendererHelper.h"
+#include "UploadArena.h"
+#include "PipelineCache.h"
+#include "CPUProfiler.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+// The culling shader reads instances as a bare model matrix.
+static_assert(sizeof(Instance) == sizeof(glm::mat4), "GPU Culler Error: Instance layout must match the culling shader.");
+
+GPUCuller::GPUCuller(Renderer* renderer)
+{
+	m_renderer = renderer;
+
+	m_shaderModule = VK_NULL_HANDLE;
+	m_lateShaderModule = VK_NULL_HANDLE;
+	m_setLayout = VK_NULL_HANDLE;
+	m_pyramidSetLayout = VK_NULL_HANDLE;
+	m_pipelineLayout = VK_NULL_HANDLE;
+	m_pipeline = VK_NULL_HANDLE;
+	m_latePipeline = VK_NULL_HANDLE;
+	m_descPool = VK_NULL_HANDLE;
+	m_pyramidSet = VK_NULL_HANDLE;
+	m_cmdPool = VK_NULL_HANDLE;
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		FrameResources& frame = m_frames[i];
+
+		for (uint32_t j = 0; j < GPU_CULL_BUFFER_COUNT; ++j)
+			frame.m_buffers[j] = VK_NULL_HANDLE;
+
+		frame.m_descSet = VK_NULL_HANDLE;
+		frame.m_cmdBuf = VK_NULL_HANDLE;
+		frame.m_completeSemaphore = VK_NULL_HANDLE;
+		frame.m_nDrawCapacity = 0;
+		frame.m_nSlotCapacity = 0;
+	}
+
+	m_nSlotCount = 0;
+	m_nDrawCapacity = GPU_CULL_INITIAL_DRAW_CAPACITY;
+	m_nSlotCapacity = GPU_CULL_INITIAL_SLOT_CAPACITY;
+	m_nLayoutUploads = 0;
+	m_depthPyramid = nullptr;
+	m_occlusionView = {};
+	m_bOcclusion = false;
+	m_nVisibilityResets = MAX_FRAMES_IN_FLIGHT;
+	m_stats = {};
+	m_dCullTime = 0.0;
+
+	CreatePipeline();
+
+	// Without the shader there is nothing to dispatch, render objects keep using CPU culling.
+	if (!IsAvailable())
+		return;
+
+	// The late phase reads the depth pyramid, without either the camera's instances are only frustum culled.
+	if (m_latePipeline)
+		m_depthPyramid = new DepthPyramid(m_renderer);
+
+	CreateDescriptors();
+	CreateCmds();
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		CreateBuffers(i);
+}
+
+GPUCuller::~GPUCuller()
+{
+	VkDevice device = m_renderer->GetDevice();
+
+	if (IsAvailable())
+	{
+		// Wait for the last culling dispatches & the draws reading their results.
+		vkQueueWaitIdle(m_renderer->GetComputeQueue());
+		m_renderer->WaitGraphicsIdle();
+
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		{
+			DestroyBuffers(i);
+			vkDestroySemaphore(device, m_frames[i].m_completeSemaphore, nullptr);
+		}
+
+		vkDestroyCommandPool(device, m_cmdPool, nullptr);
+		vkDestroyDescriptorPool(device, m_descPool, nullptr);
+		vkDestroyPipeline(device, m_pipeline, nullptr);
+	}
+
+	delete m_depthPyramid;
+
+	if (m_latePipeline)
+		vkDestroyPipeline(device, m_latePipeline, nullptr);
+
+	if (m_pipelineLayout)
+		vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+
+	if (m_setLayout)
+		vkDestroyDescriptorSetLayout(device, m_setLayout, nullptr);
+
+	if (m_pyramidSetLayout)
+		vkDestroyDescriptorSetLayout(device, m_pyramidSetLayout, nullptr);
+
+	if (m_shaderModule)
+		vkDestroyShaderModule(device, m_shaderModule, nullptr);
+
+	if (m_lateShaderModule)
+		vkDestroyShaderModule(device, m_lateShaderModule, nullptr);
+}
+
+bool GPUCuller::IsAvailable() const
+{
+	return m_pipeline != VK_NULL_HANDLE;
+}
+
+bool GPUCuller::IsOcclusionAvailable() const
+{
+	return IsAvailable() && m_latePipeline != VK_NULL_HANDLE && m_depthPyramid && m_depthPyramid->IsAvailable();
+}
+
+void GPUCuller::Cull(const DynamicArray<PipelineData*>& pipelines, const Frustum* frusta, uint32_t nViewMask, const OcclusionCullView* occlusionView, const uint32_t& nFrameIndex)
+{
+	CPU_PROFILE_ZONE("GPUCuller::Cull");
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Instance slots may have moved, so their visibility no longer applies.
+	if (UpdateLayout(pipelines))
+	{
+		m_nLayoutUploads = MAX_FRAMES_IN_FLIGHT;
+		m_nVisibilityResets = MAX_FRAMES_IN_FLIGHT;
+	}
+
+	FrameResources& frame = m_frames[nFrameIndex];
+	UploadArena* uploadArena = m_renderer->GetUploadArena();
+
+	// The frame's fence has been waited on, so its last late phase has completed. Read back its stats before they are reset.
+	m_bOcclusion = occlusionView && IsOcclusionAvailable();
+	std::memcpy(&m_stats, frame.m_memories[GPU_CULL_BUFFER_STATS].m_mappedPtr, sizeof(OcclusionStats));
+
+	// Replace buffers the layout has outgrown. Other frames still in flight may be reading theirs, so each frame's are replaced when it comes around again.
+	if (frame.m_nDrawCapacity != m_nDrawCapacity || frame.m_nSlotCapacity != m_nSlotCapacity)
+	{
+		DestroyBuffers(nFrameIndex);
+		CreateBuffers(nFrameIndex);
+	}
+
+	OcclusionStats clearStats = {};
+	uploadArena->Write(frame.m_buffers[GPU_CULL_BUFFER_STATS], frame.m_memories[GPU_CULL_BUFFER_STATS], 0, &clearStats, sizeof(OcclusionStats), true);
+
+	if (m_bOcclusion)
+		m_occlusionView = *occlusionView;
+	else
+		m_nVisibilityResets = MAX_FRAMES_IN_FLIGHT; // Visibility isn't updated without the late phase.
+
+	// ---------------------------------------------------------------------------------
+	// Draws & instances
+
+	// Only modified instances are written, once to each frame's buffer. Everything else written here is per object, not per instance.
+	for (RenderObject* obj : m_objects)
+	{
+		obj->m_gpuCuller = this;
+
+		// The exact visible counts only exist on the GPU, so the instance count stands in as an upper bound. Skipped views have none.
+		for (uint32_t v = 0; v < CULL_VIEW_COUNT; ++v)
+			obj->m_nVisibleCounts[v] = (nViewMask & CULL_VIEW_BIT(v)) ? obj->m_nInstanceCount : 0;
+
+		obj->m_nLateVisibleCount = m_bOcclusion ? obj->m_nInstanceCount : 0;
+		obj->m_fViewDistance = 0.0f; // Distances aren't read back, so GPU culled draws only sort by state.
+
+		m_draws[obj->m_nGPUDrawIndex].m_nInstanceCount = obj->m_nInstanceCount;
+
+		DirtyBitset& uploads = obj->m_gpuInstanceUploads[nFrameIndex];
+
+		if (uploads.Any())
+		{
+			uploads.TakeRanges(obj->m_nInstanceCount, GPU_CULL_UPLOAD_MERGE_GAP, m_uploadRanges);
+
+			for (const DirtyRange& range : m_uploadRanges)
+			{
+				uploadArena->Write(frame.m_buffers[GPU_CULL_BUFFER_INSTANCES], frame.m_memories[GPU_CULL_BUFFER_INSTANCES], static_cast<VkDeviceSize>(obj->m_nGPUSlotBase + range.m_nStart) * sizeof(Instance),
+					&obj->m_instanceArray[range.m_nStart], (range.m_nEnd - range.m_nStart) * sizeof(Instance), true);
+			}
+		}
+	}
+
+	if (m_nLayoutUploads > 0)
+	{
+		if (m_nSlotCount > 0)
+			uploadArena->Write(frame.m_buffers[GPU_CULL_BUFFER_SLOT_DRAWS], frame.m_memories[GPU_CULL_BUFFER_SLOT_DRAWS], 0, m_slotDraws.data(), m_nSlotCount * sizeof(uint32_t), true);
+
+		--m_nLayoutUploads;
+	}
+
+	if (m_nVisibilityResets > 0)
+	{
+		// Every instance is drawn in the early phase until the late phase has tested it.
+		if (m_nSlotCount > 0)
+		{
+			std::vector<uint32_t> visibility(m_nSlotCount, 1);
+			uploadArena->Write(frame.m_buffers[GPU_CULL_BUFFER_VISIBILITY], frame.m_memories[GPU_CULL_BUFFER_VISIBILITY], 0, visibility.data(), m_nSlotCount * sizeof(uint32_t), true);
+		}
+
+		--m_nVisibilityResets;
+	}
+
+	uint32_t nDrawCount = DrawCount();
+
+	if (nDrawCount > 0)
+	{
+		uploadArena->Write(frame.m_buffers[GPU_CULL_BUFFER_DRAWS], frame.m_memories[GPU_CULL_BUFFER_DRAWS], 0, m_draws.data(), nDrawCount * sizeof(DrawData), true);
+
+		// Reset the instance counts the shaders append to. Lists of skipped views are neither appended to nor drawn this frame.
+		for (uint32_t l = 0; l < GPU_CULL_LIST_COUNT; ++l)
+		{
+			if (l < CULL_VIEW_COUNT && !(nViewMask & CULL_VIEW_BIT(l)))
+				continue;
+
+			uploadArena->Write(frame.m_buffers[GPU_CULL_BUFFER_COMMANDS], frame.m_memories[GPU_CULL_BUFFER_COMMANDS], static_cast<VkDeviceSize>(l) * m_nDrawCapacity * sizeof(VkDrawIndexedIndirectCommand),
+				m_commands.data(), nDrawCount * sizeof(VkDrawIndexedIndirectCommand), true);
+		}
+	}
+
+	CullParams params = {};
+
+	for (uint32_t v = 0; v < CULL_VIEW_COUNT; ++v)
+	{
+		for (uint32_t p = 0; p < 6; ++p)
+			params.m_planes[v * 6 + p] = frusta[v].m_planes[p];
+	}
+
+	params.m_nSlotCount = m_nSlotCount;
+	params.m_nDrawCapacity = m_nDrawCapacity;
+	params.m_nSlotCapacity = m_nSlotCapacity;
+	params.m_nOcclusion = m_bOcclusion ? 1 : 0;
+	params.m_viewProj = m_occlusionView.m_viewProj;
+	params.m_nViewMask = nViewMask;
+
+	uploadArena->Write(frame.m_buffers[GPU_CULL_BUFFER_PARAMS], frame.m_memories[GPU_CULL_BUFFER_PARAMS], 0, &params, sizeof(CullParams), true);
+
+	// ---------------------------------------------------------------------------------
+	// Dispatch
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = nullptr;
+
+	RENDERER_SAFECALL(vkBeginCommandBuffer(frame.m_cmdBuf, &beginInfo), "GPU Culler Error: Failed to begin recording of culling command buffer.");
+
+	if (m_nSlotCount > 0)
+	{
+		vkCmdBindPipeline(frame.m_cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+		vkCmdBindDescriptorSets(frame.m_cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &frame.m_descSet, 0, nullptr);
+
+		// One invocation per instance slot.
+		vkCmdDispatch(frame.m_cmdBuf, (m_nSlotCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE, 1, 1);
+	}
+
+	RENDERER_SAFECALL(vkEndCommandBuffer(frame.m_cmdBuf), "GPU Culler Error: Failed to end recording of culling command buffer.");
+
+	// Submitted ahead of the frame's rendering, which waits on the semaphore before reading the draw commands & visible instances.
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &frame.m_cmdBuf;
+	submitInfo.waitSemaphoreCount = 0;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &frame.m_completeSemaphore;
+	submitInfo.pNext = nullptr;
+
+	RENDERER_SAFECALL(vkQueueSubmit(m_renderer->GetComputeQueue(), 1, &submitInfo, VK_NULL_HANDLE), "GPU Culler Error: Failed to submit culling command buffer.");
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	m_dCullTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+}
+
+void GPUCuller::CullLate(VkCommandBuffer cmdBuf, Texture* depthTexture, const uint32_t& nFrameIndex)
+{
+	CPU_PROFILE_ZONE("GPUCuller::CullLate");
+
+	if (!m_bOcclusion || m_nSlotCount == 0)
+		return;
+
+	// ---------------------------------------------------------------------------------
+	// Depth pyramid
+
+	if (m_depthPyramid->Build(cmdBuf, depthTexture, m_occlusionView.m_nRenderWidth, m_occlusionView.m_nRenderHeight))
+	{
+		// The pyramid was re-created & the device is idle, so its set can be updated.
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.sampler = m_depthPyramid->GetSampler();
+		imageInfo.imageView = m_depthPyramid->ImageView();
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_pyramidSet;
+		write.dstBinding = 0;
+		write.dstArrayElement = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(m_renderer->GetDevice(), 1, &write, 0, nullptr);
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Dispatch
+
+	LateCullConstants constants = {};
+	m_depthPyramid->BuildSize(constants.m_nPyramidWidth, constants.m_nPyramidHeight);
+	constants.m_nPyramidLevels = m_depthPyramid->LevelCount();
+
+	VkDescriptorSet sets[2] = { m_frames[nFrameIndex].m_descSet, m_pyramidSet };
+
+	vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_latePipeline);
+	vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 2, sets, 0, nullptr);
+	vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(LateCullConstants), &constants);
+
+	vkCmdDispatch(cmdBuf, (m_nSlotCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE, 1, 1);
+
+	// The late draws read the appended commands & instances, the host reads the stats once the frame completes.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GPUCuller::OnDepthAttachmentDestroyed()
+{
+	if (m_depthPyramid)
+		m_depthPyramid->ReleaseDepthTexture();
+}
+
+VkSemaphore GPUCuller::CompleteSemaphore(const uint32_t& nFrameIndex) const
+{
+	return m_frames[nFrameIndex].m_completeSemaphore;
+}
+
+VkBuffer GPUCuller::DrawCommandBuffer(const uint32_t& nFrameIndex) const
+{
+	return m_frames[nFrameIndex].m_buffers[GPU_CULL_BUFFER_COMMANDS];
+}
+
+VkBuffer GPUCuller::VisibleInstanceBuffer(const uint32_t& nFrameIndex) const
+{
+	return m_frames[nFrameIndex].m_buffers[GPU_CULL_BUFFER_VISIBLE];
+}
+
+VkDeviceSize GPUCuller::DrawCommandOffset(ECullView eView, uint32_t nDrawIndex, ECullPhase ePhase) const
+{
+	uint32_t nList = ePhase == CULL_PHASE_LATE ? GPU_CULL_LATE_LIST : static_cast<uint32_t>(eView);
+
+	return (static_cast<VkDeviceSize>(nList) * m_nDrawCapacity + nDrawIndex) * sizeof(VkDrawIndexedIndirectCommand);
+}
+
+VkDeviceSize GPUCuller::VisibleInstanceOffset(ECullView eView, uint32_t nSlotBase, ECullPhase ePhase) const
+{
+	uint32_t nList = ePhase == CULL_PHASE_LATE ? GPU_CULL_LATE_LIST : static_cast<uint32_t>(eView);
+
+	return (static_cast<VkDeviceSize>(nList) * m_nSlotCapacity + nSlotBase) * sizeof(Instance);
+}
+
+uint32_t GPUCuller::DrawCount() const
+{
+	return static_cast<uint32_t>(m_draws.size());
+}
+
+uint32_t GPUCuller::SlotCount() const
+{
+	return m_nSlotCount;
+}
+
+double GPUCuller::CullTime() const
+{
+	return m_dCullTime;
+}
+
+uint32_t GPUCuller::OccludedInstanceCount() const
+{
+	return m_stats.m_nOccludedInstances;
+}
+
+uint32_t GPUCuller::OccludedTriangleCount() const
+{
+	return m_stats.m_nOccludedTriangles;
+}
+
+inline void GPUCuller::CreatePipeline()
+{
+	VkDevice device = m_renderer->GetDevice();
+
+	// ---------------------------------------------------------------------------------
+	// Shader modules
+
+	m_shaderModule = RendererHelper::CreateShaderModule(device, GPU_CULL_SHADER_PATH);
+
+	if (!m_shaderModule)
+	{
+		std::cout << "GPU Culler Warning: Failed to open culling shader file at: " << GPU_CULL_SHADER_PATH << ", GPU culling is unavailable." << std::endl;
+		return;
+	}
+
+	m_lateShaderModule = RendererHelper::CreateShaderModule(device, GPU_CULL_LATE_SHADER_PATH);
+
+	if (!m_lateShaderModule)
+		std::cout << "GPU Culler Warning: Failed to open late culling shader file at: " << GPU_CULL_LATE_SHADER_PATH << ", occlusion culling is unavailable." << std::endl;
+
+	// ---------------------------------------------------------------------------------
+	// Set layouts
+
+	VkDescriptorSetLayoutBinding bindings[GPU_CULL_BUFFER_COUNT] = {};
+
+	for (uint32_t i = 0; i < GPU_CULL_BUFFER_COUNT; ++i)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = i == GPU_CULL_BUFFER_PARAMS ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		bindings[i].pImmutableSamplers = nullptr;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.flags = 0;
+	layoutInfo.bindingCount = GPU_CULL_BUFFER_COUNT;
+	layoutInfo.pBindings = bindings;
+	layoutInfo.pNext = nullptr;
+
+	RENDERER_SAFECALL(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_setLayout), "GPU Culler Error: Failed to create culling set layout.");
+
+	// Depth pyramid of the late phase.
+	VkDescriptorSetLayoutBinding pyramidBinding = {};
+	pyramidBinding.binding = 0;
+	pyramidBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pyramidBinding.descriptorCount = 1;
+	pyramidBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pyramidBinding.pImmutableSamplers = nullptr;
+
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &pyramidBinding;
+
+	RENDERER_SAFECALL(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_pyramidSetLayout), "GPU Culler Error: Failed to create depth pyramid set layout.");
+
+	// ---------------------------------------------------------------------------------
+	// Pipelines
+
+	VkDescriptorSetLayout setLayouts[2] = { m_setLayout, m_pyramidSetLayout };
+
+	VkPushConstantRange pushRange = {};
+	pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushRange.offset = 0;
+	pushRange.size = sizeof(LateCullConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 2;
+	pipelineLayoutInfo.pSetLayouts = setLayouts;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+
+	RENDERER_SAFECALL(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout), "GPU Culler Error: Failed to create culling pipeline layout.");
+
+	VkComputePipelineCreateInfo pipelineInfos[2] = {};
+
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		pipelineInfos[i].sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfos[i].stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfos[i].stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfos[i].stage.module = i == 0 ? m_shaderModule : m_lateShaderModule;
+		pipelineInfos[i].stage.pName = "main";
+		pipelineInfos[i].layout = m_pipelineLayout;
+		pipelineInfos[i].basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfos[i].basePipelineIndex = -1;
+	}
+
+	VkPipeline pipelines[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+	m_renderer->GetPipelineCache()->CreateComputePipelines(pipelineInfos, m_lateShaderModule ? 2 : 1, pipelines);
+
+	m_pipeline = pipelines[0];
+	m_latePipeline = pipelines[1];
+}
+
+inline void GPUCuller::CreateDescriptors()
+{
+	// One uniform buffer & the remaining storage buffers for each frame, & the depth pyramid.
+	VkDescriptorPoolSize poolSizes[3] = {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	poolSizes[0].descriptorCount = MAX_FRAMES_IN_FLIGHT;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = MAX_FRAMES_IN_FLIGHT * (GPU_CULL_BUFFER_COUNT - 1);
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[2].descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.maxSets = MAX_FRAMES_IN_FLIGHT + 1;
+	poolCreateInfo.poolSizeCount = 3;
+	poolCreateInfo.pPoolSizes = poolSizes;
+	poolCreateInfo.flags = 0;
+	poolCreateInfo.pNext = nullptr;
+
+	RENDERER_SAFECALL(vkCreateDescriptorPool(m_renderer->GetDevice(), &poolCreateInfo, nullptr, &m_descPool), "GPU Culler Error: Failed to create descriptor pool.");
+
+	VkDescriptorSetLayout setLayouts[MAX_FRAMES_IN_FLIGHT];
+	VkDescriptorSet descSets[MAX_FRAMES_IN_FLIGHT];
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		setLayouts[i] = m_setLayout;
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_descPool;
+	allocInfo.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
+	allocInfo.pSetLayouts = setLayouts;
+	allocInfo.pNext = nullptr;
+
+	RENDERER_SAFECALL(vkAllocateDescriptorSets(m_renderer->GetDevice(), &allocInfo, descSets), "GPU Culler Error: Failed to allocate descriptor sets.");
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		m_frames[i].m_descSet = descSets[i];
+
+	// Written once the pyramid is first built.
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &m_pyramidSetLayout;
+
+	RENDERER_SAFECALL(vkAllocateDescriptorSets(m_renderer->GetDevice(), &allocInfo, &m_pyramidSet), "GPU Culler Error: Failed to allocate depth pyramid descriptor set.");
+}
+
+inline void GPUCuller::CreateCmds()
+{
+	// Culling is recorded & submitted on the compute queue's family.
+	VkCommandPoolCreateInfo cmdPoolCreateInfo = {};
+	cmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	cmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	cmdPoolCreateInfo.queueFamilyIndex = m_renderer->ComputeQueueFamilyIndex();
+	cmdPoolCreateInfo.pNext = nullptr;
+
+	RENDERER_SAFECALL(vkCreateCommandPool(m_renderer->GetDevice(), &cmdPoolCreateInfo, nullptr, &m_cmdPool), "GPU Culler Error: Failed to create culling command pool.");
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = m_cmdPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	allocInfo.pNext = nullptr;
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.flags = 0;
+	semaphoreInfo.pNext = nullptr;
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		RENDERER_SAFECALL(vkAllocateCommandBuffers(m_renderer->GetDevice(), &allocInfo, &m_frames[i].m_cmdBuf), "GPU Culler Error: Failed to allocate culling command buffers.");
+		RENDERER_SAFECALL(vkCreateSemaphore(m_renderer->GetDevice(), &semaphoreInfo, nullptr, &m_frames[i].m_completeSemaphore), "GPU Culler Error: Failed to create culling semaphores.");
+	}
+}
+
+inline bool GPUCuller::UpdateLayout(const DynamicArray<PipelineData*>& pipelines)
+{
+	// The layout is unchanged if every object still has the draw index it was given, in the same order.
+	uint32_t nObjectCount = 0;
+	bool bChanged = false;
+
+	for (uint32_t i = 0; i < pipelines.Count(); ++i)
+	{
+		const PipelineData& data = *pipelines[i];
+
+		for (uint32_t j = 0; j < data.m_renderObjects.Count(); ++j, ++nObjectCount)
+		{
+			RenderObject* obj = data.m_renderObjects[j];
+
+			// Objects whose instance capacity grew need more slots, moving every object after them.
+			if (nObjectCount >= m_objects.size() || m_objects[nObjectCount] != obj || obj->m_nGPUDrawIndex != nObjectCount || obj->m_nGPUSlotCount != obj->m_nInstanceArraySize)
+				bChanged = true;
+		}
+	}
+
+	if (!bChanged && nObjectCount == m_objects.size())
+		return false;
+
+	// ---------------------------------------------------------------------------------
+	// Assign draws & instance slots
+
+	// Objects may have been destroyed since the last layout, so only the current objects are touched.
+	m_objects.clear();
+	m_draws.clear();
+	m_commands.clear();
+	m_slotDraws.clear();
+	m_nSlotCount = 0;
+
+	for (uint32_t i = 0; i < pipelines.Count(); ++i)
+	{
+		const PipelineData& data = *pipelines[i];
+
+		for (uint32_t j = 0; j < data.m_renderObjects.Count(); ++j)
+		{
+			RenderObject* obj = data.m_renderObjects[j];
+			uint32_t nDrawIndex = static_cast<uint32_t>(m_objects.size());
+
+			obj->m_nGPUDrawIndex = nDrawIndex;
+			obj->m_nGPUSlotBase = m_nSlotCount;
+			obj->m_nGPUSlotCount = obj->m_nInstanceArraySize;
+
+			for (uint32_t k = 0; k < MAX_FRAMES_IN_FLIGHT; ++k)
+				obj->m_gpuInstanceUploads[k].MarkRange(0, obj->m_nInstanceCount);
+
+			const MeshBounds& meshBounds = obj->m_mesh->Bounds();
+
+			DrawData draw = {};
+			draw.m_v4Center = glm::vec4(meshBounds.m_v3Center, 0.0f);
+			draw.m_v4Extents = glm::vec4(meshBounds.m_v3Extents, 0.0f);
+			draw.m_nInstanceCount = obj->m_nInstanceCount;
+			draw.m_nSlotBase = m_nSlotCount;
+
+			VkDrawIndexedIndirectCommand command = {};
+			command.indexCount = obj->m_mesh->IndexCount();
+			command.instanceCount = 0;
+			command.firstIndex = obj->m_mesh->FirstIndex();
+			command.vertexOffset = obj->m_mesh->BaseVertex();
+
+			// With multi-draw indirect the view's instances are bound once & each draw starts at its slots, otherwise instances are offset by the vertex buffer binding.
+			command.firstInstance = m_renderer->MultiDrawIndirectSupported() ? m_nSlotCount : 0;
+
+			m_objects.push_back(obj);
+			m_draws.push_back(draw);
+			m_commands.push_back(command);
+
+			// Every object reserves slots for its instance capacity, so adding instances only moves other objects when the capacity grows.
+			m_slotDraws.insert(m_slotDraws.end(), obj->m_nInstanceArraySize, nDrawIndex);
+			m_nSlotCount += obj->m_nInstanceArraySize;
+		}
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Grow buffers
+
+	uint32_t nDrawCount = DrawCount();
+
+	if (nDrawCount > m_nDrawCapacity || m_nSlotCount > m_nSlotCapacity)
+	{
+		m_nDrawCapacity = std::max(nDrawCount, m_nDrawCapacity * 2);
+		m_nSlotCapacity = std::max(m_nSlotCount, m_nSlotCapacity * 2);
+
+		// Each frame's buffers are replaced by Cull() once the frame comes around again, with every instance, slot draw index & visibility rewritten as for any layout change.
+	}
+
+	return true;
+}
+
+inline void GPUCuller::CreateBuffers(const uint32_t& nFrameIndex)
+{
+	// Written by the host each frame before the dispatch, so inputs live in host visible memory, device local where available.
+	VkMemoryPropertyFlags hostMemoryFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	if (m_renderer->GetUploadArena()->PerFrameMemoryFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		hostMemoryFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	VkDeviceSize sizes[GPU_CULL_BUFFER_COUNT];
+	sizes[GPU_CULL_BUFFER_PARAMS] = sizeof(CullParams);
+	sizes[GPU_CULL_BUFFER_INSTANCES] = static_cast<VkDeviceSize>(m_nSlotCapacity) * sizeof(Instance);
+	sizes[GPU_CULL_BUFFER_SLOT_DRAWS] = static_cast<VkDeviceSize>(m_nSlotCapacity) * sizeof(uint32_t);
+	sizes[GPU_CULL_BUFFER_DRAWS] = static_cast<VkDeviceSize>(m_nDrawCapacity) * sizeof(DrawData);
+	sizes[GPU_CULL_BUFFER_COMMANDS] = static_cast<VkDeviceSize>(GPU_CULL_LIST_COUNT) * m_nDrawCapacity * sizeof(VkDrawIndexedIndirectCommand);
+	sizes[GPU_CULL_BUFFER_VISIBLE] = static_cast<VkDeviceSize>(GPU_CULL_LIST_COUNT) * m_nSlotCapacity * sizeof(Instance);
+	sizes[GPU_CULL_BUFFER_VISIBILITY] = static_cast<VkDeviceSize>(m_nSlotCapacity) * sizeof(uint32_t);
+	sizes[GPU_CULL_BUFFER_STATS] = sizeof(OcclusionStats);
+
+	VkBufferUsageFlags usages[GPU_CULL_BUFFER_COUNT];
+	usages[GPU_CULL_BUFFER_PARAMS] = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	usages[GPU_CULL_BUFFER_INSTANCES] = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	usages[GPU_CULL_BUFFER_SLOT_DRAWS] = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	usages[GPU_CULL_BUFFER_DRAWS] = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	usages[GPU_CULL_BUFFER_COMMANDS] = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+	usages[GPU_CULL_BUFFER_VISIBLE] = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	usages[GPU_CULL_BUFFER_VISIBILITY] = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	usages[GPU_CULL_BUFFER_STATS] = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+	FrameResources& frame = m_frames[nFrameIndex];
+
+	VkDescriptorBufferInfo bufferInfos[GPU_CULL_BUFFER_COUNT];
+	VkWriteDescriptorSet writes[GPU_CULL_BUFFER_COUNT] = {};
+
+	for (uint32_t j = 0; j < GPU_CULL_BUFFER_COUNT; ++j)
+	{
+		// Visible instances are only written & read by the GPU.
+		VkMemoryPropertyFlags memoryFlags = j == GPU_CULL_BUFFER_VISIBLE ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT : hostMemoryFlags;
+
+		m_renderer->CreateBuffer(sizes[j], usages[j], memoryFlags, frame.m_buffers[j], frame.m_memories[j], true);
+
+		bufferInfos[j].buffer = frame.m_buffers[j];
+		bufferInfos[j].offset = 0;
+		bufferInfos[j].range = VK_WHOLE_SIZE;
+
+		writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[j].descriptorCount = 1;
+		writes[j].descriptorType = j == GPU_CULL_BUFFER_PARAMS ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[j].dstArrayElement = 0;
+		writes[j].dstBinding = j;
+		writes[j].dstSet = frame.m_descSet;
+		writes[j].pBufferInfo = &bufferInfos[j];
+		writes[j].pNext = nullptr;
+	}
+
+	vkUpdateDescriptorSets(m_renderer->GetDevice(), GPU_CULL_BUFFER_COUNT, writes, 0, nullptr);
+
+	// Stats are read back before the first late phase has written them.
+	std::memset(frame.m_memories[GPU_CULL_BUFFER_STATS].m_mappedPtr, 0, sizeof(OcclusionStats));
+
+	frame.m_nDrawCapacity = m_nDrawCapacity;
+	frame.m_nSlotCapacity = m_nSlotCapacity;
+}
+
+inline void GPUCuller::DestroyBuffers(const uint32_t& nFrameIndex)
+{
+	FrameResources& frame = m_frames[nFrameIndex];
+
+	for (uint32_t j = 0; j < GPU_CULL_BUFFER_COUNT; ++j)
+	{
+		if (!frame.m_buffers[j])
+			continue;
+
+		vkDestroyBuffer(m_renderer->GetDevice(), frame.m_buffers[j], nullptr);
+		m_renderer->FreeMemory(frame.m_memories[j]);
+
+		frame.m_buffers[j] = VK_NULL_HANDLE;
+	}
+}
@@ -0,0 +1,287 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "DynamicArray.h"
+#include "Renderer.h"
+#include "FrustumCuller.h"
+#include "DirtyBitset.h"
+#include "glm.hpp"
+
+/*
+Description: GPU driven frustum culling of render object instances on the compute queue. Instance transforms live in storage buffers & a compute shader
+             tests each instance's bounds against each view's frustum, appending visible instances to per-view instance buffers & counting them in indirect draw commands.
+             CPU work per frame only scales with the amount of render objects, not instances.
+             With occlusion culling the camera's instances are culled in two phases: instances visible after an earlier frame's late phase are drawn first, a depth pyramid is built from their depth
+             and a second dispatch on the graphics queue re-tests every instance against it, drawing the remaining visible instances in a late G-Buffer pass.
+             Visibility is kept per frame-in-flight, so the early phase uses the visibility of MAX_FRAMES_IN_FLIGHT frames ago rather than the last frame's. Instances which became visible
+             since are left to the late phase, & ones which became hidden are still drawn early, so more of the camera's draws move to the late pass the faster the view changes.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+class RenderObject;
+class Texture;
+class DepthPyramid;
+
+struct PipelineData;
+
+#define GPU_CULL_SHADER_PATH "Shaders/SPIR-V/gpu_cull_comp.spv"
+#define GPU_CULL_LATE_SHADER_PATH "Shaders/SPIR-V/gpu_cull_late_comp.spv"
+
+// Must match the local size of the culling shader.
+#define GPU_CULL_GROUP_SIZE 64
+
+// Initial capacities of the culling buffers, which at least double when outgrown.
+#define GPU_CULL_INITIAL_DRAW_CAPACITY 256
+#define GPU_CULL_INITIAL_SLOT_CAPACITY 4096
+
+// Runs of modified instances separated by this many unmodified instances or fewer are written as one range, trading a few redundant bytes for fewer copies.
+#define GPU_CULL_UPLOAD_MERGE_GAP 4
+
+// Draw command & visible instance lists, one for each view & one for the camera's late phase.
+#define GPU_CULL_LIST_COUNT (CULL_VIEW_COUNT + 1)
+#define GPU_CULL_LATE_LIST CULL_VIEW_COUNT
+
+enum EGPUCullBuffer
+{
+	GPU_CULL_BUFFER_PARAMS, // Frusta & counts.
+	GPU_CULL_BUFFER_INSTANCES, // Model matrix of each instance slot.
+	GPU_CULL_BUFFER_SLOT_DRAWS, // Draw index of each instance slot.
+	GPU_CULL_BUFFER_DRAWS, // Mesh bounds, instance count & first slot of each draw.
+	GPU_CULL_BUFFER_COMMANDS, // Indirect draw command of each draw, for each list.
+	GPU_CULL_BUFFER_VISIBLE, // Visible instances of each draw, for each list.
+	GPU_CULL_BUFFER_VISIBILITY, // Whether or not each instance slot was visible to the camera after the late phase of the frame MAX_FRAMES_IN_FLIGHT frames ago.
+	GPU_CULL_BUFFER_STATS, // Instances & triangles culled by occlusion, read back once the frame completes.
+	GPU_CULL_BUFFER_COUNT
+};
+
+// View occlusion culling of the camera's instances tests against.
+struct OcclusionCullView
+{
+	glm::mat4 m_viewProj;
+	uint32_t m_nRenderWidth; // Rendered area of the depth attachment.
+	uint32_t m_nRenderHeight;
+};
+
+class GPUCuller
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer, whose compute queue culling is submitted to.
+	*/
+	GPUCuller(Renderer* renderer);
+
+	~GPUCuller();
+
+	/*
+	Description: Get whether or not the culling shader was loaded, GPU culling is unavailable without it.
+	Return Type: bool
+	*/
+	bool IsAvailable() const;
+
+	/*
+	Description: Get whether or not the late culling & depth pyramid shaders were loaded, occlusion culling is unavailable without them.
+	Return Type: bool
+	*/
+	bool IsOcclusionAvailable() const;
+
+	/*
+	Description: Write the instances & draws of all render objects of the provided pipelines & submit culling for each view to the compute queue.
+	             Render objects draw indirectly from the results this frame, the frame's rendering must wait on CompleteSemaphore().
+	Param:
+	    const DynamicArray<PipelineData*>& pipelines: Pipelines of the render objects to cull.
+		const Frustum* frusta: Frustum of each view, CULL_VIEW_COUNT in size.
+		uint32_t nViewMask: Views to cull, such as CULL_VIEW_MASK_ALL. Views outside the mask are skipped by the shader & have no visible instances.
+		const OcclusionCullView* occlusionView: Camera view to cull occluded instances of, nullptr to disable occlusion culling. CullLate() must be recorded this frame if provided.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+	*/
+	void Cull(const DynamicArray<PipelineData*>& pipelines, const Frustum* frusta, uint32_t nViewMask, const OcclusionCullView* occlusionView, const uint32_t& nFrameIndex);
+
+	/*
+	Description: Record the late phase of occlusion culling, after the early phase's draws have written the depth attachment. Builds the depth pyramid & re-tests the camera's instances,
+	             appending instances visible but not drawn in the early phase to the late draws. Does nothing unless occlusion culling was requested by this frame's Cull().
+	Param:
+	    VkCommandBuffer cmdBuf: The graphics command buffer to record to, outside of a render pass.
+		Texture* depthTexture: The depth attachment, in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+	*/
+	void CullLate(VkCommandBuffer cmdBuf, Texture* depthTexture, const uint32_t& nFrameIndex);
+
+	/*
+	Description: Called when the depth attachment passed to CullLate() is destroyed, the depth pyramid is re-created by the next CullLate().
+	*/
+	void OnDepthAttachmentDestroyed();
+
+	/*
+	Description: Get the semaphore signaled once culling of the provided frame has completed.
+	Return Type: VkSemaphore
+	Param:
+	    const uint32_t& nFrameIndex: Index of the frame-in-flight.
+	*/
+	VkSemaphore CompleteSemaphore(const uint32_t& nFrameIndex) const;
+
+	// ---------------------------------------------------------------------------------
+	// Indirect draw data
+
+	VkBuffer DrawCommandBuffer(const uint32_t& nFrameIndex) const;
+
+	VkBuffer VisibleInstanceBuffer(const uint32_t& nFrameIndex) const;
+
+	/*
+	Description: Get the offset in bytes of a draw's indirect command within the draw command buffer.
+	Return Type: VkDeviceSize
+	Param:
+	    ECullView eView: The view being drawn.
+		uint32_t nDrawIndex: Index of the draw.
+		ECullPhase ePhase: The phase being drawn, only the camera has a late phase.
+	*/
+	VkDeviceSize DrawCommandOffset(ECullView eView, uint32_t nDrawIndex, ECullPhase ePhase = CULL_PHASE_EARLY) const;
+
+	/*
+	Description: Get the offset in bytes of a draw's first visible instance within the visible instance buffer.
+	Return Type: VkDeviceSize
+	Param:
+	    ECullView eView: The view being drawn.
+		uint32_t nSlotBase: First instance slot of the draw.
+		ECullPhase ePhase: The phase being drawn, only the camera has a late phase.
+	*/
+	VkDeviceSize VisibleInstanceOffset(ECullView eView, uint32_t nSlotBase, ECullPhase ePhase = CULL_PHASE_EARLY) const;
+
+	// ---------------------------------------------------------------------------------
+	// Results of the last Cull() call.
+
+	uint32_t DrawCount() const;
+
+	uint32_t SlotCount() const;
+
+	/*
+	Description: Get the CPU time in milliseconds spent writing draws & recording the culling dispatch.
+	Return Type: double
+	*/
+	double CullTime() const;
+
+	/*
+	Description: Get the amount of instances inside the camera's frustum but culled by occlusion, as of the last completed frame with the same frame index.
+	Return Type: uint32_t
+	*/
+	uint32_t OccludedInstanceCount() const;
+
+	uint32_t OccludedTriangleCount() const;
+
+private:
+
+	// Uniform parameters of the culling shaders.
+	struct CullParams
+	{
+		glm::vec4 m_planes[CULL_VIEW_COUNT * 6];
+		uint32_t m_nSlotCount;
+		uint32_t m_nDrawCapacity;
+		uint32_t m_nSlotCapacity;
+		uint32_t m_nOcclusion; // Early phase only draws the camera's instances visible after the late phase of the frame MAX_FRAMES_IN_FLIGHT frames ago.
+		glm::mat4 m_viewProj; // Camera view projection of the late phase.
+		uint32_t m_nViewMask; // Views culled by the early phase.
+		uint32_t m_nPadding[3];
+	};
+
+	// Push constants of the late culling shader.
+	struct LateCullConstants
+	{
+		uint32_t m_nPyramidWidth;
+		uint32_t m_nPyramidHeight;
+		uint32_t m_nPyramidLevels;
+		uint32_t m_nPadding;
+	};
+
+	// Contents of the stats buffer.
+	struct OcclusionStats
+	{
+		uint32_t m_nOccludedInstances;
+		uint32_t m_nOccludedTriangles;
+	};
+
+	struct DrawData
+	{
+		glm::vec4 m_v4Center;
+		glm::vec4 m_v4Extents;
+		uint32_t m_nInstanceCount;
+		uint32_t m_nSlotBase;
+		uint32_t m_nPadding[2];
+	};
+
+	struct FrameResources
+	{
+		VkBuffer m_buffers[GPU_CULL_BUFFER_COUNT];
+		MemAllocation m_memories[GPU_CULL_BUFFER_COUNT];
+		VkDescriptorSet m_descSet;
+		VkCommandBuffer m_cmdBuf;
+		VkSemaphore m_completeSemaphore;
+		uint32_t m_nDrawCapacity; // Capacities the buffers were created with, replaced once their frame comes around again if the layout outgrew them.
+		uint32_t m_nSlotCapacity;
+	};
+
+	// ---------------------------------------------------------------------------------
+	// Constructor extensions
+
+	inline void CreatePipeline();
+
+	inline void CreateDescriptors();
+
+	inline void CreateCmds();
+
+	// ---------------------------------------------------------------------------------
+	// Private runtime functions
+
+	// Assign draw indices & instance slots to the render objects, returns whether or not the layout changed.
+	inline bool UpdateLayout(const DynamicArray<PipelineData*>& pipelines);
+
+	// Create the buffers of a frame with the current capacities & point its descriptor set at them.
+	inline void CreateBuffers(const uint32_t& nFrameIndex);
+
+	inline void DestroyBuffers(const uint32_t& nFrameIndex);
+
+	Renderer* m_renderer;
+
+	VkShaderModule m_shaderModule;
+	VkShaderModule m_lateShaderModule;
+	VkDescriptorSetLayout m_setLayout;
+	VkDescriptorSetLayout m_pyramidSetLayout;
+	VkPipelineLayout m_pipelineLayout; // Shared by both phases.
+	VkPipeline m_pipeline;
+	VkPipeline m_latePipeline;
+
+	VkDescriptorPool m_descPool;
+	VkDescriptorSet m_pyramidSet;
+	VkCommandPool m_cmdPool;
+
+	FrameResources m_frames[MAX_FRAMES_IN_FLIGHT];
+
+	// ---------------------------------------------------------------------------------
+	// Layout
+
+	std::vector<RenderObject*> m_objects; // Render objects in draw index order.
+	std::vector<DrawData> m_draws;
+	std::vector<VkDrawIndexedIndirectCommand> m_commands;
+	std::vector<uint32_t> m_slotDraws;
+	std::vector<DirtyRange> m_uploadRanges; // Scratch space for the ranges of modified instances of an object.
+	uint32_t m_nSlotCount;
+	uint32_t m_nDrawCapacity;
+	uint32_t m_nSlotCapacity;
+	uint32_t m_nLayoutUploads; // Frames whose slot draw indices are yet to be written.
+
+	// ---------------------------------------------------------------------------------
+	// Occlusion
+
+	DepthPyramid* m_depthPyramid;
+	OcclusionCullView m_occlusionView;
+	bool m_bOcclusion; // Occlusion culling was requested by this frame's Cull().
+
+	// Visibility is written by a frame's late phase & read by the early phase of the next frame with the same index, which must see every instance as visible after a layout change.
+	uint32_t m_nVisibilityResets;
+
+	OcclusionStats m_stats;
+
+	double m_dCullTime;
+};
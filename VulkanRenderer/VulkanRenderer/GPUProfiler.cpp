@@ -0,0 +1,283 @@
+#include "GPUProfiler.h"
+#include "Renderer.h"
+#include "RendererHelper.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+GPUProfiler::GPUProfiler(Renderer* renderer, uint32_t nQueueFamilyIndex)
+{
+	m_renderer = renderer;
+	m_queryPool = VK_NULL_HANDLE;
+	m_nHistoryHead = GPU_PROFILER_HISTORY_FRAMES - 1;
+	m_nHistoryCount = 0;
+	m_nReadbackCount = 0;
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		m_bPending[i] = false;
+
+	// ---------------------------------------------------------------------------------
+	// Timestamp support
+
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(m_renderer->GetPhysDevice(), &deviceProperties);
+
+	uint32_t nFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_renderer->GetPhysDevice(), &nFamilyCount, nullptr);
+
+	VkQueueFamilyProperties* families = new VkQueueFamilyProperties[nFamilyCount];
+	vkGetPhysicalDeviceQueueFamilyProperties(m_renderer->GetPhysDevice(), &nFamilyCount, families);
+
+	uint32_t nValidBits = nQueueFamilyIndex < nFamilyCount ? families[nQueueFamilyIndex].timestampValidBits : 0;
+
+	delete[] families;
+
+	m_nTimestampMask = nValidBits >= 64 ? ~0ull : (1ull << nValidBits) - 1ull;
+	m_dTimestampPeriod = static_cast<double>(deviceProperties.limits.timestampPeriod);
+
+	if(nValidBits == 0)
+	{
+		std::cout << "GPU Profiler: Timestamps are not supported by the graphics queue, GPU times will not be measured.\n";
+		return;
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Query pool
+
+	VkQueryPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = MAX_FRAMES_IN_FLIGHT * GPU_PROFILER_MAX_SCOPES * 2;
+
+	RENDERER_SAFECALL(vkCreateQueryPool(m_renderer->GetDevice(), &poolInfo, nullptr, &m_queryPool), "GPU Profiler Error: Failed to create timestamp query pool.");
+}
+
+GPUProfiler::~GPUProfiler()
+{
+	if (m_queryPool)
+		vkDestroyQueryPool(m_renderer->GetDevice(), m_queryPool, nullptr);
+}
+
+uint32_t GPUProfiler::AddScope(const char* szName)
+{
+	if (!m_queryPool || m_scopes.size() >= GPU_PROFILER_MAX_SCOPES)
+		return GPU_PROFILER_INVALID_SCOPE;
+
+	Scope scope;
+	scope.m_name = szName;
+	scope.m_dLastTime = 0.0;
+
+	for (uint32_t i = 0; i < GPU_PROFILER_HISTORY_FRAMES; ++i)
+		scope.m_samples[i] = -1.0;
+
+	m_scopes.push_back(scope);
+
+	return static_cast<uint32_t>(m_scopes.size() - 1);
+}
+
+void GPUProfiler::BeginFrame(VkCommandBuffer cmdBuf, const uint32_t& nFrameIndex)
+{
+	if (!m_queryPool)
+		return;
+
+	const uint32_t nFirstQuery = nFrameIndex * GPU_PROFILER_MAX_SCOPES * 2;
+	const uint32_t nScopeCount = static_cast<uint32_t>(m_scopes.size());
+
+	// The frame's previous submission has completed. Scopes that weren't recorded are never available, so their results are skipped rather than waited on.
+	if(m_bPending[nFrameIndex] && nScopeCount > 0)
+	{
+		// Value & availability pairs.
+		uint64_t results[GPU_PROFILER_MAX_SCOPES * 2 * 2];
+
+		vkGetQueryPoolResults(m_renderer->GetDevice(), m_queryPool, nFirstQuery, nScopeCount * 2, sizeof(uint64_t) * 2 * 2 * nScopeCount, results, sizeof(uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		m_nHistoryHead = (m_nHistoryHead + 1) % GPU_PROFILER_HISTORY_FRAMES;
+		m_nHistoryCount = std::min(m_nHistoryCount + 1, (uint32_t)GPU_PROFILER_HISTORY_FRAMES);
+		++m_nReadbackCount;
+
+		for (uint32_t i = 0; i < nScopeCount; ++i)
+		{
+			const uint64_t* start = &results[i * 4];
+			const uint64_t* end = &results[i * 4 + 2];
+
+			Scope& scope = m_scopes[i];
+
+			if(start[1] && end[1])
+			{
+				scope.m_dLastTime = static_cast<double>((end[0] - start[0]) & m_nTimestampMask) * m_dTimestampPeriod / 1000000.0;
+				scope.m_samples[m_nHistoryHead] = scope.m_dLastTime;
+			}
+			else
+				scope.m_samples[m_nHistoryHead] = -1.0;
+		}
+	}
+
+	vkCmdResetQueryPool(cmdBuf, m_queryPool, nFirstQuery, GPU_PROFILER_MAX_SCOPES * 2);
+
+	m_bPending[nFrameIndex] = true;
+}
+
+void GPUProfiler::BeginScope(VkCommandBuffer cmdBuf, const uint32_t& nFrameIndex, uint32_t nScope) const
+{
+	if (nScope == GPU_PROFILER_INVALID_SCOPE)
+		return;
+
+	// Written once earlier commands complete rather than when they start, so time spent waiting on earlier work isn't attributed to the scope.
+	vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, (nFrameIndex * GPU_PROFILER_MAX_SCOPES + nScope) * 2);
+}
+
+void GPUProfiler::EndScope(VkCommandBuffer cmdBuf, const uint32_t& nFrameIndex, uint32_t nScope) const
+{
+	if (nScope == GPU_PROFILER_INVALID_SCOPE)
+		return;
+
+	vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, (nFrameIndex * GPU_PROFILER_MAX_SCOPES + nScope) * 2 + 1);
+}
+
+uint32_t GPUProfiler::ScopeCount() const
+{
+	return static_cast<uint32_t>(m_scopes.size());
+}
+
+const char* GPUProfiler::ScopeName(uint32_t nScope) const
+{
+	return m_scopes[nScope].m_name.c_str();
+}
+
+double GPUProfiler::AverageTime(uint32_t nScope) const
+{
+	const Scope& scope = m_scopes[nScope];
+
+	double dTotal = 0.0;
+	uint32_t nSampleCount = 0;
+
+	for (uint32_t i = 0; i < m_nHistoryCount; ++i)
+	{
+		double dSample = scope.m_samples[HistoryIndex(i)];
+
+		if (dSample < 0.0)
+			continue;
+
+		dTotal += dSample;
+		++nSampleCount;
+	}
+
+	return nSampleCount > 0 ? dTotal / nSampleCount : 0.0;
+}
+
+double GPUProfiler::LastTime(uint32_t nScope) const
+{
+	return m_scopes[nScope].m_dLastTime;
+}
+
+double GPUProfiler::Sample(uint32_t nScope, uint32_t nFramesAgo) const
+{
+	return m_scopes[nScope].m_samples[HistoryIndex(nFramesAgo)];
+}
+
+uint64_t GPUProfiler::ReadbackCount() const
+{
+	return m_nReadbackCount;
+}
+
+void GPUProfiler::PrintSummary() const
+{
+	for (uint32_t i = 0; i < m_scopes.size(); ++i)
+		std::cout << "GPU Profiler: " << m_scopes[i].m_name << ": " << AverageTime(i) << "ms\n";
+}
+
+bool GPUProfiler::WriteCSV(const char* szFilePath) const
+{
+	std::ofstream outStream(szFilePath, std::ios::out);
+
+	if(!outStream.good())
+	{
+		std::cout << "GPU Profiler Warning: Failed to open: " << szFilePath << " for writing.\n";
+		return false;
+	}
+
+	outStream << "Sample";
+
+	for (uint32_t i = 0; i < m_scopes.size(); ++i)
+		outStream << "," << m_scopes[i].m_name;
+
+	outStream << "\n";
+
+	// Oldest frame first.
+	for (uint32_t i = 0; i < m_nHistoryCount; ++i)
+	{
+		uint32_t nIndex = HistoryIndex(m_nHistoryCount - 1 - i);
+
+		outStream << i;
+
+		for (uint32_t j = 0; j < m_scopes.size(); ++j)
+		{
+			outStream << ",";
+
+			if (m_scopes[j].m_samples[nIndex] >= 0.0)
+				outStream << m_scopes[j].m_samples[nIndex];
+		}
+
+		outStream << "\n";
+	}
+
+	std::cout << "GPU Profiler: Wrote " << m_nHistoryCount << " frames to: " << szFilePath << "\n";
+	return true;
+}
+
+bool GPUProfiler::WriteJSON(const char* szFilePath) const
+{
+	std::ofstream outStream(szFilePath, std::ios::out);
+
+	if(!outStream.good())
+	{
+		std::cout << "GPU Profiler Warning: Failed to open: " << szFilePath << " for writing.\n";
+		return false;
+	}
+
+	outStream << "{\n\t\"frames\": " << m_nHistoryCount << ",\n\t\"scopes\": [";
+
+	for (uint32_t i = 0; i < m_scopes.size(); ++i)
+	{
+		const Scope& scope = m_scopes[i];
+
+		double dMin = 0.0;
+		double dMax = 0.0;
+		bool bFirst = true;
+
+		std::string samples;
+
+		// Oldest frame first, frames the scope wasn't recorded in are null.
+		for (uint32_t j = 0; j < m_nHistoryCount; ++j)
+		{
+			double dSample = scope.m_samples[HistoryIndex(m_nHistoryCount - 1 - j)];
+
+			if (j > 0)
+				samples += ", ";
+
+			if(dSample < 0.0)
+			{
+				samples += "null";
+				continue;
+			}
+
+			samples += std::to_string(dSample);
+
+			dMin = bFirst ? dSample : std::min(dMin, dSample);
+			dMax = bFirst ? dSample : std::max(dMax, dSample);
+			bFirst = false;
+		}
+
+		outStream << (i > 0 ? "," : "") << "\n\t\t{ \"name\": \"" << scope.m_name << "\", \"averageMs\": " << AverageTime(i) << ", \"minMs\": " << dMin << ", \"maxMs\": " << dMax << ", \"samplesMs\": [" << samples << "] }";
+	}
+
+	outStream << "\n\t]\n}\n";
+
+	std::cout << "GPU Profiler: Wrote " << m_scopes.size() << " scopes to: " << szFilePath << "\n";
+	return true;
+}
+
+inline uint32_t GPUProfiler::HistoryIndex(uint32_t nFramesAgo) const
+{
+	return (m_nHistoryHead + GPU_PROFILER_HISTORY_FRAMES - nFramesAgo) % GPU_PROFILER_HISTORY_FRAMES;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+
+/*
+Description: GPU timestamp profiler. Named scopes write timestamp pairs into a query pool region per frame-in-flight, results are read back without waiting
+             once the frame-in-flight comes around again & kept as a rolling history per scope.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+
+#ifndef MAX_FRAMES_IN_FLIGHT
+#define MAX_FRAMES_IN_FLIGHT 2
+#endif
+
+// Maximum amount of scopes which may be registered.
+#define GPU_PROFILER_MAX_SCOPES 32
+
+// Amount of frames the rolling average & dumps cover.
+#define GPU_PROFILER_HISTORY_FRAMES 128
+
+#define GPU_PROFILER_INVALID_SCOPE ~0u
+
+class GPUProfiler
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer.
+		uint32_t nQueueFamilyIndex: Queue family index of the queue profiled command buffers are submitted to.
+	*/
+	GPUProfiler(Renderer* renderer, uint32_t nQueueFamilyIndex);
+
+	~GPUProfiler();
+
+	/*
+	Description: Register a scope, returns GPU_PROFILER_INVALID_SCOPE if the maximum amount of scopes is reached or timestamps are unsupported.
+	Return Type: uint32_t
+	Param:
+	    const char* szName: Name of the scope, used for reporting.
+	*/
+	uint32_t AddScope(const char* szName);
+
+	/*
+	Description: Read back the results of this frame index's previous submission & reset its queries. The frame's previous submission must be complete,
+	             and this must be recorded before any scope of the frame.
+	Param:
+	    VkCommandBuffer cmdBuf: A primary command buffer of the frame, outside of a render pass.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+	*/
+	void BeginFrame(VkCommandBuffer cmdBuf, const uint32_t& nFrameIndex);
+
+	/*
+	Description: Write the start & end timestamps of a scope. May be recorded into secondary command buffers & from multiple threads, but each scope only once per frame.
+	Param:
+	    VkCommandBuffer cmdBuf: The command buffer to record to.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+		uint32_t nScope: The scope, ignored if it is GPU_PROFILER_INVALID_SCOPE.
+	*/
+	void BeginScope(VkCommandBuffer cmdBuf, const uint32_t& nFrameIndex, uint32_t nScope) const;
+	void EndScope(VkCommandBuffer cmdBuf, const uint32_t& nFrameIndex, uint32_t nScope) const;
+
+	// ---------------------------------------------------------------------------------
+	// Results
+
+	uint32_t ScopeCount() const;
+
+	const char* ScopeName(uint32_t nScope) const;
+
+	/*
+	Description: Get the average GPU time of a scope in milliseconds, over the frames in the history it was recorded in.
+	Return Type: double
+	*/
+	double AverageTime(uint32_t nScope) const;
+
+	/*
+	Description: Get the most recently read back GPU time of a scope in milliseconds.
+	Return Type: double
+	*/
+	double LastTime(uint32_t nScope) const;
+
+	/*
+	Description: Get the GPU time of a scope in milliseconds in a frame of the history, negative if the scope wasn't recorded in the frame.
+	Return Type: double
+	Param:
+	    uint32_t nScope: The scope.
+		uint32_t nFramesAgo: Frames before the most recently read back frame, which must be less than the amount of frames in the history.
+	*/
+	double Sample(uint32_t nScope, uint32_t nFramesAgo) const;
+
+	/*
+	Description: Get the amount of frames read back since creation, which only changes when a new frame's results are added to the history.
+	Return Type: uint64_t
+	*/
+	uint64_t ReadbackCount() const;
+
+	/*
+	Description: Print the average time of each scope.
+	*/
+	void PrintSummary() const;
+
+	/*
+	Description: Write the history as CSV, a row per frame (oldest first) & a column per scope. Frames a scope wasn't recorded in are left empty.
+	Return Type: bool
+	Param:
+	    const char* szFilePath: Path of the file to write.
+	*/
+	bool WriteCSV(const char* szFilePath) const;
+
+	/*
+	Description: Write the average, minimum, maximum & history of each scope as JSON.
+	Return Type: bool
+	Param:
+	    const char* szFilePath: Path of the file to write.
+	*/
+	bool WriteJSON(const char* szFilePath) const;
+
+private:
+
+	struct Scope
+	{
+		std::string m_name;
+		double m_samples[GPU_PROFILER_HISTORY_FRAMES]; // Negative if the scope wasn't recorded in the frame.
+		double m_dLastTime;
+	};
+
+	// Get the history index of a frame, relative to the newest frame.
+	inline uint32_t HistoryIndex(uint32_t nFramesAgo) const;
+
+	Renderer* m_renderer;
+
+	VkQueryPool m_queryPool; // A start & end query per scope for each frame-in-flight.
+	bool m_bPending[MAX_FRAMES_IN_FLIGHT]; // Whether or not the frame's queries were reset & have not been read.
+	uint64_t m_nTimestampMask;
+	double m_dTimestampPeriod; // Nanoseconds per timestamp tick.
+
+	std::vector<Scope> m_scopes;
+	uint32_t m_nHistoryHead; // Index of the newest frame in the history.
+	uint32_t m_nHistoryCount;
+	uint64_t m_nReadbackCount;
+};
@@ -0,0 +1,162 @@
+#include "GeometryPool.h"
+#include "Renderer.h"
+
+#include <algorithm>
+
+GeometryPool::GeometryPool(Renderer* renderer, const std::string& formatNameID, uint32_t nVertexStride)
+{
+	m_renderer = renderer;
+	m_formatNameID = formatNameID;
+	m_nVertexStride = nVertexStride;
+}
+
+GeometryPool::~GeometryPool()
+{
+	VkDevice device = m_renderer->GetDevice();
+
+	for (Block& block : m_blocks)
+	{
+		vkDestroyBuffer(device, block.m_vertexBuffer, nullptr);
+		vkDestroyBuffer(device, block.m_indexBuffer, nullptr);
+
+		m_renderer->FreeMemory(block.m_vertexMemory);
+		m_renderer->FreeMemory(block.m_indexMemory);
+	}
+}
+
+GeometryAllocation GeometryPool::Allocate(uint32_t nVertexCount, uint32_t nIndexCount)
+{
+	// Empty ranges would fit anywhere & be indistinguishable from their neighbours, so every allocation holds at least one of each.
+	nVertexCount = std::max(nVertexCount, 1u);
+	nIndexCount = std::max(nIndexCount, 1u);
+
+	GeometryAllocation allocation = {};
+	allocation.m_nVertexCount = nVertexCount;
+	allocation.m_nIndexCount = nIndexCount;
+
+	for (uint32_t i = 0; i < m_blocks.size(); ++i)
+	{
+		Block& block = m_blocks[i];
+
+		uint32_t nVertexRange = FindRange(block.m_freeVertices, nVertexCount);
+		uint32_t nIndexRange = FindRange(block.m_freeIndices, nIndexCount);
+
+		if (nVertexRange == UINT32_MAX || nIndexRange == UINT32_MAX)
+			continue;
+
+		allocation.m_nBlock = i;
+		allocation.m_nFirstVertex = TakeRange(block.m_freeVertices, nVertexRange, nVertexCount);
+		allocation.m_nFirstIndex = TakeRange(block.m_freeIndices, nIndexRange, nIndexCount);
+
+		return allocation;
+	}
+
+	// No block has room, meshes larger than a block get one sized to fit.
+	CreateBlock(std::max(nVertexCount, GEOMETRY_POOL_BLOCK_VERTICES), std::max(nIndexCount, GEOMETRY_POOL_BLOCK_INDICES));
+
+	Block& block = m_blocks.back();
+
+	allocation.m_nBlock = static_cast<uint32_t>(m_blocks.size() - 1);
+	allocation.m_nFirstVertex = TakeRange(block.m_freeVertices, 0, nVertexCount);
+	allocation.m_nFirstIndex = TakeRange(block.m_freeIndices, 0, nIndexCount);
+
+	return allocation;
+}
+
+void GeometryPool::Free(const GeometryAllocation& allocation)
+{
+	Block& block = m_blocks[allocation.m_nBlock];
+
+	ReturnRange(block.m_freeVertices, allocation.m_nFirstVertex, allocation.m_nVertexCount);
+	ReturnRange(block.m_freeIndices, allocation.m_nFirstIndex, allocation.m_nIndexCount);
+}
+
+VkBuffer& GeometryPool::VertexBuffer(uint32_t nBlock)
+{
+	return m_blocks[nBlock].m_vertexBuffer;
+}
+
+VkBuffer& GeometryPool::IndexBuffer(uint32_t nBlock)
+{
+	return m_blocks[nBlock].m_indexBuffer;
+}
+
+const std::string& GeometryPool::FormatNameID() const
+{
+	return m_formatNameID;
+}
+
+uint32_t GeometryPool::VertexStride() const
+{
+	return m_nVertexStride;
+}
+
+uint32_t GeometryPool::BlockCount() const
+{
+	return static_cast<uint32_t>(m_blocks.size());
+}
+
+inline void GeometryPool::CreateBlock(uint32_t nVertexCapacity, uint32_t nIndexCapacity)
+{
+	Block block = {};
+
+	m_renderer->CreateBuffer(static_cast<VkDeviceSize>(nVertexCapacity) * m_nVertexStride, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		block.m_vertexBuffer, block.m_vertexMemory);
+
+	m_renderer->CreateBuffer(static_cast<VkDeviceSize>(nIndexCapacity) * sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		block.m_indexBuffer, block.m_indexMemory);
+
+	block.m_freeVertices.push_back({ 0, nVertexCapacity });
+	block.m_freeIndices.push_back({ 0, nIndexCapacity });
+
+	m_blocks.push_back(block);
+}
+
+uint32_t GeometryPool::FindRange(const std::vector<FreeRange>& freeRanges, uint32_t nCount)
+{
+	for (uint32_t i = 0; i < freeRanges.size(); ++i)
+	{
+		if (freeRanges[i].m_nCount >= nCount)
+			return i;
+	}
+
+	return UINT32_MAX;
+}
+
+uint32_t GeometryPool::TakeRange(std::vector<FreeRange>& freeRanges, uint32_t nRange, uint32_t nCount)
+{
+	FreeRange& range = freeRanges[nRange];
+	uint32_t nStart = range.m_nStart;
+
+	range.m_nStart += nCount;
+	range.m_nCount -= nCount;
+
+	if (range.m_nCount == 0)
+		freeRanges.erase(freeRanges.begin() + nRange);
+
+	return nStart;
+}
+
+void GeometryPool::ReturnRange(std::vector<FreeRange>& freeRanges, uint32_t nStart, uint32_t nCount)
+{
+	// First free range after the returned one.
+	auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), nStart, [](const FreeRange& range, uint32_t nValue) { return range.m_nStart < nValue; });
+
+	bool bMergePrev = next != freeRanges.begin() && (next - 1)->m_nStart + (next - 1)->m_nCount == nStart;
+	bool bMergeNext = next != freeRanges.end() && nStart + nCount == next->m_nStart;
+
+	if (bMergePrev && bMergeNext)
+	{
+		(next - 1)->m_nCount += nCount + next->m_nCount;
+		freeRanges.erase(next);
+	}
+	else if (bMergePrev)
+		(next - 1)->m_nCount += nCount;
+	else if (bMergeNext)
+	{
+		next->m_nStart = nStart;
+		next->m_nCount += nCount;
+	}
+	else
+		freeRanges.insert(next, { nStart, nCount });
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "MemoryAllocator.h"
+
+/*
+Description: Shared vertex & index buffers for meshes of a single vertex format. Meshes are sub-allocated ranges of a block's buffers & draw with
+             their first vertex as the base vertex & their first index offsetting their indices, so every mesh in a block is drawn with the same binds.
+             Blocks are added when full, meshes larger than a block get a block of their own.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+
+// Vertex & index capacity of each block.
+#define GEOMETRY_POOL_BLOCK_VERTICES (256u * 1024u)
+#define GEOMETRY_POOL_BLOCK_INDICES (1024u * 1024u)
+
+// A mesh's range of a geometry pool block.
+struct GeometryAllocation
+{
+	uint32_t m_nBlock;
+	uint32_t m_nFirstVertex; // Base vertex of the mesh's draws.
+	uint32_t m_nVertexCount;
+	uint32_t m_nFirstIndex; // Added to the first index of the mesh's draws.
+	uint32_t m_nIndexCount;
+};
+
+class GeometryPool
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer owning the pool.
+		const std::string& formatNameID: Name ID of the vertex format of the pool's meshes.
+		uint32_t nVertexStride: Size in bytes of each vertex.
+	*/
+	GeometryPool(Renderer* renderer, const std::string& formatNameID, uint32_t nVertexStride);
+
+	~GeometryPool();
+
+	/*
+	Description: Allocate a range of vertices & indices, creating a block if none has room for both.
+	Return Type: GeometryAllocation
+	Param:
+	    uint32_t nVertexCount: Amount of vertices to allocate.
+		uint32_t nIndexCount: Amount of indices to allocate.
+	*/
+	GeometryAllocation Allocate(uint32_t nVertexCount, uint32_t nIndexCount);
+
+	/*
+	Description: Return a range to its block, the GPU must no longer be using it.
+	Param:
+	    const GeometryAllocation& allocation: The range to free.
+	*/
+	void Free(const GeometryAllocation& allocation);
+
+	/*
+	Description: Get the vertex buffer of a block.
+	Return Type: VkBuffer&
+	Param:
+	    uint32_t nBlock: Index of the block.
+	*/
+	VkBuffer& VertexBuffer(uint32_t nBlock);
+
+	/*
+	Description: Get the index buffer of a block.
+	Return Type: VkBuffer&
+	Param:
+	    uint32_t nBlock: Index of the block.
+	*/
+	VkBuffer& IndexBuffer(uint32_t nBlock);
+
+	const std::string& FormatNameID() const;
+
+	uint32_t VertexStride() const;
+
+	uint32_t BlockCount() const;
+
+private:
+
+	// A free run of vertices or indices.
+	struct FreeRange
+	{
+		uint32_t m_nStart;
+		uint32_t m_nCount;
+	};
+
+	struct Block
+	{
+		VkBuffer m_vertexBuffer;
+		MemAllocation m_vertexMemory;
+		VkBuffer m_indexBuffer;
+		MemAllocation m_indexMemory;
+
+		std::vector<FreeRange> m_freeVertices; // Sorted by start, adjacent ranges are merged.
+		std::vector<FreeRange> m_freeIndices;
+	};
+
+	// Create a block with the provided capacities.
+	inline void CreateBlock(uint32_t nVertexCapacity, uint32_t nIndexCapacity);
+
+	// Find the first free range which fits the count, returns UINT32_MAX if none does.
+	static uint32_t FindRange(const std::vector<FreeRange>& freeRanges, uint32_t nCount);
+
+	// Take the count from the start of a free range found by FindRange(), returns the start of the taken range.
+	static uint32_t TakeRange(std::vector<FreeRange>& freeRanges, uint32_t nRange, uint32_t nCount);
+
+	// Return a range, merging it with adjacent free ranges.
+	static void ReturnRange(std::vector<FreeRange>& freeRanges, uint32_t nStart, uint32_t nCount);
+
+	Renderer* m_renderer;
+	std::string m_formatNameID;
+	uint32_t m_nVertexStride;
+
+	std::vector<Block> m_blocks;
+};
+
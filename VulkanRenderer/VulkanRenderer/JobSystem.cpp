@@ -0,0 +1,255 @@
+#include "JobSystem.h"
+#include "CPUProfiler.h"
+#include <algorithm>
+#include <string>
+
+// Index of the calling thread's deque. Threads not created by the job system use the main thread's deque.
+static thread_local uint32_t t_nThreadIndex = 0;
+
+JobCounter::JobCounter()
+{
+	m_nValue = 0;
+}
+
+bool JobCounter::IsComplete() const
+{
+	return m_nValue.load() == 0;
+}
+
+JobSystem::JobSystem(uint32_t nThreadCount)
+{
+	m_nThreadCount = std::max(nThreadCount, 1u);
+	m_queues = new ThreadQueue[m_nThreadCount];
+
+	for (uint32_t i = 0; i < m_nThreadCount; ++i)
+	{
+		m_queues[i].m_nExecutedCount = 0;
+		m_queues[i].m_nStolenCount = 0;
+	}
+
+	m_nQueuedJobs = 0;
+	m_nSleepingCount = 0;
+	m_bShutdown = false;
+
+	// Index zero belongs to the main thread, which runs jobs while it waits.
+	m_threads = new std::thread*[m_nThreadCount];
+	m_threads[0] = nullptr;
+
+	for (uint32_t i = 1; i < m_nThreadCount; ++i)
+		m_threads[i] = new std::thread(&JobSystem::WorkerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bShutdown = true;
+	}
+
+	m_wakeCondition.notify_all();
+
+	for (uint32_t i = 1; i < m_nThreadCount; ++i)
+	{
+		m_threads[i]->join();
+		delete m_threads[i];
+	}
+
+	delete[] m_threads;
+	delete[] m_queues;
+}
+
+void JobSystem::Run(const std::function<void()>& func, JobCounter* counter, JobCounter* dependency)
+{
+	if (counter)
+		counter->m_nValue.fetch_add(1);
+
+	Job job = { func, counter };
+
+	if(dependency)
+	{
+		std::lock_guard<std::mutex> lock(dependency->m_mutex);
+
+		// The dependency's last job decrements & takes waiting jobs under the same lock, so this check can't miss the release.
+		if(dependency->m_nValue.load() > 0)
+		{
+			dependency->m_waitingJobs.push_back(job);
+			return;
+		}
+	}
+
+	Push(job);
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+	Job job;
+
+	while(counter->m_nValue.load() > 0)
+	{
+		// Help with outstanding work rather than blocking.
+		if (TryGetJob(t_nThreadIndex, job))
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+
+	// The last job may still hold the counter's lock, wait for it to be released before the counter can be destroyed.
+	std::lock_guard<std::mutex> lock(counter->m_mutex);
+}
+
+void JobSystem::ParallelFor(uint32_t nCount, uint32_t nBatchSize, const std::function<void(uint32_t, uint32_t)>& func)
+{
+	if (nCount == 0)
+		return;
+
+	nBatchSize = std::max(nBatchSize, 1u);
+
+	JobCounter counter;
+
+	// Queue all but the last batch, which is run on this thread.
+	uint32_t nStart = 0;
+	for (; nStart + nBatchSize < nCount; nStart += nBatchSize)
+	{
+		uint32_t nEnd = nStart + nBatchSize;
+		Run([&func, nStart, nEnd]() { func(nStart, nEnd); }, &counter);
+	}
+
+	func(nStart, nCount);
+
+	Wait(&counter);
+}
+
+uint32_t JobSystem::ThreadCount() const
+{
+	return m_nThreadCount;
+}
+
+uint64_t JobSystem::ExecutedJobCount() const
+{
+	uint64_t nCount = 0;
+
+	for (uint32_t i = 0; i < m_nThreadCount; ++i)
+		nCount += m_queues[i].m_nExecutedCount.load(std::memory_order_relaxed);
+
+	return nCount;
+}
+
+uint64_t JobSystem::StolenJobCount() const
+{
+	uint64_t nCount = 0;
+
+	for (uint32_t i = 0; i < m_nThreadCount; ++i)
+		nCount += m_queues[i].m_nStolenCount.load(std::memory_order_relaxed);
+
+	return nCount;
+}
+
+void JobSystem::WorkerMain(uint32_t nThreadIndex)
+{
+	t_nThreadIndex = nThreadIndex;
+
+	CPU_PROFILE_THREAD(("Job Worker " + std::to_string(nThreadIndex)).c_str());
+
+	Job job;
+
+	while(true)
+	{
+		if(TryGetJob(nThreadIndex, job))
+		{
+			Execute(job);
+			continue;
+		}
+
+		// Sleep until jobs are queued. The sleeping count is raised before checking for jobs, so Push() will see it & notify.
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+		m_nSleepingCount.fetch_add(1);
+		m_wakeCondition.wait(lock, [this]() { return m_bShutdown || m_nQueuedJobs.load() > 0; });
+		m_nSleepingCount.fetch_sub(1);
+
+		if (m_bShutdown)
+			return;
+	}
+}
+
+inline void JobSystem::Push(const Job& job)
+{
+	ThreadQueue& queue = m_queues[t_nThreadIndex];
+
+	{
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		queue.m_jobs.push_back(job);
+	}
+
+	m_nQueuedJobs.fetch_add(1);
+
+	// Only take the sleep lock when a worker may be sleeping.
+	if(m_nSleepingCount.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.notify_one();
+	}
+}
+
+inline bool JobSystem::TryGetJob(uint32_t nThreadIndex, Job& outJob)
+{
+	// Take the newest job from this thread's deque, it is most likely to still be in cache.
+	{
+		ThreadQueue& queue = m_queues[nThreadIndex];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+
+		if(!queue.m_jobs.empty())
+		{
+			outJob = std::move(queue.m_jobs.back());
+			queue.m_jobs.pop_back();
+
+			m_nQueuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// Steal the oldest job from another thread, starting with the next thread to spread out contention.
+	for (uint32_t i = 1; i < m_nThreadCount; ++i)
+	{
+		ThreadQueue& victim = m_queues[(nThreadIndex + i) % m_nThreadCount];
+		std::lock_guard<std::mutex> lock(victim.m_mutex);
+
+		if(!victim.m_jobs.empty())
+		{
+			outJob = std::move(victim.m_jobs.front());
+			victim.m_jobs.pop_front();
+
+			m_nQueuedJobs.fetch_sub(1);
+			m_queues[nThreadIndex].m_nStolenCount.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+inline void JobSystem::Execute(Job& job)
+{
+	job.m_func();
+
+	m_queues[t_nThreadIndex].m_nExecutedCount.fetch_add(1, std::memory_order_relaxed);
+
+	JobCounter* counter = job.m_counter;
+
+	if (!counter)
+		return;
+
+	// Decrement under the counter's lock, so a waiter can't destroy the counter while waiting jobs are being taken from it.
+	std::vector<Job> released;
+	{
+		std::lock_guard<std::mutex> lock(counter->m_mutex);
+
+		// Take jobs depending on the counter if this was its last job.
+		if (counter->m_nValue.fetch_sub(1) == 1)
+			released.swap(counter->m_waitingJobs);
+	}
+
+	// The counter may no longer exist past this point.
+	for (uint32_t i = 0; i < released.size(); ++i)
+		Push(released[i]);
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <deque>
+#include <vector>
+
+/*
+Description: Work-stealing job system. Each thread owns a job deque, taking its own jobs newest first and stealing the oldest jobs of other threads when idle.
+             Completion is tracked with job counters, which may also hold back jobs depending on them.
+Author: Nic Van Zuylen
+*/
+
+class JobCounter;
+
+struct Job
+{
+	std::function<void()> m_func;
+	JobCounter* m_counter; // Decremented once the job has completed, may be nullptr.
+};
+
+// Counts unfinished jobs. Must outlive all jobs referencing it, so it should only be destroyed after JobSystem::Wait() returns.
+class JobCounter
+{
+public:
+
+	JobCounter();
+
+	/*
+	Description: Get whether or not all jobs referencing this counter have completed.
+	Return Type: bool
+	*/
+	bool IsComplete() const;
+
+private:
+
+	friend class JobSystem;
+
+	std::atomic<uint32_t> m_nValue;
+
+	std::mutex m_mutex;
+	std::vector<Job> m_waitingJobs; // Jobs which will be queued once the counter reaches zero.
+};
+
+class JobSystem
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    uint32_t nThreadCount: Total amount of threads jobs may run on, including the main thread.
+	*/
+	JobSystem(uint32_t nThreadCount);
+
+	~JobSystem();
+
+	/*
+	Description: Queue a job on the calling thread's deque.
+	Param:
+	    const std::function<void()>& func: The job function.
+		JobCounter* counter: Counter incremented now & decremented once the job has completed, may be nullptr.
+		JobCounter* dependency: The job is held back until this counter reaches zero, may be nullptr.
+	*/
+	void Run(const std::function<void()>& func, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+	/*
+	Description: Run jobs on the calling thread until the provided counter reaches zero.
+	Param:
+	    JobCounter* counter: The counter to wait on.
+	*/
+	void Wait(JobCounter* counter);
+
+	/*
+	Description: Split a range into batches run as jobs & wait for all of them, the calling thread runs jobs while it waits.
+	Param:
+	    uint32_t nCount: Size of the range.
+		uint32_t nBatchSize: Maximum range size per job.
+		const std::function<void(uint32_t, uint32_t)>& func: Processes [nStart, nEnd) of the range, called concurrently.
+	*/
+	void ParallelFor(uint32_t nCount, uint32_t nBatchSize, const std::function<void(uint32_t, uint32_t)>& func);
+
+	/*
+	Description: Get the total amount of threads jobs may run on, including the main thread.
+	Return Type: uint32_t
+	*/
+	uint32_t ThreadCount() const;
+
+	/*
+	Description: Get the amount of jobs executed, and the amount of those which were stolen from another thread since creation.
+	*/
+	uint64_t ExecutedJobCount() const;
+	uint64_t StolenJobCount() const;
+
+private:
+
+	// Padded to avoid false sharing between threads.
+	struct alignas(64) ThreadQueue
+	{
+		std::mutex m_mutex;
+		std::deque<Job> m_jobs;
+		std::atomic<uint64_t> m_nExecutedCount;
+		std::atomic<uint64_t> m_nStolenCount;
+	};
+
+	// Worker thread entry point.
+	void WorkerMain(uint32_t nThreadIndex);
+
+	// Add a job to the calling thread's deque & wake a sleeping worker.
+	inline void Push(const Job& job);
+
+	// Take a job from the provided thread's deque, or steal from another if it is empty.
+	inline bool TryGetJob(uint32_t nThreadIndex, Job& outJob);
+
+	// Run a job & release jobs depending on its counter if it was the last one.
+	inline void Execute(Job& job);
+
+	ThreadQueue* m_queues;
+	uint32_t m_nThreadCount;
+	std::thread** m_threads;
+
+	std::atomic<uint32_t> m_nQueuedJobs;
+	std::atomic<uint32_t> m_nSleepingCount;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	bool m_bShutdown;
+};
@@ -0,0 +1,238 @@
+#include "JobSystemTest.h"
+#include "JobSystem.h"
+
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <cstring>
+#include <cstdlib>
+
+bool JobSystemTest::ParseArgs(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--jobtest") == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool JobSystemTest::Run()
+{
+	std::cout << "Job System Test: " << JOB_TEST_THREAD_COUNT << " threads, " << std::thread::hardware_concurrency() << " hardware threads\n";
+
+	// Every check runs even if an earlier one fails.
+	bool bPassed = true;
+	bPassed = Report("Counter dependencies", TestDependencies()) && bPassed;
+	bPassed = Report("Parallel-for coverage", TestParallelFor()) && bPassed;
+	bPassed = Report("Work stealing", TestWorkStealing()) && bPassed;
+	bPassed = Report("Shutdown with queued jobs", TestShutdown()) && bPassed;
+
+	std::cout << "Job System Test: " << (bPassed ? "All checks passed" : "Checks FAILED") << "\n";
+
+	return bPassed;
+}
+
+bool JobSystemTest::TestDependencies()
+{
+	JobSystem jobSystem(JOB_TEST_THREAD_COUNT);
+
+	const uint32_t nJobCount = 64;
+
+	JobCounter first;
+	JobCounter second;
+	JobCounter third;
+	JobCounter unrelated;
+	std::atomic<uint32_t> nFirstDone(0);
+	std::atomic<uint32_t> nSecondDone(0);
+	std::atomic<uint32_t> nThirdDone(0);
+	std::atomic<bool> bOrdered(true);
+
+	// Each stage checks the whole previous stage has completed when it starts. The sleeps give the stages time to overlap if the ordering is broken.
+	for (uint32_t i = 0; i < nJobCount; ++i)
+	{
+		jobSystem.Run([&]()
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			++nFirstDone;
+		}, &first);
+	}
+
+	for (uint32_t i = 0; i < nJobCount; ++i)
+	{
+		jobSystem.Run([&]()
+		{
+			if (nFirstDone.load() != nJobCount)
+				bOrdered = false;
+
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			++nSecondDone;
+		}, &second, &first);
+	}
+
+	for (uint32_t i = 0; i < nJobCount; ++i)
+	{
+		jobSystem.Run([&]()
+		{
+			if (nSecondDone.load() != nJobCount)
+				bOrdered = false;
+
+			++nThirdDone;
+		}, &third, &second);
+	}
+
+	// A dependency which has already completed doesn't hold the job back.
+	std::atomic<bool> bUnheldRan(false);
+	JobCounter completed;
+	jobSystem.Run([&]() { bUnheldRan = true; }, &unrelated, &completed);
+
+	jobSystem.Wait(&first);
+	jobSystem.Wait(&second);
+	jobSystem.Wait(&third);
+	jobSystem.Wait(&unrelated);
+
+	return bOrdered && nThirdDone.load() == nJobCount && bUnheldRan;
+}
+
+bool JobSystemTest::TestParallelFor()
+{
+	JobSystem jobSystem(JOB_TEST_THREAD_COUNT);
+
+	const uint32_t counts[] = { 0, 1, 63, 64, 65, 1000, 100000 };
+	const uint32_t batchSizes[] = { 0, 1, 64, 4096 };
+
+	for (uint32_t nCount : counts)
+	{
+		for (uint32_t nBatchSize : batchSizes)
+		{
+			std::vector<std::atomic<uint32_t>> hits(nCount);
+			std::atomic<bool> bInRange(true);
+
+			for (std::atomic<uint32_t>& nHits : hits)
+				nHits = 0;
+
+			jobSystem.ParallelFor(nCount, nBatchSize, [&](uint32_t nStart, uint32_t nEnd)
+			{
+				if (nStart >= nEnd || nEnd > nCount)
+				{
+					bInRange = false;
+					return;
+				}
+
+				for (uint32_t i = nStart; i < nEnd; ++i)
+					++hits[i];
+			});
+
+			uint32_t nMissed = 0;
+			uint32_t nRepeated = 0;
+
+			for (std::atomic<uint32_t>& nHits : hits)
+			{
+				nMissed += nHits.load() == 0 ? 1 : 0;
+				nRepeated += nHits.load() > 1 ? 1 : 0;
+			}
+
+			if (!bInRange || nMissed > 0 || nRepeated > 0)
+			{
+				std::cout << "Job System Test: Parallel-for of " << nCount << " in batches of " << nBatchSize << ": " << nMissed << " indices missed, " << nRepeated << " repeated"
+					<< (bInRange ? "\n" : ", invalid batch range\n");
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool JobSystemTest::TestWorkStealing()
+{
+	JobSystem jobSystem(JOB_TEST_THREAD_COUNT);
+
+	const uint32_t nJobCount = 64;
+
+	uint64_t nStolenBefore = jobSystem.StolenJobCount();
+
+	JobCounter spawner;
+	JobCounter work;
+	std::atomic<uint32_t> nDone(0);
+	std::mutex threadMutex;
+	std::set<std::thread::id> threadIDs;
+
+	// A single job queues all of the work on its own thread's deque, leaving the other threads nothing to do unless they steal.
+	jobSystem.Run([&]()
+	{
+		for (uint32_t i = 0; i < nJobCount; ++i)
+		{
+			jobSystem.Run([&]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+				{
+					std::lock_guard<std::mutex> lock(threadMutex);
+					threadIDs.insert(std::this_thread::get_id());
+				}
+
+				++nDone;
+			}, &work);
+		}
+	}, &spawner);
+
+	jobSystem.Wait(&spawner);
+	jobSystem.Wait(&work);
+
+	uint64_t nStolen = jobSystem.StolenJobCount() - nStolenBefore;
+
+	std::cout << "Job System Test: " << nJobCount << " jobs queued on one deque ran on " << threadIDs.size() << " threads, " << nStolen << " stolen\n";
+
+	return nDone.load() == nJobCount && nStolen > 0 && threadIDs.size() > 1;
+}
+
+bool JobSystemTest::TestShutdown()
+{
+	const uint32_t nJobCount = 256;
+
+	JobSystem* jobSystem = new JobSystem(JOB_TEST_THREAD_COUNT);
+
+	std::atomic<uint32_t> nStarted(0);
+	std::atomic<uint32_t> nFinished(0);
+
+	for (uint32_t i = 0; i < nJobCount; ++i)
+	{
+		jobSystem->Run([&]()
+		{
+			++nStarted;
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+			++nFinished;
+		});
+	}
+
+	// Destroy the job system without waiting for its jobs, on another thread so a deadlock can be detected.
+	std::future<void> shutdown = std::async(std::launch::async, [jobSystem]() { delete jobSystem; });
+
+	if (shutdown.wait_for(std::chrono::milliseconds(JOB_TEST_SHUTDOWN_TIMEOUT_MS)) == std::future_status::timeout)
+	{
+		// The future would block on the deadlocked thread when destroyed, so exit now.
+		std::cout << "Job System Test: Shutdown did not complete within " << JOB_TEST_SHUTDOWN_TIMEOUT_MS << "ms\n" << std::flush;
+		std::_Exit(1);
+	}
+
+	shutdown.get();
+
+	std::cout << "Job System Test: " << nStarted.load() << "/" << nJobCount << " queued jobs ran before shutdown\n";
+
+	// All workers have been joined, so no job may be left part way through.
+	return nStarted.load() == nFinished.load();
+}
+
+bool JobSystemTest::Report(const char* szName, bool bPassed)
+{
+	std::cout << "Job System Test: " << szName << ": " << (bPassed ? "Passed" : "FAILED") << "\n";
+
+	return bPassed;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+/*
+Description: Self-test of the job system, run with --jobtest instead of the application. Checks counter dependencies, parallel-for coverage,
+             work stealing of an imbalanced load & shutdown with jobs still queued, printing each result & returning whether all passed.
+Author: Nic Van Zuylen
+*/
+
+// Worker threads of the job systems created by the test, including the main thread.
+#define JOB_TEST_THREAD_COUNT 4
+
+// Time a shutdown may take before the test considers it deadlocked.
+#define JOB_TEST_SHUTDOWN_TIMEOUT_MS 10000
+
+class JobSystemTest
+{
+public:
+
+	/*
+	Description: Get whether or not --jobtest was passed.
+	Return Type: bool
+	Param:
+	    int argc: Argument count from main().
+		char** argv: Arguments from main().
+	*/
+	static bool ParseArgs(int argc, char** argv);
+
+	/*
+	Description: Run every check, returns whether or not all of them passed.
+	Return Type: bool
+	*/
+	static bool Run();
+
+private:
+
+	// Jobs held back by a counter only start once all jobs of the counter have completed, across a chain of counters.
+	static bool TestDependencies();
+
+	// Every index of a range is processed exactly once, for ranges both smaller & larger than the batch size.
+	static bool TestParallelFor();
+
+	// Jobs queued on one worker's deque are stolen & run by the other threads.
+	static bool TestWorkStealing();
+
+	// Destroying a job system with jobs still queued returns, & every job which started also finished.
+	static bool TestShutdown();
+
+	// Print the result of a check & pass it through.
+	static bool Report(const char* szName, bool bPassed);
+};
@@ -4,13 +4,14 @@
 #include "Mesh.h"
 #include "Shader.h"
 #include "ShadowMap.h"
+#include "CPUProfiler.h"
 
 VkCommandBufferInheritanceInfo LightingManager::m_inheritanceInfo =
 {
 	VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
 	nullptr,
 	VK_NULL_HANDLE,
-	LIGHTING_SUBPASS_INDEX,
+	0,
 	VK_NULL_HANDLE,
 	VK_FALSE,
 	0,
@@ -25,13 +26,14 @@ VkCommandBufferBeginInfo LightingManager::m_beginInfo =
 	&LightingManager::m_inheritanceInfo
 };
 
-LightingManager::LightingManager(Renderer* renderer, Shader* dirLightShader, Shader* pointLightShader, VkDescriptorSet* mvpUBOSets, VkDescriptorSet gBufferInputSet,
+LightingManager::LightingManager(Renderer* renderer, Shader* dirLightShader, Shader* pointLightShader, VkDescriptorSet* mvpUBOSets, VkDescriptorSet gBufferInputSet, const VkSpecializationInfo* gBufferSpecInfo,
 	const unsigned int& nWindowWidth, const unsigned int& nWindowHeight, ShadowMap* shadowMap,
-	VkCommandPool cmdPool, VkRenderPass pass, VkDescriptorSetLayout uboLayout, VkDescriptorSetLayout gBufferLayout, unsigned int nQueueFamilyIndex) : RenderModule(renderer, cmdPool, pass, nQueueFamilyIndex, false)
+	VkCommandPool cmdPool, VkRenderPass pass, uint32_t nSubpassIndex, VkDescriptorSetLayout uboLayout, VkDescriptorSetLayout gBufferLayout, unsigned int nQueueFamilyIndex) : RenderModule(renderer, cmdPool, pass, nSubpassIndex, nQueueFamilyIndex, false)
 {
 	// Copy descriptor set handles...
 	std::memcpy(m_mvpUBOSets, mvpUBOSets, sizeof(VkDescriptorSet) * MAX_FRAMES_IN_FLIGHT);
 	m_gBufferInputSet = gBufferInputSet;
+	m_gBufferSpecInfo = gBufferSpecInfo;
 
 	m_mvpUBOSetLayout = uboLayout;
 	m_gBufferSetLayout = gBufferLayout;
@@ -54,8 +56,13 @@ LightingManager::LightingManager(Renderer* renderer, Shader* dirLightShader, Sha
 	CreateDescriptorPool();
 	CreateSetLayouts();
 	CreateDescriptorSets();
-	CreateDirLightingPipeline(nWindowWidth, nWindowHeight);
-	CreatePointLightingPipeline(nWindowWidth, nWindowHeight);
+	CreateLightingPipelines();
+
+	// Output size used for dynamic viewport state.
+	m_nOutputWidth = nWindowWidth;
+	m_nOutputHeight = nWindowHeight;
+	m_nRenderWidth = nWindowWidth;
+	m_nRenderHeight = nWindowHeight;
 }
 
 LightingManager::~LightingManager()
@@ -74,18 +81,12 @@ LightingManager::~LightingManager()
 	vkDestroyDescriptorSetLayout(device, m_dirLightUBOLayout, nullptr);
 
 	// Destroy UBOs
-	vkDestroyBuffer(device, m_dirLightStageBuffer, nullptr);
-	vkFreeMemory(device, m_dirLightStageMemory, nullptr);
-
 	vkDestroyBuffer(device, m_dirLightUBO, nullptr);
-	vkFreeMemory(device, m_dirLightUBOMemory, nullptr);
+	m_renderer->FreeMemory(m_dirLightUBOMemory);
 
 	// Destroy vertex buffers.
-	vkDestroyBuffer(device, m_pointLightStageInsBuffer, nullptr);
-	vkFreeMemory(device, m_pointLightStageInsMemory, nullptr);
-
 	vkDestroyBuffer(device, m_pointLightInsBuffer, nullptr);
-	vkFreeMemory(device, m_pointLightInsMemory, nullptr);
+	m_renderer->FreeMemory(m_pointLightInsMemory);
 
 	// Delete point light volume mesh.
 	delete m_pointLightVolMesh;
@@ -183,7 +184,7 @@ void LightingManager::UpdatePointLight(const PointLight& data, const unsigned in
 	m_bPointLightChange = true;
 }
 
-void LightingManager::RecreatePipelines(Shader* dirLightShader, Shader* pointLightShader, const unsigned int& nWindowWidth, const unsigned int& nWindowHeight)
+void LightingManager::RecreatePipelines(Shader* dirLightShader, Shader* pointLightShader)
 {
 	// Destroy pipelines but not pipeline layouts.
 	vkDestroyPipeline(m_renderer->GetDevice(), m_dirLightPipeline, nullptr);
@@ -194,28 +195,35 @@ void LightingManager::RecreatePipelines(Shader* dirLightShader, Shader* pointLig
 	m_pointLightShader = pointLightShader;
 
 	// Re-create pipelines. Without re-creating the layouts.
-	CreateDirLightingPipeline(nWindowWidth, nWindowHeight, false);
-	CreatePointLightingPipeline(nWindowWidth, nWindowHeight, false);
+	CreateLightingPipelines(false);
 }
 
 void LightingManager::RecordCommandBuffer(const uint32_t& nPresentImageIndex, const uint32_t& nFrameIndex, const VkFramebuffer& framebuffer, const VkCommandBuffer transferCmdBuf)
 {
-	// Set inheritence framebuffer & render pass.
+	CPU_PROFILE_ZONE("LightingManager::RecordCommandBuffer");
+
+	// Set inheritence framebuffer, render pass & subpass.
 	m_inheritanceInfo.renderPass = m_renderPass;
+	m_inheritanceInfo.subpass = m_nSubpassIndex;
 	m_inheritanceInfo.framebuffer = framebuffer;
 
 	VkCommandBuffer cmdBuf = m_cmdBuffers[nFrameIndex];
 
 	// Update lighting
 	if (m_bDirLightChange)
-		UpdateDirLights(transferCmdBuf);
+		UpdateDirLights();
 
 	if (m_bPointLightChange)
-		UpdatePointLights(transferCmdBuf);
+		UpdatePointLights();
 
 	// Begin recording...
 	RENDERER_SAFECALL(vkBeginCommandBuffer(cmdBuf, &m_beginInfo), "Lighting Manager Error: Failed to begin recording of draw commands.");
 
+	m_renderer->GetGPUProfiler()->BeginScope(cmdBuf, nFrameIndex, m_nProfilerScope);
+
+	// Pipelines use dynamic viewport & scissor state, set it to the current output size.
+	RecordViewportState(cmdBuf);
+
 	// ----------------------------------------------------------------------------------------------
 	// Directional lighting
 
@@ -242,10 +250,14 @@ void LightingManager::RecordCommandBuffer(const uint32_t& nPresentImageIndex, co
 	m_pointLightVolMesh->Bind(cmdBuf, m_pointLightInsBuffer);
 
 	// Draw point lights...
-	vkCmdDrawIndexed(cmdBuf, m_pointLightVolMesh->IndexCount(), m_pointLights.Count(), 0, 0, 0);
+	vkCmdDrawIndexed(cmdBuf, m_pointLightVolMesh->IndexCount(), m_pointLights.Count(), m_pointLightVolMesh->FirstIndex(), m_pointLightVolMesh->BaseVertex(), 0);
+
+	m_nDrawCallCount = 2;
 
 	// ----------------------------------------------------------------------------------------------
 
+	m_renderer->GetGPUProfiler()->EndScope(cmdBuf, nFrameIndex, m_nProfilerScope);
+
 	// End recording...
 	RENDERER_SAFECALL(vkEndCommandBuffer(cmdBuf), "Lighting Manager Error: Failed to end recording of draw commands.");
 }
@@ -260,52 +272,26 @@ const bool& LightingManager::PointLightingChanged()
 	return m_bPointLightChange;
 }
 
-void LightingManager::UpdateDirLights(const VkCommandBuffer& cmdBuffer)
+void LightingManager::UpdateDirLights()
 {
 	int nGlobalSize = sizeof(GlobalDirLightData);
 	int nBufferSize = sizeof(DirectionalLight) * MAX_DIRECTIONAL_LIGHTS;
 
-	// Map directional light UBO memory...
-	void* mappedPtr = nullptr;
-	RENDERER_SAFECALL(vkMapMemory(m_renderer->GetDevice(), m_dirLightStageMemory, 0, nBufferSize, 0, &mappedPtr), "Lighting Manager Error: Failed to map directional light data for update.");
+	UploadArena* uploadArena = m_renderer->GetUploadArena();
 
-	char* charPtr = static_cast<char*>(mappedPtr);
-
-	std::memcpy(charPtr, m_dirLights.Data(), nBufferSize);
-	std::memcpy(&charPtr[nBufferSize], &m_globalDirData, nGlobalSize);
-
-	// Unmap buffer memory.
-	vkUnmapMemory(m_renderer->GetDevice(), m_dirLightStageMemory);
-
-	// Issue copy command to copy staging buffer to the device local buffer.
-	VkBufferCopy copyRegion = { 0, 0, nBufferSize + nGlobalSize };
-	vkCmdCopyBuffer(cmdBuffer, m_dirLightStageBuffer, m_dirLightUBO, 1, &copyRegion);
+	// Stage lights & global data, the writes are contiguous so they are merged into a single copy region.
+	uploadArena->Write(m_dirLightUBO, m_dirLightUBOMemory, 0, m_dirLights.Data(), nBufferSize);
+	uploadArena->Write(m_dirLightUBO, m_dirLightUBOMemory, nBufferSize, &m_globalDirData, nGlobalSize);
 
 	m_bDirLightChange = false;
 }
 
-void LightingManager::UpdatePointLights(const VkCommandBuffer& cmdBuffer) 
+void LightingManager::UpdatePointLights() 
 {
 	int nCopySize = sizeof(PointLight) * (m_nChangePLightEnd - m_nChangePLightStart);
 
-	// Map instance staging buffer.
-	void* bufferPtr = nullptr;
-	RENDERER_SAFECALL(vkMapMemory(m_renderer->GetDevice(), m_pointLightStageInsMemory, sizeof(PointLight) * m_nChangePLightStart, nCopySize, 0, &bufferPtr), "Lighting Manager Error: Failed to update point light instance data on GPU.");
-
-	// Copy data...
-	memcpy_s(bufferPtr, nCopySize, &m_pointLights.Data()[m_nChangePLightStart], nCopySize);
-
-	// Unmap buffer.
-	vkUnmapMemory(m_renderer->GetDevice(), m_pointLightStageInsMemory);
-
-	// Copy instance staging buffer to device local instance buffer.
-	VkBufferCopy insCopyRegion = {};
-	insCopyRegion.srcOffset = sizeof(PointLight) * m_nChangePLightStart;
-	insCopyRegion.dstOffset = sizeof(PointLight) * m_nChangePLightStart;
-	insCopyRegion.size = nCopySize;
-
-	// Submit copy command.
-	vkCmdCopyBuffer(cmdBuffer, m_pointLightStageInsBuffer, m_pointLightInsBuffer, 1, &insCopyRegion);
+	// Stage only the changed range of lights for copying into the device local instance buffer.
+	m_renderer->GetUploadArena()->Write(m_pointLightInsBuffer, m_pointLightInsMemory, sizeof(PointLight) * m_nChangePLightStart, &m_pointLights.Data()[m_nChangePLightStart], nCopySize);
 
 	m_nChangePLightStart = 0U;
 	m_nChangePLightEnd = 1U;
@@ -315,15 +301,20 @@ void LightingManager::UpdatePointLights(const VkCommandBuffer& cmdBuffer)
 
 void LightingManager::OnOutputResize(const RenderModuleResizeData& resizeData)
 {
-	// Update render pass handle.
-	m_renderPass = resizeData.m_renderPass;
+	// Update output size. The pipelines use dynamic viewport state and the render pass is kept across resizes, so they are kept.
+	RenderModule::OnOutputResize(resizeData);
 
 	// Update descriptor set references.
 	std::memcpy(m_mvpUBOSets, resizeData.m_mvpUBOSets, sizeof(VkDescriptorSet) * MAX_FRAMES_IN_FLIGHT);
 	m_gBufferInputSet = *resizeData.m_gBufferSets;
+}
 
-	// Re-create lighting graphics pipelines for the new output resolution.
-	RecreatePipelines(m_dirLightShader, m_pointLightShader, resizeData.m_nWidth, resizeData.m_nHeight);
+void LightingManager::SetRenderPass(VkRenderPass pass, uint32_t nSubpassIndex)
+{
+	RenderModule::SetRenderPass(pass, nSubpassIndex);
+
+	// The lighting subpass may now share a render pass with the G-Buffer pass or not, so the pipelines may be incompatible with it.
+	RecreatePipelines(m_dirLightShader, m_pointLightShader);
 }
 
 inline void LightingManager::CreateDirLightBuffers()
@@ -341,9 +332,6 @@ inline void LightingManager::CreateDirLightBuffers()
 
 	uint32_t nSize = sizeof(GlobalDirLightData) + (sizeof(DirectionalLight) * MAX_DIRECTIONAL_LIGHTS);
 
-	// Create staging buffer...
-	m_renderer->CreateBuffer(nSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_dirLightStageBuffer, m_dirLightStageMemory);
-
 	// One UBO for all directional lights, to avoid memory fragmentation.
 	m_renderer->CreateBuffer(nSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_dirLightUBO, m_dirLightUBOMemory);
 
@@ -351,9 +339,6 @@ inline void LightingManager::CreateDirLightBuffers()
 
 void LightingManager::CreatePointLightBuffers()
 {
-	// Create point light staging buffer, with enough memory for MAX_POINT_LIGHT_COUNT lights.
-	m_renderer->CreateBuffer(sizeof(PointLight) * MAX_POINT_LIGHT_COUNT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_pointLightStageInsBuffer, m_pointLightStageInsMemory);
-
 	// Create point light device local buffer, with enough memory for MAX_POINT_LIGHT_COUNT lights.
 	m_renderer->CreateBuffer(sizeof(PointLight) * MAX_POINT_LIGHT_COUNT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_pointLightInsBuffer, m_pointLightInsMemory);
 }
@@ -429,8 +414,11 @@ void LightingManager::CreateDescriptorSets()
 	vkUpdateDescriptorSets(m_renderer->GetDevice(), 1, &dirLightUBOWrite, 0, nullptr);
 }
 
-void LightingManager::CreateDirLightingPipeline(const unsigned int& nWindowWidth, const unsigned int& nWindowHeight, bool bCreateLayout)
+inline void LightingManager::CreateLightingPipelines(bool bCreateLayouts)
 {
+	// ----------------------------------------------------------------------------------------------
+	// Shader stages
+
 	// Vertex shader stage information.
 	VkPipelineShaderStageCreateInfo vertStageInfo = {};
 	vertStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -444,174 +432,26 @@ void LightingManager::CreateDirLightingPipeline(const unsigned int& nWindowWidth
 	fragStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	fragStageInfo.module = m_dirLightShader->m_fragModule;
 	fragStageInfo.pName = "main";
+	fragStageInfo.pSpecializationInfo = m_gBufferSpecInfo;
 
 	// Array of shader stage information.
-	VkPipelineShaderStageCreateInfo shaderStageInfos[] = { vertStageInfo, fragStageInfo };
-
-	VkPipelineVertexInputStateCreateInfo vertInputInfo = {};
-	vertInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertInputInfo.vertexBindingDescriptionCount = 0;
-	vertInputInfo.pVertexBindingDescriptions = nullptr;
-	vertInputInfo.vertexAttributeDescriptionCount = 0;
-	vertInputInfo.pVertexAttributeDescriptions = nullptr;
-
-	// Input assembly stage configuration.
-	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-	// Viewport configuration.
-	VkViewport viewPort = {};
-	viewPort.x = 0.0f;
-	viewPort.y = 0.0f;
-	viewPort.width = (float)nWindowWidth;
-	viewPort.height = (float)nWindowHeight;
-	viewPort.minDepth = 0.0f;
-	viewPort.maxDepth = 1.0f;
-
-	// Scissor configuration.
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent = { nWindowWidth, nWindowHeight };
-
-	// Viewport state configuration.
-	VkPipelineViewportStateCreateInfo viewportState = {};
-	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewPort;
-	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
-
-	// Primitive rasterization stage configuration.
-	VkPipelineRasterizationStateCreateInfo rasterizer = {};
-	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterizer.depthClampEnable = VK_FALSE;
-	rasterizer.rasterizerDiscardEnable = VK_FALSE;
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL; // Fragment shader will be run on all rasterized fragments within each triangle.
-	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT; // Face culling
-	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-
-	// Used for shadow mapping...
-	rasterizer.depthBiasEnable = VK_FALSE;
-	rasterizer.depthBiasConstantFactor = 0.0f;
-	rasterizer.depthBiasClamp = 0.0f;
-	rasterizer.depthBiasSlopeFactor = 0.0f;
+	VkPipelineShaderStageCreateInfo dirShaderStageInfos[] = { vertStageInfo, fragStageInfo };
 
-	// Depth / Stencil state
-	VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
-	depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-	depthStencilState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-	depthStencilState.depthTestEnable = VK_FALSE; // No depth testing for deferred shading lighting pass.
-	depthStencilState.depthWriteEnable = VK_FALSE; // Also no writing to depth.
-	depthStencilState.stencilTestEnable = VK_FALSE; // Not needed.
-	depthStencilState.depthBoundsTestEnable = VK_FALSE; // We don't need the bounds test.
-	depthStencilState.minDepthBounds = 0.0f;
-	depthStencilState.maxDepthBounds = 1.0f;
-	depthStencilState.flags = 0;
-
-	// Multisampling stage configuration.
-	VkPipelineMultisampleStateCreateInfo multisampler = {};
-	multisampler.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampler.sampleShadingEnable = VK_FALSE;
-	multisampler.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-	multisampler.minSampleShading = 1.0f;
-	multisampler.pSampleMask = nullptr;
-	multisampler.alphaToCoverageEnable = VK_FALSE;
-	multisampler.alphaToOneEnable = VK_FALSE;
-
-	// TODO: Set this up for deferred shading, to allow blending of multiple lights.
-	// Color blending
-	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable = VK_FALSE; // Blending not required yet...
-	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-	VkPipelineColorBlendAttachmentState colorBlendAttachments[] = { colorBlendAttachment };
-
-	VkPipelineColorBlendStateCreateInfo colorBlending = {};
-	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlending.logicOpEnable = VK_FALSE;
-	colorBlending.logicOp = VK_LOGIC_OP_COPY;
-	colorBlending.attachmentCount = 1; // Blending for color output.
-	colorBlending.pAttachments = colorBlendAttachments;
-	colorBlending.blendConstants[0] = 0.0f;
-	colorBlending.blendConstants[1] = 0.0f;
-	colorBlending.blendConstants[2] = 0.0f;
-	colorBlending.blendConstants[3] = 0.0f;
-
-	// Get shadow map camera set layout if shadow mapping is used.
-	VkDescriptorSetLayout shadowMapCamSetLayout = VK_NULL_HANDLE;
-
-	if (m_shadowMapModule)
-		shadowMapCamSetLayout = m_shadowMapModule->GetShadowMapCamSetLayout();
-
-	VkDescriptorSetLayout setLayouts[] = { m_mvpUBOSetLayout, m_gBufferSetLayout, m_dirLightUBOLayout, shadowMapCamSetLayout };
-
-	// Only create layout if allowed.
-	if (bCreateLayout)
-	{
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 3 + (m_shadowMapModule != nullptr);
-		pipelineLayoutInfo.pSetLayouts = setLayouts; // Lighting pass descriptor sets...
-		pipelineLayoutInfo.pushConstantRangeCount = 0;
-		pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-	    RENDERER_SAFECALL(vkCreatePipelineLayout(m_renderer->GetDevice(), &pipelineLayoutInfo, nullptr, &m_dirLightPipelineLayout), "Renderer Error: Failed to create lighting graphics pipeline layout.");
-	}
-
-	// Create pipeline.
-	VkGraphicsPipelineCreateInfo pipelineInfo = {};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
-	pipelineInfo.pStages = shaderStageInfos;
-	pipelineInfo.pVertexInputState = &vertInputInfo;
-	pipelineInfo.pInputAssemblyState = &inputAssembly;
-	pipelineInfo.pViewportState = &viewportState;
-	pipelineInfo.pRasterizationState = &rasterizer;
-	pipelineInfo.pMultisampleState = &multisampler;
-	pipelineInfo.pDepthStencilState = &depthStencilState;
-	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = nullptr;
-	pipelineInfo.layout = m_dirLightPipelineLayout;
-	pipelineInfo.renderPass = m_renderPass;
-	pipelineInfo.subpass = LIGHTING_SUBPASS_INDEX;
-	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-	pipelineInfo.basePipelineIndex = -1;
-
-	RENDERER_SAFECALL(vkCreateGraphicsPipelines(m_renderer->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_dirLightPipeline), "Renderer Error: Failed to create lighting graphics pipeline.");
-}
-
-inline void LightingManager::CreatePointLightingPipeline(const unsigned int& nWindowWidth, const unsigned int& nWindowHeight, bool bCreateLayout)
-{
-	// Vertex shader stage information.
-	VkPipelineShaderStageCreateInfo vertStageInfo = {};
-	vertStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
 	vertStageInfo.module = m_pointLightShader->m_vertModule;
-	vertStageInfo.pName = "main";
-
-	// Fragment shader stage information.
-	VkPipelineShaderStageCreateInfo fragStageInfo = {};
-	fragStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	fragStageInfo.module = m_pointLightShader->m_fragModule;
-	fragStageInfo.pName = "main";
 
-	// Array of shader stage information.
-	VkPipelineShaderStageCreateInfo shaderStageInfos[] = { vertStageInfo, fragStageInfo };
+	VkPipelineShaderStageCreateInfo pointShaderStageInfos[] = { vertStageInfo, fragStageInfo };
+
+	// ----------------------------------------------------------------------------------------------
+	// Vertex input
 
-	VkVertexInputBindingDescription pointLightInsDesc = {};
-	pointLightInsDesc.binding = 1;
-	pointLightInsDesc.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
-	pointLightInsDesc.stride = sizeof(PointLight);
+	// Directional lighting is a fullscreen pass with no vertex input.
+	VkPipelineVertexInputStateCreateInfo dirVertInputInfo = {};
+	dirVertInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	dirVertInputInfo.vertexBindingDescriptionCount = 0;
+	dirVertInputInfo.pVertexBindingDescriptions = nullptr;
+	dirVertInputInfo.vertexAttributeDescriptionCount = 0;
+	dirVertInputInfo.pVertexAttributeDescriptions = nullptr;
 
 	const VertexInfo* pointLightMeshFormat = m_pointLightVolMesh->VertexFormat();
 
@@ -631,12 +471,16 @@ inline void LightingManager::CreatePointLightingPipeline(const unsigned int& nWi
 
 	VkVertexInputBindingDescription bindingDescs[] = { pointLightMeshFormat->BindingDescription(), insInfo.BindingDescription() };
 
-	VkPipelineVertexInputStateCreateInfo vertInputInfo = {};
-	vertInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertInputInfo.vertexBindingDescriptionCount = 2;
-	vertInputInfo.pVertexBindingDescriptions = bindingDescs;
-	vertInputInfo.vertexAttributeDescriptionCount = attrDescriptions.Count();
-	vertInputInfo.pVertexAttributeDescriptions = attrDescriptions.Data();
+	// Point lights are drawn as instanced light volume meshes.
+	VkPipelineVertexInputStateCreateInfo pointVertInputInfo = {};
+	pointVertInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	pointVertInputInfo.vertexBindingDescriptionCount = 2;
+	pointVertInputInfo.pVertexBindingDescriptions = bindingDescs;
+	pointVertInputInfo.vertexAttributeDescriptionCount = attrDescriptions.Count();
+	pointVertInputInfo.pVertexAttributeDescriptions = attrDescriptions.Data();
+
+	// ----------------------------------------------------------------------------------------------
+	// Shared fixed function state
 
 	// Input assembly stage configuration.
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
@@ -644,27 +488,21 @@ inline void LightingManager::CreatePointLightingPipeline(const unsigned int& nWi
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	// Viewport configuration.
-	VkViewport viewPort = {};
-	viewPort.x = 0.0f;
-	viewPort.y = 0.0f;
-	viewPort.width = (float)nWindowWidth;
-	viewPort.height = (float)nWindowHeight;
-	viewPort.minDepth = 0.0f;
-	viewPort.maxDepth = 1.0f;
-
-	// Scissor configuration.
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent = { nWindowWidth, nWindowHeight };
-
-	// Viewport state configuration.
+	// Viewport state configuration. Viewport & scissor are dynamic so the pipelines survive output resizes.
 	VkPipelineViewportStateCreateInfo viewportState = {};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewPort;
+	viewportState.pViewports = nullptr;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+	viewportState.pScissors = nullptr;
+
+	VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	// Dynamic state configuration.
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
 
 	// Primitive rasterization stage configuration.
 	VkPipelineRasterizationStateCreateInfo rasterizer = {};
@@ -704,64 +542,102 @@ inline void LightingManager::CreatePointLightingPipeline(const unsigned int& nWi
 	multisampler.alphaToCoverageEnable = VK_FALSE;
 	multisampler.alphaToOneEnable = VK_FALSE;
 
-	// TODO: Set this up for deferred shading, to allow blending of multiple lights.
+	// ----------------------------------------------------------------------------------------------
 	// Color blending
-	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-	colorBlendAttachment.blendEnable = VK_TRUE; // Blending is required to combine the colors and intensity of overlapping lights.
-	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // The color and intensity of lights will be combined.
-	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-	VkPipelineColorBlendAttachmentState colorBlendAttachments[] = { colorBlendAttachment };
-
-	VkPipelineColorBlendStateCreateInfo colorBlending = {};
-	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlending.logicOpEnable = VK_FALSE;
-	colorBlending.logicOp = VK_LOGIC_OP_COPY;
-	colorBlending.attachmentCount = 1; // Blending for color output.
-	colorBlending.pAttachments = colorBlendAttachments;
-	colorBlending.blendConstants[0] = 0.0f;
-	colorBlending.blendConstants[1] = 0.0f;
-	colorBlending.blendConstants[2] = 0.0f;
-	colorBlending.blendConstants[3] = 0.0f;
-
-	VkDescriptorSetLayout setLayouts[] = { m_mvpUBOSetLayout, m_gBufferSetLayout };
-
-	// Only create layout if allowed.
-	if(bCreateLayout) 
+
+	// Directional lighting writes the lit color directly.
+	VkPipelineColorBlendAttachmentState dirBlendAttachment = {};
+	dirBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	dirBlendAttachment.blendEnable = VK_FALSE;
+	dirBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	dirBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+	dirBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	dirBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	dirBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	dirBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	// Point lighting requires blending to combine the colors and intensity of overlapping lights.
+	VkPipelineColorBlendAttachmentState pointBlendAttachment = dirBlendAttachment;
+	pointBlendAttachment.blendEnable = VK_TRUE;
+	pointBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+
+	VkPipelineColorBlendStateCreateInfo dirColorBlending = {};
+	dirColorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	dirColorBlending.logicOpEnable = VK_FALSE;
+	dirColorBlending.logicOp = VK_LOGIC_OP_COPY;
+	dirColorBlending.attachmentCount = 1; // Blending for color output.
+	dirColorBlending.pAttachments = &dirBlendAttachment;
+	dirColorBlending.blendConstants[0] = 0.0f;
+	dirColorBlending.blendConstants[1] = 0.0f;
+	dirColorBlending.blendConstants[2] = 0.0f;
+	dirColorBlending.blendConstants[3] = 0.0f;
+
+	VkPipelineColorBlendStateCreateInfo pointColorBlending = dirColorBlending;
+	pointColorBlending.pAttachments = &pointBlendAttachment;
+
+	// ----------------------------------------------------------------------------------------------
+	// Layouts
+
+	// Get shadow map camera set layout if shadow mapping is used.
+	VkDescriptorSetLayout shadowMapCamSetLayout = VK_NULL_HANDLE;
+
+	if (m_shadowMapModule)
+		shadowMapCamSetLayout = m_shadowMapModule->GetShadowMapCamSetLayout();
+
+	VkDescriptorSetLayout setLayouts[] = { m_mvpUBOSetLayout, m_gBufferSetLayout, m_dirLightUBOLayout, shadowMapCamSetLayout };
+
+	// Only create layouts if allowed.
+	if (bCreateLayouts)
 	{
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 2;
+		pipelineLayoutInfo.setLayoutCount = 3 + (m_shadowMapModule != nullptr);
 		pipelineLayoutInfo.pSetLayouts = setLayouts; // Lighting pass descriptor sets...
 		pipelineLayoutInfo.pushConstantRangeCount = 0;
 		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
+	    RENDERER_SAFECALL(vkCreatePipelineLayout(m_renderer->GetDevice(), &pipelineLayoutInfo, nullptr, &m_dirLightPipelineLayout), "Renderer Error: Failed to create lighting graphics pipeline layout.");
+
+		// Point lights only use the MVP UBO and G Buffer sets.
+		pipelineLayoutInfo.setLayoutCount = 2;
+
 		RENDERER_SAFECALL(vkCreatePipelineLayout(m_renderer->GetDevice(), &pipelineLayoutInfo, nullptr, &m_pointLightPipelineLayout), "Renderer Error: Failed to create lighting graphics pipeline layout.");
 	}
 
-	// Create pipeline.
-	VkGraphicsPipelineCreateInfo pipelineInfo = {};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
-	pipelineInfo.pStages = shaderStageInfos;
-	pipelineInfo.pVertexInputState = &vertInputInfo;
-	pipelineInfo.pInputAssemblyState = &inputAssembly;
-	pipelineInfo.pViewportState = &viewportState;
-	pipelineInfo.pRasterizationState = &rasterizer;
-	pipelineInfo.pMultisampleState = &multisampler;
-	pipelineInfo.pDepthStencilState = &depthStencilState;
-	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = nullptr;
-	pipelineInfo.layout = m_dirLightPipelineLayout;
-	pipelineInfo.renderPass = m_renderPass;
-	pipelineInfo.subpass = LIGHTING_SUBPASS_INDEX;
-	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-	pipelineInfo.basePipelineIndex = -1;
-
-	RENDERER_SAFECALL(vkCreateGraphicsPipelines(m_renderer->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pointLightPipeline), "Renderer Error: Failed to create lighting graphics pipeline.");
+	// ----------------------------------------------------------------------------------------------
+	// Pipelines
+
+	VkGraphicsPipelineCreateInfo pipelineInfos[2] = {};
+
+	VkGraphicsPipelineCreateInfo& dirPipelineInfo = pipelineInfos[0];
+	dirPipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	dirPipelineInfo.stageCount = 2;
+	dirPipelineInfo.pStages = dirShaderStageInfos;
+	dirPipelineInfo.pVertexInputState = &dirVertInputInfo;
+	dirPipelineInfo.pInputAssemblyState = &inputAssembly;
+	dirPipelineInfo.pViewportState = &viewportState;
+	dirPipelineInfo.pRasterizationState = &rasterizer;
+	dirPipelineInfo.pMultisampleState = &multisampler;
+	dirPipelineInfo.pDepthStencilState = &depthStencilState;
+	dirPipelineInfo.pColorBlendState = &dirColorBlending;
+	dirPipelineInfo.pDynamicState = &dynamicState;
+	dirPipelineInfo.layout = m_dirLightPipelineLayout;
+	dirPipelineInfo.renderPass = m_renderPass;
+	dirPipelineInfo.subpass = m_nSubpassIndex;
+	dirPipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	dirPipelineInfo.basePipelineIndex = -1;
+
+	VkGraphicsPipelineCreateInfo& pointPipelineInfo = pipelineInfos[1];
+	pointPipelineInfo = dirPipelineInfo;
+	pointPipelineInfo.pStages = pointShaderStageInfos;
+	pointPipelineInfo.pVertexInputState = &pointVertInputInfo;
+	pointPipelineInfo.pColorBlendState = &pointColorBlending;
+
+	VkPipeline pipelines[2];
+
+	// Create both lighting pipelines in a single call.
+	m_renderer->GetPipelineCache()->CreateGraphicsPipelines(pipelineInfos, 2, pipelines);
+
+	m_dirLightPipeline = pipelines[0];
+	m_pointLightPipeline = pipelines[1];
 }
\ No newline at end of file
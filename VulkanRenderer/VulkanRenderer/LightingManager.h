@@ -37,9 +37,9 @@ class LightingManager : public RenderModule
 {
 public:
 
-	LightingManager(Renderer* renderer, Shader* dirLightShader, Shader* pointLightShader, VkDescriptorSet* mvpUBOSets, VkDescriptorSet gBufferInputSet,
+	LightingManager(Renderer* renderer, Shader* dirLightShader, Shader* pointLightShader, VkDescriptorSet* mvpUBOSets, VkDescriptorSet gBufferInputSet, const VkSpecializationInfo* gBufferSpecInfo,
 		const unsigned int& nWindowWidth, const unsigned int& nWindowHeight, ShadowMap* shadowMap,
-		VkCommandPool cmdPool, VkRenderPass pass, VkDescriptorSetLayout uboLayout, VkDescriptorSetLayout gBufferLayout, unsigned int nQueueFamilyIndex);
+		VkCommandPool cmdPool, VkRenderPass pass, uint32_t nSubpassIndex, VkDescriptorSetLayout uboLayout, VkDescriptorSetLayout gBufferLayout, unsigned int nQueueFamilyIndex);
 
 	~LightingManager();
 
@@ -124,24 +124,27 @@ public:
 	/*
 	Description: Update directional lighting data on the GPU.
 	*/
-	inline void UpdateDirLights(const VkCommandBuffer& cmdBuffer);
+	inline void UpdateDirLights();
 
 	/*
 	Description: Update point lighting data on the GPU.
-	Param:
-	    VkCommandBuffer cmdBuffer: The transfer command buffer to record to.
 	*/
-	void UpdatePointLights(const VkCommandBuffer& cmdBuffer);
+	void UpdatePointLights();
 
 	/*
 	Description: Run when the subscene output resolution is modified.
 	*/
 	void OnOutputResize(const RenderModuleResizeData& resizeData) override;
 
+	/*
+	Description: Run when the render graph is rebuilt, re-creates the lighting pipelines for the new render pass.
+	*/
+	void SetRenderPass(VkRenderPass pass, uint32_t nSubpassIndex) override;
+
 	/*
 	Description: Re-create lighting graphics pipelines.
 	*/
-	void RecreatePipelines(Shader* dirLightShader, Shader* pointLightShader, const unsigned int& nWindowWidth, const unsigned int& nWindowHeight);
+	void RecreatePipelines(Shader* dirLightShader, Shader* pointLightShader);
 
 	/*
 	Description: Record lighting pass command buffer.
@@ -160,9 +163,8 @@ private:
 
 	inline void CreateDescriptorSets();
 
-	inline void CreateDirLightingPipeline(const unsigned int& nWindowWidth, const unsigned int& nWindowHeight, bool bCreateLayout = true);
-
-	inline void CreatePointLightingPipeline(const unsigned int& nWindowWidth, const unsigned int& nWindowHeight, bool bCreateLayout = true);
+	// Create the directional & point lighting pipelines in a single batch.
+	inline void CreateLightingPipelines(bool bCreateLayouts = true);
 
 	// ---------------------------------------------------------------------------------
 	// Template Vulkan Structures
@@ -195,17 +197,11 @@ private:
 	// ---------------------------------------------------------------------------------
 	// Buffers
 
-	VkBuffer m_dirLightStageBuffer;
-	VkDeviceMemory m_dirLightStageMemory;
-
 	VkBuffer m_dirLightUBO;
-	VkDeviceMemory m_dirLightUBOMemory;
-
-	VkBuffer m_pointLightStageInsBuffer;
-	VkDeviceMemory m_pointLightStageInsMemory;
+	MemAllocation m_dirLightUBOMemory;
 
 	VkBuffer m_pointLightInsBuffer;
-	VkDeviceMemory m_pointLightInsMemory;
+	MemAllocation m_pointLightInsMemory;
 
 	// ---------------------------------------------------------------------------------
 	// Descriptors
@@ -216,6 +212,7 @@ private:
 
 	VkDescriptorSet m_mvpUBOSets[MAX_FRAMES_IN_FLIGHT];
 	VkDescriptorSet m_gBufferInputSet;
+	const VkSpecializationInfo* m_gBufferSpecInfo; // Selects the G-Buffer decoding path of the lighting shaders.
 
 	VkDescriptorSetLayout m_mvpUBOSetLayout;
 	VkDescriptorSetLayout m_gBufferSetLayout;
@@ -5,6 +5,7 @@
 
 Sampler* Material::m_defaultSampler = nullptr;
 int Material::m_globalMaterialCount = 0;
+uint32_t Material::m_nNextMaterialID = 0;
 
 Material::Material(Renderer* renderer, Shader* shader, const DynamicArray<Texture*>& textureMaps, const DynamicArray<MaterialProperty>& properties, bool bUseMVPUBO)
 {
@@ -26,6 +27,7 @@ Material::Material(Renderer* renderer, Shader* shader, const DynamicArray<Textur
 
 	m_sampler = m_defaultSampler;
 
+	m_nID = m_nNextMaterialID++;
 	m_nameID += "S:Default|";
 	m_nameID += shader->m_name;
 
@@ -72,6 +74,7 @@ Material::Material(Renderer* renderer, Shader* shader, const std::initializer_li
 
 	m_sampler = m_defaultSampler;
 
+	m_nID = m_nNextMaterialID++;
 	m_nameID += "S:Default|";
 	m_nameID += shader->m_name;
 
@@ -100,29 +103,19 @@ Material::Material(Renderer* renderer, Shader* shader, const std::initializer_li
 	CreateDescriptorObjects();
 }
 
-void Material::UseDescriptorSet(const VkCommandBuffer& cmdBuffer, const VkCommandBuffer& transferCmdBuf, VkPipelineLayout& pipeline, VkDescriptorSet& mvpUBOSet, const unsigned int& nFrameIndex)
+void Material::UpdateProperties(const unsigned int& nFrameIndex)
 {
 	if(m_nUpdateProperties) 
 	{
-		VkDevice device = m_renderer->GetDevice();
-
-		// Map and update property staging buffer.
-		void* mappedPtr = nullptr;
-		vkMapMemory(device, m_propStagingMem[nFrameIndex], 0, VK_WHOLE_SIZE, 0, &mappedPtr);
-
-		// Copy data into staging buffer.
-		std::memcpy(mappedPtr, m_matPropData.Data(), m_matPropData.GetSize());
-
-		// Unmap memory.
-		vkUnmapMemory(device, m_propStagingMem[nFrameIndex]);
-
-		// Issue staging buffer to ubo copy command.
-		VkBufferCopy copyData = { 0, 0, m_matPropData.GetSize() };
-		vkCmdCopyBuffer(transferCmdBuf, m_propStagingBuf[nFrameIndex], m_propertyUBO[nFrameIndex], 1, &copyData);
+		// Write properties to this frame's UBO, directly or through the upload arena.
+		m_renderer->GetUploadArena()->Write(m_propertyUBO[nFrameIndex], m_propUBOMemory[nFrameIndex], 0, m_matPropData.Data(), m_matPropData.GetSize(), true);
 
 		m_nUpdateProperties -= 1;
 	}
+}
 
+void Material::UseDescriptorSet(const VkCommandBuffer& cmdBuffer, VkPipelineLayout& pipeline, VkDescriptorSet& mvpUBOSet, const unsigned int& nFrameIndex)
+{
 	VkDescriptorSet sets[2] = { mvpUBOSet, m_matDescSets[nFrameIndex] };
 
 	vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline, 0, 2, sets, 0, nullptr);
@@ -152,18 +145,11 @@ Material::~Material()
 	// Destroy buffers.
 	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) 
 	{
-		// Destroy staging buffers.
-		if (m_propStagingBuf[i])
-		{
-			vkDestroyBuffer(m_renderer->GetDevice(), m_propStagingBuf[i], nullptr);
-			vkFreeMemory(m_renderer->GetDevice(), m_propStagingMem[i], nullptr);
-		}
-
 		// Destroy property buffers.
 		if(m_propertyUBO[i]) 
 		{
 		    vkDestroyBuffer(m_renderer->GetDevice(), m_propertyUBO[i], nullptr);
-		    vkFreeMemory(m_renderer->GetDevice(), m_propUBOMemory[i], nullptr);
+		    m_renderer->FreeMemory(m_propUBOMemory[i]);
 		}
 	}
 }
@@ -202,12 +188,11 @@ void Material::AddProperty(EMatPropType type, const char* name)
 
 inline void Material::CreateMatPropertyUBO()
 {
-	// Create buffers for each frame-in-flight, one staging and one device local.
+	VkMemoryPropertyFlags memoryFlags = m_renderer->GetUploadArena()->PerFrameMemoryFlags();
+
+	// Create a UBO for each frame-in-flight, updates are staged through the renderer's upload arena.
 	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) 
-	{
-		m_renderer->CreateBuffer(m_matPropData.GetSize(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, m_propStagingBuf[i], m_propStagingMem[i]);
-		m_renderer->CreateBuffer(m_matPropData.GetSize(), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_propertyUBO[i], m_propUBOMemory[i]);
-	}
+		m_renderer->CreateBuffer(m_matPropData.GetSize(), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryFlags, m_propertyUBO[i], m_propUBOMemory[i]);
 }
 
 void Material::SetFloat(const char* name, float fVal)
@@ -306,6 +291,11 @@ const std::string& Material::GetName() const
 	return m_nameID;
 }
 
+uint32_t Material::ID() const
+{
+	return m_nID;
+}
+
 const VkDescriptorSetLayout& Material::GetDescriptorLayout() const 
 {
 	return m_matSetLayout;
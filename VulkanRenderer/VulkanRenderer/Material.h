@@ -57,15 +57,21 @@ public:
 	~Material();
 
 	/*
-	Description: Issue vulkan command for using the specified descriptor set of this material. (Specified by index.)
+	Description: Write modified material properties to the property UBO of the provided frame. Must be called on the main thread before recording.
+	Param:
+	    const unsigned int& nFrameIndex: The index of the current frame-in-flight.
+	*/
+	void UpdateProperties(const unsigned int& nFrameIndex);
+
+	/*
+	Description: Issue vulkan command for using the specified descriptor set of this material. (Specified by index.) Safe to call from multiple recording threads.
 	Param:
 	    const VkCommandBuffer& cmdBuffer: The command buffer to issue commands to.
-		const VkCommandBuffer& transferCmdBuf: The command buffer to issue transfer commands to.
 		VkPipelineLayout& pipeline: The pipeline to bind this material's descriptor sets to.
 		VkDescriptorSet& mvpUBOSet: The MVP matrix UBO descriptor set to bind for this frame.
 		const unsigned int& nFrameIndex: The index of the current frame-in-flight.
 	*/
-	void UseDescriptorSet(const VkCommandBuffer& cmdBuffer, const VkCommandBuffer& transferCmdBuf, VkPipelineLayout& pipeline, VkDescriptorSet& mvpUBOSet, const unsigned int& nFrameIndex);
+	void UseDescriptorSet(const VkCommandBuffer& cmdBuffer, VkPipelineLayout& pipeline, VkDescriptorSet& mvpUBOSet, const unsigned int& nFrameIndex);
 
 	/*
 	Description: Set the texture sampler used by this material.
@@ -94,6 +100,12 @@ public:
 	*/
 	const std::string& GetName() const;
 
+	/*
+	Description: Get the unique ID of this material, used to sort draws by material.
+	Return Type: uint32_t
+	*/
+	uint32_t ID() const;
+
 	/*
 	Description: The descriptor set layout of this material.
 	*/
@@ -136,12 +148,14 @@ private:
 
 	static Sampler* m_defaultSampler; // Used if no sampler is explicitly provided.
 	static int m_globalMaterialCount; // Tracks the amount of existing materials, if there is none the default sampler is freed when the last material is destroyed.
+	static uint32_t m_nNextMaterialID; // Source of material IDs, which distinguish materials sharing a shader & textures for draw sorting.
 
 	// ---------------------------------------------------------------------------------
 	// Main
 
 	Renderer* m_renderer;
 	Shader* m_shader;
+	uint32_t m_nID;
 	Sampler* m_sampler;
 	DynamicArray<Texture*> m_textures;
 	bool m_bUseMVPUBO; // Flags the use of the MVP matrix UBO for this material.
@@ -154,11 +168,8 @@ private:
 	DynamicArray<char> m_matPropData; // Material property UBO data.
 	std::map<const char*, int> m_matPropSearchIndices; // Search indices for material properties.
 
-	VkBuffer m_propStagingBuf[MAX_FRAMES_IN_FLIGHT];
-	VkDeviceMemory m_propStagingMem[MAX_FRAMES_IN_FLIGHT];
-
 	VkBuffer m_propertyUBO[MAX_FRAMES_IN_FLIGHT];
-	VkDeviceMemory m_propUBOMemory[MAX_FRAMES_IN_FLIGHT];
+	MemAllocation m_propUBOMemory[MAX_FRAMES_IN_FLIGHT];
 
 	// ---------------------------------------------------------------------------------
 	// Descriptors
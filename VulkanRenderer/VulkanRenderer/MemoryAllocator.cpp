@@ -0,0 +1,328 @@
+#include "MemoryAllocator.h"
+#include "RendererHelper.h"
+
+#include <iostream>
+#include <stdexcept>
+
+// Round nValue up to the nearest multiple of nAlignment. (Alignment must be a power of two.)
+#define ALIGN_UP(nValue, nAlignment) (((nValue) + (nAlignment) - 1) & ~((nAlignment) - 1))
+
+MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physDevice)
+{
+	m_device = device;
+	m_nDeviceAllocationCount = 0;
+
+	vkGetPhysicalDeviceMemoryProperties(physDevice, &m_memProperties);
+
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(physDevice, &deviceProperties);
+
+	m_nBufferImageGranularity = deviceProperties.limits.bufferImageGranularity;
+	m_nMaxAllocationCount = deviceProperties.limits.maxMemoryAllocationCount;
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	for(uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+	{
+		for(uint32_t j = 0; j < MEMORY_POOL_COUNT; ++j)
+		{
+			DynamicArray<MemoryBlock*>& pool = m_blocks[i][j];
+
+			for(uint32_t k = 0; k < pool.Count(); ++k)
+			{
+				MemoryBlock* block = pool[k];
+
+				if (block->m_nAllocationCount > 0)
+					std::cout << "Memory Allocator Warning: Block destroyed with " << block->m_nAllocationCount << " live allocation(s).\n";
+
+				if (block->m_mappedPtr)
+					vkUnmapMemory(m_device, block->m_memory);
+
+				vkFreeMemory(m_device, block->m_memory, nullptr);
+				delete block;
+			}
+
+			pool.Clear();
+		}
+	}
+}
+
+void MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EMemoryPool ePool, MemAllocation& outAllocation)
+{
+	uint32_t nMemoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties);
+
+	// Linear & optimal resources can share blocks when there is no granularity restriction between them.
+	if (m_nBufferImageGranularity <= 1)
+		ePool = MEMORY_POOL_LINEAR;
+
+	VkDeviceSize nBlockSize = GetBlockSize(nMemoryTypeIndex);
+
+	// Resources larger than half a block get their own dedicated block.
+	if(requirements.size > nBlockSize / 2)
+	{
+		MemoryBlock* block = CreateBlock(nMemoryTypeIndex, ePool, requirements.size, true);
+		AllocateFromBlock(block, requirements.size, requirements.alignment, outAllocation);
+
+		return;
+	}
+
+	// Try existing blocks first.
+	DynamicArray<MemoryBlock*>& pool = m_blocks[nMemoryTypeIndex][ePool];
+	for(uint32_t i = 0; i < pool.Count(); ++i)
+	{
+		if (!pool[i]->m_bDedicated && AllocateFromBlock(pool[i], requirements.size, requirements.alignment, outAllocation))
+			return;
+	}
+
+	// No existing block has room, allocate a new one.
+	MemoryBlock* block = CreateBlock(nMemoryTypeIndex, ePool, nBlockSize, false);
+	AllocateFromBlock(block, requirements.size, requirements.alignment, outAllocation);
+}
+
+void MemoryAllocator::Free(MemAllocation& allocation)
+{
+	MemoryBlock* block = allocation.m_block;
+
+	if (!block)
+		return;
+
+	MemRange freed = { allocation.m_nOffset, allocation.m_nSize };
+
+	// Merge with adjacent free ranges.
+	for(uint32_t i = 0; i < block->m_freeRanges.Count();)
+	{
+		MemRange& range = block->m_freeRanges[i];
+
+		if(range.m_nOffset + range.m_nSize == freed.m_nOffset)
+		{
+			freed.m_nOffset = range.m_nOffset;
+			freed.m_nSize += range.m_nSize;
+		}
+		else if(freed.m_nOffset + freed.m_nSize == range.m_nOffset)
+		{
+			freed.m_nSize += range.m_nSize;
+		}
+		else
+		{
+			++i;
+			continue;
+		}
+
+		// Remove the merged range by replacing it with the last range.
+		block->m_freeRanges[i] = block->m_freeRanges[block->m_freeRanges.Count() - 1];
+		block->m_freeRanges.Pop();
+	}
+
+	block->m_freeRanges.Push(freed);
+	block->m_nBytesInUse -= allocation.m_nSize;
+	--block->m_nAllocationCount;
+
+	// Release empty dedicated blocks, and empty regular blocks if there is another block in the pool to allocate from.
+	if (block->m_nAllocationCount == 0 && (block->m_bDedicated || m_blocks[block->m_nMemoryTypeIndex][block->m_nPoolIndex].Count() > 1))
+		DestroyBlock(block);
+
+	allocation = {};
+}
+
+uint32_t MemoryAllocator::FindMemoryType(uint32_t nTypeFilter, VkMemoryPropertyFlags properties) const
+{
+	for (uint32_t i = 0; i < m_memProperties.memoryTypeCount; ++i)
+	{
+		// Ensure properties match...
+		if ((nTypeFilter & (1 << i)) && ((m_memProperties.memoryTypes[i].propertyFlags & properties) == properties))
+			return i;
+	}
+
+	throw std::runtime_error("Memory Allocator Error: Failed to find suitable memory type for allocation.");
+	return 0;
+}
+
+bool MemoryAllocator::HasMemoryType(VkMemoryPropertyFlags properties, uint32_t nTypeFilter) const
+{
+	for (uint32_t i = 0; i < m_memProperties.memoryTypeCount; ++i)
+	{
+		if ((nTypeFilter & (1 << i)) && (m_memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			return true;
+	}
+
+	return false;
+}
+
+MemAllocatorStats MemoryAllocator::GetStats() const
+{
+	MemAllocatorStats stats = {};
+
+	VkDeviceSize nTotalFree = 0;
+	VkDeviceSize nLargestFreeSum = 0; // Sum of the largest free range of each block.
+
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+	{
+		for (uint32_t j = 0; j < MEMORY_POOL_COUNT; ++j)
+		{
+			const DynamicArray<MemoryBlock*>& pool = m_blocks[i][j];
+
+			for (uint32_t k = 0; k < pool.Count(); ++k)
+			{
+				const MemoryBlock* block = pool[k];
+
+				++stats.m_nBlockCount;
+				stats.m_nAllocationCount += block->m_nAllocationCount;
+				stats.m_nFreeRangeCount += block->m_freeRanges.Count();
+				stats.m_nBytesAllocated += block->m_nSize;
+				stats.m_nBytesInUse += block->m_nBytesInUse;
+
+				VkDeviceSize nBlockLargestFree = 0;
+
+				for(uint32_t r = 0; r < block->m_freeRanges.Count(); ++r)
+				{
+					const MemRange& range = block->m_freeRanges[r];
+
+					nTotalFree += range.m_nSize;
+
+					if (range.m_nSize > nBlockLargestFree)
+						nBlockLargestFree = range.m_nSize;
+				}
+
+				nLargestFreeSum += nBlockLargestFree;
+
+				if (nBlockLargestFree > stats.m_nLargestFreeRange)
+					stats.m_nLargestFreeRange = nBlockLargestFree;
+			}
+		}
+	}
+
+	stats.m_fFragmentation = nTotalFree > 0 ? 1.0f - static_cast<float>(static_cast<double>(nLargestFreeSum) / static_cast<double>(nTotalFree)) : 0.0f;
+
+	return stats;
+}
+
+void MemoryAllocator::PrintStats() const
+{
+	MemAllocatorStats stats = GetStats();
+
+	std::cout << "Memory Allocator: " << stats.m_nBlockCount << " block(s) (" << m_nDeviceAllocationCount << "/" << m_nMaxAllocationCount << " device allocations), "
+		<< stats.m_nAllocationCount << " allocation(s)\n";
+	std::cout << "Memory Allocator: " << (stats.m_nBytesInUse / 1024) << "KB in use of " << (stats.m_nBytesAllocated / 1024) << "KB allocated, "
+		<< stats.m_nFreeRangeCount << " free range(s), fragmentation: " << (stats.m_fFragmentation * 100.0f) << "%\n";
+}
+
+MemoryBlock* MemoryAllocator::CreateBlock(uint32_t nMemoryTypeIndex, EMemoryPool ePool, VkDeviceSize nSize, bool bDedicated)
+{
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = nSize;
+	allocInfo.memoryTypeIndex = nMemoryTypeIndex;
+	allocInfo.pNext = nullptr;
+
+	MemoryBlock* block = new MemoryBlock;
+	block->m_nSize = nSize;
+	block->m_nBytesInUse = 0;
+	block->m_mappedPtr = nullptr;
+	block->m_nMemoryTypeIndex = nMemoryTypeIndex;
+	block->m_nAllocationCount = 0;
+	block->m_nPoolIndex = ePool;
+	block->m_bDedicated = bDedicated;
+	block->m_freeRanges.Push({ 0, nSize });
+
+	if(vkAllocateMemory(m_device, &allocInfo, nullptr, &block->m_memory) != VK_SUCCESS)
+	{
+		delete block;
+		throw std::runtime_error("Memory Allocator Error: Failed to allocate device memory block.");
+	}
+
+	// Host visible blocks are mapped once for their entire lifetime.
+	if (m_memProperties.memoryTypes[nMemoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		RENDERER_SAFECALL(vkMapMemory(m_device, block->m_memory, 0, VK_WHOLE_SIZE, 0, &block->m_mappedPtr), "Memory Allocator Error: Failed to map host visible memory block.");
+
+	m_blocks[nMemoryTypeIndex][ePool].Push(block);
+	++m_nDeviceAllocationCount;
+
+	return block;
+}
+
+void MemoryAllocator::DestroyBlock(MemoryBlock* block)
+{
+	if (block->m_mappedPtr)
+		vkUnmapMemory(m_device, block->m_memory);
+
+	vkFreeMemory(m_device, block->m_memory, nullptr);
+
+	m_blocks[block->m_nMemoryTypeIndex][block->m_nPoolIndex].Pop(block);
+	--m_nDeviceAllocationCount;
+
+	delete block;
+}
+
+bool MemoryAllocator::AllocateFromBlock(MemoryBlock* block, VkDeviceSize nSize, VkDeviceSize nAlignment, MemAllocation& outAllocation)
+{
+	if (nAlignment < 1)
+		nAlignment = 1;
+
+	// Find the smallest free range the allocation fits within (best-fit).
+	int nBestIndex = -1;
+	VkDeviceSize nBestWaste = ~0ull;
+	VkDeviceSize nBestOffset = 0;
+
+	for(uint32_t i = 0; i < block->m_freeRanges.Count(); ++i)
+	{
+		const MemRange& range = block->m_freeRanges[i];
+
+		VkDeviceSize nAlignedOffset = ALIGN_UP(range.m_nOffset, nAlignment);
+		VkDeviceSize nRequiredSize = (nAlignedOffset - range.m_nOffset) + nSize;
+
+		if (nRequiredSize > range.m_nSize)
+			continue;
+
+		VkDeviceSize nWaste = range.m_nSize - nRequiredSize;
+		if(nWaste < nBestWaste)
+		{
+			nBestIndex = static_cast<int>(i);
+			nBestWaste = nWaste;
+			nBestOffset = nAlignedOffset;
+
+			// Perfect fit.
+			if (nWaste == 0)
+				break;
+		}
+	}
+
+	if (nBestIndex < 0)
+		return false;
+
+	MemRange range = block->m_freeRanges[nBestIndex];
+
+	// Remove the range by replacing it with the last range.
+	block->m_freeRanges[nBestIndex] = block->m_freeRanges[block->m_freeRanges.Count() - 1];
+	block->m_freeRanges.Pop();
+
+	// Return alignment padding before the allocation and the remainder after it to the free list.
+	if (nBestOffset > range.m_nOffset)
+		block->m_freeRanges.Push({ range.m_nOffset, nBestOffset - range.m_nOffset });
+
+	VkDeviceSize nEnd = nBestOffset + nSize;
+	VkDeviceSize nRangeEnd = range.m_nOffset + range.m_nSize;
+	if (nRangeEnd > nEnd)
+		block->m_freeRanges.Push({ nEnd, nRangeEnd - nEnd });
+
+	block->m_nBytesInUse += nSize;
+	++block->m_nAllocationCount;
+
+	outAllocation.m_memory = block->m_memory;
+	outAllocation.m_nOffset = nBestOffset;
+	outAllocation.m_nSize = nSize;
+	outAllocation.m_mappedPtr = block->m_mappedPtr ? static_cast<char*>(block->m_mappedPtr) + nBestOffset : nullptr;
+	outAllocation.m_block = block;
+
+	return true;
+}
+
+VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t nMemoryTypeIndex) const
+{
+	VkDeviceSize nHeapSize = m_memProperties.memoryHeaps[m_memProperties.memoryTypes[nMemoryTypeIndex].heapIndex].size;
+
+	if (nHeapSize < MEMORY_SMALL_HEAP_SIZE)
+		return nHeapSize / MEMORY_SMALL_HEAP_BLOCK_DIVISOR;
+
+	return MEMORY_BLOCK_SIZE;
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "DynamicArray.h"
+
+/*
+Description: Block based device memory allocator. Allocates large VkDeviceMemory blocks per memory type and sub-allocates buffers & images from them.
+Author: Nic Van Zuylen
+*/
+
+// Preferred size of a single device memory block.
+#define MEMORY_BLOCK_SIZE (64ull * 1024ull * 1024ull)
+
+// Heaps smaller than this have their block size reduced to a fraction of the heap size.
+#define MEMORY_SMALL_HEAP_SIZE (1024ull * 1024ull * 1024ull)
+
+// Fraction of a small heap's size used as the block size.
+#define MEMORY_SMALL_HEAP_BLOCK_DIVISOR 8
+
+struct MemoryBlock;
+
+// Handle to a sub-allocated region of device memory.
+struct MemAllocation
+{
+	VkDeviceMemory m_memory; // Memory object of the block the allocation lives in.
+	VkDeviceSize m_nOffset; // Offset of the allocation within the block.
+	VkDeviceSize m_nSize; // Size of the allocation in bytes.
+	void* m_mappedPtr; // Persistent host pointer to the start of the allocation, nullptr if the memory is not host visible.
+	MemoryBlock* m_block; // Block the allocation belongs to.
+};
+
+struct MemAllocatorStats
+{
+	uint32_t m_nBlockCount; // Amount of VkDeviceMemory objects allocated.
+	uint32_t m_nAllocationCount; // Amount of live sub-allocations.
+	uint32_t m_nFreeRangeCount; // Amount of free ranges across all blocks.
+	VkDeviceSize m_nBytesAllocated; // Total size of all device memory blocks.
+	VkDeviceSize m_nBytesInUse; // Total size of all live sub-allocations.
+	VkDeviceSize m_nLargestFreeRange; // Size of the largest free range across all blocks.
+	float m_fFragmentation; // 1 - (sum of each block's largest free range / total free bytes), 0 means free memory within each block is contiguous.
+};
+
+// Free range within a memory block.
+struct MemRange
+{
+	VkDeviceSize m_nOffset;
+	VkDeviceSize m_nSize;
+};
+
+struct MemoryBlock
+{
+	VkDeviceMemory m_memory;
+	VkDeviceSize m_nSize;
+	VkDeviceSize m_nBytesInUse;
+	void* m_mappedPtr; // Persistent mapping of the whole block, nullptr if the memory type is not host visible.
+	uint32_t m_nMemoryTypeIndex;
+	uint32_t m_nAllocationCount;
+	uint32_t m_nPoolIndex; // Index of the resource pool (linear/optimal) this block belongs to.
+	bool m_bDedicated; // Whether or not this block was allocated for a single oversized resource.
+	DynamicArray<MemRange> m_freeRanges;
+};
+
+// Resource pool indices. Linear (buffers) & optimal (images) resources are kept in separate blocks when bufferImageGranularity requires it.
+enum EMemoryPool
+{
+	MEMORY_POOL_LINEAR,
+	MEMORY_POOL_OPTIMAL,
+	MEMORY_POOL_COUNT
+};
+
+class MemoryAllocator
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    VkDevice device: The logical device to allocate memory from.
+		VkPhysicalDevice physDevice: The physical device used to query memory types & limits.
+	*/
+	MemoryAllocator(VkDevice device, VkPhysicalDevice physDevice);
+
+	~MemoryAllocator();
+
+	/*
+	Description: Sub-allocate memory satisfying the provided requirements.
+	Param:
+	    const VkMemoryRequirements& requirements: Size, alignment and memory type bits of the resource.
+		VkMemoryPropertyFlags properties: Required memory property flags.
+		EMemoryPool ePool: Whether the resource is linear (buffer) or optimal (image).
+		MemAllocation& outAllocation: Allocation handle output.
+	*/
+	void Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EMemoryPool ePool, MemAllocation& outAllocation);
+
+	/*
+	Description: Return an allocation's memory to its block for reuse.
+	Param:
+	    MemAllocation& allocation: The allocation to free, it will be cleared.
+	*/
+	void Free(MemAllocation& allocation);
+
+	/*
+	Description: Find the index of a memory type matching the type filter and property flags.
+	Return Type: uint32_t
+	Param:
+	    uint32_t nTypeFilter: Bit mask of acceptable memory types.
+		VkMemoryPropertyFlags properties: Required memory property flags.
+	*/
+	uint32_t FindMemoryType(uint32_t nTypeFilter, VkMemoryPropertyFlags properties) const;
+
+	/*
+	Description: Get whether or not any memory type has all of the provided property flags.
+	Return Type: bool
+	Param:
+	    VkMemoryPropertyFlags properties: Required memory property flags.
+		uint32_t nTypeFilter: Bit mask of acceptable memory types.
+	*/
+	bool HasMemoryType(VkMemoryPropertyFlags properties, uint32_t nTypeFilter = ~0u) const;
+
+	/*
+	Description: Get allocation statistics over all blocks.
+	Return Type: MemAllocatorStats
+	*/
+	MemAllocatorStats GetStats() const;
+
+	/*
+	Description: Print allocation statistics to the console.
+	*/
+	void PrintStats() const;
+
+private:
+
+	// Allocate a new device memory block for the provided memory type & pool.
+	MemoryBlock* CreateBlock(uint32_t nMemoryTypeIndex, EMemoryPool ePool, VkDeviceSize nSize, bool bDedicated);
+
+	// Free a block's device memory and remove it from its pool.
+	void DestroyBlock(MemoryBlock* block);
+
+	// Attempt to sub-allocate from a block using best-fit, returns whether or not it succeeded.
+	bool AllocateFromBlock(MemoryBlock* block, VkDeviceSize nSize, VkDeviceSize nAlignment, MemAllocation& outAllocation);
+
+	// Get the block size used for a memory type.
+	VkDeviceSize GetBlockSize(uint32_t nMemoryTypeIndex) const;
+
+	VkDevice m_device;
+	VkPhysicalDeviceMemoryProperties m_memProperties;
+	VkDeviceSize m_nBufferImageGranularity;
+	uint32_t m_nMaxAllocationCount;
+
+	DynamicArray<MemoryBlock*> m_blocks[VK_MAX_MEMORY_TYPES][MEMORY_POOL_COUNT];
+	uint32_t m_nDeviceAllocationCount; // Amount of live VkDeviceMemory objects.
+};
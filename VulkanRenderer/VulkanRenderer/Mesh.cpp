@@ -2,8 +2,11 @@
 #include "VertexInfo.h"
 #include "RenderObject.h"
 #include "Renderer.h"
+#include "CPUProfiler.h"
+#include "MeshSimplifier.h"
 #include <vector>
 #include <iostream>
+#include <chrono>
 
 // Using tiny obj loader header lib for .obj file loading.
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -11,11 +14,15 @@
 
 const VertexInfo Mesh::defaultFormat = VertexInfo({ VERTEX_ATTRIB_FLOAT4, VERTEX_ATTRIB_FLOAT4, VERTEX_ATTRIB_FLOAT4, VERTEX_ATTRIB_FLOAT2 });
 
-Mesh::Mesh(Renderer* renderer, const char* filePath) 
+uint32_t Mesh::m_nNextMeshID = 0;
+
+Mesh::Mesh(Renderer* renderer, const char* filePath, bool bGenerateLODs) 
 {
 	m_renderer = renderer;
 	m_empty = true;
 	m_filePath = filePath;
+	m_uploadToken = 0;
+	m_nID = m_nNextMeshID++;
 	
 	m_vertexFormat = &defaultFormat;
 
@@ -23,23 +30,25 @@ Mesh::Mesh(Renderer* renderer, const char* filePath)
 	std::string tmpName = filePath;
 	m_name = "|" + tmpName.substr(tmpName.find_last_of('/') + 1) + "|";
 
-	Load(filePath);
+	Load(filePath, bGenerateLODs);
 
 	m_empty = false;
 }
 
-Mesh::Mesh(Renderer* renderer, const char* filePath, const VertexInfo* vertexFormat)
+Mesh::Mesh(Renderer* renderer, const char* filePath, const VertexInfo* vertexFormat, bool bGenerateLODs)
 {
 	m_renderer = renderer;
 	m_empty = true;
 	m_filePath = filePath;
+	m_uploadToken = 0;
+	m_nID = m_nNextMeshID++;
 	m_vertexFormat = vertexFormat;
 
 	// Use the filename as the name.
 	std::string tmpName = filePath;
 	m_name = "|" + tmpName.substr(tmpName.find_last_of('/') + 1) + "|";
 
-	Load(filePath);
+	Load(filePath, bGenerateLODs);
 
 	m_empty = false;
 }
@@ -48,28 +57,26 @@ Mesh::~Mesh()
 {
 	if(!m_empty) 
 	{
+		// The upload may still be pending.
+		m_renderer->GetUploadContext()->Wait(m_uploadToken);
 		m_renderer->WaitGraphicsIdle();
 
-		vkFreeMemory(m_renderer->GetDevice(), m_vertexMemory, nullptr);
-		vkFreeMemory(m_renderer->GetDevice(), m_indexMemory, nullptr);
-
-		vkDestroyBuffer(m_renderer->GetDevice(), m_vertexBuffer, nullptr);
-		vkDestroyBuffer(m_renderer->GetDevice(), m_indexBuffer, nullptr);
+		m_geometryPool->Free(m_geometry);
 	}
 }
 
-void Mesh::Load(const char* filePath) 
+void Mesh::Load(const char* filePath, bool bGenerateLODs) 
 {
+	CPU_PROFILE_ZONE("Mesh::Load");
+
 	// Delete old mesh if there is one.
 	if(!m_empty) 
 	{
+		// The upload may still be pending.
+		m_renderer->GetUploadContext()->Wait(m_uploadToken);
 		m_renderer->WaitGraphicsIdle();
 
-		vkFreeMemory(m_renderer->GetDevice(), m_vertexMemory, nullptr);
-		vkFreeMemory(m_renderer->GetDevice(), m_indexMemory, nullptr);
-
-		vkDestroyBuffer(m_renderer->GetDevice(), m_vertexBuffer, nullptr);
-		vkDestroyBuffer(m_renderer->GetDevice(), m_indexBuffer, nullptr);
+		m_geometryPool->Free(m_geometry);
 	}
 
 	m_filePath = filePath;
@@ -95,15 +102,25 @@ void Mesh::Load(const char* filePath)
 	unsigned long long vertBufSize = 0;
 	unsigned long long indexBufSize = 0;
 
+	// Levels of the indices, starting with the full detail level.
+	DynamicArray<MeshLOD> lods;
+	bool bCachedLODs = false;
+	bool bWriteCache = false;
+
 	// Read cache if one is found.
 	if(cacheInStream.good()) 
 	{
 		std::cout << "Mesh: Reading cache file at: " << cachePath << "\n";
 
-		MeshCacheData inCacheData;
+		MeshCacheData inCacheData = {};
 
 		// Read cache data...
 		cacheInStream.read((char*)&inCacheData, sizeof(MeshCacheData));
+		cacheInStream.clear(); // Caches of tiny meshes may be shorter than the header.
+
+		// Caches written before LODs have vertex data where the LOD fields are.
+		if (inCacheData.m_nVertOffset < sizeof(MeshCacheData))
+			inCacheData.m_nLODCount = 0;
 
 		// Resize vertex array.
 		wholeMeshVertices.SetSize(static_cast<int>(inCacheData.m_nVertCount));
@@ -125,9 +142,19 @@ void Mesh::Load(const char* filePath)
 		// Read index data...
 		cacheInStream.read((char*)wholeMeshIndices.Data(), inCacheData.m_nIndexCount * sizeof(unsigned int));
 
-		// Set buffer sizes.
-		vertBufSize = sizeof(ComplexVertex) * wholeMeshVertices.Count();
-		indexBufSize = sizeof(unsigned int) * wholeMeshIndices.Count();
+		// Read LOD data...
+		if(inCacheData.m_nLODCount > 0)
+		{
+			lods.SetSize(static_cast<int>(inCacheData.m_nLODCount));
+			lods.SetCount(static_cast<int>(inCacheData.m_nLODCount));
+
+			cacheInStream.seekg(inCacheData.m_nLODOffset);
+			cacheInStream.read((char*)lods.Data(), inCacheData.m_nLODCount * sizeof(MeshLOD));
+
+			bCachedLODs = true;
+		}
+		else
+			lods.Push({ 0, wholeMeshIndices.Count(), 0.0f });
 
 		// Release file handle.
 		cacheInStream.close();
@@ -135,130 +162,124 @@ void Mesh::Load(const char* filePath)
 	else // Otherwise load and convert OBJ file.
 	{
 		LoadOBJ(wholeMeshVertices, wholeMeshIndices, m_filePath);
+		lods.Push({ 0, wholeMeshIndices.Count(), 0.0f });
 
-		vertBufSize = sizeof(ComplexVertex) * wholeMeshVertices.Count();
-		indexBufSize = sizeof(unsigned int) * wholeMeshIndices.Count();
-
-		// -----------------------------------------------------------------------------------------
-		// Cache writing
-
-		std::ofstream cacheOutStream(cachePath.c_str(), std::ios::binary | std::ios::out);
+		bWriteCache = true;
+	}
 
-		MeshCacheData outCacheData;
-		outCacheData.m_nVertCount = wholeMeshVertices.Count();
-		outCacheData.m_nIndexCount = wholeMeshIndices.Count();
-		outCacheData.m_nVertOffset = sizeof(MeshCacheData);
-		outCacheData.m_nIndexOffset = outCacheData.m_nVertOffset + vertBufSize;
+	// -----------------------------------------------------------------------------------------
+	// LODs
 
-		if (cacheOutStream.good())
-		{
-			std::cout << "Mesh: Writing cache file at: " << cachePath << "\n";
+	if(bGenerateLODs && !bCachedLODs)
+	{
+		GenerateLODs(wholeMeshVertices, wholeMeshIndices, lods);
+		bWriteCache = true;
+	}
 
-			// Write cache data.
-			cacheOutStream.write((const char*)&outCacheData, sizeof(MeshCacheData));
+	// -----------------------------------------------------------------------------------------
+	// Cache writing
 
-			// Seek to vertex data start offset.
-			cacheOutStream.seekp(outCacheData.m_nVertOffset);
+	if(bWriteCache)
+		WriteCache(cachePath, wholeMeshVertices, wholeMeshIndices, lods, bGenerateLODs);
 
-			// Write vertex data...
-			cacheOutStream.write((const char*)wholeMeshVertices.Data(), vertBufSize);
+	// Only the full detail level is used without LODs, its indices come first.
+	if (!bGenerateLODs)
+		lods.SetCount(1);
 
-			// Seek to index data start offset.
-			cacheOutStream.seekp(outCacheData.m_nIndexOffset);
+	m_lods = lods;
 
-			// Write index data.
-			cacheOutStream.write((const char*)wholeMeshIndices.Data(), indexBufSize);
+	const MeshLOD& lastLOD = m_lods[m_lods.Count() - 1];
 
-			// Release file handle.
-			cacheOutStream.close();
-		}
-	}
+	vertBufSize = sizeof(ComplexVertex) * wholeMeshVertices.Count();
+	indexBufSize = sizeof(unsigned int) * (lastLOD.m_nFirstIndex + lastLOD.m_nIndexCount);
 
 	// -----------------------------------------------------------------------------------------
 	// Buffers
 
-	// Create new vertex staging buffer.
-	VkBuffer vertexStagingBuffer;
-	VkDeviceMemory vertStagingBufferMemory;
-	m_renderer->CreateBuffer(vertBufSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexStagingBuffer, vertStagingBufferMemory);
-
-	VkBuffer indexStagingBuffer;
-	VkDeviceMemory indexStagingBufMemory;
-	m_renderer->CreateBuffer(indexBufSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, indexStagingBuffer, indexStagingBufMemory);
+	// Sub-allocate vertices & indices from the pool shared by meshes of this vertex format.
+	m_geometryPool = m_renderer->GetGeometryPool(m_vertexFormat, sizeof(ComplexVertex));
+	m_geometry = m_geometryPool->Allocate(wholeMeshVertices.Count(), static_cast<uint32_t>(indexBufSize / sizeof(unsigned int)));
 
-	// Create vertex buffer.
-	m_renderer->CreateBuffer(vertBufSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_vertexBuffer, m_vertexMemory);
+	// Queue vertex & index copies on the upload context, they are submitted in a batch with other uploads.
+	UploadContext* uploadContext = m_renderer->GetUploadContext();
 
-	// Create index buffer.
-	m_renderer->CreateBuffer(indexBufSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_indexBuffer, m_indexMemory);
+	if (vertBufSize > 0)
+		uploadContext->UploadBuffer(VertexBuffer(), static_cast<VkDeviceSize>(m_geometry.m_nFirstVertex) * sizeof(ComplexVertex), wholeMeshVertices.Data(), vertBufSize, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 
-	// Copy vertices to the vertex staging buffer.
-	void* bufMemory = nullptr;
-	RENDERER_SAFECALL(vkMapMemory(m_renderer->GetDevice(), vertStagingBufferMemory, 0, vertBufSize, 0, &bufMemory), "Renderer Error: Failed to map staging buffer memory.");
+	if (indexBufSize > 0)
+		m_uploadToken = uploadContext->UploadBuffer(IndexBuffer(), static_cast<VkDeviceSize>(m_geometry.m_nFirstIndex) * sizeof(unsigned int), wholeMeshIndices.Data(), indexBufSize, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 
-	memcpy_s(bufMemory, vertBufSize, wholeMeshVertices.Data(), vertBufSize);
-
-	vkUnmapMemory(m_renderer->GetDevice(), vertStagingBufferMemory);
-
-	bufMemory = nullptr;
-
-	// Copy indices to the index staging buffer.
-	RENDERER_SAFECALL(vkMapMemory(m_renderer->GetDevice(), indexStagingBufMemory, 0, indexBufSize, 0, &bufMemory), "Renderer Error: Failed to map staging buffer memory.");
+	m_totalVertexCount = static_cast<unsigned int>(wholeMeshVertices.GetSize());
+	m_totalIndexCount = m_lods[0].m_nIndexCount;
 
-	memcpy_s(bufMemory, indexBufSize, wholeMeshIndices.Data(), indexBufSize);
+	// -----------------------------------------------------------------------------------------
+	// Bounds
 
-	vkUnmapMemory(m_renderer->GetDevice(), indexStagingBufMemory);
+	glm::vec3 v3Min(0.0f);
+	glm::vec3 v3Max(0.0f);
 
-	// Copy staging buffer contents to vertex buffer contents.
-	Renderer::TempCmdBuffer tempCopyCmdBuffer = m_renderer->CreateTempCommandBuffer();
-	RecordCopyCommandBuffer(m_renderer, tempCopyCmdBuffer.m_handle, vertexStagingBuffer, m_vertexBuffer, indexStagingBuffer, m_indexBuffer, vertBufSize, indexBufSize);
-	m_renderer->UseAndDestroyTempCommandBuffer(tempCopyCmdBuffer);
+	if(wholeMeshVertices.Count() > 0)
+	{
+		v3Min = wholeMeshVertices[0].m_position;
+		v3Max = v3Min;
 
-	// Destroy staging buffers.
-	vkFreeMemory(m_renderer->GetDevice(), vertStagingBufferMemory, nullptr);
-	vkDestroyBuffer(m_renderer->GetDevice(), vertexStagingBuffer, nullptr);
+		for (uint32_t i = 1; i < wholeMeshVertices.Count(); ++i)
+		{
+			glm::vec3 v3Position = wholeMeshVertices[i].m_position;
 
-	vkFreeMemory(m_renderer->GetDevice(), indexStagingBufMemory, nullptr);
-	vkDestroyBuffer(m_renderer->GetDevice(), indexStagingBuffer, nullptr);
+			v3Min = glm::min(v3Min, v3Position);
+			v3Max = glm::max(v3Max, v3Position);
+		}
+	}
 
-	m_totalVertexCount = static_cast<unsigned int>(wholeMeshVertices.GetSize());
-	m_totalIndexCount = static_cast<unsigned int>(wholeMeshIndices.GetSize());
+	m_bounds.m_v3Center = (v3Min + v3Max) * 0.5f;
+	m_bounds.m_v3Extents = (v3Max - v3Min) * 0.5f;
 
 	// -----------------------------------------------------------------------------------------
 }
 
 void Mesh::Bind(VkCommandBuffer& commandBuffer)
 {
-	VkBuffer vertBuffers[] = { m_vertexBuffer };
+	VkBuffer vertBuffers[] = { VertexBuffer() };
 	size_t offsets[] = { 0 };
 
 	// Bind vertex buffers.
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertBuffers, offsets);
 
 	// Bind index buffer.
-	vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(commandBuffer, IndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
 }
 
-void Mesh::Bind(VkCommandBuffer& commandBuffer, const VkBuffer& instanceBuffer) 
+void Mesh::Bind(VkCommandBuffer& commandBuffer, const VkBuffer& instanceBuffer, VkDeviceSize nInstanceOffset) 
 {
-	VkBuffer vertBuffers[] = { m_vertexBuffer, instanceBuffer };
-	size_t offsets[] = { 0, 0 };
+	VkBuffer vertBuffers[] = { VertexBuffer(), instanceBuffer };
+	VkDeviceSize offsets[] = { 0, nInstanceOffset };
 
 	// Bind vertex buffers.
 	vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertBuffers, offsets);
 
 	// Bind index buffer.
-	vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(commandBuffer, IndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
 }
 
 VkBuffer& Mesh::VertexBuffer() 
 {
-	return m_vertexBuffer;
+	return m_geometryPool->VertexBuffer(m_geometry.m_nBlock);
 }
 
 VkBuffer& Mesh::IndexBuffer() 
 {
-	return m_indexBuffer;
+	return m_geometryPool->IndexBuffer(m_geometry.m_nBlock);
+}
+
+int32_t Mesh::BaseVertex() const
+{
+	return static_cast<int32_t>(m_geometry.m_nFirstVertex);
+}
+
+uint32_t Mesh::FirstIndex() const
+{
+	return m_geometry.m_nFirstIndex;
 }
 
 unsigned int Mesh::VertexCount() 
@@ -271,45 +292,51 @@ unsigned int Mesh::IndexCount()
 	return m_totalIndexCount;
 }
 
-const std::string& Mesh::GetName() 
+uint32_t Mesh::LODCount() const
 {
-	return m_name;
+	return m_lods.Count();
 }
 
-const VertexInfo* Mesh::VertexFormat() 
+const MeshLOD& Mesh::GetLOD(uint32_t nLevel) const
 {
-	return m_vertexFormat;
+	return m_lods[nLevel];
 }
 
-void Mesh::RecordCopyCommandBuffer(Renderer* renderer, VkCommandBuffer cmdBuffer, VkBuffer vertStagingBuffer, VkBuffer vertFinalBuffer, VkBuffer indStagingBuffer, VkBuffer indFinalBuffer, unsigned long long vertCopySize, unsigned long long indCopySize)
+uint32_t Mesh::SelectLOD(float fDistance, float fScale, float fProjectionScale, float fPixelThreshold) const
 {
-	VkCommandBufferBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-	beginInfo.pInheritanceInfo = nullptr;
-	beginInfo.pNext = nullptr;
+	// The view is within the bounds, any error may cover the screen.
+	if (fDistance <= 0.0f)
+		return 0;
+
+	// Size in pixels of a mesh space unit at the instance's distance.
+	float fPixelsPerUnit = fScale * fProjectionScale / fDistance;
 
-	// Begin recording.
-	RENDERER_SAFECALL(vkBeginCommandBuffer(cmdBuffer, &beginInfo), "Mesh Error: Failed to begin recording of copy command buffer.");
+	// Errors increase with each level.
+	uint32_t nLevel = 0;
+	while (nLevel + 1 < m_lods.Count() && m_lods[nLevel + 1].m_fError * fPixelsPerUnit <= fPixelThreshold)
+		++nLevel;
 
-	VkBufferCopy vertCopyRegion = {};
-	vertCopyRegion.srcOffset = 0;
-	vertCopyRegion.dstOffset = 0;
-	vertCopyRegion.size = vertCopySize;
+	return nLevel;
+}
 
-	// Copy vertex staging buffer contents to vertex final buffer contents.
-	vkCmdCopyBuffer(cmdBuffer, vertStagingBuffer, vertFinalBuffer, 1, &vertCopyRegion);
+uint32_t Mesh::ID() const
+{
+	return m_nID;
+}
 
-	VkBufferCopy indCopyRegion = {};
-	indCopyRegion.srcOffset = 0;
-	indCopyRegion.dstOffset = 0;
-	indCopyRegion.size = indCopySize;
+const std::string& Mesh::GetName() 
+{
+	return m_name;
+}
 
-	// Copy index staging buffer contents to index final buffer contents.
-	vkCmdCopyBuffer(cmdBuffer, indStagingBuffer, indFinalBuffer, 1, &indCopyRegion);
+const VertexInfo* Mesh::VertexFormat() 
+{
+	return m_vertexFormat;
+}
 
-	// End recording.
-	RENDERER_SAFECALL(vkEndCommandBuffer(cmdBuffer), "Mesh Error: Failed to end copy command buffer recording.");
+const MeshBounds& Mesh::Bounds() const
+{
+	return m_bounds;
 }
 
 void Mesh::CalculateTangents(DynamicArray<ComplexVertex>& vertices, DynamicArray<unsigned int>& indices) 
@@ -354,6 +381,82 @@ void Mesh::CalculateTangents(DynamicArray<ComplexVertex>& vertices, DynamicArray
 	}
 }
 
+void Mesh::GenerateLODs(const DynamicArray<ComplexVertex>& vertices, DynamicArray<unsigned int>& indices, DynamicArray<MeshLOD>& lods)
+{
+	CPU_PROFILE_ZONE("Mesh::GenerateLODs");
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Each level continues simplifying the previous one, so errors are measured against the full detail level.
+	MeshSimplifier simplifier(vertices, indices);
+
+	for (uint32_t i = 1; i < MESH_MAX_LODS; ++i)
+	{
+		uint32_t nPrevIndexCount = lods[i - 1].m_nIndexCount;
+		float fError = simplifier.Simplify(static_cast<uint32_t>(nPrevIndexCount * MESH_LOD_REDUCTION));
+
+		// Borders & seams can stop simplification, a level barely coarser than the previous one is not worth its memory.
+		if (simplifier.IndexCount() > nPrevIndexCount * MESH_LOD_MIN_REDUCTION)
+			break;
+
+		lods.Push({ indices.Count(), simplifier.IndexCount(), fError });
+		simplifier.WriteIndices(indices);
+	}
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+	double dTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+
+	std::cout << "Mesh: Generated " << lods.Count() - 1 << " LODs of " << m_name << " in " << dTime << "ms\n";
+
+	for (uint32_t i = 0; i < lods.Count(); ++i)
+		std::cout << "Mesh: LOD " << i << ": " << lods[i].m_nIndexCount / 3 << " triangles, error: " << lods[i].m_fError << "\n";
+}
+
+void Mesh::WriteCache(const std::string& cachePath, const DynamicArray<ComplexVertex>& vertices, const DynamicArray<unsigned int>& indices, const DynamicArray<MeshLOD>& lods, bool bWriteLODs)
+{
+	std::ofstream cacheOutStream(cachePath.c_str(), std::ios::binary | std::ios::out);
+
+	size_t nVertBufSize = sizeof(ComplexVertex) * vertices.Count();
+	size_t nIndexBufSize = sizeof(unsigned int) * indices.Count();
+
+	MeshCacheData outCacheData;
+	outCacheData.m_nVertCount = vertices.Count();
+	outCacheData.m_nIndexCount = indices.Count();
+	outCacheData.m_nVertOffset = sizeof(MeshCacheData);
+	outCacheData.m_nIndexOffset = outCacheData.m_nVertOffset + nVertBufSize;
+	outCacheData.m_nLODCount = bWriteLODs ? lods.Count() : 0;
+	outCacheData.m_nLODOffset = outCacheData.m_nIndexOffset + nIndexBufSize;
+
+	if (cacheOutStream.good())
+	{
+		std::cout << "Mesh: Writing cache file at: " << cachePath << "\n";
+
+		// Write cache data.
+		cacheOutStream.write((const char*)&outCacheData, sizeof(MeshCacheData));
+
+		// Seek to vertex data start offset.
+		cacheOutStream.seekp(outCacheData.m_nVertOffset);
+
+		// Write vertex data...
+		cacheOutStream.write((const char*)vertices.Data(), nVertBufSize);
+
+		// Seek to index data start offset.
+		cacheOutStream.seekp(outCacheData.m_nIndexOffset);
+
+		// Write index data.
+		cacheOutStream.write((const char*)indices.Data(), nIndexBufSize);
+
+		// Seek to LOD data start offset.
+		cacheOutStream.seekp(outCacheData.m_nLODOffset);
+
+		// Write LOD data.
+		cacheOutStream.write((const char*)lods.Data(), sizeof(MeshLOD) * outCacheData.m_nLODCount);
+
+		// Release file handle.
+		cacheOutStream.close();
+	}
+}
+
 void Mesh::LoadOBJ(DynamicArray<ComplexVertex>& vertices, DynamicArray<unsigned int>& indices, const char* path) 
 {
 	std::vector<tinyobj::shape_t> shapes;
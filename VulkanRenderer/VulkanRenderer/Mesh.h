@@ -4,6 +4,7 @@
 #include "glm.hpp"
 #include "DynamicArray.h"
 #include "Renderer.h"
+#include "FrustumCuller.h"
 #include <string>
 
 //class Renderer;
@@ -23,21 +24,42 @@ struct ComplexVertex
 	glm::vec2 m_texCoords;
 };
 
+// Maximum amount of detail levels of a mesh, including the full detail level.
+#define MESH_MAX_LODS 4
+
+// Each generated LOD targets this ratio of the previous level's indices.
+#define MESH_LOD_REDUCTION 0.5f
+
+// LOD generation stops once a level keeps more than this ratio of the previous level's indices.
+#define MESH_LOD_MIN_REDUCTION 0.8f
+
+// A detail level of a mesh, indexing the shared vertex buffer.
+struct MeshLOD
+{
+	uint32_t m_nFirstIndex; // Offset of the level's indices within the index buffer.
+	uint32_t m_nIndexCount;
+	float m_fError; // Mesh space distance the level's surface may deviate from the full detail level.
+};
+
 struct MeshCacheData 
 {
 	uint64_t m_nVertCount;
-	uint64_t m_nIndexCount;
+	uint64_t m_nIndexCount; // Indices of all levels.
 	size_t m_nVertOffset;
 	size_t m_nIndexOffset;
+
+	// Caches written before LODs end at the fields above, with vertex data directly after.
+	uint64_t m_nLODCount; // Zero if LODs were not generated.
+	size_t m_nLODOffset;
 };
 
 class Mesh 
 {
 public:
 
-	Mesh(Renderer* renderer, const char* szFilePath);
+	Mesh(Renderer* renderer, const char* szFilePath, bool bGenerateLODs = false);
 
-	Mesh(Renderer* renderer, const char* szFilePath, const VertexInfo* m_format);
+	Mesh(Renderer* renderer, const char* szFilePath, const VertexInfo* m_format, bool bGenerateLODs = false);
 
 	~Mesh();
 
@@ -45,37 +67,50 @@ public:
 	Description: Load the mesh from a file, and any included materials.
 	Param:
 	    const char* szFilePath: The path to the .obj mesh file.
-		unsigned int textureFlags: The texturemaps to load from the obj's materials, by default all maps are loaded.
+		bool bGenerateLODs: Whether or not to use a LOD chain, generated by simplification & stored in the mesh cache if the cache has none.
 	*/
-	void Load(const char* szFilePath);
+	void Load(const char* szFilePath, bool bGenerateLODs = false);
 
 	/*
-	Description: Bind the VAO of this mesh for use in drawing without instancing.
+	Description: Bind the vertex & index buffers of this mesh's geometry pool block for use in drawing without instancing. Draws must offset by BaseVertex() & FirstIndex().
 	Param:
 	    VkCommandBuffer& commandBuffer: The command buffer to bind this mesh to.
 	*/
 	void Bind(VkCommandBuffer& commandBuffer);
 
 	/*
-	Description: Bind the VAO of this mesh for use in drawing with instancing.
+	Description: Bind the vertex & index buffers of this mesh's geometry pool block for use in drawing with instancing. Draws must offset by BaseVertex() & FirstIndex().
 	Param:
 		VkCommandBuffer& commandBuffer: The command buffer to bind this mesh to.
 		VkBuffer& instanceBuffer: The instance buffer to bind alongside the vertex buffer.
+		VkDeviceSize nInstanceOffset: Offset in bytes of the first instance within the instance buffer.
 	*/
-	void Bind(VkCommandBuffer& commandBuffer, const VkBuffer& instanceBuffer);
+	void Bind(VkCommandBuffer& commandBuffer, const VkBuffer& instanceBuffer, VkDeviceSize nInstanceOffset = 0);
 
 	/*
-	Description: Returns the vertex buffer handle of this mesh.
+	Description: Returns the vertex buffer handle of this mesh, shared with other meshes in the same geometry pool block.
 	Return Type: VkBuffer
 	*/
 	VkBuffer& VertexBuffer();
 
 	/*
-	Description: Returns the index buffer handle of this mesh.
+	Description: Returns the index buffer handle of this mesh, shared with other meshes in the same geometry pool block.
 	Return Type: VkBuffer
 	*/
 	VkBuffer& IndexBuffer();
 
+	/*
+	Description: Get the first vertex of this mesh within its vertex buffer, the vertex offset of its draws. Indices are relative to it.
+	Return Type: int32_t
+	*/
+	int32_t BaseVertex() const;
+
+	/*
+	Description: Get the first index of this mesh within its index buffer, LOD first indices are relative to it.
+	Return Type: uint32_t
+	*/
+	uint32_t FirstIndex() const;
+
 	/*
 	Description: Get the amount of vertices in the entire mesh.
 	Return Type: unsigned int
@@ -83,11 +118,42 @@ public:
 	unsigned int VertexCount();
 
 	/*
-	Description: Get the amount of indices in the entire mesh.
+	Description: Get the amount of indices of the full detail level, which starts at the first index.
 	Return Type: unsigned int
 	*/
 	unsigned int IndexCount();
 
+	/*
+	Description: Get the amount of detail levels of this mesh, including the full detail level.
+	Return Type: uint32_t
+	*/
+	uint32_t LODCount() const;
+
+	/*
+	Description: Get a detail level of this mesh, level zero is the full detail mesh & following levels are coarser.
+	Return Type: const MeshLOD&
+	Param:
+	    uint32_t nLevel: Index of the level.
+	*/
+	const MeshLOD& GetLOD(uint32_t nLevel) const;
+
+	/*
+	Description: Select the coarsest detail level whose error, projected to the screen, is within a threshold.
+	Return Type: uint32_t
+	Param:
+	    float fDistance: Distance from the view to the nearest point of the instance's bounds, the full detail level is used at or below zero.
+		float fScale: Largest scale of the instance's model matrix.
+		float fProjectionScale: Pixels per world space unit at a distance of one, the viewport height divided by twice the tangent of half the vertical field of view.
+		float fPixelThreshold: Largest acceptable error in pixels.
+	*/
+	uint32_t SelectLOD(float fDistance, float fScale, float fProjectionScale, float fPixelThreshold) const;
+
+	/*
+	Description: Get the unique ID of this mesh, used to sort draws by mesh.
+	Return Type: uint32_t
+	*/
+	uint32_t ID() const;
+
 	/*
 	Description: Get the name of this mesh, which should be the name of the file.
 	Return Type: std::string&
@@ -100,15 +166,16 @@ public:
 	*/
 	const VertexInfo* VertexFormat();
 
+	/*
+	Description: Get the mesh space bounding box of this mesh, enclosing all vertices.
+	Return Type: const MeshBounds&
+	*/
+	const MeshBounds& Bounds() const;
+
 	const static VertexInfo defaultFormat;
 
 private:
 
-	/*
-	Description: Record the copy command buffer to copy this mesh's staging buffer memory to it's vertex and index buffers.
-	*/
-	static void RecordCopyCommandBuffer(Renderer* renderer, VkCommandBuffer cmdBuffer, VkBuffer vertStagingBuffer, VkBuffer vertFinalBuffer, VkBuffer indStagingBuffer, VkBuffer indFinalBuffer, unsigned long long vertCopySize, unsigned long long indCopySize);
-
 	/*
 	Description: Calculate mesh tangents.
 	*/
@@ -123,17 +190,39 @@ private:
 	*/
 	void LoadOBJ(DynamicArray<ComplexVertex>& vertices, DynamicArray<unsigned int>& indices, const char* path);
 
-	// Vulkan handles
+	/*
+	Description: Simplify the full detail level into a chain of coarser levels, appending their indices.
+	Param:
+	    const DynamicArray<ComplexVertex>& vertices: The vertices of the mesh.
+		DynamicArray<unsigned int>& indices: The indices of the full detail level, followed by the indices of the generated levels.
+		DynamicArray<MeshLOD>& lods: The full detail level, followed by the generated levels.
+	*/
+	void GenerateLODs(const DynamicArray<ComplexVertex>& vertices, DynamicArray<unsigned int>& indices, DynamicArray<MeshLOD>& lods);
 
-	VkBuffer m_vertexBuffer;
-	VkDeviceMemory m_vertexMemory;
+	/*
+	Description: Write vertices, indices & LODs to a mesh cache file.
+	Param:
+	    const std::string& cachePath: The path of the cache file.
+		const DynamicArray<ComplexVertex>& vertices: The vertices of the mesh.
+		const DynamicArray<unsigned int>& indices: The indices of all levels.
+		const DynamicArray<MeshLOD>& lods: The levels of the indices.
+		bool bWriteLODs: Whether or not LODs were generated, if not they are generated & written by the next load requesting them.
+	*/
+	void WriteCache(const std::string& cachePath, const DynamicArray<ComplexVertex>& vertices, const DynamicArray<unsigned int>& indices, const DynamicArray<MeshLOD>& lods, bool bWriteLODs);
 
-	VkBuffer m_indexBuffer;
-	VkDeviceMemory m_indexMemory;
+	// Geometry
+
+	GeometryPool* m_geometryPool;
+	GeometryAllocation m_geometry; // Range of the pool holding this mesh's vertices & indices.
+
+	UploadToken m_uploadToken; // Completion token of the vertex & index buffer upload.
 
 	// Misc data
 	Renderer* m_renderer;
 
+	static uint32_t m_nNextMeshID;
+	uint32_t m_nID;
+
 	const char* m_filePath;
 	std::string m_name;
 
@@ -142,6 +231,10 @@ private:
 	unsigned int m_totalVertexCount;
 	unsigned int m_totalIndexCount;
 
+	DynamicArray<MeshLOD> m_lods;
+
+	MeshBounds m_bounds;
+
 	bool m_empty;
 };
 
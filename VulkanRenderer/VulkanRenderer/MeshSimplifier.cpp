@@ -0,0 +1,333 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+MeshSimplifier::MeshSimplifier(const DynamicArray<ComplexVertex>& vertices, const DynamicArray<unsigned int>& indices)
+{
+	m_vertices = vertices.Data();
+	m_fError = 0.0f;
+
+	uint32_t nVertexCount = vertices.Count();
+	uint32_t nIndexCount = indices.Count() - (indices.Count() % 3);
+
+	m_indices.assign(indices.Data(), indices.Data() + nIndexCount);
+	m_nTriangleCount = nIndexCount / 3;
+	m_deadTriangles.assign(m_nTriangleCount, false);
+
+	m_quadrics.assign(nVertexCount, {});
+	m_locked.assign(nVertexCount, false);
+	m_collapsed.assign(nVertexCount, false);
+	m_versions.assign(nVertexCount, 0);
+	m_vertexTriangles.resize(nVertexCount);
+
+	// -----------------------------------------------------------------------------------------
+	// Position welding
+
+	// Vertices sharing a position are split by an attribute seam, they are locked & share one representative for edge connectivity.
+	std::vector<uint32_t> sortedVertices(nVertexCount);
+	for (uint32_t i = 0; i < nVertexCount; ++i)
+		sortedVertices[i] = i;
+
+	auto positionLess = [&](uint32_t a, uint32_t b)
+	{
+		const glm::vec4& pa = m_vertices[a].m_position;
+		const glm::vec4& pb = m_vertices[b].m_position;
+
+		if (pa.x != pb.x)
+			return pa.x < pb.x;
+		if (pa.y != pb.y)
+			return pa.y < pb.y;
+
+		return pa.z < pb.z;
+	};
+
+	std::sort(sortedVertices.begin(), sortedVertices.end(), positionLess);
+
+	std::vector<uint32_t> representatives(nVertexCount);
+	for (uint32_t i = 0; i < nVertexCount;)
+	{
+		uint32_t nEnd = i + 1;
+		while (nEnd < nVertexCount && !positionLess(sortedVertices[i], sortedVertices[nEnd]))
+			++nEnd;
+
+		for (uint32_t j = i; j < nEnd; ++j)
+		{
+			representatives[sortedVertices[j]] = sortedVertices[i];
+			m_locked[sortedVertices[j]] = nEnd - i > 1;
+		}
+
+		i = nEnd;
+	}
+
+	// -----------------------------------------------------------------------------------------
+	// Borders
+
+	// An edge is on a border when no triangle uses it in the opposite direction, moving its vertices would shrink the hole or outline.
+	std::vector<uint64_t> edges(nIndexCount);
+	for (uint32_t i = 0; i < nIndexCount; ++i)
+	{
+		uint64_t nA = representatives[m_indices[i]];
+		uint64_t nB = representatives[m_indices[i - (i % 3) + ((i + 1) % 3)]];
+
+		edges[i] = (nA << 32) | nB;
+	}
+
+	std::vector<uint64_t> sortedEdges = edges;
+	std::sort(sortedEdges.begin(), sortedEdges.end());
+
+	for (uint32_t i = 0; i < nIndexCount; ++i)
+	{
+		uint64_t nReverse = (edges[i] << 32) | (edges[i] >> 32);
+
+		if (!std::binary_search(sortedEdges.begin(), sortedEdges.end(), nReverse))
+		{
+			m_locked[m_indices[i]] = true;
+			m_locked[m_indices[i - (i % 3) + ((i + 1) % 3)]] = true;
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------
+	// Quadrics
+
+	for (uint32_t t = 0; t < m_nTriangleCount; ++t)
+	{
+		const uint32_t* tri = &m_indices[t * 3];
+
+		glm::vec3 p0 = m_vertices[tri[0]].m_position;
+		glm::vec3 p1 = m_vertices[tri[1]].m_position;
+		glm::vec3 p2 = m_vertices[tri[2]].m_position;
+
+		glm::vec3 v3Normal = glm::cross(p1 - p0, p2 - p0);
+		float fDoubleArea = glm::length(v3Normal);
+
+		for (uint32_t i = 0; i < 3; ++i)
+			m_vertexTriangles[tri[i]].push_back(t);
+
+		if (fDoubleArea <= 0.0f)
+			continue;
+
+		v3Normal /= fDoubleArea;
+
+		double a = v3Normal.x, b = v3Normal.y, c = v3Normal.z, d = -glm::dot(v3Normal, p0);
+		double w = fDoubleArea * 0.5;
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			Quadric& q = m_quadrics[tri[i]];
+
+			q.m_a2 += w * a * a; q.m_ab += w * a * b; q.m_ac += w * a * c; q.m_ad += w * a * d;
+			q.m_b2 += w * b * b; q.m_bc += w * b * c; q.m_bd += w * b * d;
+			q.m_c2 += w * c * c; q.m_cd += w * c * d;
+			q.m_d2 += w * d * d;
+			q.m_weight += w;
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------
+	// Initial collapses
+
+	for (uint32_t i = 0; i < nVertexCount; ++i)
+		PushCollapse(i);
+}
+
+float MeshSimplifier::Simplify(uint32_t nTargetIndexCount)
+{
+	while (m_nTriangleCount * 3 > nTargetIndexCount && !m_collapses.empty())
+	{
+		Collapse collapse = m_collapses.top();
+		m_collapses.pop();
+
+		uint32_t nU = collapse.m_nU;
+		uint32_t nV = collapse.m_nV;
+
+		// Superseded by a newer collapse of u.
+		if (m_collapsed[nU] || collapse.m_nVersion != m_versions[nU])
+			continue;
+
+		// u is tried again once its neighbourhood changes.
+		if (FlipsTriangles(nU, nV))
+			continue;
+
+		// Move u's triangles onto v, removing those which shared the edge.
+		for (uint32_t t : m_vertexTriangles[nU])
+		{
+			if (m_deadTriangles[t])
+				continue;
+
+			uint32_t* tri = &m_indices[t * 3];
+
+			if (tri[0] == nV || tri[1] == nV || tri[2] == nV)
+			{
+				m_deadTriangles[t] = true;
+				--m_nTriangleCount;
+
+				continue;
+			}
+
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				if (tri[i] == nU)
+					tri[i] = nV;
+			}
+
+			m_vertexTriangles[nV].push_back(t);
+		}
+
+		m_vertexTriangles[nU].clear();
+		m_collapsed[nU] = true;
+
+		Quadric& qU = m_quadrics[nU];
+		Quadric& qV = m_quadrics[nV];
+
+		qV.m_a2 += qU.m_a2; qV.m_ab += qU.m_ab; qV.m_ac += qU.m_ac; qV.m_ad += qU.m_ad;
+		qV.m_b2 += qU.m_b2; qV.m_bc += qU.m_bc; qV.m_bd += qU.m_bd;
+		qV.m_c2 += qU.m_c2; qV.m_cd += qU.m_cd;
+		qV.m_d2 += qU.m_d2;
+		qV.m_weight += qU.m_weight;
+
+		// Drop dead triangles from v's list, so it doesn't grow with every collapse.
+		std::vector<uint32_t>& vTriangles = m_vertexTriangles[nV];
+		vTriangles.erase(std::remove_if(vTriangles.begin(), vTriangles.end(), [&](uint32_t t) { return m_deadTriangles[t]; }), vTriangles.end());
+
+		m_fError = std::max(m_fError, collapse.m_fCost);
+
+		// v's quadric & triangles changed, which changes the collapses of v & of every vertex around it.
+		PushCollapse(nV);
+
+		for (uint32_t t : vTriangles)
+		{
+			const uint32_t* tri = &m_indices[t * 3];
+
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				if (tri[i] != nV)
+					PushCollapse(tri[i]);
+			}
+		}
+	}
+
+	return m_fError;
+}
+
+void MeshSimplifier::WriteIndices(DynamicArray<unsigned int>& outIndices) const
+{
+	// Grow the array once, rather than per index.
+	uint32_t nNewCount = outIndices.Count() + IndexCount();
+	if (outIndices.GetSize() < nNewCount)
+		outIndices.SetSize(nNewCount);
+
+	for (uint32_t t = 0; t < m_deadTriangles.size(); ++t)
+	{
+		if (m_deadTriangles[t])
+			continue;
+
+		for (uint32_t i = 0; i < 3; ++i)
+			outIndices.Push(m_indices[t * 3 + i]);
+	}
+}
+
+uint32_t MeshSimplifier::IndexCount() const
+{
+	return m_nTriangleCount * 3;
+}
+
+float MeshSimplifier::Error() const
+{
+	return m_fError;
+}
+
+inline float MeshSimplifier::CollapseCost(uint32_t nU, uint32_t nV) const
+{
+	const Quadric& qU = m_quadrics[nU];
+	const Quadric& qV = m_quadrics[nV];
+	const glm::vec4& p = m_vertices[nV].m_position;
+
+	double x = p.x, y = p.y, z = p.z;
+
+	double a2 = qU.m_a2 + qV.m_a2, ab = qU.m_ab + qV.m_ab, ac = qU.m_ac + qV.m_ac, ad = qU.m_ad + qV.m_ad;
+	double b2 = qU.m_b2 + qV.m_b2, bc = qU.m_bc + qV.m_bc, bd = qU.m_bd + qV.m_bd;
+	double c2 = qU.m_c2 + qV.m_c2, cd = qU.m_cd + qV.m_cd;
+	double d2 = qU.m_d2 + qV.m_d2;
+	double weight = qU.m_weight + qV.m_weight;
+
+	double error = a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z) + 2.0 * (ad * x + bd * y + cd * z) + d2;
+
+	if (weight <= 0.0)
+		return 0.0f;
+
+	return static_cast<float>(std::sqrt(std::max(error / weight, 0.0)));
+}
+
+inline void MeshSimplifier::PushCollapse(uint32_t nVertex)
+{
+	if (m_locked[nVertex])
+		return;
+
+	Collapse collapse = { FLT_MAX, nVertex, nVertex, ++m_versions[nVertex] };
+
+	for (uint32_t t : m_vertexTriangles[nVertex])
+	{
+		if (m_deadTriangles[t])
+			continue;
+
+		const uint32_t* tri = &m_indices[t * 3];
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			if (tri[i] == nVertex)
+				continue;
+
+			float fCost = CollapseCost(nVertex, tri[i]);
+
+			if (fCost < collapse.m_fCost)
+			{
+				collapse.m_fCost = fCost;
+				collapse.m_nV = tri[i];
+			}
+		}
+	}
+
+	if (collapse.m_nV != nVertex)
+		m_collapses.push(collapse);
+}
+
+inline bool MeshSimplifier::FlipsTriangles(uint32_t nU, uint32_t nV) const
+{
+	glm::vec3 v3Target = m_vertices[nV].m_position;
+
+	for (uint32_t t : m_vertexTriangles[nU])
+	{
+		if (m_deadTriangles[t])
+			continue;
+
+		const uint32_t* tri = &m_indices[t * 3];
+
+		// Triangles sharing the edge are removed by the collapse.
+		if (tri[0] == nV || tri[1] == nV || tri[2] == nV)
+			continue;
+
+		glm::vec3 p[3];
+		glm::vec3 moved[3];
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			p[i] = m_vertices[tri[i]].m_position;
+			moved[i] = tri[i] == nU ? v3Target : p[i];
+		}
+
+		glm::vec3 v3Before = glm::cross(p[1] - p[0], p[2] - p[0]);
+		glm::vec3 v3After = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+		// Already degenerate, there is no orientation to keep.
+		if (glm::dot(v3Before, v3Before) <= 0.0f)
+			continue;
+
+		// Reject normals turning by more than about 80 degrees, which also rejects triangles collapsing to slivers.
+		if (glm::dot(v3Before, v3After) <= 0.17f * glm::length(v3Before) * glm::length(v3After))
+			return true;
+	}
+
+	return false;
+}
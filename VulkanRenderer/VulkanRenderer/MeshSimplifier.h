@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <functional>
+#include <cstdint>
+#include "Mesh.h"
+
+/*
+Description: Quadric error simplification of an indexed triangle mesh, used to generate mesh LOD chains. Edges are collapsed onto one of their existing vertices,
+             so every level indexes the vertices of the full detail mesh & shares its vertex buffer. Borders & vertices split by attribute seams are never moved.
+             Simplification is progressive, each call continues collapsing from the result of the previous one.
+Author: Nic Van Zuylen
+*/
+
+class MeshSimplifier
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    const DynamicArray<ComplexVertex>& vertices: Vertices of the mesh, which must outlive the simplifier.
+		const DynamicArray<unsigned int>& indices: Triangle list indices of the mesh.
+	*/
+	MeshSimplifier(const DynamicArray<ComplexVertex>& vertices, const DynamicArray<unsigned int>& indices);
+
+	/*
+	Description: Collapse edges in order of increasing error, until no more than the target amount of indices remain or no collapse is valid.
+	Return Type: float
+	Param:
+	    uint32_t nTargetIndexCount: Amount of indices to reduce the mesh to.
+	*/
+	float Simplify(uint32_t nTargetIndexCount);
+
+	/*
+	Description: Append the indices of the remaining triangles.
+	Param:
+	    DynamicArray<unsigned int>& outIndices: The array to append to.
+	*/
+	void WriteIndices(DynamicArray<unsigned int>& outIndices) const;
+
+	/*
+	Description: Get the amount of indices of the remaining triangles.
+	Return Type: uint32_t
+	*/
+	uint32_t IndexCount() const;
+
+	/*
+	Description: Get the largest error of the collapses so far, the root mean square distance in mesh space of a moved vertex to the planes of the triangles merged into it.
+	Return Type: float
+	*/
+	float Error() const;
+
+private:
+
+	// Symmetric 4x4 matrix summing squared distances to planes, weighted by triangle area.
+	struct Quadric
+	{
+		double m_a2, m_ab, m_ac, m_ad;
+		double m_b2, m_bc, m_bd;
+		double m_c2, m_cd;
+		double m_d2;
+		double m_weight;
+	};
+
+	// The cheapest collapse of vertex u, onto vertex v. Valid while the version of u is unchanged, it is re-pushed whenever u's neighbourhood changes.
+	struct Collapse
+	{
+		float m_fCost;
+		uint32_t m_nU;
+		uint32_t m_nV;
+		uint32_t m_nVersion;
+
+		bool operator>(const Collapse& other) const { return m_fCost > other.m_fCost; }
+	};
+
+	// Sum of two quadrics, evaluated at the position of v & divided by the total weight.
+	inline float CollapseCost(uint32_t nU, uint32_t nV) const;
+
+	// Push the cheapest collapse of an unlocked vertex onto one of its neighbours, replacing its previous one.
+	inline void PushCollapse(uint32_t nVertex);
+
+	// Whether moving u onto v would flip or fold any of u's remaining triangles.
+	inline bool FlipsTriangles(uint32_t nU, uint32_t nV) const;
+
+	const ComplexVertex* m_vertices;
+
+	std::vector<uint32_t> m_indices; // Triangle list, triangles removed by collapses are marked dead.
+	std::vector<bool> m_deadTriangles;
+	uint32_t m_nTriangleCount;
+
+	std::vector<Quadric> m_quadrics;
+	std::vector<bool> m_locked;
+	std::vector<bool> m_collapsed;
+	std::vector<uint32_t> m_versions;
+	std::vector<std::vector<uint32_t>> m_vertexTriangles; // Triangles referencing each vertex, including dead ones.
+
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_collapses;
+
+	float m_fError;
+};
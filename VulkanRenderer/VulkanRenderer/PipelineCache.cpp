@@ -0,0 +1,164 @@
+#include "PipelineCache.h"
+#include "RendererHelper.h"
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+PipelineCache::PipelineCache(VkDevice device, VkPhysicalDevice physDevice, const char* szFilePath)
+{
+	m_device = device;
+	m_szFilePath = szFilePath;
+	m_handle = VK_NULL_HANDLE;
+
+	vkGetPhysicalDeviceProperties(physDevice, &m_deviceProperties);
+
+	ResetStats();
+
+	char* initialData = nullptr;
+	size_t nInitialSize = 0;
+
+	m_bWarm = Load(initialData, nInitialSize);
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = nInitialSize;
+	createInfo.pInitialData = initialData;
+
+	RENDERER_SAFECALL(vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_handle), "Pipeline Cache Error: Failed to create pipeline cache.");
+
+	delete[] initialData;
+
+	if (m_bWarm)
+		std::cout << "Pipeline Cache: Loaded " << nInitialSize << " bytes from: " << m_szFilePath << "\n";
+	else
+		std::cout << "Pipeline Cache: No valid cache found at: " << m_szFilePath << ", pipelines will be compiled from scratch.\n";
+}
+
+PipelineCache::~PipelineCache()
+{
+	Save();
+
+	vkDestroyPipelineCache(m_device, m_handle, nullptr);
+}
+
+void PipelineCache::CreateGraphicsPipelines(const VkGraphicsPipelineCreateInfo* createInfos, uint32_t nCount, VkPipeline* outPipelines)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	RENDERER_SAFECALL(vkCreateGraphicsPipelines(m_device, m_handle, nCount, createInfos, nullptr, outPipelines), "Pipeline Cache Error: Failed to create graphics pipelines.");
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	m_dCreationTime += std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+	m_nPipelineCount += nCount;
+	++m_nBatchCount;
+}
+
+void PipelineCache::CreateComputePipelines(const VkComputePipelineCreateInfo* createInfos, uint32_t nCount, VkPipeline* outPipelines)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	RENDERER_SAFECALL(vkCreateComputePipelines(m_device, m_handle, nCount, createInfos, nullptr, outPipelines), "Pipeline Cache Error: Failed to create compute pipelines.");
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	m_dCreationTime += std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+	m_nPipelineCount += nCount;
+	++m_nBatchCount;
+}
+
+void PipelineCache::Save()
+{
+	size_t nDataSize = 0;
+	RENDERER_SAFECALL(vkGetPipelineCacheData(m_device, m_handle, &nDataSize, nullptr), "Pipeline Cache Error: Failed to get pipeline cache data size.");
+
+	if (nDataSize == 0)
+		return;
+
+	char* data = new char[nDataSize];
+	RENDERER_SAFECALL(vkGetPipelineCacheData(m_device, m_handle, &nDataSize, data), "Pipeline Cache Error: Failed to get pipeline cache data.");
+
+	PipelineCacheFileHeader header = {};
+	header.m_nMagic = PIPELINE_CACHE_FILE_MAGIC;
+	header.m_nVendorID = m_deviceProperties.vendorID;
+	header.m_nDeviceID = m_deviceProperties.deviceID;
+	header.m_nDriverVersion = m_deviceProperties.driverVersion;
+	std::memcpy(header.m_pipelineCacheUUID, m_deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.m_nDataSize = nDataSize;
+
+	std::ofstream outStream(m_szFilePath, std::ios::binary | std::ios::out);
+
+	if(outStream.good())
+	{
+		outStream.write((const char*)&header, sizeof(PipelineCacheFileHeader));
+		outStream.write(data, nDataSize);
+		outStream.close();
+
+		std::cout << "Pipeline Cache: Wrote " << nDataSize << " bytes to: " << m_szFilePath << "\n";
+	}
+	else
+		std::cout << "Pipeline Cache Warning: Failed to open: " << m_szFilePath << " for writing.\n";
+
+	delete[] data;
+}
+
+VkPipelineCache PipelineCache::Handle() const
+{
+	return m_handle;
+}
+
+bool PipelineCache::IsWarm() const
+{
+	return m_bWarm;
+}
+
+void PipelineCache::ResetStats()
+{
+	m_nPipelineCount = 0;
+	m_nBatchCount = 0;
+	m_dCreationTime = 0.0;
+}
+
+void PipelineCache::PrintStats(const char* szEvent) const
+{
+	std::cout << "Pipeline Cache: " << szEvent << " created " << m_nPipelineCount << " pipelines in " << m_nBatchCount << " calls, taking " << m_dCreationTime << "ms (" << (m_bWarm ? "warm" : "cold") << " cache)\n";
+}
+
+inline bool PipelineCache::Load(char*& outData, size_t& nOutSize)
+{
+	std::ifstream inStream(m_szFilePath, std::ios::binary | std::ios::in);
+
+	if (!inStream.good())
+		return false;
+
+	PipelineCacheFileHeader header = {};
+	inStream.read((char*)&header, sizeof(PipelineCacheFileHeader));
+
+	// Reject caches written by a different device or driver, the driver may also reject them but is not required to handle garbage safely.
+	bool bValid = inStream.good() && header.m_nMagic == PIPELINE_CACHE_FILE_MAGIC
+		&& header.m_nVendorID == m_deviceProperties.vendorID
+		&& header.m_nDeviceID == m_deviceProperties.deviceID
+		&& header.m_nDriverVersion == m_deviceProperties.driverVersion
+		&& std::memcmp(header.m_pipelineCacheUUID, m_deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0
+		&& header.m_nDataSize > 0;
+
+	if(!bValid)
+	{
+		std::cout << "Pipeline Cache: Cache file: " << m_szFilePath << " does not match this device or driver, discarding.\n";
+		return false;
+	}
+
+	outData = new char[header.m_nDataSize];
+	inStream.read(outData, header.m_nDataSize);
+
+	if(!inStream.good())
+	{
+		delete[] outData;
+		outData = nullptr;
+		return false;
+	}
+
+	nOutSize = static_cast<size_t>(header.m_nDataSize);
+	return true;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+/*
+Description: Renderer-wide VkPipelineCache, persisted to disk between runs and shared by all render modules.
+Author: Nic Van Zuylen
+*/
+
+// File the pipeline cache is stored in, relative to the working directory.
+#define PIPELINE_CACHE_FILE_PATH "pipeline.pcache"
+
+// Identifies pipeline cache files written by this renderer.
+#define PIPELINE_CACHE_FILE_MAGIC 0x48435050 // "PPCH"
+
+// Header written ahead of the driver's cache data, used to reject caches from other devices or drivers.
+struct PipelineCacheFileHeader
+{
+	uint32_t m_nMagic;
+	uint32_t m_nVendorID;
+	uint32_t m_nDeviceID;
+	uint32_t m_nDriverVersion;
+	uint8_t m_pipelineCacheUUID[VK_UUID_SIZE];
+	uint64_t m_nDataSize;
+};
+
+class PipelineCache
+{
+public:
+
+	/*
+	Constructor: Create the pipeline cache, with the initial data loaded from disk if a valid cache file exists.
+	Param:
+	    VkDevice device: The logical device pipelines will be created with.
+		VkPhysicalDevice physDevice: The physical device the cache must match.
+		const char* szFilePath: The file the cache is loaded from and saved to.
+	*/
+	PipelineCache(VkDevice device, VkPhysicalDevice physDevice, const char* szFilePath = PIPELINE_CACHE_FILE_PATH);
+
+	// Saves the cache to disk before destroying it.
+	~PipelineCache();
+
+	/*
+	Description: Create graphics pipelines using the cache, pipelines created together should be passed in a single call.
+	Param:
+	    const VkGraphicsPipelineCreateInfo* createInfos: Array of pipeline create infos.
+		uint32_t nCount: Amount of pipelines to create.
+		VkPipeline* outPipelines: Array of output pipeline handles.
+	*/
+	void CreateGraphicsPipelines(const VkGraphicsPipelineCreateInfo* createInfos, uint32_t nCount, VkPipeline* outPipelines);
+
+	/*
+	Description: Create compute pipelines using the cache, pipelines created together should be passed in a single call.
+	Param:
+	    const VkComputePipelineCreateInfo* createInfos: Array of pipeline create infos.
+		uint32_t nCount: Amount of pipelines to create.
+		VkPipeline* outPipelines: Array of output pipeline handles.
+	*/
+	void CreateComputePipelines(const VkComputePipelineCreateInfo* createInfos, uint32_t nCount, VkPipeline* outPipelines);
+
+	/*
+	Description: Write the cache contents to disk.
+	*/
+	void Save();
+
+	/*
+	Description: Get the Vulkan pipeline cache handle.
+	Return Type: VkPipelineCache
+	*/
+	VkPipelineCache Handle() const;
+
+	/*
+	Description: Get whether or not the initial cache data was loaded from disk.
+	Return Type: bool
+	*/
+	bool IsWarm() const;
+
+	/*
+	Description: Reset the pipeline creation counters, used to measure a specific event. (e.g. startup or resize)
+	*/
+	void ResetStats();
+
+	/*
+	Description: Print the amount of pipelines and time spent creating them since the last ResetStats() call.
+	Param:
+	    const char* szEvent: Name of the event measured.
+	*/
+	void PrintStats(const char* szEvent) const;
+
+private:
+
+	// Load & validate cache data from disk, returns whether or not valid data was found.
+	inline bool Load(char*& outData, size_t& nOutSize);
+
+	VkDevice m_device;
+	VkPhysicalDeviceProperties m_deviceProperties;
+	VkPipelineCache m_handle;
+	const char* m_szFilePath;
+	bool m_bWarm;
+
+	uint32_t m_nPipelineCount;
+	uint32_t m_nBatchCount;
+	double m_dCreationTime; // Milliseconds.
+};
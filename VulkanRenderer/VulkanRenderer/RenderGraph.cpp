@@ -0,0 +1,1021 @@
+#include "RenderGraph.h"
+#include "Renderer.h"
+#include "RenderModule.h"
+#include "RendererHelper.h"
+#include <algorithm>
+#include <iostream>
+
+RenderGraph::RenderGraph(Renderer* renderer)
+{
+	m_renderer = renderer;
+	m_nWidth = 0;
+	m_nHeight = 0;
+	m_nRenderWidth = ~0u;
+	m_nRenderHeight = ~0u;
+	m_bCompiled = false;
+
+	m_externalOutput = RENDER_GRAPH_INVALID_INDEX;
+	m_externalFinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	m_nExternalWidth = 0;
+	m_nExternalHeight = 0;
+}
+
+RenderGraph::~RenderGraph()
+{
+	DestroyFramebuffers();
+
+	for (uint32_t i = 0; i < m_renderPasses.size(); ++i)
+	{
+		vkDestroyRenderPass(m_renderer->GetDevice(), m_renderPasses[i].m_handle, nullptr);
+
+		if (m_renderPasses[i].m_externalHandle)
+			vkDestroyRenderPass(m_renderer->GetDevice(), m_renderPasses[i].m_externalHandle, nullptr);
+	}
+
+	DestroyTextures();
+}
+
+RenderGraphResource RenderGraph::AddAttachment(const char* szName, EAttachmentType type, VkFormat format, VkClearValue clearValue)
+{
+	RENDERER_SAFECALL(m_bCompiled, "Render Graph Error: Attachments cannot be added after the graph is compiled.");
+
+	Resource resource = {};
+	resource.m_name = szName;
+	resource.m_type = type;
+	resource.m_format = format;
+	resource.m_clearValue = clearValue;
+	resource.m_importedTexture = nullptr;
+	resource.m_finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	resource.m_bOutput = false;
+	resource.m_bClear = true;
+	resource.m_nPhysicalIndex = RENDER_GRAPH_INVALID_INDEX;
+
+	m_resources.push_back(resource);
+
+	return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::ImportAttachment(const char* szName, Texture* texture, VkImageLayout finalLayout, bool bOutput, bool bClear, VkClearValue clearValue)
+{
+	RENDERER_SAFECALL(m_bCompiled, "Render Graph Error: Attachments cannot be imported after the graph is compiled.");
+
+	Resource resource = {};
+	resource.m_name = szName;
+	resource.m_type = texture->GetAttachmentType();
+	resource.m_format = texture->Format();
+	resource.m_clearValue = clearValue;
+	resource.m_importedTexture = texture;
+	resource.m_finalLayout = finalLayout;
+	resource.m_bOutput = bOutput;
+	resource.m_bClear = bClear;
+	resource.m_nPhysicalIndex = RENDER_GRAPH_INVALID_INDEX;
+
+	m_resources.push_back(resource);
+
+	return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+void RenderGraph::SetImportedTexture(RenderGraphResource resource, Texture* texture)
+{
+	Resource& res = m_resources[resource];
+	res.m_importedTexture = texture;
+
+	if (res.m_nPhysicalIndex != RENDER_GRAPH_INVALID_INDEX)
+		m_physicalAttachments[res.m_nPhysicalIndex].m_texture = texture;
+}
+
+RenderGraphPass RenderGraph::AddPass(const char* szName)
+{
+	RENDERER_SAFECALL(m_bCompiled, "Render Graph Error: Passes cannot be added after the graph is compiled.");
+
+	Pass pass = {};
+	pass.m_name = szName;
+	pass.m_module = nullptr;
+	pass.m_bCompute = false;
+	pass.m_bCulled = true;
+	pass.m_nRenderPassIndex = RENDER_GRAPH_INVALID_INDEX;
+	pass.m_nSubpassIndex = RENDER_GRAPH_INVALID_INDEX;
+
+	m_passes.push_back(pass);
+
+	return static_cast<RenderGraphPass>(m_passes.size() - 1);
+}
+
+RenderGraphPass RenderGraph::AddComputePass(const char* szName)
+{
+	RenderGraphPass pass = AddPass(szName);
+	m_passes[pass].m_bCompute = true;
+
+	return pass;
+}
+
+void RenderGraph::AddAccess(RenderGraphPass pass, RenderGraphResource resource, ERenderGraphAccess access)
+{
+	RENDERER_SAFECALL(m_bCompiled, "Render Graph Error: Pass accesses cannot be added after the graph is compiled.");
+	RENDERER_SAFECALL(m_passes[pass].m_bCompute && access != RENDER_GRAPH_READ_SAMPLED, "Render Graph Error: Compute passes may only sample attachments.");
+
+	m_passes[pass].m_accesses.push_back({ resource, access });
+}
+
+void RenderGraph::SetPassModule(RenderGraphPass pass, RenderModule* module)
+{
+	m_passes[pass].m_module = module;
+}
+
+void RenderGraph::SetPassCompute(RenderGraphPass pass, const std::function<void(VkCommandBuffer, const uint32_t&)>& recordFunc)
+{
+	RENDERER_SAFECALL(!m_passes[pass].m_bCompute, "Render Graph Error: Only compute passes can record through a function.");
+
+	m_passes[pass].m_recordFunc = recordFunc;
+}
+
+void RenderGraph::AllowExternalOutput(RenderGraphResource resource, VkImageLayout finalLayout)
+{
+	RENDERER_SAFECALL(m_bCompiled, "Render Graph Error: External output cannot be allowed after the graph is compiled.");
+	RENDERER_SAFECALL(!m_resources[resource].m_importedTexture || !m_resources[resource].m_bOutput, "Render Graph Error: External output must replace an imported output attachment.");
+
+	m_externalOutput = resource;
+	m_externalFinalLayout = finalLayout;
+}
+
+void RenderGraph::SetExternalOutputImages(const VkImageView* views, uint32_t nCount, uint32_t nWidth, uint32_t nHeight)
+{
+	m_externalViews.assign(views, views + nCount);
+	m_nExternalWidth = nWidth;
+	m_nExternalHeight = nHeight;
+}
+
+void RenderGraph::Compile(uint32_t nWidth, uint32_t nHeight)
+{
+	m_nWidth = nWidth;
+	m_nHeight = nHeight;
+
+	CullPasses();
+	GroupPasses();
+
+	// The variant render pass leaves the external image in its final layout, so the output can't be loaded by a later render pass.
+	if(m_externalOutput != RENDER_GRAPH_INVALID_INDEX)
+	{
+		const Resource& output = m_resources[m_externalOutput];
+		RENDERER_SAFECALL(output.m_nFirstRenderPass != output.m_nLastRenderPass, "Render Graph Error: External output must be written within a single render pass.");
+	}
+
+	AllocateAttachments();
+	CreateTextures();
+
+	for (uint32_t i = 0; i < m_physicalAttachments.size(); ++i)
+		m_physicalAttachments[i].m_currentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	// Render passes are created in execution order, as the layouts attachments are left in carry over to the next.
+	for (uint32_t i = 0; i < m_renderPasses.size(); ++i)
+		CreateRenderPass(i);
+
+	CreateFramebuffers();
+
+	m_bCompiled = true;
+}
+
+void RenderGraph::Resize(uint32_t nWidth, uint32_t nHeight)
+{
+	m_nWidth = nWidth;
+	m_nHeight = nHeight;
+
+	// Attachment formats & usage don't change, so the render passes remain compatible with the new images.
+	DestroyFramebuffers();
+	DestroyTextures();
+	CreateTextures();
+	CreateFramebuffers();
+}
+
+void RenderGraph::SetRenderArea(uint32_t nWidth, uint32_t nHeight)
+{
+	m_nRenderWidth = nWidth;
+	m_nRenderHeight = nHeight;
+}
+
+void RenderGraph::Execute(VkCommandBuffer cmdBuf, const uint32_t& nPresentImageIndex, const uint32_t& nFrameIndex, VkCommandBuffer transferCmdBuf, bool bExternalOutput)
+{
+	for (uint32_t i = 0; i < m_renderPasses.size(); ++i)
+	{
+		RenderPassData& renderPass = m_renderPasses[i];
+
+		RecordComputePasses(cmdBuf, renderPass.m_computePasses, nFrameIndex);
+
+		VkRenderPass handle = renderPass.m_handle;
+		VkFramebuffer framebuffer = renderPass.m_framebuffer;
+		uint32_t nWidth = renderPass.m_nWidth;
+		uint32_t nHeight = renderPass.m_nHeight;
+
+		// The variant is compatible with the original render pass, so modules' pipelines & inheritance info remain valid.
+		if (bExternalOutput && renderPass.m_externalHandle)
+		{
+			handle = renderPass.m_externalHandle;
+			framebuffer = renderPass.m_externalFramebuffers[nPresentImageIndex];
+			nWidth = renderPass.m_nExternalWidth;
+			nHeight = renderPass.m_nExternalHeight;
+		}
+
+		if(renderPass.m_bScaled)
+		{
+			nWidth = std::min(nWidth, m_nRenderWidth);
+			nHeight = std::min(nHeight, m_nRenderHeight);
+		}
+
+		VkRenderPassBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		beginInfo.clearValueCount = static_cast<uint32_t>(renderPass.m_clearValues.size());
+		beginInfo.pClearValues = renderPass.m_clearValues.data();
+		beginInfo.framebuffer = framebuffer;
+		beginInfo.renderArea = { { 0, 0 }, { nWidth, nHeight } };
+		beginInfo.renderPass = handle;
+		beginInfo.pNext = nullptr;
+
+		vkCmdBeginRenderPass(cmdBuf, &beginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		for (uint32_t j = 0; j < renderPass.m_passes.size(); ++j)
+		{
+			if (j > 0)
+				vkCmdNextSubpass(cmdBuf, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+			RenderModule* module = m_passes[renderPass.m_passes[j]].m_module;
+
+			if (!module)
+				continue;
+
+			// Modules may record across worker threads, their command buffers are executed in order.
+			module->RecordCommandBuffer(nPresentImageIndex, nFrameIndex, framebuffer, transferCmdBuf);
+			vkCmdExecuteCommands(cmdBuf, module->GetCommandBufferCount(nFrameIndex), module->GetCommandBuffer(nFrameIndex));
+		}
+
+		vkCmdEndRenderPass(cmdBuf);
+	}
+
+	RecordComputePasses(cmdBuf, m_trailingComputePasses, nFrameIndex);
+}
+
+void RenderGraph::PrintSummary() const
+{
+	for (uint32_t i = 0; i < m_passes.size(); ++i)
+	{
+		const Pass& pass = m_passes[i];
+
+		if (pass.m_bCulled)
+			std::cout << "Render Graph: Pass \"" << pass.m_name << "\" culled, its results are never consumed.\n";
+		else if (pass.m_bCompute)
+			std::cout << "Render Graph: Compute pass \"" << pass.m_name << "\" -> before render pass " << pass.m_nRenderPassIndex << "\n";
+		else
+			std::cout << "Render Graph: Pass \"" << pass.m_name << "\" -> render pass " << pass.m_nRenderPassIndex << ", subpass " << pass.m_nSubpassIndex << "\n";
+	}
+
+	uint32_t nTransientCount = 0;
+	uint32_t nTransientImageCount = 0;
+	uint32_t nPassLocalCount = 0;
+	VkDeviceSize nRequestedSize = 0; // Memory needed without aliasing.
+	VkDeviceSize nAllocatedSize = 0;
+	VkDeviceSize nLazySize = 0;
+	VkDeviceSize nDiscardedSize = 0; // Attachment memory which is not written back at the end of a render pass.
+
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+	{
+		const Resource& res = m_resources[i];
+
+		if (res.m_importedTexture || res.m_nPhysicalIndex == RENDER_GRAPH_INVALID_INDEX)
+			continue;
+
+		VkDeviceSize nSize = m_physicalAttachments[res.m_nPhysicalIndex].m_texture->GetMemorySize();
+
+		++nTransientCount;
+		nRequestedSize += nSize;
+
+		if(res.m_usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+		{
+			++nPassLocalCount;
+			nDiscardedSize += nSize;
+		}
+	}
+
+	for (uint32_t i = 0; i < m_physicalAttachments.size(); ++i)
+	{
+		const PhysicalAttachment& physical = m_physicalAttachments[i];
+
+		if (physical.m_bImported)
+			continue;
+
+		++nTransientImageCount;
+		nAllocatedSize += physical.m_texture->GetMemorySize();
+
+		if (physical.m_texture->IsLazilyAllocated())
+			nLazySize += physical.m_texture->GetMemorySize();
+	}
+
+	std::cout << "Render Graph: " << m_renderPasses.size() << " render passes, " << nTransientCount << " transient attachments on " << nTransientImageCount << " images.\n";
+	VkDeviceSize nPixelCount = static_cast<VkDeviceSize>(m_nWidth) * m_nHeight;
+
+	std::cout << "Render Graph: " << (nRequestedSize / 1024) << "KB of attachments (" << (nPixelCount > 0 ? nRequestedSize / nPixelCount : 0) << " bytes per pixel) on " << (nAllocatedSize / 1024) << "KB of images, " << ((nRequestedSize - nAllocatedSize) / 1024) << "KB saved by aliasing.\n";
+	std::cout << "Render Graph: " << nPassLocalCount << " attachments never leave their render pass, " << (nDiscardedSize / 1024) << "KB of stores discarded per frame, "
+		<< (nLazySize / 1024) << "KB lazily allocated" << (nPassLocalCount > 0 && nLazySize == 0 ? " (not supported by this device).\n" : ".\n");
+}
+
+VkRenderPass RenderGraph::GetRenderPass(RenderGraphPass pass) const
+{
+	const Pass& passData = m_passes[pass];
+
+	if (passData.m_bCulled || passData.m_bCompute)
+		return VK_NULL_HANDLE;
+
+	return m_renderPasses[passData.m_nRenderPassIndex].m_handle;
+}
+
+uint32_t RenderGraph::GetSubpassIndex(RenderGraphPass pass) const
+{
+	return m_passes[pass].m_nSubpassIndex;
+}
+
+bool RenderGraph::IsPassCulled(RenderGraphPass pass) const
+{
+	return m_passes[pass].m_bCulled;
+}
+
+bool RenderGraph::HasExternalOutput() const
+{
+	if (m_externalOutput == RENDER_GRAPH_INVALID_INDEX || m_externalViews.empty())
+		return false;
+
+	return m_resources[m_externalOutput].m_nFirstRenderPass != RENDER_GRAPH_INVALID_INDEX;
+}
+
+Texture* RenderGraph::GetTexture(RenderGraphResource resource) const
+{
+	const Resource& res = m_resources[resource];
+
+	if (res.m_importedTexture)
+		return res.m_importedTexture;
+
+	if (res.m_nPhysicalIndex == RENDER_GRAPH_INVALID_INDEX)
+		return nullptr;
+
+	return m_physicalAttachments[res.m_nPhysicalIndex].m_texture;
+}
+
+inline void RenderGraph::CullPasses()
+{
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+		m_resources[i].m_bConsumed = false;
+
+	// Walk backwards, so an attachment is known to be consumed before the pass writing it is reached.
+	for (int32_t i = static_cast<int32_t>(m_passes.size()) - 1; i >= 0; --i)
+	{
+		Pass& pass = m_passes[i];
+
+		// Compute passes may write resources outside of the graph, so they are always kept.
+		pass.m_bCulled = !pass.m_bCompute;
+
+		for (uint32_t j = 0; j < pass.m_accesses.size(); ++j)
+		{
+			const Access& access = pass.m_accesses[j];
+			const Resource& res = m_resources[access.m_resource];
+
+			bool bWrite = access.m_access == RENDER_GRAPH_WRITE_COLOR || access.m_access == RENDER_GRAPH_WRITE_DEPTH;
+
+			if (bWrite && (res.m_bOutput || res.m_bConsumed))
+				pass.m_bCulled = false;
+		}
+
+		if (pass.m_bCulled)
+			continue;
+
+		// Attachments this pass reads are now needed by earlier passes.
+		for (uint32_t j = 0; j < pass.m_accesses.size(); ++j)
+		{
+			const Access& access = pass.m_accesses[j];
+
+			if (access.m_access == RENDER_GRAPH_READ_INPUT || access.m_access == RENDER_GRAPH_READ_SAMPLED)
+				m_resources[access.m_resource].m_bConsumed = true;
+		}
+	}
+}
+
+inline void RenderGraph::GroupPasses()
+{
+	m_renderPasses.clear();
+
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+	{
+		Resource& res = m_resources[i];
+		res.m_nFirstRenderPass = RENDER_GRAPH_INVALID_INDEX;
+		res.m_nLastRenderPass = RENDER_GRAPH_INVALID_INDEX;
+		res.m_bSampledLater = false;
+		res.m_usage = res.m_type == ATTACHMENT_DEPTH_STENCIL ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	}
+
+	// Sampling can read any pixel, so a pass writing a sampled attachment ends its render pass. Input attachment reads can stay in the same render pass.
+	bool bEndRenderPass = false;
+
+	// Compute passes waiting for the next render pass.
+	std::vector<RenderGraphPass> pendingComputePasses;
+
+	for (uint32_t i = 0; i < m_passes.size(); ++i)
+	{
+		Pass& pass = m_passes[i];
+
+		if (pass.m_bCulled)
+			continue;
+
+		if (pass.m_bCompute)
+		{
+			// Recorded before the next render pass, which can't continue the current one.
+			uint32_t nNextIndex = static_cast<uint32_t>(m_renderPasses.size());
+
+			pass.m_nRenderPassIndex = nNextIndex;
+			pendingComputePasses.push_back(i);
+			bEndRenderPass = true;
+
+			// Sampled attachments are stored by their writer & kept alive until the compute pass has read them.
+			for (uint32_t j = 0; j < pass.m_accesses.size(); ++j)
+			{
+				Resource& res = m_resources[pass.m_accesses[j].m_resource];
+
+				if (res.m_nFirstRenderPass == RENDER_GRAPH_INVALID_INDEX)
+					res.m_nFirstRenderPass = nNextIndex;
+
+				res.m_nLastRenderPass = nNextIndex;
+				res.m_usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+				res.m_bSampledLater = true;
+			}
+
+			continue;
+		}
+
+		if (m_renderPasses.empty() || bEndRenderPass)
+		{
+			RenderPassData renderPass = {};
+			renderPass.m_handle = VK_NULL_HANDLE;
+			renderPass.m_framebuffer = VK_NULL_HANDLE;
+			renderPass.m_bScaled = false;
+			renderPass.m_externalHandle = VK_NULL_HANDLE;
+			renderPass.m_computePasses = pendingComputePasses;
+
+			m_renderPasses.push_back(renderPass);
+			pendingComputePasses.clear();
+			bEndRenderPass = false;
+		}
+
+		uint32_t nCurrentIndex = static_cast<uint32_t>(m_renderPasses.size()) - 1;
+		RenderPassData& renderPass = m_renderPasses[nCurrentIndex];
+
+		pass.m_nRenderPassIndex = nCurrentIndex;
+		pass.m_nSubpassIndex = static_cast<uint32_t>(renderPass.m_passes.size());
+		renderPass.m_passes.push_back(i);
+
+		// Extend attachment lifetimes & gather their usage.
+		for (uint32_t j = 0; j < pass.m_accesses.size(); ++j)
+		{
+			const Access& access = pass.m_accesses[j];
+			Resource& res = m_resources[access.m_resource];
+
+			if (res.m_nFirstRenderPass == RENDER_GRAPH_INVALID_INDEX)
+				res.m_nFirstRenderPass = nCurrentIndex;
+
+			// Transient attachments are sized with the graph, so render passes using them are limited to the render area.
+			if (!res.m_importedTexture)
+				renderPass.m_bScaled = true;
+
+			res.m_nLastRenderPass = nCurrentIndex;
+
+			switch (access.m_access)
+			{
+			case RENDER_GRAPH_READ_INPUT:
+				res.m_usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+				break;
+
+			case RENDER_GRAPH_READ_SAMPLED:
+				res.m_usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+				res.m_bSampledLater = true;
+				break;
+
+			default:
+				break;
+			}
+
+			bool bWrite = access.m_access == RENDER_GRAPH_WRITE_COLOR || access.m_access == RENDER_GRAPH_WRITE_DEPTH;
+
+			if (bWrite && IsSampledAfter(access.m_resource, i))
+				bEndRenderPass = true;
+		}
+	}
+
+	m_trailingComputePasses = pendingComputePasses;
+
+	// Attachments used within a single render pass are never loaded or stored, so their images can live in tile memory only.
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+	{
+		Resource& res = m_resources[i];
+
+		if (!res.m_importedTexture && res.m_nFirstRenderPass != RENDER_GRAPH_INVALID_INDEX && res.m_nFirstRenderPass == res.m_nLastRenderPass)
+			res.m_usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+	}
+}
+
+inline bool RenderGraph::IsSampledAfter(RenderGraphResource resource, RenderGraphPass pass) const
+{
+	for (uint32_t i = pass + 1; i < m_passes.size(); ++i)
+	{
+		if (m_passes[i].m_bCulled)
+			continue;
+
+		for (uint32_t j = 0; j < m_passes[i].m_accesses.size(); ++j)
+		{
+			const Access& access = m_passes[i].m_accesses[j];
+
+			if (access.m_resource == resource && access.m_access == RENDER_GRAPH_READ_SAMPLED)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+inline void RenderGraph::AllocateAttachments()
+{
+	m_physicalAttachments.clear();
+
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+	{
+		Resource& res = m_resources[i];
+		res.m_nPhysicalIndex = RENDER_GRAPH_INVALID_INDEX;
+
+		// Unused by any pass which was not culled.
+		if (res.m_nFirstRenderPass == RENDER_GRAPH_INVALID_INDEX)
+			continue;
+
+		if (!res.m_importedTexture)
+		{
+			// Reuse an image whose attachments are all done with before this one is first written. Its contents are not loaded, so they don't need to be preserved.
+			for (uint32_t j = 0; j < m_physicalAttachments.size(); ++j)
+			{
+				PhysicalAttachment& physical = m_physicalAttachments[j];
+
+				if (!physical.m_bImported && physical.m_type == res.m_type && physical.m_format == res.m_format && physical.m_usage == res.m_usage && physical.m_nLastRenderPass < res.m_nFirstRenderPass)
+				{
+					physical.m_nLastRenderPass = res.m_nLastRenderPass;
+
+					res.m_nPhysicalIndex = j;
+					break;
+				}
+			}
+
+			if (res.m_nPhysicalIndex != RENDER_GRAPH_INVALID_INDEX)
+				continue;
+		}
+
+		PhysicalAttachment physical = {};
+		physical.m_texture = res.m_importedTexture;
+		physical.m_bImported = res.m_importedTexture != nullptr;
+		physical.m_type = res.m_type;
+		physical.m_format = res.m_format;
+		physical.m_usage = res.m_usage;
+		physical.m_nLastRenderPass = res.m_nLastRenderPass;
+		physical.m_currentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		m_physicalAttachments.push_back(physical);
+		res.m_nPhysicalIndex = static_cast<uint32_t>(m_physicalAttachments.size()) - 1;
+	}
+}
+
+inline void RenderGraph::CreateRenderPass(uint32_t nIndex)
+{
+	RenderPassData& renderPass = m_renderPasses[nIndex];
+
+	// ---------------------------------------------------------------------------------
+	// Attachment slots
+
+	renderPass.m_attachments.clear();
+
+	for (uint32_t i = 0; i < renderPass.m_passes.size(); ++i)
+	{
+		const Pass& pass = m_passes[renderPass.m_passes[i]];
+
+		for (uint32_t j = 0; j < pass.m_accesses.size(); ++j)
+		{
+			// Sampled attachments are not bound to the render pass.
+			if (pass.m_accesses[j].m_access == RENDER_GRAPH_READ_SAMPLED)
+				continue;
+
+			uint32_t nPhysicalIndex = m_resources[pass.m_accesses[j].m_resource].m_nPhysicalIndex;
+
+			if (std::find(renderPass.m_attachments.begin(), renderPass.m_attachments.end(), nPhysicalIndex) == renderPass.m_attachments.end())
+				renderPass.m_attachments.push_back(nPhysicalIndex);
+		}
+	}
+
+	const uint32_t nSubpassCount = static_cast<uint32_t>(renderPass.m_passes.size());
+	const uint32_t nSlotCount = static_cast<uint32_t>(renderPass.m_attachments.size());
+
+	// ---------------------------------------------------------------------------------
+	// References & per subpass usage
+
+	std::vector<std::vector<VkAttachmentReference>> colorRefs(nSubpassCount);
+	std::vector<std::vector<VkAttachmentReference>> inputRefs(nSubpassCount);
+	std::vector<std::vector<uint32_t>> preserveRefs(nSubpassCount);
+	std::vector<VkAttachmentReference> depthRefs(nSubpassCount, { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED });
+
+	std::vector<VkPipelineStageFlags> useStages(nSubpassCount * nSlotCount, 0);
+	std::vector<VkAccessFlags> useAccess(nSubpassCount * nSlotCount, 0);
+	std::vector<VkPipelineStageFlags> sampledStages(nSubpassCount, 0);
+
+	std::vector<uint32_t> firstUses(nSlotCount, RENDER_GRAPH_INVALID_INDEX);
+	std::vector<uint32_t> lastUses(nSlotCount, RENDER_GRAPH_INVALID_INDEX);
+	std::vector<Access> firstAccesses(nSlotCount);
+	std::vector<Access> lastAccesses(nSlotCount);
+
+	for (uint32_t i = 0; i < nSubpassCount; ++i)
+	{
+		const Pass& pass = m_passes[renderPass.m_passes[i]];
+
+		for (uint32_t j = 0; j < pass.m_accesses.size(); ++j)
+		{
+			const Access& access = pass.m_accesses[j];
+
+			VkPipelineStageFlags stages = 0;
+			VkAccessFlags accessMask = 0;
+			GetAccessMasks(access.m_access, stages, accessMask);
+
+			if (access.m_access == RENDER_GRAPH_READ_SAMPLED)
+			{
+				sampledStages[i] |= stages;
+				continue;
+			}
+
+			uint32_t nPhysicalIndex = m_resources[access.m_resource].m_nPhysicalIndex;
+			uint32_t nSlot = static_cast<uint32_t>(std::find(renderPass.m_attachments.begin(), renderPass.m_attachments.end(), nPhysicalIndex) - renderPass.m_attachments.begin());
+
+			useStages[i * nSlotCount + nSlot] |= stages;
+			useAccess[i * nSlotCount + nSlot] |= accessMask;
+
+			if (firstUses[nSlot] == RENDER_GRAPH_INVALID_INDEX)
+			{
+				firstUses[nSlot] = i;
+				firstAccesses[nSlot] = access;
+			}
+
+			lastUses[nSlot] = i;
+			lastAccesses[nSlot] = access;
+
+			switch (access.m_access)
+			{
+			case RENDER_GRAPH_WRITE_COLOR:
+				colorRefs[i].push_back({ nSlot, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+				break;
+
+			case RENDER_GRAPH_WRITE_DEPTH:
+				depthRefs[i] = { nSlot, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+				break;
+
+			case RENDER_GRAPH_READ_INPUT:
+				inputRefs[i].push_back({ nSlot, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Descriptions
+
+	std::vector<VkAttachmentDescription> descriptions(nSlotCount);
+	renderPass.m_clearValues.resize(nSlotCount);
+
+	for (uint32_t i = 0; i < nSlotCount; ++i)
+	{
+		PhysicalAttachment& physical = m_physicalAttachments[renderPass.m_attachments[i]];
+		const Resource& first = m_resources[firstAccesses[i].m_resource];
+		const Resource& last = m_resources[lastAccesses[i].m_resource];
+
+		bool bFirstWrite = firstAccesses[i].m_access == RENDER_GRAPH_WRITE_COLOR || firstAccesses[i].m_access == RENDER_GRAPH_WRITE_DEPTH;
+		VkImageLayout attachmentLayout = physical.m_type == ATTACHMENT_DEPTH_STENCIL ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentDescription& desc = descriptions[i];
+		desc.flags = 0;
+		desc.format = physical.m_format;
+		desc.samples = VK_SAMPLE_COUNT_1_BIT;
+
+		// Load contents written by an earlier render pass, otherwise clear or discard them.
+		if (!bFirstWrite || first.m_nFirstRenderPass < nIndex)
+			desc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		else
+			desc.loadOp = first.m_bClear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+
+		// Only store contents used after this render pass, transient attachments consumed within it never leave tile memory.
+		bool bStore = last.m_importedTexture || last.m_nLastRenderPass > nIndex;
+		desc.storeOp = bStore ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		bool bHasStencil = physical.m_format == VK_FORMAT_D16_UNORM_S8_UINT || physical.m_format == VK_FORMAT_D24_UNORM_S8_UINT || physical.m_format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+		desc.stencilLoadOp = bHasStencil ? desc.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		desc.stencilStoreOp = bHasStencil ? desc.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		desc.initialLayout = desc.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? physical.m_currentLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (last.m_nLastRenderPass > nIndex)
+			desc.finalLayout = last.m_bSampledLater ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : attachmentLayout;
+		else if (last.m_importedTexture)
+			desc.finalLayout = last.m_finalLayout;
+		else
+			desc.finalLayout = attachmentLayout;
+
+		physical.m_currentLayout = desc.finalLayout;
+
+		renderPass.m_clearValues[i] = first.m_clearValue;
+	}
+
+	// Attachments untouched by a subpass must be preserved through it if they are used afterwards.
+	for (uint32_t i = 0; i < nSubpassCount; ++i)
+	{
+		for (uint32_t j = 0; j < nSlotCount; ++j)
+		{
+			bool bUsed = useStages[i * nSlotCount + j] != 0;
+			bool bNeededAfter = lastUses[j] > i || descriptions[j].storeOp == VK_ATTACHMENT_STORE_OP_STORE;
+
+			if (!bUsed && firstUses[j] < i && bNeededAfter)
+				preserveRefs[i].push_back(j);
+		}
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Subpasses
+
+	std::vector<VkSubpassDescription> subpasses(nSubpassCount);
+
+	for (uint32_t i = 0; i < nSubpassCount; ++i)
+	{
+		VkSubpassDescription& subpass = subpasses[i];
+		subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs[i].size());
+		subpass.pColorAttachments = colorRefs[i].data();
+		subpass.inputAttachmentCount = static_cast<uint32_t>(inputRefs[i].size());
+		subpass.pInputAttachments = inputRefs[i].data();
+		subpass.preserveAttachmentCount = static_cast<uint32_t>(preserveRefs[i].size());
+		subpass.pPreserveAttachments = preserveRefs[i].data();
+		subpass.pDepthStencilAttachment = depthRefs[i].attachment != VK_ATTACHMENT_UNUSED ? &depthRefs[i] : nullptr;
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Dependencies
+
+	std::vector<VkSubpassDependency> dependencies;
+
+	const VkPipelineStageFlags attachmentWriteStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	const VkAccessFlags attachmentWriteAccess = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	for (uint32_t i = 0; i < nSubpassCount; ++i)
+	{
+		for (uint32_t j = 0; j < nSlotCount; ++j)
+		{
+			VkPipelineStageFlags stages = useStages[i * nSlotCount + j];
+			VkAccessFlags accessMask = useAccess[i * nSlotCount + j];
+
+			if (!stages)
+				continue;
+
+			if (firstUses[j] == i)
+			{
+				// Wait on previous writes & reads of the image, e.g. the previous frame, the previous attachment sharing the image or a compute pass sampling it.
+				AddDependency(dependencies, VK_SUBPASS_EXTERNAL, i, attachmentWriteStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, stages, attachmentWriteAccess, accessMask);
+			}
+			else
+			{
+				// Wait on the closest earlier subpass using the attachment.
+				uint32_t nPrevious = i - 1;
+				while (!useStages[nPrevious * nSlotCount + j])
+					--nPrevious;
+
+				AddDependency(dependencies, nPrevious, i, useStages[nPrevious * nSlotCount + j], stages, useAccess[nPrevious * nSlotCount + j], accessMask);
+			}
+
+			// Make stored results visible to later render passes, compute passes & transfers.
+			if (lastUses[j] == i && descriptions[j].storeOp == VK_ATTACHMENT_STORE_OP_STORE)
+			{
+				VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT
+					| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+				VkAccessFlags dstAccess = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+					| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+				AddDependency(dependencies, i, VK_SUBPASS_EXTERNAL, stages, dstStages, accessMask, dstAccess);
+			}
+		}
+
+		// Sampled attachments were written by an earlier render pass.
+		if (sampledStages[i])
+			AddDependency(dependencies, VK_SUBPASS_EXTERNAL, i, attachmentWriteStages, sampledStages[i], attachmentWriteAccess, VK_ACCESS_SHADER_READ_BIT);
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Create Render Pass
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = nSlotCount;
+	renderPassInfo.pAttachments = descriptions.data();
+	renderPassInfo.subpassCount = nSubpassCount;
+	renderPassInfo.pSubpasses = subpasses.data();
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies = dependencies.data();
+
+	RENDERER_SAFECALL(vkCreateRenderPass(m_renderer->GetDevice(), &renderPassInfo, nullptr, &renderPass.m_handle), "Render Graph Error: Failed to create render pass.");
+
+	// ---------------------------------------------------------------------------------
+	// External output variant
+
+	if (m_externalOutput == RENDER_GRAPH_INVALID_INDEX || m_resources[m_externalOutput].m_nFirstRenderPass != nIndex)
+		return;
+
+	uint32_t nOutputSlot = static_cast<uint32_t>(std::find(renderPass.m_attachments.begin(), renderPass.m_attachments.end(), m_resources[m_externalOutput].m_nPhysicalIndex) - renderPass.m_attachments.begin());
+
+	// Only layouts differ, which doesn't affect render pass compatibility.
+	descriptions[nOutputSlot].finalLayout = m_externalFinalLayout;
+
+	RENDERER_SAFECALL(vkCreateRenderPass(m_renderer->GetDevice(), &renderPassInfo, nullptr, &renderPass.m_externalHandle), "Render Graph Error: Failed to create external output render pass.");
+}
+
+inline void RenderGraph::CreateTextures()
+{
+	for (uint32_t i = 0; i < m_physicalAttachments.size(); ++i)
+	{
+		PhysicalAttachment& physical = m_physicalAttachments[i];
+
+		if (physical.m_bImported)
+			continue;
+
+		uint32_t properties = (physical.m_usage & VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT) ? TEXTURE_PROPERTIES_INPUT_ATTACHMENT : TEXTURE_PROPERTIES_NONE;
+
+		if (physical.m_usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+			properties |= TEXTURE_PROPERTIES_TRANSIENT;
+
+		physical.m_texture = new Texture(m_renderer, m_nWidth, m_nHeight, physical.m_type, physical.m_format, properties, physical.m_usage);
+	}
+}
+
+inline void RenderGraph::CreateFramebuffers()
+{
+	for (uint32_t i = 0; i < m_renderPasses.size(); ++i)
+	{
+		RenderPassData& renderPass = m_renderPasses[i];
+
+		std::vector<VkImageView> views(renderPass.m_attachments.size());
+
+		// Render to the largest area all attachments cover, imported attachments may differ in size.
+		renderPass.m_nWidth = ~0u;
+		renderPass.m_nHeight = ~0u;
+
+		for (uint32_t j = 0; j < renderPass.m_attachments.size(); ++j)
+		{
+			Texture* texture = m_physicalAttachments[renderPass.m_attachments[j]].m_texture;
+
+			views[j] = texture->ImageView();
+			renderPass.m_nWidth = std::min(renderPass.m_nWidth, static_cast<uint32_t>(texture->GetWidth()));
+			renderPass.m_nHeight = std::min(renderPass.m_nHeight, static_cast<uint32_t>(texture->GetHeight()));
+		}
+
+		VkFramebufferCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		createInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		createInfo.pAttachments = views.data();
+		createInfo.renderPass = renderPass.m_handle;
+		createInfo.layers = 1;
+		createInfo.width = renderPass.m_nWidth;
+		createInfo.height = renderPass.m_nHeight;
+		createInfo.flags = 0;
+		createInfo.pNext = nullptr;
+
+		RENDERER_SAFECALL(vkCreateFramebuffer(m_renderer->GetDevice(), &createInfo, nullptr, &renderPass.m_framebuffer), "Render Graph Error: Failed to create framebuffer.");
+
+		if (!renderPass.m_externalHandle || m_externalViews.empty())
+			continue;
+
+		// One framebuffer per external image, with the output attachment's view replaced.
+		uint32_t nOutputSlot = static_cast<uint32_t>(std::find(renderPass.m_attachments.begin(), renderPass.m_attachments.end(), m_resources[m_externalOutput].m_nPhysicalIndex) - renderPass.m_attachments.begin());
+
+		renderPass.m_nExternalWidth = m_nExternalWidth;
+		renderPass.m_nExternalHeight = m_nExternalHeight;
+
+		for (uint32_t j = 0; j < renderPass.m_attachments.size(); ++j)
+		{
+			if (j == nOutputSlot)
+				continue;
+
+			Texture* texture = m_physicalAttachments[renderPass.m_attachments[j]].m_texture;
+
+			renderPass.m_nExternalWidth = std::min(renderPass.m_nExternalWidth, static_cast<uint32_t>(texture->GetWidth()));
+			renderPass.m_nExternalHeight = std::min(renderPass.m_nExternalHeight, static_cast<uint32_t>(texture->GetHeight()));
+		}
+
+		createInfo.renderPass = renderPass.m_externalHandle;
+		createInfo.width = renderPass.m_nExternalWidth;
+		createInfo.height = renderPass.m_nExternalHeight;
+
+		renderPass.m_externalFramebuffers.resize(m_externalViews.size());
+
+		for (uint32_t j = 0; j < m_externalViews.size(); ++j)
+		{
+			views[nOutputSlot] = m_externalViews[j];
+
+			RENDERER_SAFECALL(vkCreateFramebuffer(m_renderer->GetDevice(), &createInfo, nullptr, &renderPass.m_externalFramebuffers[j]), "Render Graph Error: Failed to create external output framebuffer.");
+		}
+	}
+}
+
+inline void RenderGraph::DestroyFramebuffers()
+{
+	for (uint32_t i = 0; i < m_renderPasses.size(); ++i)
+	{
+		if (m_renderPasses[i].m_framebuffer)
+		{
+			vkDestroyFramebuffer(m_renderer->GetDevice(), m_renderPasses[i].m_framebuffer, nullptr);
+			m_renderPasses[i].m_framebuffer = VK_NULL_HANDLE;
+		}
+
+		for (uint32_t j = 0; j < m_renderPasses[i].m_externalFramebuffers.size(); ++j)
+			vkDestroyFramebuffer(m_renderer->GetDevice(), m_renderPasses[i].m_externalFramebuffers[j], nullptr);
+
+		m_renderPasses[i].m_externalFramebuffers.clear();
+	}
+}
+
+inline void RenderGraph::DestroyTextures()
+{
+	for (uint32_t i = 0; i < m_physicalAttachments.size(); ++i)
+	{
+		PhysicalAttachment& physical = m_physicalAttachments[i];
+
+		if (!physical.m_bImported)
+		{
+			delete physical.m_texture;
+			physical.m_texture = nullptr;
+		}
+	}
+}
+
+inline void RenderGraph::RecordComputePasses(VkCommandBuffer cmdBuf, const std::vector<RenderGraphPass>& passes, const uint32_t& nFrameIndex)
+{
+	for (uint32_t i = 0; i < passes.size(); ++i)
+	{
+		const Pass& pass = m_passes[passes[i]];
+
+		if (pass.m_recordFunc)
+			pass.m_recordFunc(cmdBuf, nFrameIndex);
+	}
+}
+
+inline void RenderGraph::GetAccessMasks(ERenderGraphAccess access, VkPipelineStageFlags& stages, VkAccessFlags& accessMask) const
+{
+	switch (access)
+	{
+	case RENDER_GRAPH_WRITE_COLOR:
+		stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		accessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		break;
+
+	case RENDER_GRAPH_WRITE_DEPTH:
+		stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		accessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		break;
+
+	case RENDER_GRAPH_READ_INPUT:
+		stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		accessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+		break;
+
+	case RENDER_GRAPH_READ_SAMPLED:
+		stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		accessMask = VK_ACCESS_SHADER_READ_BIT;
+		break;
+
+	default:
+		RENDERER_SAFECALL(true, "Render Graph Error: Invalid Enum!");
+		break;
+	}
+}
+
+inline void RenderGraph::AddDependency(std::vector<VkSubpassDependency>& dependencies, uint32_t nSrc, uint32_t nDst, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+	for (uint32_t i = 0; i < dependencies.size(); ++i)
+	{
+		VkSubpassDependency& dependency = dependencies[i];
+
+		if (dependency.srcSubpass == nSrc && dependency.dstSubpass == nDst)
+		{
+			dependency.srcStageMask |= srcStages;
+			dependency.dstStageMask |= dstStages;
+			dependency.srcAccessMask |= srcAccess;
+			dependency.dstAccessMask |= dstAccess;
+			return;
+		}
+	}
+
+	// Dependencies between subpasses only cover attachments, which are accessed at the same pixel.
+	VkDependencyFlags flags = (nSrc != VK_SUBPASS_EXTERNAL && nDst != VK_SUBPASS_EXTERNAL) ? VK_DEPENDENCY_BY_REGION_BIT : 0;
+
+	dependencies.push_back({ nSrc, nDst, srcStages, dstStages, srcAccess, dstAccess, flags });
+}
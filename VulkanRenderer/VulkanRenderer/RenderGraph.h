@@ -0,0 +1,338 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <functional>
+#include "Texture.h"
+
+/*
+Description: Builds render passes from declared passes & the attachments they read & write. Passes whose results are never consumed are culled,
+             consecutive passes are merged into subpasses of a single render pass where possible, and load/store ops, layouts & dependencies are derived from attachment usage.
+			 Transient attachments with non-overlapping lifetimes share images. Compute passes are recorded between render passes & may sample attachments written before them.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+class RenderModule;
+
+typedef uint32_t RenderGraphResource;
+typedef uint32_t RenderGraphPass;
+
+#define RENDER_GRAPH_INVALID_INDEX ~0u
+
+enum ERenderGraphAccess
+{
+	RENDER_GRAPH_WRITE_COLOR,
+	RENDER_GRAPH_WRITE_DEPTH,
+	RENDER_GRAPH_READ_INPUT, // Read as an input attachment, in the same pixel only.
+	RENDER_GRAPH_READ_SAMPLED // Read through a sampler, the writing pass must be in an earlier render pass.
+};
+
+class RenderGraph
+{
+public:
+
+	RenderGraph(Renderer* renderer);
+
+	~RenderGraph();
+
+	// ---------------------------------------------------------------------------------
+	// Declaration
+
+	/*
+	Description: Declare a transient attachment, the image is created & owned by the graph.
+	Return Type: RenderGraphResource
+	Param:
+	    const char* szName: Name of the attachment, used for reporting.
+		EAttachmentType type: Color or depth/stencil.
+		VkFormat format: Image format.
+		VkClearValue clearValue: Value the attachment is cleared to by the first pass writing it.
+	*/
+	RenderGraphResource AddAttachment(const char* szName, EAttachmentType type, VkFormat format, VkClearValue clearValue);
+
+	/*
+	Description: Declare an attachment using an existing image. Imported attachments are always stored.
+	Return Type: RenderGraphResource
+	Param:
+	    const char* szName: Name of the attachment, used for reporting.
+		Texture* texture: The existing image.
+		VkImageLayout finalLayout: Layout the image is left in after the last pass using it.
+		bool bOutput: Whether or not the image is consumed outside of the graph, passes writing it are never culled.
+		bool bClear: Whether or not the first pass writing it clears it, otherwise the previous contents are discarded.
+		VkClearValue clearValue: Clear value used if bClear is true.
+	*/
+	RenderGraphResource ImportAttachment(const char* szName, Texture* texture, VkImageLayout finalLayout, bool bOutput, bool bClear, VkClearValue clearValue = {});
+
+	/*
+	Description: Replace the image of an imported attachment, e.g. after it was re-created for a resize.
+	Param:
+	    RenderGraphResource resource: The imported attachment.
+		Texture* texture: The new image.
+	*/
+	void SetImportedTexture(RenderGraphResource resource, Texture* texture);
+
+	/*
+	Description: Declare a pass, passes are executed in declaration order.
+	Return Type: RenderGraphPass
+	Param:
+	    const char* szName: Name of the pass, used for reporting.
+	*/
+	RenderGraphPass AddPass(const char* szName);
+
+	/*
+	Description: Declare a compute pass, recorded outside of render passes between the passes declared before & after it. Compute passes may only sample attachments,
+	             and are never culled since they may write resources outside of the graph.
+	Return Type: RenderGraphPass
+	Param:
+	    const char* szName: Name of the pass, used for reporting.
+	*/
+	RenderGraphPass AddComputePass(const char* szName);
+
+	/*
+	Description: Declare an attachment access of a pass. Color writes & input reads are bound in the order they are declared.
+	Param:
+	    RenderGraphPass pass: The accessing pass.
+		RenderGraphResource resource: The accessed attachment.
+		ERenderGraphAccess access: How the attachment is accessed.
+	*/
+	void AddAccess(RenderGraphPass pass, RenderGraphResource resource, ERenderGraphAccess access);
+
+	/*
+	Description: Set the module recording the commands of a pass, may be set after Compile() since modules need the pass' render pass & subpass to create pipelines.
+	Param:
+	    RenderGraphPass pass: The pass.
+		RenderModule* module: The module recording the pass.
+	*/
+	void SetPassModule(RenderGraphPass pass, RenderModule* module);
+
+	/*
+	Description: Set the function recording the commands of a compute pass into the primary command buffer, may be set after Compile().
+	             The function must record its own barriers for resources outside of the graph.
+	Param:
+	    RenderGraphPass pass: The compute pass.
+		const std::function<void(VkCommandBuffer, const uint32_t&)>& recordFunc: Records the pass into the provided command buffer for the provided frame-in-flight.
+	*/
+	void SetPassCompute(RenderGraphPass pass, const std::function<void(VkCommandBuffer, const uint32_t&)>& recordFunc);
+
+	/*
+	Description: Allow the render pass writing an output attachment to write to external images instead, e.g. swap chain images, through a compatible variant of the render pass.
+	             Must be called before Compile(), the attachment must be written within a single render pass.
+	Param:
+	    RenderGraphResource resource: The imported output attachment, its format must match the external images.
+		VkImageLayout finalLayout: Layout the external images are left in.
+	*/
+	void AllowExternalOutput(RenderGraphResource resource, VkImageLayout finalLayout);
+
+	/*
+	Description: Set the external images the output attachment may be replaced with, takes effect when the graph is compiled or resized.
+	Param:
+	    const VkImageView* views: Views of the external images.
+		uint32_t nCount: Amount of external images.
+		uint32_t nWidth: Width of the external images.
+		uint32_t nHeight: Height of the external images.
+	*/
+	void SetExternalOutputImages(const VkImageView* views, uint32_t nCount, uint32_t nWidth, uint32_t nHeight);
+
+	// ---------------------------------------------------------------------------------
+	// Compilation & execution
+
+	/*
+	Description: Cull unused passes, create render passes, images & framebuffers. The graph can't be declared further after this.
+	Param:
+	    uint32_t nWidth: Width of transient attachments.
+		uint32_t nHeight: Height of transient attachments.
+	*/
+	void Compile(uint32_t nWidth, uint32_t nHeight);
+
+	/*
+	Description: Re-create transient images & framebuffers at a new size. Render passes are kept, so pipelines created with them remain valid.
+	Param:
+	    uint32_t nWidth: New width of transient attachments.
+		uint32_t nHeight: New height of transient attachments.
+	*/
+	void Resize(uint32_t nWidth, uint32_t nHeight);
+
+	/*
+	Description: Limit rendering of render passes using transient attachments to an area from the top left corner, without re-creating any images.
+	             Render passes only using imported attachments, e.g. the shadow map, always cover their whole framebuffer.
+	Param:
+	    uint32_t nWidth: Width of the rendered area, clamped to the framebuffer width.
+		uint32_t nHeight: Height of the rendered area, clamped to the framebuffer height.
+	*/
+	void SetRenderArea(uint32_t nWidth, uint32_t nHeight);
+
+	/*
+	Description: Record all render passes, having each pass' module record & executing its secondary command buffers.
+	Param:
+	    VkCommandBuffer cmdBuf: The primary command buffer to record to.
+		const uint32_t& nPresentImageIndex: Index of the swap chain image to render to.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+		VkCommandBuffer transferCmdBuf: Command buffer to record all transfer commands to.
+		bool bExternalOutput: Write the external output image at nPresentImageIndex instead of the output attachment's own image.
+	*/
+	void Execute(VkCommandBuffer cmdBuf, const uint32_t& nPresentImageIndex, const uint32_t& nFrameIndex, VkCommandBuffer transferCmdBuf, bool bExternalOutput = false);
+
+	/*
+	Description: Print the passes, render passes & attachment allocation of the compiled graph.
+	*/
+	void PrintSummary() const;
+
+	// ---------------------------------------------------------------------------------
+	// Compiled information
+
+	/*
+	Description: Get the render pass a pass was compiled into, VK_NULL_HANDLE if the pass was culled or is a compute pass.
+	Return Type: VkRenderPass
+	*/
+	VkRenderPass GetRenderPass(RenderGraphPass pass) const;
+
+	/*
+	Description: Get the subpass index of a pass within its render pass.
+	Return Type: uint32_t
+	*/
+	uint32_t GetSubpassIndex(RenderGraphPass pass) const;
+
+	/*
+	Description: Get whether or not a pass was culled.
+	Return Type: bool
+	*/
+	bool IsPassCulled(RenderGraphPass pass) const;
+
+	/*
+	Description: Get the image backing an attachment, nullptr if the attachment is unused.
+	Return Type: Texture*
+	*/
+	Texture* GetTexture(RenderGraphResource resource) const;
+
+	/*
+	Description: Get whether or not the external output images can be written by Execute(), they must be set & the output attachment's pass must not be culled.
+	Return Type: bool
+	*/
+	bool HasExternalOutput() const;
+
+private:
+
+	struct Access
+	{
+		RenderGraphResource m_resource;
+		ERenderGraphAccess m_access;
+	};
+
+	struct Resource
+	{
+		std::string m_name;
+		EAttachmentType m_type;
+		VkFormat m_format;
+		VkClearValue m_clearValue;
+		Texture* m_importedTexture; // nullptr for transient attachments.
+		VkImageLayout m_finalLayout;
+		bool m_bOutput;
+		bool m_bClear;
+
+		// Compiled
+		bool m_bConsumed; // Read by a pass which is not culled.
+		uint32_t m_nFirstRenderPass;
+		uint32_t m_nLastRenderPass;
+		bool m_bSampledLater; // Read through a sampler, always by a later render pass than its writer.
+		VkImageUsageFlags m_usage;
+		uint32_t m_nPhysicalIndex;
+	};
+
+	struct Pass
+	{
+		std::string m_name;
+		std::vector<Access> m_accesses;
+		RenderModule* m_module;
+		bool m_bCompute;
+		std::function<void(VkCommandBuffer, const uint32_t&)> m_recordFunc; // Compute passes only.
+
+		// Compiled
+		bool m_bCulled;
+		uint32_t m_nRenderPassIndex; // Render pass a compute pass is recorded before.
+		uint32_t m_nSubpassIndex;
+	};
+
+	// An image shared by one or more attachments.
+	struct PhysicalAttachment
+	{
+		Texture* m_texture;
+		bool m_bImported;
+		EAttachmentType m_type;
+		VkFormat m_format;
+		VkImageUsageFlags m_usage;
+		uint32_t m_nLastRenderPass;
+		VkImageLayout m_currentLayout; // Used while compiling to chain layouts between render passes.
+	};
+
+	struct RenderPassData
+	{
+		VkRenderPass m_handle;
+		VkFramebuffer m_framebuffer;
+		std::vector<RenderGraphPass> m_passes; // One per subpass.
+		std::vector<RenderGraphPass> m_computePasses; // Recorded before the render pass begins.
+		std::vector<uint32_t> m_attachments; // Physical attachment indices.
+		std::vector<VkClearValue> m_clearValues;
+		uint32_t m_nWidth;
+		uint32_t m_nHeight;
+		bool m_bScaled; // Uses transient attachments, so rendering is limited to the render area.
+
+		// Variant writing the external output images, VK_NULL_HANDLE if the render pass doesn't write the output.
+		VkRenderPass m_externalHandle;
+		std::vector<VkFramebuffer> m_externalFramebuffers; // One per external image.
+		uint32_t m_nExternalWidth;
+		uint32_t m_nExternalHeight;
+	};
+
+	// Mark passes contributing to an output or consumed attachment, from the last pass backwards.
+	inline void CullPasses();
+
+	// Merge live passes into render passes, ending a render pass after a pass writing an attachment which is sampled later.
+	inline void GroupPasses();
+
+	// Get whether or not a pass after the provided pass samples the attachment.
+	inline bool IsSampledAfter(RenderGraphResource resource, RenderGraphPass pass) const;
+
+	// Assign images to attachments, reusing transient images which are no longer used.
+	inline void AllocateAttachments();
+
+	// Create the render pass at the provided index, deriving load/store ops, layouts & dependencies from its subpasses' accesses.
+	inline void CreateRenderPass(uint32_t nIndex);
+
+	inline void CreateTextures();
+
+	inline void CreateFramebuffers();
+
+	inline void DestroyFramebuffers();
+
+	inline void DestroyTextures();
+
+	// Record compute passes into the primary command buffer.
+	inline void RecordComputePasses(VkCommandBuffer cmdBuf, const std::vector<RenderGraphPass>& passes, const uint32_t& nFrameIndex);
+
+	// Get the stages & access types of an attachment access.
+	inline void GetAccessMasks(ERenderGraphAccess access, VkPipelineStageFlags& stages, VkAccessFlags& accessMask) const;
+
+	// Add a dependency, or merge its masks into an existing dependency between the same subpasses.
+	inline void AddDependency(std::vector<VkSubpassDependency>& dependencies, uint32_t nSrc, uint32_t nDst, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages, VkAccessFlags srcAccess, VkAccessFlags dstAccess);
+
+	Renderer* m_renderer;
+
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+	std::vector<PhysicalAttachment> m_physicalAttachments;
+	std::vector<RenderPassData> m_renderPasses;
+	std::vector<RenderGraphPass> m_trailingComputePasses; // Compute passes recorded after the last render pass.
+
+	uint32_t m_nWidth;
+	uint32_t m_nHeight;
+	uint32_t m_nRenderWidth;
+	uint32_t m_nRenderHeight;
+	bool m_bCompiled;
+
+	// External output
+	RenderGraphResource m_externalOutput;
+	VkImageLayout m_externalFinalLayout;
+	std::vector<VkImageView> m_externalViews;
+	uint32_t m_nExternalWidth;
+	uint32_t m_nExternalHeight;
+};
@@ -1,34 +1,200 @@
 #include "RenderModule.h"
 #include "Renderer.h"
+#include "CPUProfiler.h"
+#include <algorithm>
+#include <chrono>
 
-RenderModule::RenderModule(Renderer* renderer, VkCommandPool cmdPool, VkRenderPass pass, unsigned int nQueueFamilyIndex, bool bStatic)
+RenderModule::RenderModule(Renderer* renderer, VkCommandPool cmdPool, VkRenderPass pass, uint32_t nSubpassIndex, unsigned int nQueueFamilyIndex, bool bStatic)
 {
 	m_renderer = renderer;
 	m_nQueueFamilyIndex = nQueueFamilyIndex;
 	m_bStatic = bStatic;
 
 	m_renderPass = pass;
+	m_nSubpassIndex = nSubpassIndex;
+	m_nOutputWidth = m_renderer->FrameWidth();
+	m_nOutputHeight = m_renderer->FrameHeight();
+	m_nRenderWidth = m_nOutputWidth;
+	m_nRenderHeight = m_nOutputHeight;
 
 	m_cmdPool = cmdPool;
 
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		m_nWorkerCounts[i] = 0;
+
+	m_dRecordTime = 0.0;
+	m_nDrawCallCount = 0;
+	m_nProfilerScope = GPU_PROFILER_INVALID_SCOPE;
+
 	CreateCommandBuffers();
 }
 
 RenderModule::~RenderModule() 
 {
-
+	// Destroying the pools also frees their command buffers.
+	for (uint32_t i = 0; i < m_workerCmdPools.Count(); ++i)
+		vkDestroyCommandPool(m_renderer->GetDevice(), m_workerCmdPools[i], nullptr);
 }
 
 void RenderModule::OnOutputResize(const RenderModuleResizeData& resizeData)
 {
-	m_renderPass = resizeData.m_renderPass;
+	m_nOutputWidth = resizeData.m_nWidth;
+	m_nOutputHeight = resizeData.m_nHeight;
+	m_nRenderWidth = m_nOutputWidth;
+	m_nRenderHeight = m_nOutputHeight;
+}
+
+void RenderModule::SetRenderPass(VkRenderPass pass, uint32_t nSubpassIndex)
+{
+	m_renderPass = pass;
+	m_nSubpassIndex = nSubpassIndex;
+}
+
+void RenderModule::SetRenderArea(uint32_t nWidth, uint32_t nHeight)
+{
+	m_nRenderWidth = std::min(nWidth, m_nOutputWidth);
+	m_nRenderHeight = std::min(nHeight, m_nOutputHeight);
+}
+
+void RenderModule::SetProfilerScope(uint32_t nScope)
+{
+	m_nProfilerScope = nScope;
+}
+
+VkRenderPass RenderModule::GetRenderPass() const
+{
+	return m_renderPass;
+}
+
+uint32_t RenderModule::GetSubpassIndex() const
+{
+	return m_nSubpassIndex;
 }
 
 const VkCommandBuffer* RenderModule::GetCommandBuffer(unsigned int nBufferIndex)
 {
+	if (m_workerCmdBuffers.Count() > 0)
+		return &m_workerCmdBuffers[nBufferIndex * MAX_RECORDING_THREADS];
+
 	return &m_cmdBuffers[nBufferIndex];
 }
 
+uint32_t RenderModule::GetCommandBufferCount(unsigned int nBufferIndex) const
+{
+	if (m_workerCmdBuffers.Count() > 0)
+		return m_nWorkerCounts[nBufferIndex];
+
+	return 1;
+}
+
+double RenderModule::RecordTime() const
+{
+	return m_dRecordTime;
+}
+
+uint32_t RenderModule::DrawCallCount() const
+{
+	return m_nDrawCallCount;
+}
+
+void RenderModule::RecordViewportState(VkCommandBuffer cmdBuf)
+{
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(m_nRenderWidth);
+	viewport.height = static_cast<float>(m_nRenderHeight);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor = {};
+	scissor.offset = { 0, 0 };
+	scissor.extent = { m_nRenderWidth, m_nRenderHeight };
+
+	vkCmdSetViewport(cmdBuf, 0, 1, &viewport);
+	vkCmdSetScissor(cmdBuf, 0, 1, &scissor);
+}
+
+void RenderModule::CreateWorkerCmdBuffers()
+{
+	const uint32_t nBufferCount = MAX_FRAMES_IN_FLIGHT * MAX_RECORDING_THREADS;
+
+	m_workerCmdPools.SetSize(nBufferCount);
+	m_workerCmdPools.SetCount(nBufferCount);
+	m_workerCmdBuffers.SetSize(nBufferCount);
+	m_workerCmdBuffers.SetCount(nBufferCount);
+
+	// Command pools are externally synchronized, so each worker of each frame needs its own to record concurrently.
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = m_nQueueFamilyIndex;
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocInfo.commandBufferCount = 1;
+
+	for (uint32_t i = 0; i < nBufferCount; ++i)
+	{
+		RENDERER_SAFECALL(vkCreateCommandPool(m_renderer->GetDevice(), &poolInfo, nullptr, &m_workerCmdPools[i]), "Module Error: Failed to create worker command pool.");
+
+		allocInfo.commandPool = m_workerCmdPools[i];
+		RENDERER_SAFECALL(vkAllocateCommandBuffers(m_renderer->GetDevice(), &allocInfo, &m_workerCmdBuffers[i]), "Module Error: Failed to allocate worker command buffer.");
+	}
+}
+
+void RenderModule::RecordParallel(const uint32_t& nFrameIndex, uint32_t nItemCount, const VkCommandBufferBeginInfo& beginInfo, const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& recordFunc)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	JobSystem* jobSystem = m_renderer->GetJobSystem();
+	GPUProfiler* profiler = m_renderer->GetGPUProfiler();
+	VkDevice device = m_renderer->GetDevice();
+
+	// Use no more workers than there are items, but always record at least one buffer so there is something to execute.
+	uint32_t nWorkerCount = std::min(m_renderer->RecordingThreadCount(), jobSystem->ThreadCount());
+	nWorkerCount = std::max(std::min(nWorkerCount, nItemCount), 1u);
+
+	m_nWorkerCounts[nFrameIndex] = nWorkerCount;
+
+	const uint32_t nFirstBuffer = nFrameIndex * MAX_RECORDING_THREADS;
+
+	// One job per worker command buffer.
+	jobSystem->ParallelFor(nWorkerCount, 1, [&](uint32_t nWorkerIndex, uint32_t nWorkerEnd)
+	{
+		CPU_PROFILE_ZONE("RenderModule Worker");
+
+		const uint32_t nBufferIndex = nFirstBuffer + nWorkerIndex;
+
+		// This frame's previous submission has completed, recycle all of the worker's command memory at once.
+		RENDERER_SAFECALL(vkResetCommandPool(device, m_workerCmdPools[nBufferIndex], 0), "Module Error: Failed to reset worker command pool.");
+
+		VkCommandBuffer cmdBuf = m_workerCmdBuffers[nBufferIndex];
+
+		RENDERER_SAFECALL(vkBeginCommandBuffer(cmdBuf, &beginInfo), "Module Error: Failed to begin recording of worker command buffer.");
+
+		// Contiguous range of the list, so executing the buffers in order preserves the list order.
+		uint32_t nStart = (nItemCount * nWorkerIndex) / nWorkerCount;
+		uint32_t nEnd = (nItemCount * (nWorkerIndex + 1)) / nWorkerCount;
+
+		// The buffers execute in order, so the first & last bracket the whole list.
+		if (nWorkerIndex == 0)
+			profiler->BeginScope(cmdBuf, nFrameIndex, m_nProfilerScope);
+
+		recordFunc(cmdBuf, nStart, nEnd);
+
+		if (nWorkerIndex == nWorkerCount - 1)
+			profiler->EndScope(cmdBuf, nFrameIndex, m_nProfilerScope);
+
+		RENDERER_SAFECALL(vkEndCommandBuffer(cmdBuf), "Module Error: Failed to end recording of worker command buffer.");
+	});
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	m_dRecordTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count() / 1000.0;
+}
+
 inline void RenderModule::CreateCommandBuffers()
 {
 	// Allocate handle memory for command buffers. One for each frame-in-flight.
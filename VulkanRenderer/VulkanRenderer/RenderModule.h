@@ -2,12 +2,12 @@
 #include <vulkan/vulkan.h>
 #include "DynamicArray.h"
 #include "Renderer.h"
+#include <functional>
 
 struct RenderModuleResizeData 
 {
 	uint32_t m_nWidth; // New render output width.
 	uint32_t m_nHeight; // New render output height.
-	VkRenderPass m_renderPass; // New render pass handle.
 	VkDescriptorSet* m_mvpUBOSets; // New MVP UBO handles MAX_FRAMES_IN_FLIGHT in count.
 	VkDescriptorSet* m_gBufferSets; // New G-Buffer input attachment descriptor set.
 };
@@ -16,7 +16,7 @@ class RenderModule
 {
 public:
 
-	RenderModule(Renderer* renderer, VkCommandPool cmdPool, VkRenderPass pass, unsigned int nQueueFamilyIndex, bool bStatic);
+	RenderModule(Renderer* renderer, VkCommandPool cmdPool, VkRenderPass pass, uint32_t nSubpassIndex, unsigned int nQueueFamilyIndex, bool bStatic);
 
 	virtual ~RenderModule() = 0;
 
@@ -29,14 +29,98 @@ public:
 	*/
 	virtual void OnOutputResize(const RenderModuleResizeData& resizeData);
 
+	/*
+	Description: Called when the render graph is rebuilt, with the render pass this module now records within. Modules re-create pipelines created for the previous render pass.
+	Param:
+	    VkRenderPass pass: The new render pass, VK_NULL_HANDLE if the module's render graph pass was culled.
+		uint32_t nSubpassIndex: Index of the module's subpass within the new render pass.
+	*/
+	virtual void SetRenderPass(VkRenderPass pass, uint32_t nSubpassIndex);
+
+	/*
+	Description: Set the area of the render output rendered to from the top left corner, for rendering at a lower resolution without re-creating images. Reset to the whole output on resize.
+	Param:
+	    uint32_t nWidth: Width of the rendered area, clamped to the output width.
+		uint32_t nHeight: Height of the rendered area, clamped to the output height.
+	*/
+	void SetRenderArea(uint32_t nWidth, uint32_t nHeight);
+
+	/*
+	Description: Set the GPU profiler scope the module's recorded commands are timed with.
+	Param:
+	    uint32_t nScope: Scope of the renderer's GPU profiler, GPU_PROFILER_INVALID_SCOPE to not time the module.
+	*/
+	void SetProfilerScope(uint32_t nScope);
+
+	/*
+	Description: Get the render pass this module records within, VK_NULL_HANDLE if its render graph pass was culled.
+	Return Type: VkRenderPass
+	*/
+	VkRenderPass GetRenderPass() const;
+
+	/*
+	Description: Get the index of the subpass this module records within.
+	Return Type: uint32_t
+	*/
+	uint32_t GetSubpassIndex() const;
+
+	/*
+	Description: Get the secondary command buffers recorded for the provided frame, to be executed in order.
+	Return Type: const VkCommandBuffer*
+	Param:
+	    unsigned int nBufferIndex: Index of the frame-in-flight.
+	*/
 	const VkCommandBuffer* GetCommandBuffer(unsigned int nBufferIndex);
 
+	/*
+	Description: Get the amount of secondary command buffers recorded for the provided frame.
+	Return Type: uint32_t
+	Param:
+	    unsigned int nBufferIndex: Index of the frame-in-flight.
+	*/
+	uint32_t GetCommandBufferCount(unsigned int nBufferIndex) const;
+
+	/*
+	Description: Get the CPU time in milliseconds spent recording the last parallel recorded frame.
+	Return Type: double
+	*/
+	double RecordTime() const;
+
+	/*
+	Description: Get the amount of draw commands recorded in the last recorded frame.
+	Return Type: uint32_t
+	*/
+	uint32_t DrawCallCount() const;
+
 private:
 
 	inline void CreateCommandBuffers();
 
 protected:
 
+	/*
+	Description: Set the dynamic viewport & scissor state to cover the render area. Secondary command buffers do not inherit dynamic state, so this must be recorded into each.
+	Param:
+	    VkCommandBuffer cmdBuf: The command buffer to record to.
+	*/
+	void RecordViewportState(VkCommandBuffer cmdBuf);
+
+	/*
+	Description: Create a command pool & secondary command buffer for each recording worker & frame-in-flight, required by RecordParallel().
+	*/
+	void CreateWorkerCmdBuffers();
+
+	/*
+	Description: Record a list of items across the renderer's job system threads. Each worker records a contiguous range of the list into its own secondary command buffer,
+	             the buffers are then executed in list order. The profiler scope is written around the first & last buffer.
+	Param:
+	    const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+		uint32_t nItemCount: Amount of items in the list.
+		const VkCommandBufferBeginInfo& beginInfo: Begin info & inheritance info for the worker command buffers.
+		const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& recordFunc: Records items [nStart, nEnd) into the provided command buffer, called concurrently.
+	*/
+	void RecordParallel(const uint32_t& nFrameIndex, uint32_t nItemCount, const VkCommandBufferBeginInfo& beginInfo, const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& recordFunc);
+
 	// ---------------------------------------------------------------------------------
 	// Main
 
@@ -48,6 +132,11 @@ protected:
 	// Rendering
 
 	VkRenderPass m_renderPass;
+	uint32_t m_nSubpassIndex;
+	uint32_t m_nOutputWidth;
+	uint32_t m_nOutputHeight;
+	uint32_t m_nRenderWidth;
+	uint32_t m_nRenderHeight;
 
 	// ---------------------------------------------------------------------------------
 	// Command pool
@@ -58,5 +147,13 @@ protected:
 	// Command buffers
 
 	DynamicArray<VkCommandBuffer> m_cmdBuffers;
+
+	// Worker command pools & buffers, MAX_RECORDING_THREADS for each frame-in-flight. Empty unless CreateWorkerCmdBuffers() was called.
+	DynamicArray<VkCommandPool> m_workerCmdPools;
+	DynamicArray<VkCommandBuffer> m_workerCmdBuffers;
+	uint32_t m_nWorkerCounts[MAX_FRAMES_IN_FLIGHT]; // Amount of worker buffers recorded in each frame.
+	double m_dRecordTime;
+	uint32_t m_nDrawCallCount; // Set by derived modules when recording.
+	uint32_t m_nProfilerScope;
 };
 
@@ -5,13 +5,20 @@
 #include "Material.h"
 #include "Renderer.h"
 #include "SubScene.h"
+#include "GBufferPass.h"
+#include "GPUCuller.h"
+#include "FrustumCuller.h"
+#include "DrawList.h"
+
+#include <algorithm>
+#include <cstring>
 
 DynamicArray<EVertexAttribute> RenderObject::m_defaultInstanceAttributes = 
 { 
 	VERTEX_ATTRIB_FLOAT4, VERTEX_ATTRIB_FLOAT4, VERTEX_ATTRIB_FLOAT4, VERTEX_ATTRIB_FLOAT4, // Model matrix
 };
 
-RenderObject::RenderObject(Scene* scene, Mesh* mesh, Material* material, DynamicArray<EVertexAttribute>* instanceAttributes, uint32_t nMaxInstanceCount, uint32_t nSubScenebits)
+RenderObject::RenderObject(Scene* scene, Mesh* mesh, Material* material, DynamicArray<EVertexAttribute>* instanceAttributes, uint32_t nInstanceCapacity, uint32_t nSubScenebits)
 {
 	m_scene = scene;
 	m_subScene = scene->GetPrimarySubScene();
@@ -20,10 +27,33 @@ RenderObject::RenderObject(Scene* scene, Mesh* mesh, Material* material, Dynamic
 	m_material = material;
 	m_pipelineData = nullptr;
 	
-	m_instanceArray = new Instance[nMaxInstanceCount];
-	m_nInstanceArraySize = nMaxInstanceCount;
+	m_instanceArray = nullptr;
+	m_nInstanceArraySize = 0;
 	m_nInstanceCount = 0;
-	m_bInstancesModified = true;
+	m_nFreeSlot = UINT32_MAX;
+
+	m_gpuCuller = nullptr;
+	m_nGPUDrawIndex = ~0u;
+	m_nGPUSlotBase = 0;
+	m_nGPUSlotCount = 0;
+	m_nLateVisibleCount = 0;
+	m_fViewDistance = 0.0f;
+
+	// Per-view visible instances, written each frame to the culler's instance buffer of the view.
+	for (uint32_t i = 0; i < CULL_VIEW_COUNT; ++i)
+	{
+		m_visibleInstances[i] = nullptr;
+		m_nVisibleCounts[i] = 0;
+		m_nVisibleOffsets[i] = 0;
+
+		for (uint32_t j = 0; j < MESH_MAX_LODS; ++j)
+			m_nLODVisibleCounts[i][j] = 0;
+	}
+
+	m_visibleLODs = nullptr;
+	m_groupedInstances = nullptr;
+
+	GrowInstances(std::max(nInstanceCapacity, 1u));
 
 	m_nameID = "|" + material->GetName() + mesh->VertexFormat()->NameID();
 
@@ -45,24 +75,27 @@ RenderObject::~RenderObject()
 		m_renderer->WaitGraphicsIdle();
 		m_renderer->WaitTransferIdle();
 
-		// Destroy instance staging buffer & memory.
-		vkDestroyBuffer(m_renderer->GetDevice(), m_instanceStagingBuffer, nullptr);
-		vkFreeMemory(m_renderer->GetDevice(), m_instanceStagingMemory, nullptr);
-
-		m_instanceStagingBuffer = nullptr;
-		m_instanceStagingMemory = nullptr;
+		// Destroy visible instance arrays.
+		for (uint32_t i = 0; i < CULL_VIEW_COUNT; ++i)
+			delete[] m_visibleInstances[i];
 
-		// Destroy instance buffer & memory.
-		vkDestroyBuffer(m_renderer->GetDevice(), m_instanceBuffer, nullptr);
-		vkFreeMemory(m_renderer->GetDevice(), m_instanceMemory, nullptr);
+		delete[] m_visibleLODs;
+		delete[] m_groupedInstances;
 
-		m_instanceBuffer = nullptr;
-		m_instanceMemory = nullptr;
+		m_instanceArray = nullptr;
 	}
 
 	// Remove this render object from the pipeline.
 	m_pipelineData->m_renderObjects.Pop(this);
 
+	// Remove this object's material from the pipeline if no other object still uses it.
+	bool bMaterialUsed = false;
+	for (uint32_t i = 0; i < m_pipelineData->m_renderObjects.Count() && !bMaterialUsed; ++i)
+		bMaterialUsed = m_pipelineData->m_renderObjects[i]->m_material == m_material;
+
+	if (!bMaterialUsed)
+		m_pipelineData->m_materials.Pop(m_material);
+
 	if (m_pipelineData->m_renderObjects.Count() == 0) // This is the last object using the pipeline, destroy the pipeline.
 	{
 		// Wait for graphics & transfer queues to be idle.
@@ -71,6 +104,10 @@ RenderObject::~RenderObject()
 
 		// Destroy pipeline objects.
 		vkDestroyPipeline(m_renderer->GetDevice(), m_pipelineData->m_handle, nullptr);
+
+		if (m_pipelineData->m_lateHandle)
+			vkDestroyPipeline(m_renderer->GetDevice(), m_pipelineData->m_lateHandle, nullptr);
+
 		vkDestroyPipelineLayout(m_renderer->GetDevice(), m_pipelineData->m_layout, nullptr);
 
 		delete m_pipelineData;
@@ -78,80 +115,246 @@ RenderObject::~RenderObject()
 	}
 }
 
-void RenderObject::CommandDraw(VkCommandBuffer_T* cmdBuffer) 
+void RenderObject::CommandDraw(VkCommandBuffer_T* cmdBuffer, ECullView eView, const uint32_t& nFrameIndex, ECullPhase ePhase) 
 {
 	Mesh& meshRef = *m_mesh;
 
-	// Bind vertex, index and instance buffers.
-	meshRef.Bind(cmdBuffer, m_instanceBuffer);
+	if(m_gpuCuller)
+	{
+		// Bind this object's visible instances of the view written by the culling shader, which also writes the instance count of the draw.
+		meshRef.Bind(cmdBuffer, m_gpuCuller->VisibleInstanceBuffer(nFrameIndex), GPUInstanceOffset(eView, ePhase));
 
-	// Draw...
-	vkCmdDrawIndexed(cmdBuffer, meshRef.IndexCount(), m_nInstanceCount, 0, 0, 0);
+		vkCmdDrawIndexedIndirect(cmdBuffer, m_gpuCuller->DrawCommandBuffer(nFrameIndex), m_gpuCuller->DrawCommandOffset(eView, m_nGPUDrawIndex, ePhase), 1, sizeof(VkDrawIndexedIndirectCommand));
+
+		return;
+	}
+
+	// CPU culling draws every visible instance in the early phase.
+	if (ePhase == CULL_PHASE_LATE)
+		return;
+
+	// Bind vertex, index and the view's visible instance buffers.
+	meshRef.Bind(cmdBuffer, m_subScene->GetFrustumCuller()->InstanceBuffer(eView, nFrameIndex));
+
+	// Draw each LOD's range of the visible instances with the LOD's range of the index buffer...
+	uint32_t nFirstInstance = m_nVisibleOffsets[eView];
+
+	for (uint32_t i = 0; i < meshRef.LODCount(); ++i)
+	{
+		uint32_t nInstanceCount = m_nLODVisibleCounts[eView][i];
+
+		if (nInstanceCount == 0)
+			continue;
+
+		const MeshLOD& lod = meshRef.GetLOD(i);
+		vkCmdDrawIndexed(cmdBuffer, lod.m_nIndexCount, nInstanceCount, meshRef.FirstIndex() + lod.m_nFirstIndex, meshRef.BaseVertex(), nFirstInstance);
+
+		nFirstInstance += nInstanceCount;
+	}
 }
 
-void RenderObject::AddInstance(Instance& instance) 
+void RenderObject::AddDraws(DrawList& drawList, VkPipeline pipeline, uint32_t nPipelineID, ECullView eView, const uint32_t& nFrameIndex, ECullPhase ePhase)
 {
-	// Don't attempt to add beyond the max instance limit.
-	if (m_nInstanceCount >= m_nInstanceArraySize)
+	DrawRecord record = {};
+	record.m_pipeline = pipeline;
+	record.m_layout = m_pipelineData->m_layout;
+	record.m_material = m_material; // Objects sharing a pipeline may use different materials, each binding its own descriptor set.
+	record.m_vertexBuffer = m_mesh->VertexBuffer();
+	record.m_indexBuffer = m_mesh->IndexBuffer();
+
+	uint32_t nMaterialID = record.m_material->ID();
+	uint32_t nMeshID = m_mesh->ID();
+
+	if (m_gpuCuller)
+	{
+		// Draw this object's visible instances of the view written by the culling shader, which also writes the instance count of the draw.
+		record.m_instanceBuffer = m_gpuCuller->VisibleInstanceBuffer(nFrameIndex);
+		record.m_nInstanceOffset = GPUInstanceOffset(eView, ePhase);
+		record.m_indirectBuffer = m_gpuCuller->DrawCommandBuffer(nFrameIndex);
+		record.m_nIndirectOffset = m_gpuCuller->DrawCommandOffset(eView, m_nGPUDrawIndex, ePhase);
+
+		// Sorting by draw index keeps the commands of a pipeline consecutive, so they merge into a single multi-draw.
+		drawList.Add(DrawList::MakeKey(nPipelineID, nMaterialID, 0.0f, m_nGPUDrawIndex, 0), record);
+		return;
+	}
+
+	// CPU culling draws every visible instance in the early phase.
+	if (ePhase == CULL_PHASE_LATE)
 		return;
 
-	m_instanceArray[m_nInstanceCount++] = instance;
-	m_bInstancesModified = true;
+	// Every object shares the view's instance buffer, so records of a pipeline differ only in their commands & merge into a single multi-draw.
+	record.m_instanceBuffer = m_subScene->GetFrustumCuller()->InstanceBuffer(eView, nFrameIndex);
+	record.m_nInstanceOffset = 0;
+
+	// A record for each LOD's range of the visible instances, drawn with the LOD's range of the index buffer.
+	uint32_t nFirstInstance = m_nVisibleOffsets[eView];
+
+	for (uint32_t i = 0; i < m_mesh->LODCount(); ++i)
+	{
+		uint32_t nInstanceCount = m_nLODVisibleCounts[eView][i];
+
+		if (nInstanceCount == 0)
+			continue;
+
+		const MeshLOD& lod = m_mesh->GetLOD(i);
+		record.m_command.indexCount = lod.m_nIndexCount;
+		record.m_command.instanceCount = nInstanceCount;
+		record.m_command.firstIndex = m_mesh->FirstIndex() + lod.m_nFirstIndex;
+		record.m_command.vertexOffset = m_mesh->BaseVertex();
+		record.m_command.firstInstance = nFirstInstance;
+
+		drawList.Add(DrawList::MakeKey(nPipelineID, nMaterialID, m_fViewDistance, nMeshID, i), record);
+
+		nFirstInstance += nInstanceCount;
+	}
 }
 
-void RenderObject::RemoveInstance(const unsigned int& nIndex)
+InstanceHandle RenderObject::AddInstance(const Instance& instance) 
 {
-	if (m_nInstanceCount <= 0)
-		return;
+	// Double the capacity when full, so adding many instances only reallocates a few times.
+	if (m_nInstanceCount >= m_nInstanceArraySize)
+		GrowInstances(m_nInstanceArraySize * 2);
+
+	// Reuse a free slot, there are never more slots than the instance capacity.
+	uint32_t nSlot = m_nFreeSlot;
 
-	// Copy the contents beyond the provided index to the provided index to overlap the old data, and close the gap.
-	if (nIndex < m_nInstanceCount - 1)
+	if (nSlot != UINT32_MAX)
+		m_nFreeSlot = m_slotIndices[nSlot];
+	else
 	{
-		unsigned int nCopySize = (m_nInstanceCount - (nIndex + 1)) * sizeof(Instance);
-		memcpy_s(&m_instanceArray[nIndex], nCopySize, &m_instanceArray[nIndex + 1], nCopySize);
+		nSlot = static_cast<uint32_t>(m_slotIndices.size());
+
+		m_slotIndices.push_back(0);
+		m_slotGenerations.push_back(0);
 	}
-	
-	--m_nInstanceCount;
+
+	m_slotIndices[nSlot] = m_nInstanceCount;
+	m_instanceSlots[m_nInstanceCount] = nSlot;
+
+	m_instanceArray[m_nInstanceCount] = instance;
+	MarkInstancesModified(m_nInstanceCount, m_nInstanceCount + 1);
+
+	++m_nInstanceCount;
+
+	return { nSlot, m_slotGenerations[nSlot] };
 }
 
-void RenderObject::SetInstance(const unsigned int& nIndex, Instance& instance) 
+bool RenderObject::RemoveInstance(InstanceHandle handle)
 {
-	// Don't attempt to modify beyond the max instance limit.
-	if (nIndex < m_nInstanceCount) 
+	if (!IsValid(handle))
+		return false;
+
+	uint32_t nIndex = m_slotIndices[handle.m_nSlot];
+	uint32_t nLast = m_nInstanceCount - 1;
+
+	// Move the last instance into the gap, the last index is beyond the instance count afterwards so only the gap is modified.
+	if (nIndex != nLast)
 	{
-	    m_instanceArray[nIndex] = instance;
+		uint32_t nMovedSlot = m_instanceSlots[nLast];
 
-		m_bInstancesModified = true;
+		m_instanceArray[nIndex] = m_instanceArray[nLast];
+		m_instanceSlots[nIndex] = nMovedSlot;
+		m_slotIndices[nMovedSlot] = nIndex;
+
+		MarkInstancesModified(nIndex, nIndex + 1);
 	}
+
+	// Free the slot with a new generation, so the removed instance's handles are stale.
+	++m_slotGenerations[handle.m_nSlot];
+	m_slotIndices[handle.m_nSlot] = m_nFreeSlot;
+	m_nFreeSlot = handle.m_nSlot;
+
+	--m_nInstanceCount;
+
+	return true;
 }
 
-void RenderObject::UpdateInstanceData(VkCommandBuffer cmdBuffer)
+bool RenderObject::SetInstance(InstanceHandle handle, const Instance& instance) 
 {
-	if (!m_bInstancesModified || m_nInstanceCount == 0)
-		return;
+	if (!IsValid(handle))
+		return false;
 
-	int nCopySize = sizeof(Instance) * m_nInstanceCount;
+	uint32_t nIndex = m_slotIndices[handle.m_nSlot];
 
-	// Map instance staging buffer.
-	void* bufferPtr = nullptr;
-	RENDERER_SAFECALL(vkMapMemory(m_renderer->GetDevice(), m_instanceStagingMemory, 0, nCopySize, 0, &bufferPtr), "RenderObject error: Failed to update instance data on GPU.");
+	m_instanceArray[nIndex] = instance;
+	MarkInstancesModified(nIndex, nIndex + 1);
 
-	// Copy data...
-	memcpy_s(bufferPtr, nCopySize, m_instanceArray, nCopySize);
+	return true;
+}
 
-	// Unmap buffer.
-	vkUnmapMemory(m_renderer->GetDevice(), m_instanceStagingMemory);
+bool RenderObject::IsValid(InstanceHandle handle) const
+{
+	return handle.m_nSlot < m_slotGenerations.size() && m_slotGenerations[handle.m_nSlot] == handle.m_nGeneration;
+}
 
-	// Copy instance staging buffer to device local instance buffer.
-	VkBufferCopy insCopyRegion = {};
-	insCopyRegion.srcOffset = 0;
-	insCopyRegion.dstOffset = 0;
-	insCopyRegion.size = sizeof(Instance) * m_nInstanceCount;
+InstanceHandle RenderObject::InstanceAt(uint32_t nIndex) const
+{
+	uint32_t nSlot = m_instanceSlots[nIndex];
 
-	// Record copy command.
-	vkCmdCopyBuffer(cmdBuffer, m_instanceStagingBuffer, m_instanceBuffer, 1, &insCopyRegion);
+	return { nSlot, m_slotGenerations[nSlot] };
+}
 
-	m_bInstancesModified = false;
+uint32_t RenderObject::InstanceCount() const
+{
+	return m_nInstanceCount;
+}
+
+inline void RenderObject::GrowInstances(uint32_t nCapacity)
+{
+	// Only called between frames on the main thread, culling jobs & recording never run alongside this.
+	Instance* instances = new Instance[nCapacity];
+
+	if (m_instanceArray)
+	{
+		std::memcpy(instances, m_instanceArray, sizeof(Instance) * m_nInstanceCount);
+		delete[] m_instanceArray;
+	}
+
+	m_instanceArray = instances;
+	m_nInstanceArraySize = nCapacity;
+
+	// Visible instances & LOD grouping are rebuilt by every cull, so their contents are not kept.
+	for (uint32_t i = 0; i < CULL_VIEW_COUNT; ++i)
+	{
+		delete[] m_visibleInstances[i];
+		m_visibleInstances[i] = new Instance[nCapacity];
+	}
+
+	if (m_mesh->LODCount() > 1)
+	{
+		delete[] m_visibleLODs;
+		delete[] m_groupedInstances;
+
+		m_visibleLODs = new uint8_t[nCapacity];
+		m_groupedInstances = new Instance[nCapacity];
+	}
+
+	m_bounds.Resize(nCapacity);
+	m_modifiedBounds.Resize(nCapacity);
+	m_instanceSlots.resize(nCapacity);
+
+	// The GPU culler reserves slots for the whole capacity, so it lays out its slots again on its next cull, writing every instance to the new slots.
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		m_gpuInstanceUploads[i].Resize(nCapacity);
+}
+
+inline void RenderObject::MarkInstancesModified(uint32_t nStart, uint32_t nEnd)
+{
+	m_modifiedBounds.MarkRange(nStart, nEnd);
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		m_gpuInstanceUploads[i].MarkRange(nStart, nEnd);
+}
+
+inline VkDeviceSize RenderObject::GPUInstanceOffset(ECullView eView, ECullPhase ePhase) const
+{
+	// With multi-draw indirect the draw commands start at this object's slots, so every object binds the start of the view's instances.
+	return m_gpuCuller->VisibleInstanceOffset(eView, m_renderer->MultiDrawIndirectSupported() ? 0 : m_nGPUSlotBase, ePhase);
+}
+
+uint32_t RenderObject::VisibleInstanceCount(ECullView eView, ECullPhase ePhase) const
+{
+	return ePhase == CULL_PHASE_LATE ? m_nLateVisibleCount : m_nVisibleCounts[eView];
 }
 
 void RenderObject::RecreatePipeline() 
@@ -177,18 +380,10 @@ PipelineData* RenderObject::GetPipeline()
 void RenderObject::CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertexAttributes, bool bRecreate)
 {
 	// -------------------------------------------------------------------------------------------------------------------
-	// Instance buffer
+	// Instance format
 
 	VertexInfo insVertInfo(*vertexAttributes, true, m_mesh->VertexFormat());
 
-	// Create instance staging buffer.
-	if(!m_instanceStagingBuffer && !m_instanceStagingMemory)
-	    m_renderer->CreateBuffer(m_nInstanceArraySize * sizeof(Instance), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_instanceStagingBuffer, m_instanceStagingMemory);
-
-	// Create device local instance buffer.
-	if(!m_instanceBuffer && !m_instanceMemory)
-	    m_renderer->CreateBuffer(m_nInstanceArraySize * sizeof(Instance), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_instanceBuffer, m_instanceMemory);
-
 	// -------------------------------------------------------------------------------------------------------------------
 	// Check for existing matching pipeline in any subscene.
 
@@ -204,6 +399,14 @@ void RenderObject::CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertex
 		m_pipelineData = pipelineData;
 		m_pipelineData->m_renderObjects.Push(this);
 
+		// Add this object's material to the pipeline if it is the first object using it.
+		bool bMaterialAdded = false;
+		for (uint32_t i = 0; i < m_pipelineData->m_materials.Count() && !bMaterialAdded; ++i)
+			bMaterialAdded = m_pipelineData->m_materials[i] == m_material;
+
+		if (!bMaterialAdded)
+			m_pipelineData->m_materials.Push(m_material);
+
 		return;
 	}
 	else if(bRecreate) 
@@ -223,6 +426,12 @@ void RenderObject::CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertex
 		    vkDestroyPipeline(m_renderer->GetDevice(), pipelineData->m_handle, nullptr);
 			pipelineData->m_handle = nullptr;
 		}
+
+		if(pipelineData->m_lateHandle) 
+		{
+		    vkDestroyPipeline(m_renderer->GetDevice(), pipelineData->m_lateHandle, nullptr);
+			pipelineData->m_lateHandle = nullptr;
+		}
 	}
 	
 	// -------------------------------------------------------------------------------------------------------------------
@@ -240,6 +449,7 @@ void RenderObject::CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertex
 	fragStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 	fragStageInfo.module = m_material->GetShader()->m_fragModule;
 	fragStageInfo.pName = "main";
+	fragStageInfo.pSpecializationInfo = m_subScene->GetGBufferSpecializationInfo();
 
 	// Array of shader stage information.
 	VkPipelineShaderStageCreateInfo shaderStageInfos[] = { vertStageInfo, fragStageInfo };
@@ -272,27 +482,21 @@ void RenderObject::CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertex
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	// Viewport configuration.
-	VkViewport viewPort = {};
-	viewPort.x = 0.0f;
-	viewPort.y = 0.0f;
-	viewPort.width = (float)m_renderer->FrameWidth();
-	viewPort.height = (float)m_renderer->FrameHeight();
-	viewPort.minDepth = 0.0f;
-	viewPort.maxDepth = 1.0f;
-
-	// Scissor configuration.
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent = { m_renderer->FrameWidth(), m_renderer->FrameHeight() };
-
-	// Viewport state configuration.
+	// Viewport state configuration. Viewport & scissor are dynamic and set by the render module, so the pipeline survives output resizes.
 	VkPipelineViewportStateCreateInfo viewportState = {};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewPort;
+	viewportState.pViewports = nullptr;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+	viewportState.pScissors = nullptr;
+
+	VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	// Dynamic state configuration.
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
 
 	// Primitive rasterization stage configuration.
 	VkPipelineRasterizationStateCreateInfo rasterizer = {};
@@ -369,8 +573,8 @@ void RenderObject::CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertex
 		pipelineData = new PipelineData;
 		pipelineData->m_renderObjects.Push(this);
 
-		// Set pipeline material.
-		pipelineData->m_material = m_material;
+		// Add the first pipeline material.
+		pipelineData->m_materials.Push(m_material);
 
 		// Copy vertex attributes.
 		pipelineData->m_vertexAttributes = *vertexAttributes;
@@ -394,7 +598,7 @@ void RenderObject::CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertex
 
 	RENDERER_SAFECALL(vkCreatePipelineLayout(m_renderer->GetDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineData->m_layout), "Renderer Error: Failed to create graphics pipeline layout.");
 
-	// Create pipeline.
+	// Create pipelines.
 	VkGraphicsPipelineCreateInfo pipelineInfo = {};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	pipelineInfo.stageCount = 2;
@@ -406,14 +610,29 @@ void RenderObject::CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertex
 	pipelineInfo.pMultisampleState = &multisampler;
 	pipelineInfo.pDepthStencilState = &depthStencilState;
 	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = nullptr;
+	pipelineInfo.pDynamicState = &dynamicState;
 	pipelineInfo.layout = m_pipelineData->m_layout;
-	pipelineInfo.renderPass = m_subScene->GetRenderPass();
-	pipelineInfo.subpass = G_BUFFER_SUBPASS_INDEX;
+	pipelineInfo.renderPass = m_subScene->GetGBufferPass()->GetRenderPass();
+	pipelineInfo.subpass = m_subScene->GetGBufferPass()->GetSubpassIndex();
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	RENDERER_SAFECALL(vkCreateGraphicsPipelines(m_renderer->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipelineData->m_handle), "Renderer Error: Failed to create graphics pipeline.");
+	// The late G-Buffer pass shares the subpass' attachments, but not the render pass of the early G-Buffer pass.
+	GBufferPass* lateGPass = m_subScene->GetLateGBufferPass();
+
+	VkGraphicsPipelineCreateInfo pipelineInfos[2] = { pipelineInfo, pipelineInfo };
+	VkPipeline handles[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+
+	if (lateGPass)
+	{
+		pipelineInfos[1].renderPass = lateGPass->GetRenderPass();
+		pipelineInfos[1].subpass = lateGPass->GetSubpassIndex();
+	}
+
+	m_renderer->GetPipelineCache()->CreateGraphicsPipelines(pipelineInfos, lateGPass ? 2 : 1, handles);
+
+	m_pipelineData->m_handle = handles[0];
+	m_pipelineData->m_lateHandle = handles[1];
 
 	delete[] attrDescriptions;
 }
\ No newline at end of file
@@ -1,14 +1,20 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <vector>
 #include "glm.hpp"
 #include "Table.h"
 #include "VertexInfo.h"
 #include "Scene.h"
+#include "MemoryAllocator.h"
+#include "FrustumCuller.h"
+#include "Mesh.h"
+#include "DirtyBitset.h"
 
 class Renderer;
-class Mesh;
 class RenderObject;
 class Material;
+class GPUCuller;
+class DrawList;
 
 struct PipelineData;
 struct Shader;
@@ -20,6 +26,13 @@ struct Instance
 	glm::mat4 m_modelMat;
 };
 
+// Handle to an instance of a render object, which stays valid while other instances are added & removed. Handles of removed instances are detected as stale.
+struct InstanceHandle
+{
+	uint32_t m_nSlot; // Slot mapping the handle to the instance's current index.
+	uint32_t m_nGeneration; // Generation of the slot when the handle was given, slots are reused with the next generation once their instance is removed.
+};
+
 class RenderObject
 {
 public:
@@ -33,48 +46,88 @@ public:
 		Mesh* mesh: The mesh to render.
 		Material* material: The material to render with.
 		DynamicArray<EVertexAttribute>* instanceAttributes: Array of per-instance vertex attributes for the instance buffer.
-		uint32_t nMaxInstanceCount: Maximum amount of instances allowed for this render object.
+		uint32_t nInstanceCapacity: Initial instance capacity of this render object, which grows as instances are added.
 		uint32_t nSubSceneBits: Bit field containing bit indices of the subscenes this object will be rendered in.
 	*/
-	RenderObject(Scene* scene, Mesh* mesh, Material* material, DynamicArray<EVertexAttribute>* instanceAttributes = &m_defaultInstanceAttributes, uint32_t nMaxInstanceCount = 1, uint32_t nSubScenebits = 1);
+	RenderObject(Scene* scene, Mesh* mesh, Material* material, DynamicArray<EVertexAttribute>* instanceAttributes = &m_defaultInstanceAttributes, uint32_t nInstanceCapacity = 1, uint32_t nSubScenebits = 1);
 
 	~RenderObject();
 
 	/*
-	Description: Add the draw commands of this object to the externally recorded command buffer.
+	Description: Add the draw commands of this object's instances visible in a view to the externally recorded command buffer, with a draw per LOD in use.
 	Param:
 	    VkCommandBuffer& cmdBuffer: The command buffer to record to.
+		ECullView eView: The view being rendered, whose visible instances are drawn.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+		ECullPhase ePhase: The occlusion culling phase being rendered, instances are only drawn late when culled on the GPU with occlusion culling.
+	*/
+	void CommandDraw(VkCommandBuffer_T* cmdBuffer, ECullView eView, const uint32_t& nFrameIndex, ECullPhase ePhase = CULL_PHASE_EARLY);
+
+	/*
+	Description: Add draw records of this object's instances visible in a view to a draw list, with a record per LOD in use or a single indirect record while culled on the GPU.
+	Param:
+	    DrawList& drawList: The draw list to add to.
+		VkPipeline pipeline: The pipeline to draw with.
+		uint32_t nPipelineID: ID of the pipeline within the draw list, for sorting.
+		ECullView eView: The view being rendered, whose visible instances are drawn.
+		const uint32_t& nFrameIndex: Index of the current frame-in-flight.
+		ECullPhase ePhase: The occlusion culling phase being rendered, instances are only drawn late when culled on the GPU with occlusion culling.
+	*/
+	void AddDraws(DrawList& drawList, VkPipeline pipeline, uint32_t nPipelineID, ECullView eView, const uint32_t& nFrameIndex, ECullPhase ePhase = CULL_PHASE_EARLY);
+
+	/*
+	Description: Add an instance of this render object, growing the instance capacity if it is full.
+	Return Type: InstanceHandle
+	Param:
+	    const Instance& instance: The instance to add.
 	*/
-	void CommandDraw(VkCommandBuffer_T* cmdBuffer);
+	InstanceHandle AddInstance(const Instance& instance);
 
 	/*
-	Description: Add an instance of this render object.
+	Description: Remove an instance of this render object in constant time, moving the last instance into its place. The handle becomes stale.
+	Return Type: bool
 	Param:
-	    Instance& instance: The instance to add.
+	    InstanceHandle handle: Handle of the instance to remove.
 	*/
-	void AddInstance(Instance& instance);
+	bool RemoveInstance(InstanceHandle handle);
 
 	/*
-	Description: Remove an instance of this render object.
+	Description: Set the values of an instance. Only this instance is marked modified: GPU culling writes just it to each frame's instance buffer,
+	             & CPU culling recomputes just its bounds. CPU culling still writes every visible instance of the object each frame, as its visible
+	             instances are compacted into per-view buffers whose contents change with visibility.
+	Return Type: bool
 	Param:
-		const int& nIndex: The index of the instance to remove.
+	    InstanceHandle handle: Handle of the instance to modify.
+		const Instance& instance: The instance data to use.
 	*/
-	void RemoveInstance(const unsigned int& nIndex);
+	bool SetInstance(InstanceHandle handle, const Instance& instance);
 
 	/*
-	Description: Set the values of the instance at the specified index.
+	Description: Get whether or not a handle refers to a current instance of this object, false once its instance is removed.
+	Return Type: bool
 	Param:
-	    const int& nIndex: The index of the instance to modify.
-		Instance& instance: The instance data to use.
+	    InstanceHandle handle: The handle to check.
 	*/
-	void SetInstance(const unsigned int& nIndex, Instance& instance);
+	bool IsValid(InstanceHandle handle) const;
 
 	/*
-	Description: Update instance data on the GPU.
+	Description: Get the handle of the instance currently at an index, such as the instance each object is created with at index zero. Indices change as instances are removed.
+	Return Type: InstanceHandle
 	Param:
-	    VkCommandBuffer: The command buffer to record transfer commands to.
+	    uint32_t nIndex: Index of the instance, less than the instance count.
 	*/
-	void UpdateInstanceData(VkCommandBuffer cmdBuffer);
+	InstanceHandle InstanceAt(uint32_t nIndex) const;
+
+	uint32_t InstanceCount() const;
+
+	/*
+	Description: Get the amount of instances visible in a view, as of the last cull.
+	Return Type: uint32_t
+	Param:
+	    ECullView eView: The view to get the visible instance count of.
+		ECullPhase ePhase: The occlusion culling phase to get the visible instance count of.
+	*/
+	uint32_t VisibleInstanceCount(ECullView eView, ECullPhase ePhase = CULL_PHASE_EARLY) const;
 
 	/*
 	Description: Recreate the graphics pipeline this object uses.
@@ -89,6 +142,9 @@ public:
 
 private:
 
+	friend class FrustumCuller;
+	friend class GPUCuller;
+
 	/*
 	Description: Create a graphics pipeline or use an existing one for this object.
 	Param:
@@ -97,6 +153,15 @@ private:
 	*/
 	void CreateGraphicsPipeline(DynamicArray<EVertexAttribute>* vertexAttributes, bool bRecreate = false);
 
+	// Grow the instance arrays to at least the provided capacity, keeping the current instances & their bounds.
+	inline void GrowInstances(uint32_t nCapacity);
+
+	// Mark a range of instances as modified, so their bounds are recomputed & they are written to each frame's GPU culler instance buffer.
+	inline void MarkInstancesModified(uint32_t nStart, uint32_t nEnd);
+
+	// Offset of the instance buffer binding of GPU culled draws, the object's slots without multi-draw indirect or the start of the view's slots with it.
+	inline VkDeviceSize GPUInstanceOffset(ECullView eView, ECullPhase ePhase) const;
+
 	std::string m_nameID;
 
 	Scene* m_scene;
@@ -107,15 +172,35 @@ private:
 
 	// Instance data.
 	Instance* m_instanceArray;
-	unsigned int m_nInstanceArraySize;
+	unsigned int m_nInstanceArraySize; // Capacity of the instance arrays, doubled when full.
 	unsigned int m_nInstanceCount;
-	bool m_bInstancesModified;
-
-	VkBuffer m_instanceStagingBuffer;
-	VkDeviceMemory m_instanceStagingMemory;
-
-	VkBuffer m_instanceBuffer;
-	VkDeviceMemory m_instanceMemory;
+	DirtyBitset m_modifiedBounds; // Instances whose bounds are recomputed on the next CPU cull.
+
+	// Instance handles, each slot maps a handle to its instance's index & each instance maps back to its slot, so a removal may move the last instance into the gap.
+	std::vector<uint32_t> m_slotIndices; // Instance index of each used slot, or the next free slot of each free slot.
+	std::vector<uint32_t> m_slotGenerations;
+	std::vector<uint32_t> m_instanceSlots; // Slot of each instance, sized to the instance capacity.
+	uint32_t m_nFreeSlot; // First slot of the free list, UINT32_MAX when every slot is used.
+
+	// Culling data, visible instances of each view are compacted & written to the culler's instance buffer of the view, starting at the visible offset.
+	InstanceBounds m_bounds;
+	Instance* m_visibleInstances[CULL_VIEW_COUNT];
+	uint32_t m_nVisibleCounts[CULL_VIEW_COUNT];
+	uint32_t m_nVisibleOffsets[CULL_VIEW_COUNT];
+	uint32_t m_nLateVisibleCount; // Camera instances drawn in the late phase, an upper bound like the GPU culled visible counts.
+	float m_fViewDistance; // Distance from the camera to the nearest visible camera instance's bounds, zero while culled on the GPU.
+
+	// LOD data, only allocated if the mesh has LODs. Visible camera instances are grouped by LOD, & each LOD drawn from its range of the instance buffer.
+	uint8_t* m_visibleLODs; // Selected LOD of each visible camera instance.
+	Instance* m_groupedInstances; // Scratch space for grouping, swapped with the camera's visible instances.
+	uint32_t m_nLODVisibleCounts[CULL_VIEW_COUNT][MESH_MAX_LODS];
+
+	// GPU culling data, while culled on the GPU the object draws indirectly from the culler's buffers instead.
+	GPUCuller* m_gpuCuller;
+	uint32_t m_nGPUDrawIndex;
+	uint32_t m_nGPUSlotBase; // First instance slot of the object in the culler's instance buffers.
+	uint32_t m_nGPUSlotCount; // Instance slots reserved for the object, its instance capacity as of the last layout.
+	DirtyBitset m_gpuInstanceUploads[MAX_FRAMES_IN_FLIGHT]; // Instances yet to be written to each frame's GPU culler instance buffer.
 
 	// Pipeline information.
 	PipelineData* m_pipelineData;
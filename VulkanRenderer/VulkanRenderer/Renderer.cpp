@@ -1,6 +1,8 @@
 #include "Renderer.h"
 #include <set>
 #include <thread>
+#include <algorithm>
+#include <cstring>
 
 #include "LightingManager.h"
 #include "Shader.h"
@@ -10,6 +12,8 @@
 #include "gtc/matrix_transform.hpp"
 
 #include "SubScene.h"
+#include "VertexInfo.h"
+#include "CPUProfiler.h"
 
 #define GLFW_FORCE_RADIANS
 #define GLFW_FORCE_DEPTH_ZERO_TO_ONE
@@ -24,6 +28,9 @@ const DynamicArray<const char*> Renderer::m_deviceExtensions =
 	VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+// Headless renderers never present, so they need no swap chain support.
+const DynamicArray<const char*> Renderer::m_headlessDeviceExtensions;
+
 const RendererHelper::EQueueFamilyFlags Renderer::m_eDesiredQueueFamilies = static_cast<RendererHelper::EQueueFamilyFlags>
 (
     RendererHelper::EQueueFamilyFlags::QUEUE_FAMILY_PRESENT |
@@ -63,13 +70,31 @@ const bool Renderer::m_bEnableValidationLayers = true;
 Renderer::Renderer(GLFWwindow* window)
 {
 	m_window = window;
-	m_extensions = nullptr;
-	m_nExtensionCount = 0;
+	m_bHeadless = false;
 
 	m_nWindowWidth = WINDOW_WIDTH;
 	m_nWindowHeight = WINDOW_HEIGHT;
 
-	m_nSuperSampleLevel = SUPERSAMPLE_LEVEL;
+	Initialize();
+}
+
+Renderer::Renderer(const unsigned int& nWidth, const unsigned int& nHeight)
+{
+	m_window = nullptr;
+	m_bHeadless = true;
+
+	m_nWindowWidth = nWidth;
+	m_nWindowHeight = nHeight;
+
+	Initialize();
+}
+
+inline void Renderer::Initialize()
+{
+	m_extensions = nullptr;
+	m_nExtensionCount = 0;
+
+	m_nMaxRenderScale = MAX_RENDER_SCALE;
 
 	m_instance = VK_NULL_HANDLE;
 	m_physDevice = VK_NULL_HANDLE;
@@ -81,6 +106,20 @@ Renderer::Renderer(GLFWwindow* window)
 
 	m_bMinimized = false;
 
+	m_nElapsedFrames = 0;
+	m_nFrameIndex = 0;
+	m_nPresentImageIndex = 0;
+
+	m_swapChain = VK_NULL_HANDLE;
+	m_windowSurface = VK_NULL_HANDLE;
+	m_bReadback = false;
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		m_readbackBuffers[i] = VK_NULL_HANDLE;
+		m_bReadbackRecorded[i] = false;
+	}
+
 	// Check for validation layer support.
 	CheckValidationLayerSupport();
 
@@ -94,7 +133,8 @@ Renderer::Renderer(GLFWwindow* window)
 	}
 
 	// Window
-	CreateWindowSurface();
+	if (!m_bHeadless)
+		CreateWindowSurface();
 
 	// Phyiscal device
 	GetPhysicalDevice();
@@ -103,15 +143,40 @@ Renderer::Renderer(GLFWwindow* window)
 	CreateLogicalDevice();
 	CreateCommandPools();
 
+	// Pipeline cache, shared by all render modules.
+	m_pipelineCache = new PipelineCache(m_logicDevice, m_physDevice);
+
+	// Job system, the threading backbone shared by all subsystems. hardware_concurrency() may return zero if unknown.
+	m_jobSystem = new JobSystem(std::max(std::thread::hardware_concurrency(), 1u));
+	m_nRecordingThreadCount = std::min(m_jobSystem->ThreadCount(), (uint32_t)MAX_RECORDING_THREADS);
+
+	// Memory allocator
+	m_memAllocator = new MemoryAllocator(m_logicDevice, m_physDevice);
+	m_uploadArena = new UploadArena(this);
+
 	// Get queue handles...
 	vkGetDeviceQueue(m_logicDevice, m_nPresentQueueFamilyIndex, 0, &m_presentQueue);
 	vkGetDeviceQueue(m_logicDevice, m_nGraphicsQueueFamilyIndex, 0, &m_graphicsQueue);
 	vkGetDeviceQueue(m_logicDevice, m_nTransferQueueFamilyIndex, 0, &m_transferQueue);
 	vkGetDeviceQueue(m_logicDevice, m_nComputeQueueFamilyIndex, 0, &m_computeQueue); // May also be the graphics queue.
 
-	// Swap Chain Images
-	CreateSwapChain();
-	CreateSwapChainImageViews();
+	// Asset uploads, copies fall back to the graphics queue if there is no dedicated transfer family.
+	if (m_nTransferQueueFamilyIndex >= 0)
+		m_uploadContext = new UploadContext(this, m_graphicsQueue, m_nGraphicsQueueFamilyIndex, m_transferQueue, m_nTransferQueueFamilyIndex);
+	else
+		m_uploadContext = new UploadContext(this, m_graphicsQueue, m_nGraphicsQueueFamilyIndex, m_graphicsQueue, m_nGraphicsQueueFamilyIndex);
+
+	// GPU timestamps of the graphics queue.
+	m_gpuProfiler = new GPUProfiler(this, m_nGraphicsQueueFamilyIndex);
+
+	// Swap Chain Images, or offscreen output images in their place.
+	if (m_bHeadless)
+		CreateOffscreenImages();
+	else
+	{
+		CreateSwapChain();
+		CreateSwapChainImageViews();
+	}
 
 	EGBufferAttachmentTypeBit gBufferBits = (EGBufferAttachmentTypeBit)(GBUFFER_COLOR_BIT | GBUFFER_COLOR_HDR_BIT | GBUFFER_DEPTH_BIT | GBUFFER_POSITION_BIT | GBUFFER_NORMAL_BIT);
 
@@ -144,6 +209,28 @@ Renderer::~Renderer()
 	// Destroy command pools.
 	vkDestroyCommandPool(m_logicDevice, m_mainGraphicsCommandPool, nullptr);
 
+	// Headless output images are sub-allocated, so they must be freed before the allocator is destroyed.
+	if (m_bHeadless)
+		DestroyOffscreenImages();
+
+	// Meshes are destroyed, but their pools' buffers remain until now.
+	for (GeometryPool* pool : m_geometryPools)
+		delete pool;
+
+	delete m_uploadContext;
+	delete m_uploadArena;
+
+	delete m_gpuProfiler;
+
+	// Write pipeline cache to disk.
+	delete m_pipelineCache;
+
+	delete m_jobSystem;
+
+	// Free all remaining device memory blocks.
+	m_memAllocator->PrintStats();
+	delete m_memAllocator;
+
 	delete[] m_extensions;
 	m_extensions = nullptr;
 
@@ -151,18 +238,22 @@ Renderer::~Renderer()
 	if(m_bEnableValidationLayers)
 	    RendererHelper::DestroyDebugUtilsMessengerEXT(m_instance, nullptr, &m_messenger);
 
-	// Destroy image views.
-	for (uint32_t i = 0; i < m_swapChainImageViews.Count(); ++i)
-		vkDestroyImageView(m_logicDevice, m_swapChainImageViews[i], nullptr);
+	if(!m_bHeadless)
+	{
+		// Destroy image views.
+		for (uint32_t i = 0; i < m_swapChainImageViews.Count(); ++i)
+			vkDestroyImageView(m_logicDevice, m_swapChainImageViews[i], nullptr);
 
-	// Destroy swap chain.
-	vkDestroySwapchainKHR(m_logicDevice, m_swapChain, nullptr);
+		// Destroy swap chain.
+		vkDestroySwapchainKHR(m_logicDevice, m_swapChain, nullptr);
+	}
 
 	// Destroy logical device.
 	vkDestroyDevice(m_logicDevice, nullptr);
 
 	// Destroy window surface.
-	vkDestroySurfaceKHR(m_instance, m_windowSurface, nullptr);
+	if (!m_bHeadless)
+		vkDestroySurfaceKHR(m_instance, m_windowSurface, nullptr);
 
 	// Destroy Vulkan instance.
 	vkDestroyInstance(m_instance, nullptr);
@@ -203,42 +294,51 @@ void Renderer::ResizeWindow(const unsigned int& nWidth, const unsigned int& nHei
 	// Wait for device to idle.
 	vkDeviceWaitIdle(m_logicDevice);
 
-	// Destroy swap chain image views.
-	for (uint32_t i = 0; i < m_swapChainImageViews.Count(); ++i)
+	if(m_bHeadless)
 	{
-		vkDestroyImageView(m_logicDevice, m_swapChainImageViews[i], nullptr);
-		m_swapChainImageViews[i] = nullptr;
+		// Headless output images have no surface, they are simply re-created at the new size.
+		DestroyOffscreenImages();
+		CreateOffscreenImages();
 	}
+	else
+	{
+		// Destroy swap chain image views.
+		for (uint32_t i = 0; i < m_swapChainImageViews.Count(); ++i)
+		{
+			vkDestroyImageView(m_logicDevice, m_swapChainImageViews[i], nullptr);
+			m_swapChainImageViews[i] = nullptr;
+		}
 
-	// Destroy swap chain.
-	vkDestroySwapchainKHR(m_logicDevice, m_swapChain, nullptr);
-	m_swapChain = nullptr;
+		// Destroy swap chain.
+		vkDestroySwapchainKHR(m_logicDevice, m_swapChain, nullptr);
+		m_swapChain = nullptr;
 
-	if(bNewSurface) 
-	{
-		// Destroy window surface.
-		vkDestroySurfaceKHR(m_instance, m_windowSurface, nullptr);
-	}
+		if(bNewSurface) 
+		{
+			// Destroy window surface.
+			vkDestroySurfaceKHR(m_instance, m_windowSurface, nullptr);
+		}
 
-	// ---------------------------------------------------------------------------------------------------------
-	// Recreation
+		// ---------------------------------------------------------------------------------------------------------
+		// Recreation
 
-	if(bNewSurface) 
-	{
-		// Create new window surface.
-		CreateWindowSurface();
+		if(bNewSurface) 
+		{
+			// Create new window surface.
+			CreateWindowSurface();
 
-		// Check for surface present suppport.
-		VkBool32 hasPresentSupport = VK_FALSE;
-	    RENDERER_SAFECALL(vkGetPhysicalDeviceSurfaceSupportKHR(m_physDevice, m_nPresentQueueFamilyIndex, m_windowSurface, &hasPresentSupport), "Renderer Error: Failed to get surface support confirmation on new window surface.");
+			// Check for surface present suppport.
+			VkBool32 hasPresentSupport = VK_FALSE;
+		    RENDERER_SAFECALL(vkGetPhysicalDeviceSurfaceSupportKHR(m_physDevice, m_nPresentQueueFamilyIndex, m_windowSurface, &hasPresentSupport), "Renderer Error: Failed to get surface support confirmation on new window surface.");
 
-		if (!hasPresentSupport)
-			throw std::runtime_error("Renderer Error: Fullscreen window does not support new surface.");
-	}
+			if (!hasPresentSupport)
+				throw std::runtime_error("Renderer Error: Fullscreen window does not support new surface.");
+		}
 
-	// Recreate swap chain and swap chain images.
-	CreateSwapChain();
-	CreateSwapChainImageViews();
+		// Recreate swap chain and swap chain images.
+		CreateSwapChain();
+		CreateSwapChainImageViews();
+	}
 
 	// ---------------------------------------------------------------------------------------------------------
 	// Semaphore recreation.
@@ -259,7 +359,11 @@ void Renderer::ResizeWindow(const unsigned int& nWidth, const unsigned int& nHei
 	m_nFrameIndex = 1;
 
 	// Re-create subscenes.
-	m_scene->ResizeOutput(m_nWindowWidth * m_nSuperSampleLevel, m_nWindowHeight * m_nSuperSampleLevel);
+	m_pipelineCache->ResetStats();
+
+	m_scene->ResizeOutput(m_nWindowWidth * m_nMaxRenderScale, m_nWindowHeight * m_nMaxRenderScale);
+
+	m_pipelineCache->PrintStats("Resize");
 }
 
 Scene* Renderer::GetScene()
@@ -307,9 +411,11 @@ void Renderer::CreateVKInstance()
 #endif
 
 	unsigned int glfwExtensionCount = 0;
-	const char** glfwExtensions;
+	const char** glfwExtensions = nullptr;
 
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	// Surface extensions, headless renderers have no surface & may run without GLFW initialized.
+	if (!m_bHeadless)
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
 #ifdef RENDERER_DEBUG
 	// Expand array by 1...
@@ -394,10 +500,13 @@ void Renderer::GetPhysicalDevice()
 	RENDERER_SAFECALL(vkEnumeratePhysicalDevices(m_instance, &nDeviceCount, devices.Data()), "Renderer Error: Failed to obtain physical device data.");
 
 	// Check if devices are suitable and the first suitable device.
+	const DynamicArray<const char*>& deviceExtensions = m_bHeadless ? m_headlessDeviceExtensions : m_deviceExtensions;
+
 	int bestScore = 0;
 	for(unsigned int i = 0; i < nDeviceCount; ++i)
 	{
-		int suitabilityScore = RendererHelper::DeviceSuitable(m_windowSurface, devices[i], m_deviceExtensions, m_eDesiredQueueFamilies);
+		// Headless renderers have a null surface, so present support is not required.
+		int suitabilityScore = RendererHelper::DeviceSuitable(m_windowSurface, devices[i], deviceExtensions, m_eDesiredQueueFamilies);
 		if (suitabilityScore > bestScore) 
 		{
 			m_physDevice = devices[i];
@@ -412,6 +521,10 @@ void Renderer::GetPhysicalDevice()
 	m_nComputeQueueFamilyIndex = indices.m_nComputeFamilyIndex;
 	m_nTransferQueueFamilyIndex = indices.m_nTransferFamilyIndex;
 
+	// Nothing is presented when headless, the present queue is just an alias of the graphics queue.
+	if (m_bHeadless)
+		m_nPresentQueueFamilyIndex = m_nGraphicsQueueFamilyIndex;
+
 	if (m_physDevice == VK_NULL_HANDLE)
 		throw std::runtime_error("Renderer Error: Failed to find suitable GPU!");
 }
@@ -439,13 +552,17 @@ void Renderer::CreateLogicalDevice()
 	vkGetPhysicalDeviceFeatures(m_physDevice, &features);
 	features.samplerAnisotropy = VK_TRUE;
 
+	m_bMultiDrawIndirect = features.multiDrawIndirect && features.drawIndirectFirstInstance;
+
 	VkDeviceCreateInfo logicDeviceCreateInfo = {};
 	logicDeviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	logicDeviceCreateInfo.pQueueCreateInfos = queueCreateInfos.Data();
 	logicDeviceCreateInfo.queueCreateInfoCount = queueCreateInfos.Count();
 	logicDeviceCreateInfo.pEnabledFeatures = &features;
-	logicDeviceCreateInfo.enabledExtensionCount = m_deviceExtensions.Count();
-	logicDeviceCreateInfo.ppEnabledExtensionNames = m_deviceExtensions.Data();
+	const DynamicArray<const char*>& deviceExtensions = m_bHeadless ? m_headlessDeviceExtensions : m_deviceExtensions;
+
+	logicDeviceCreateInfo.enabledExtensionCount = deviceExtensions.Count();
+	logicDeviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.Data();
 
 	// Logical device validation layers
 	if (m_bEnableValidationLayers)
@@ -561,6 +678,52 @@ void Renderer::CreateSwapChainImageViews()
 	}
 }
 
+void Renderer::CreateOffscreenImages()
+{
+	m_swapChainImageExtents = { m_nWindowWidth, m_nWindowHeight };
+	m_swapChainImageFormat = HEADLESS_OUTPUT_FORMAT;
+
+	// One output image per frame-in-flight, so a frame never renders to an image that is still being read back.
+	m_swapChainImages.SetSize(MAX_FRAMES_IN_FLIGHT);
+	m_swapChainImages.SetCount(MAX_FRAMES_IN_FLIGHT);
+	m_swapChainImageViews.SetSize(MAX_FRAMES_IN_FLIGHT);
+	m_swapChainImageViews.SetCount(MAX_FRAMES_IN_FLIGHT);
+
+	// Tightly packed texels of HEADLESS_OUTPUT_FORMAT.
+	VkDeviceSize nReadbackSize = static_cast<VkDeviceSize>(m_nWindowWidth) * m_nWindowHeight * 4;
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		// Transfer dst for blits & transfer src for readback, as with swap chain images.
+		CreateImage(m_swapChainImages[i], m_offscreenImageMemories[i], m_nWindowWidth, m_nWindowHeight, HEADLESS_OUTPUT_FORMAT, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+		CreateImageView(m_swapChainImages[i], m_swapChainImageViews[i], HEADLESS_OUTPUT_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		CreateBuffer(nReadbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_readbackBuffers[i], m_readbackMemories[i]);
+
+		m_bReadbackRecorded[i] = false;
+	}
+}
+
+void Renderer::DestroyOffscreenImages()
+{
+	for (uint32_t i = 0; i < m_swapChainImages.Count(); ++i)
+	{
+		vkDestroyImageView(m_logicDevice, m_swapChainImageViews[i], nullptr);
+		vkDestroyImage(m_logicDevice, m_swapChainImages[i], nullptr);
+		FreeMemory(m_offscreenImageMemories[i]);
+
+		vkDestroyBuffer(m_logicDevice, m_readbackBuffers[i], nullptr);
+		FreeMemory(m_readbackMemories[i]);
+
+		m_readbackBuffers[i] = VK_NULL_HANDLE;
+	}
+
+	m_swapChainImages.Clear();
+	m_swapChainImageViews.Clear();
+}
+
 void Renderer::CreateCommandPools() 
 {
 	// ==================================================================================================================================================
@@ -595,6 +758,8 @@ void Renderer::CreateSyncObjects()
 
 void Renderer::Begin() 
 {
+	CPU_PROFILE_ZONE("Renderer::Begin");
+
 	// Do not attempt to render to a zero sized window.
 	if (m_bMinimized)
 		return;
@@ -608,6 +773,13 @@ void Renderer::Begin()
 	vkWaitForFences(m_logicDevice, 1, &m_inFlightFences[m_nFrameIndex], VK_TRUE, ~(0ULL));
 	vkResetFences(m_logicDevice, 1, &m_inFlightFences[m_nFrameIndex]);
 
+	// Headless renderers have an output image per frame-in-flight, which the fence waited on above already guards.
+	if(m_bHeadless)
+	{
+		m_nPresentImageIndex = m_nFrameIndex;
+		return;
+	}
+
 	// ----------------------------------------------------------------------------------------------
 	// Aquire next image to render to from the swap chain.
 
@@ -617,6 +789,8 @@ void Renderer::Begin()
 
 void Renderer::End()
 {
+	CPU_PROFILE_ZONE("Renderer::End");
+
 	// Do not attempt to render to a zero sized window.
 	if (m_bMinimized)
 		return;
@@ -626,7 +800,18 @@ void Renderer::End()
 	
 	VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
 
-	m_scene->DrawSubscenes(m_nPresentImageIndex, m_nElapsedFrames, m_nFrameIndex, m_imageAvailableSemaphores[m_nFrameIndex], renderFinishedSemaphore, m_inFlightFences[m_nFrameIndex]);
+	// Submit assets uploaded since the last frame ahead of the frame's commands, and free staging memory of completed uploads.
+	m_uploadContext->Submit();
+	m_uploadContext->Poll();
+
+	// No image is acquired when headless, so there is nothing to wait on.
+	VkSemaphore imageAvailableSemaphore = m_bHeadless ? VK_NULL_HANDLE : m_imageAvailableSemaphores[m_nFrameIndex];
+
+	m_scene->DrawSubscenes(m_nPresentImageIndex, m_nElapsedFrames, m_nFrameIndex, imageAvailableSemaphore, renderFinishedSemaphore, m_inFlightFences[m_nFrameIndex]);
+
+	// Headless frames are complete once their fence is signaled, there is nothing to present.
+	if (m_bHeadless)
+		return;
 
 	// ----------------------------------------------------------------------------------------------
 	// Submit rendered frame to the swap chain for presentation.
@@ -655,6 +840,84 @@ void Renderer::End()
 	// ----------------------------------------------------------------------------------------------
 }
 
+void Renderer::WaitForFrame(bool bLatest)
+{
+	CPU_PROFILE_ZONE("Renderer::WaitForFrame");
+
+	if (m_bMinimized)
+		return;
+
+	// The fence Begin() waits on next, or the fence of the frame last submitted by End(). Fences are created signaled, so this never waits on an unsubmitted frame.
+	uint32_t nFrameIndex = static_cast<uint32_t>((bLatest ? m_nElapsedFrames + MAX_FRAMES_IN_FLIGHT - 1 : m_nElapsedFrames) % MAX_FRAMES_IN_FLIGHT);
+
+	vkWaitForFences(m_logicDevice, 1, &m_inFlightFences[nFrameIndex], VK_TRUE, ~(0ULL));
+}
+
+void Renderer::SetOutputReadback(bool bEnabled)
+{
+	m_bReadback = bEnabled;
+}
+
+bool Renderer::ReadOutput(void* outPixels)
+{
+	// The most recently submitted frame, nothing has been submitted since creation or a resize if no frames have elapsed.
+	if (!m_bHeadless || m_nElapsedFrames == 0 || !m_bReadbackRecorded[m_nFrameIndex])
+		return false;
+
+	vkWaitForFences(m_logicDevice, 1, &m_inFlightFences[m_nFrameIndex], VK_TRUE, ~(0ULL));
+
+	// The readback memory is host coherent & persistently mapped.
+	std::memcpy(outPixels, m_readbackMemories[m_nFrameIndex].m_mappedPtr, m_swapChainImageExtents.width * m_swapChainImageExtents.height * 4);
+
+	return true;
+}
+
+void Renderer::RecordOutputReadback(VkCommandBuffer cmdBuf, const uint32_t& nImageIndex, const uint32_t& nFrameIndex)
+{
+	m_bReadbackRecorded[nFrameIndex] = m_bHeadless && m_bReadback;
+
+	if (!m_bReadbackRecorded[nFrameIndex])
+		return;
+
+	// ----------------------------------------------------------------------------------------------
+	// Wait for the output image's final writes, from either the output render pass or the blit.
+
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = m_swapChainImages[nImageIndex];
+	imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	// ----------------------------------------------------------------------------------------------
+	// Copy the image to the frame's readback buffer, tightly packed.
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.imageExtent = { m_swapChainImageExtents.width, m_swapChainImageExtents.height, 1 };
+
+	vkCmdCopyImageToBuffer(cmdBuf, m_swapChainImages[nImageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_readbackBuffers[nFrameIndex], 1, &copyRegion);
+
+	// Make the copy visible to the host once the frame's fence is signaled.
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = m_readbackBuffers[nFrameIndex];
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+}
+
 void Renderer::WaitGraphicsIdle() 
 {
 	vkQueueWaitIdle(m_graphicsQueue);
@@ -683,7 +946,7 @@ unsigned int Renderer::FindMemoryType(unsigned int typeFilter, VkMemoryPropertyF
 	return 0;
 }
 
-void Renderer::CreateBuffer(const unsigned long long& size, const VkBufferUsageFlags& bufferUsage, VkMemoryPropertyFlags properties, VkBuffer& bufferHandle, VkDeviceMemory& bufferMemory)
+void Renderer::CreateBuffer(const unsigned long long& size, const VkBufferUsageFlags& bufferUsage, VkMemoryPropertyFlags properties, VkBuffer& bufferHandle, MemAllocation& bufferMemory, bool bShareWithCompute)
 {
 	VkBufferCreateInfo bufCreateInfo = {};
 	bufCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -691,6 +954,16 @@ void Renderer::CreateBuffer(const unsigned long long& size, const VkBufferUsageF
 	bufCreateInfo.usage = bufferUsage;
 	bufCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+	uint32_t sharedFamilies[] = { static_cast<uint32_t>(m_nGraphicsQueueFamilyIndex), static_cast<uint32_t>(m_nComputeQueueFamilyIndex) };
+
+	// Only distinct families need concurrent sharing.
+	if(bShareWithCompute && m_nGraphicsQueueFamilyIndex != m_nComputeQueueFamilyIndex)
+	{
+		bufCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufCreateInfo.queueFamilyIndexCount = 2;
+		bufCreateInfo.pQueueFamilyIndices = sharedFamilies;
+	}
+
 	// Create buffer object.
 	RENDERER_SAFECALL(vkCreateBuffer(m_logicDevice, &bufCreateInfo, nullptr, &bufferHandle), "Mesh Error: Failed to create buffer.");
 
@@ -698,19 +971,14 @@ void Renderer::CreateBuffer(const unsigned long long& size, const VkBufferUsageF
 	VkMemoryRequirements memRequirements;
 	vkGetBufferMemoryRequirements(m_logicDevice, bufferHandle, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-	allocInfo.pNext = nullptr;
-
-	RENDERER_SAFECALL(vkAllocateMemory(m_logicDevice, &allocInfo, nullptr, &bufferMemory), "Mesh Error: Failed to allocate buffer memory.");
+	// Sub-allocate memory for the buffer.
+	m_memAllocator->Allocate(memRequirements, properties, MEMORY_POOL_LINEAR, bufferMemory);
 
-	// Associate the newly allocated memory with the buffer object.
-	vkBindBufferMemory(m_logicDevice, bufferHandle, bufferMemory, 0);
+	// Associate the allocated memory with the buffer object.
+	vkBindBufferMemory(m_logicDevice, bufferHandle, bufferMemory.m_memory, bufferMemory.m_nOffset);
 }
 
-void Renderer::CreateImage(VkImage& image, VkDeviceMemory& imageMemory, const uint32_t& nWidth, const uint32_t& nHeight, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage)
+void Renderer::CreateImage(VkImage& image, MemAllocation& imageMemory, const uint32_t& nWidth, const uint32_t& nHeight, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage)
 {
 	VkImageCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -731,18 +999,36 @@ void Renderer::CreateImage(VkImage& image, VkDeviceMemory& imageMemory, const ui
 	// Create image.
 	RENDERER_SAFECALL(vkCreateImage(m_logicDevice, &createInfo, nullptr, &image), "Renderer Error: Failed to create image object.");
 
+	AllocateImageMemory(image, tiling, imageMemory);
+}
+
+bool Renderer::AllocateImageMemory(VkImage image, VkImageTiling tiling, MemAllocation& imageMemory, bool bLazilyAllocated)
+{
 	VkMemoryRequirements imageMemRequirements;
 	vkGetImageMemoryRequirements(m_logicDevice, image, &imageMemRequirements);
 
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = imageMemRequirements.size;
-	allocInfo.memoryTypeIndex = FindMemoryType(imageMemRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	// Linearly tiled images may share blocks with buffers, optimally tiled images are kept apart to respect bufferImageGranularity.
+	EMemoryPool ePool = tiling == VK_IMAGE_TILING_LINEAR ? MEMORY_POOL_LINEAR : MEMORY_POOL_OPTIMAL;
+
+	// Lazily allocated memory is only committed when the driver needs it, tile based GPUs can keep transient attachments in tile memory without ever backing them.
+	// Most desktop GPUs have no such memory type, transient images then fall back to regular device local memory.
+	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	bLazilyAllocated = bLazilyAllocated && m_memAllocator->HasMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, imageMemRequirements.memoryTypeBits);
 
-	RENDERER_SAFECALL(vkAllocateMemory(m_logicDevice, &allocInfo, nullptr, &imageMemory), "Renderer Error: Failed to allocate texture image memory.");
+	if (bLazilyAllocated)
+		properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+	m_memAllocator->Allocate(imageMemRequirements, properties, ePool, imageMemory);
 
 	// Bind image memory to the image.
-	vkBindImageMemory(m_logicDevice, image, imageMemory, 0);
+	vkBindImageMemory(m_logicDevice, image, imageMemory.m_memory, imageMemory.m_nOffset);
+
+	return bLazilyAllocated;
+}
+
+void Renderer::FreeMemory(MemAllocation& memory)
+{
+	m_memAllocator->Free(memory);
 }
 
 void Renderer::CreateImageView(const VkImage& image, VkImageView& view, VkFormat format, VkImageAspectFlags aspectFlags) 
@@ -817,19 +1103,102 @@ VkCommandPool Renderer::GetCommandPool()
 	return m_mainGraphicsCommandPool;
 }
 
+MemoryAllocator* Renderer::GetMemoryAllocator()
+{
+	return m_memAllocator;
+}
+
+UploadArena* Renderer::GetUploadArena()
+{
+	return m_uploadArena;
+}
+
+UploadContext* Renderer::GetUploadContext()
+{
+	return m_uploadContext;
+}
+
+GeometryPool* Renderer::GetGeometryPool(const VertexInfo* format, uint32_t nVertexStride)
+{
+	for (GeometryPool* pool : m_geometryPools)
+	{
+		if (pool->FormatNameID() == format->NameID() && pool->VertexStride() == nVertexStride)
+			return pool;
+	}
+
+	m_geometryPools.push_back(new GeometryPool(this, format->NameID(), nVertexStride));
+	return m_geometryPools.back();
+}
+
+PipelineCache* Renderer::GetPipelineCache()
+{
+	return m_pipelineCache;
+}
+
+GPUProfiler* Renderer::GetGPUProfiler()
+{
+	return m_gpuProfiler;
+}
+
+JobSystem* Renderer::GetJobSystem()
+{
+	return m_jobSystem;
+}
+
+VkQueue Renderer::GetComputeQueue()
+{
+	return m_computeQueue;
+}
+
+uint32_t Renderer::GraphicsQueueFamilyIndex() const
+{
+	return static_cast<uint32_t>(m_nGraphicsQueueFamilyIndex);
+}
+
+uint32_t Renderer::ComputeQueueFamilyIndex() const
+{
+	return static_cast<uint32_t>(m_nComputeQueueFamilyIndex);
+}
+
+void Renderer::SetRecordingThreadCount(uint32_t nThreadCount)
+{
+	m_nRecordingThreadCount = std::max(std::min(nThreadCount, (uint32_t)MAX_RECORDING_THREADS), 1u);
+}
+
+uint32_t Renderer::RecordingThreadCount() const
+{
+	return m_nRecordingThreadCount;
+}
+
+bool Renderer::IsHeadless() const
+{
+	return m_bHeadless;
+}
+
+bool Renderer::MultiDrawIndirectSupported() const
+{
+	return m_bMultiDrawIndirect;
+}
+
+VkImageLayout Renderer::OutputImageLayout() const
+{
+	// The present layout is only valid with the swap chain extension, which headless devices may not support.
+	return m_bHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+}
+
 uint32_t Renderer::FrameWidth() const
 {
-	return m_swapChainImageExtents.width * m_nSuperSampleLevel;
+	return m_swapChainImageExtents.width * m_nMaxRenderScale;
 }
 
 uint32_t Renderer::FrameHeight() const
 {
-	return m_swapChainImageExtents.height * m_nSuperSampleLevel;
+	return m_swapChainImageExtents.height * m_nMaxRenderScale;
 }
 
-uint32_t Renderer::SuperSampleLevel() const
+uint32_t Renderer::MaxRenderScale() const
 {
-	return m_nSuperSampleLevel;
+	return m_nMaxRenderScale;
 }
 
 const unsigned int Renderer::SwapChainImageCount() const
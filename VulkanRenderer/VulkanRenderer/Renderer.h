@@ -6,6 +6,13 @@
 #include <thread>
 
 #include "RendererHelper.h"
+#include "MemoryAllocator.h"
+#include "UploadArena.h"
+#include "UploadContext.h"
+#include "PipelineCache.h"
+#include "JobSystem.h"
+#include "GPUProfiler.h"
+#include "GeometryPool.h"
 
 #include "DynamicArray.h"
 #include "Queue.h"
@@ -17,19 +24,29 @@
 #define WINDOW_WIDTH 1280
 #define WINDOW_HEIGHT 720
 
-#define SUPERSAMPLE_LEVEL 2
+// Render attachments are allocated at this multiple of the swap chain size, the dynamic render scale never exceeds it.
+#define MAX_RENDER_SCALE 2
+
+// Lowest dynamic render scale, relative to the swap chain size.
+#define MIN_RENDER_SCALE 0.5f
+
+// GPU frame time in milliseconds the dynamic render scale is adjusted towards.
+#define TARGET_GPU_FRAME_TIME 16.0
 
 #define MAX_FRAMES_IN_FLIGHT 2
 #define MAX_CONCURRENT_COPIES MAX_FRAMES_IN_FLIGHT
 
-#define SHADOW_MAPPING_SUBPASS_INDEX 0 
-#define G_BUFFER_SUBPASS_INDEX 1
-#define LIGHTING_SUBPASS_INDEX 2
+// Maximum amount of secondary command buffers a render module may record in parallel each frame.
+#define MAX_RECORDING_THREADS 8
+
+// Format of the output images rendered to by headless renderers, in place of swap chain images.
+#define HEADLESS_OUTPUT_FORMAT VK_FORMAT_R8G8B8A8_UNORM
 
 class Scene;
 class LightingManager;
 class RenderObject;
 class Texture;
+class VertexInfo;
 
 struct Shader;
 
@@ -46,6 +63,9 @@ public:
 
 	Renderer(GLFWwindow* window);
 
+	// Create a headless renderer, which renders to offscreen output images of the provided size instead of a window's swap chain. Needs no window system or present support.
+	Renderer(const unsigned int& nWidth, const unsigned int& nHeight);
+
     ~Renderer();
 
 	// Functionality
@@ -63,6 +83,27 @@ public:
 	// End the main render pass.
 	void End();
 
+	/*
+	Description: Wait for the GPU to finish a submitted frame ahead of Begin(), so Begin() doesn't block after input for the next frame was sampled.
+	Param:
+	    bool bLatest: Wait for the most recently submitted frame rather than the frame-in-flight Begin() waits on, so no frames are queued ahead of the GPU.
+	*/
+	void WaitForFrame(bool bLatest);
+
+	// Copy the output image of each headless frame to host memory, so it can be read with ReadOutput().
+	void SetOutputReadback(bool bEnabled);
+
+	/*
+	Description: Wait for the most recently submitted headless frame to complete & copy its output image, returns false if it was rendered without readback.
+	Return Type: bool
+	Param:
+	    void* outPixels: Destination of the pixels, tightly packed rows of HEADLESS_OUTPUT_FORMAT texels the size of SwapChainImageExtents().
+	*/
+	bool ReadOutput(void* outPixels);
+
+	// Record the copy of a headless output image to its frame's readback buffer, if readback is enabled. The image must be in OutputImageLayout().
+	void RecordOutputReadback(VkCommandBuffer cmdBuf, const uint32_t& nImageIndex, const uint32_t& nFrameIndex);
+
 	// Wait for the graphics queue to be idle.
 	void WaitGraphicsIdle();
 
@@ -72,11 +113,18 @@ public:
 	// Find the optimal memory type for allocating buffer memory.
 	unsigned int FindMemoryType(unsigned int typeFilter, VkMemoryPropertyFlags propertyFlags);
 
-	// Create a buffer with the provided size, usage flags, memory property flags, buffer and memory handles.
-	void CreateBuffer(const unsigned long long& size, const VkBufferUsageFlags& bufferUsage, VkMemoryPropertyFlags properties, VkBuffer& bufferHandle, VkDeviceMemory& bufferMemory);
+	// Create a buffer with the provided size, usage flags, memory property flags, buffer and memory handles. Memory is sub-allocated from the renderer's memory allocator.
+	// Buffers shared with the compute queue may be accessed by both the graphics & compute queue families without ownership transfers.
+	void CreateBuffer(const unsigned long long& size, const VkBufferUsageFlags& bufferUsage, VkMemoryPropertyFlags properties, VkBuffer& bufferHandle, MemAllocation& bufferMemory, bool bShareWithCompute = false);
 
 	// Create an image with the specified width, height, format, tiling and usage flags.
-	void CreateImage(VkImage& image, VkDeviceMemory& imageMemory, const uint32_t& nWidth, const uint32_t& nHeight, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage);
+	void CreateImage(VkImage& image, MemAllocation& imageMemory, const uint32_t& nWidth, const uint32_t& nHeight, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage);
+
+	// Allocate & bind device local memory for an already created image. Lazily allocated memory is used if requested & supported, returns whether or not it was used.
+	bool AllocateImageMemory(VkImage image, VkImageTiling tiling, MemAllocation& imageMemory, bool bLazilyAllocated = false);
+
+	// Return memory allocated by CreateBuffer or CreateImage to the memory allocator.
+	void FreeMemory(MemAllocation& memory);
 
 	// Create an image view for the specified image.
 	void CreateImageView(const VkImage& image, VkImageView& view, VkFormat format, VkImageAspectFlags aspectFlags);
@@ -100,11 +148,48 @@ public:
 
 	VkCommandPool GetCommandPool();
 
+	MemoryAllocator* GetMemoryAllocator();
+
+	UploadArena* GetUploadArena();
+
+	UploadContext* GetUploadContext();
+
+	// Get the geometry pool shared by meshes of a vertex format, created on first use.
+	GeometryPool* GetGeometryPool(const VertexInfo* format, uint32_t nVertexStride);
+
+	PipelineCache* GetPipelineCache();
+
+	JobSystem* GetJobSystem();
+
+	GPUProfiler* GetGPUProfiler();
+
+	// Queue for compute work, may be the graphics queue.
+	VkQueue GetComputeQueue();
+
+	uint32_t GraphicsQueueFamilyIndex() const;
+
+	uint32_t ComputeQueueFamilyIndex() const;
+
+	// Set the amount of threads render modules may record command buffers on, clamped to [1, MAX_RECORDING_THREADS].
+	void SetRecordingThreadCount(uint32_t nThreadCount);
+
+	uint32_t RecordingThreadCount() const;
+
+	// Whether or not this renderer renders to offscreen output images instead of a swap chain.
+	bool IsHeadless() const;
+
+	// Whether or not a single indirect draw command may draw multiple commands with their own first instance, requires the multiDrawIndirect & drawIndirectFirstInstance features.
+	bool MultiDrawIndirectSupported() const;
+
+	// Layout the primary subscene leaves output images in once rendered, ready to present or, for offscreen output images, to read back.
+	VkImageLayout OutputImageLayout() const;
+
 	uint32_t FrameWidth() const;
 
 	uint32_t FrameHeight() const;
 
-	uint32_t SuperSampleLevel() const;
+	// Multiple of the swap chain size render attachments are allocated at.
+	uint32_t MaxRenderScale() const;
 
 	const unsigned int SwapChainImageCount() const;
 
@@ -135,6 +220,9 @@ private:
 	// -----------------------------------------------------------------------------------------------------
 	// Initialization functions
 
+	// Create the instance, device & all subsystems, shared by the windowed & headless constructors.
+	inline void Initialize();
+
 	// Create Vulkan instance.
 	inline void CreateVKInstance();
 
@@ -156,6 +244,12 @@ private:
 	// Create swapchain image views.
 	inline void CreateSwapChainImageViews();
 
+	// Create headless output images & their readback buffers, in place of a swap chain.
+	inline void CreateOffscreenImages();
+
+	// Destroy headless output images & their readback buffers.
+	inline void DestroyOffscreenImages();
+
 	// Create command pools.
 	inline void CreateCommandPools();
 
@@ -179,7 +273,10 @@ private:
 	unsigned int m_nWindowWidth;
 	unsigned int m_nWindowHeight;
 
-	uint32_t m_nSuperSampleLevel;
+	bool m_bHeadless; // Rendering to offscreen output images, without a window, surface or swap chain.
+	bool m_bMultiDrawIndirect;
+
+	uint32_t m_nMaxRenderScale;
 
 	// -----------------------------------------------------------------------------------------------------
 	// Validation layers
@@ -193,6 +290,7 @@ private:
 	// Device extensions
 
 	static const DynamicArray<const char*> m_deviceExtensions;
+	static const DynamicArray<const char*> m_headlessDeviceExtensions;
 
 	// -----------------------------------------------------------------------------------------------------
 	// Vulkan Instance & Devices
@@ -201,6 +299,30 @@ private:
 	VkPhysicalDevice m_physDevice;
 	VkDevice m_logicDevice;
 
+	// -----------------------------------------------------------------------------------------------------
+	// Memory
+
+	MemoryAllocator* m_memAllocator;
+	UploadArena* m_uploadArena; // Per-frame buffer update staging.
+	UploadContext* m_uploadContext; // Batched asset uploads.
+	std::vector<GeometryPool*> m_geometryPools; // Shared mesh buffers, one pool per vertex format.
+
+	// -----------------------------------------------------------------------------------------------------
+	// Pipelines
+
+	PipelineCache* m_pipelineCache;
+
+	// -----------------------------------------------------------------------------------------------------
+	// Threading
+
+	JobSystem* m_jobSystem;
+	uint32_t m_nRecordingThreadCount;
+
+	// -----------------------------------------------------------------------------------------------------
+	// Profiling
+
+	GPUProfiler* m_gpuProfiler;
+
 	// -----------------------------------------------------------------------------------------------------
 	// Queue families.
 
@@ -229,6 +351,15 @@ private:
 	DynamicArray<VkImage> m_swapChainImages;
 	DynamicArray<VkImageView> m_swapChainImageViews;
 
+	// -----------------------------------------------------------------------------------------------------
+	// Headless output images, one per frame-in-flight, taking the place of swap chain images.
+
+	MemAllocation m_offscreenImageMemories[MAX_FRAMES_IN_FLIGHT];
+	VkBuffer m_readbackBuffers[MAX_FRAMES_IN_FLIGHT];
+	MemAllocation m_readbackMemories[MAX_FRAMES_IN_FLIGHT];
+	bool m_bReadbackRecorded[MAX_FRAMES_IN_FLIGHT]; // Whether or not the frame's output was copied to its readback buffer.
+	bool m_bReadback;
+
 	// -----------------------------------------------------------------------------------------------------
 	// Commands
 
@@ -1,4 +1,6 @@
 #include "RendererHelper.h"
+#include <fstream>
+#include <vector>
 
 VkFormat RendererHelper::FindBestDepthFormat(VkPhysicalDevice physDevice, DynamicArray<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags features)
 {
@@ -23,6 +25,33 @@ VkFormat RendererHelper::FindBestDepthFormat(VkPhysicalDevice physDevice, Dynami
 	return formats[0];
 }
 
+VkShaderModule RendererHelper::CreateShaderModule(VkDevice device, const char* szPath)
+{
+	std::ifstream shaderFile(szPath, std::ios::binary | std::ios::ate);
+
+	if (!shaderFile.good())
+		return VK_NULL_HANDLE;
+
+	// Start at the end of the file so that tellg() returns the size of the file.
+	const int nFileSize = static_cast<int>(shaderFile.tellg());
+
+	std::vector<char> contents(nFileSize);
+
+	shaderFile.seekg(0);
+	shaderFile.read(contents.data(), nFileSize);
+	shaderFile.close();
+
+	VkShaderModuleCreateInfo modCreateInfo = {};
+	modCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	modCreateInfo.codeSize = nFileSize;
+	modCreateInfo.pCode = reinterpret_cast<const uint32_t*>(contents.data());
+
+	VkShaderModule shaderModule = VK_NULL_HANDLE;
+	RENDERER_SAFECALL(vkCreateShaderModule(device, &modCreateInfo, nullptr, &shaderModule), "Renderer Error: Failed to create shader module.");
+
+	return shaderModule;
+}
+
 bool RendererHelper::CheckDeviceExtensionSupport(const DynamicArray<const char*>& extensionNames, VkPhysicalDevice device)
 {
 	// Get amount of available device extensions.
@@ -109,8 +138,11 @@ RendererHelper::QueueFamilyIndices RendererHelper::FindQueueFamilies(VkSurfaceKH
 	// Get queue indices.
 	for (unsigned int i = 0; i < queueFamilyCount; ++i)
 	{
+		// Headless rendering has no surface to present to.
 		VkBool32 hasPresentSupport = VK_FALSE;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, windowSurface, &hasPresentSupport);
+
+		if (windowSurface != VK_NULL_HANDLE)
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, windowSurface, &hasPresentSupport);
 
 		// Find present family index.
 		if (eDesiredFamilies & QUEUE_FAMILY_PRESENT && queueFamilies[i].queueCount > 0 && hasPresentSupport)
@@ -152,9 +184,6 @@ RendererHelper::QueueFamilyIndices RendererHelper::FindQueueFamilies(VkSurfaceKH
 
 int RendererHelper::DeviceSuitable(VkSurfaceKHR windowSurface, VkPhysicalDevice device, const DynamicArray<const char*>& extensionNames, EQueueFamilyFlags eDesiredQueueFamilies)
 {
-	if (windowSurface == VK_NULL_HANDLE)
-		throw std::runtime_error("Renderer Error: Cannot check suitability for a null window surface!");
-
 	if (device == VK_NULL_HANDLE)
 		throw std::runtime_error("Renderer Error: Cannot check suitability for a null device!");
 
@@ -171,16 +200,18 @@ int RendererHelper::DeviceSuitable(VkSurfaceKHR windowSurface, VkPhysicalDevice
 	if (!bExtensionsSupported)
 		return 0;
 
-	// Get swap chain information.
-	SwapChainDetails* swapChainDetails = GetSwapChainSupportDetails(windowSurface, device);
+	// Check if swap chain support is suitable, headless rendering (a null window surface) needs no swap chain.
+	if(windowSurface != VK_NULL_HANDLE)
+	{
+		SwapChainDetails* swapChainDetails = GetSwapChainSupportDetails(windowSurface, device);
 
-	// Check if swap chain support is suitable.
-	bool bSuitableSwapChain = swapChainDetails->m_formats.Count() > 0 && swapChainDetails->m_presentModes.Count() > 0;
+		bool bSuitableSwapChain = swapChainDetails->m_formats.Count() > 0 && swapChainDetails->m_presentModes.Count() > 0;
 
-	delete swapChainDetails;
+		delete swapChainDetails;
 
-	if (!bSuitableSwapChain)
-		return 0;
+		if (!bSuitableSwapChain)
+			return 0;
+	}
 
 	int score = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU && features.geometryShader;
 	score += FindQueueFamilies(windowSurface, device, eDesiredQueueFamilies).m_bAllFamiliesFound; // Ensures all correct queue families are found.
@@ -52,7 +52,7 @@ public:
 	Description: Check whether or not the provided physical device meets standard game graphical capabilities, and rate suitability with a score output.
 	Return Type: int
 	Param:
-		VkSurfaceKHR windowSurface: The window surface the swap chain will present to.
+		VkSurfaceKHR windowSurface: The window surface the swap chain will present to, or VK_NULL_HANDLE for headless rendering.
 		VkPhysicalDevice device: The physical device to query.
 	    const DynamicArray<const char*>& extensionNames: Names of Vulkan extensions required.
 		EQueueFamilyFlags desiredQueueFamilies: The desired queue families to be found on the phyiscal device.
@@ -72,7 +72,7 @@ public:
 	Description: Retreive information on queue families for the provided device and window surface.
 	Return Type: QueueFamilyIndices
 	Param:
-	    VkSurfaceKHR windowSurface: The window surface to check.
+	    VkSurfaceKHR windowSurface: The window surface to check, no family has present support if it is VK_NULL_HANDLE.
 		VkPhysicalDevice device: The physical device to check.
 		EQueueFamilyFlags eDesiredFamilies: The desired queue families to find.
 	*/
@@ -100,6 +100,15 @@ public:
 	*/
 	static VkFormat FindBestDepthFormat(VkPhysicalDevice physDevice, DynamicArray<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags features);
 
+	/*
+	Description: Create a shader module from a SPIR-V file, VK_NULL_HANDLE if the file can't be opened.
+	Return Type: VkShaderModule
+	Param:
+	    VkDevice device: The logical device to create the module with.
+		const char* szPath: Path of the SPIR-V file.
+	*/
+	static VkShaderModule CreateShaderModule(VkDevice device, const char* szPath);
+
 	template<typename T>
 	static T GetExternalFunction(VkInstance instance, const char* funcName)
 	{
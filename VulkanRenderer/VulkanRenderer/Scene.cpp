@@ -5,6 +5,7 @@
 
 #include "SubScene.h"
 #include "Shader.h"
+#include "CPUProfiler.h"
 
 Scene::Scene(Renderer* renderer, uint32_t nQueueFamilyIndex)
 {
@@ -22,6 +23,7 @@ Scene::Scene(Renderer* renderer, uint32_t nQueueFamilyIndex)
 
 	SubSceneParams params;
 	params.eAttachmentBits = (EGBufferAttachmentTypeBit)(GBUFFER_COLOR_BIT | GBUFFER_COLOR_HDR_BIT | GBUFFER_DEPTH_BIT | GBUFFER_NORMAL_BIT);
+	params.m_eGBufferLayout = GBUFFER_LAYOUT_STANDARD; // GBUFFER_LAYOUT_COMPACT halves the color & normal bandwidth.
 	params.m_miscGAttachments = 
 	{ 
 		{ GBUFFER_MISC_8_BIT, { 0.0f, 0.0f, 0.0f, 1.0f } }, // Emission
@@ -96,6 +98,8 @@ Renderer* Scene::GetRenderer()
 
 void Scene::DrawSubscenes(const uint32_t& nPresentImageIndex, const uint64_t nElapsedFrames, const uint32_t& nFrameIndex, VkSemaphore& imageAvailableSemaphore, VkSemaphore& renderFinishedSemaphore, VkFence& frameFence)
 {
+	CPU_PROFILE_ZONE("Scene::DrawSubscenes");
+
 	// ---------------------------------------------------------------------------------
 	// Frame indices
 
@@ -117,26 +121,60 @@ void Scene::DrawSubscenes(const uint32_t& nPresentImageIndex, const uint64_t nEl
 	// ---------------------------------------------------------------------------------
 	// Record & Submit subscenes
 
-	VkPipelineStageFlags renderWaitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,  VK_PIPELINE_STAGE_TRANSFER_BIT }; // Wait for transfers to complete first before submitting render commands.
+
+	UploadArena* uploadArena = m_renderer->GetUploadArena();
+
+	// Reset this frame's upload region, the in-flight fence for this frame has already been waited on.
+	uploadArena->BeginFrame(nFrameIndex);
 
 	// Record subscene command bufer.
 	m_primarySubscene->RecordPrimaryCmdBuffer(nPresentImageIndex, nFrameIndex, m_transferCmdBufs[nFrameIndex]);
 
+	// Record batched copies for all buffer updates staged while recording.
+	uploadArena->Flush(m_transferCmdBufs[nFrameIndex]);
+
 	// Finish recording of transfer commands.
 	RENDERER_SAFECALL(vkEndCommandBuffer(m_transferCmdBufs[nFrameIndex]), "Scene Error: Failed to end recording of transfer command buffer.");
 
-	VkSemaphore renderWaitSemaphores[] = { imageAvailableSemaphore, m_transferCompleteSemaphores[nTransferFrameIndex] };
+	VkSemaphore renderWaitSemaphores[3];
+	VkPipelineStageFlags renderWaitStages[3];
+	uint32_t nRenderWaitCount = 0;
+
+	// Headless renderers acquire no image, so there is no image to wait on & no presentation to signal.
+	bool bPresent = imageAvailableSemaphore != VK_NULL_HANDLE;
+
+	if(bPresent)
+	{
+		renderWaitSemaphores[nRenderWaitCount] = imageAvailableSemaphore;
+		renderWaitStages[nRenderWaitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	}
+
+	// Wait for transfers to complete first before submitting render commands, only after the first frame.
+	if(nElapsedFrames > 1)
+	{
+		renderWaitSemaphores[nRenderWaitCount] = m_transferCompleteSemaphores[nTransferFrameIndex];
+		renderWaitStages[nRenderWaitCount++] = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	}
+
+	// Wait for GPU culling of this frame before reading its indirect draws & visible instances, or appending to them in the late occlusion culling phase.
+	VkSemaphore cullSemaphore = m_primarySubscene->CullWaitSemaphore();
+
+	if(cullSemaphore != VK_NULL_HANDLE)
+	{
+		renderWaitSemaphores[nRenderWaitCount] = cullSemaphore;
+		renderWaitStages[nRenderWaitCount++] = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	}
 
 	// Set render finished semaphore reference, used outside this function to wait for rendering to finish before aquiring the next swap chain image.
-	renderFinishedSemaphore = m_renderFinishedSemaphores[nFrameIndex];
+	renderFinishedSemaphore = bPresent ? m_renderFinishedSemaphores[nFrameIndex] : VK_NULL_HANDLE;
 
 	VkSubmitInfo renderSubmitInfo = {};
 	renderSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	renderSubmitInfo.pNext = nullptr;
-	renderSubmitInfo.waitSemaphoreCount = 1 + (nElapsedFrames > 1); // Only wait on second semaphore after the first frame.
+	renderSubmitInfo.waitSemaphoreCount = nRenderWaitCount;
 	renderSubmitInfo.pWaitSemaphores = renderWaitSemaphores;
 	renderSubmitInfo.pWaitDstStageMask = renderWaitStages;
-	renderSubmitInfo.signalSemaphoreCount = 1;
+	renderSubmitInfo.signalSemaphoreCount = bPresent ? 1 : 0;
 	renderSubmitInfo.pSignalSemaphores = &m_renderFinishedSemaphores[nFrameIndex];
 	renderSubmitInfo.commandBufferCount = 1;
 	renderSubmitInfo.pCommandBuffers = &m_primarySubscene->GetCommandBuffer(nFrameIndex);
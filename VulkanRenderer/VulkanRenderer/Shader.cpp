@@ -1,6 +1,7 @@
 #include "Shader.h"
 #include "Renderer.h"
 #include "RenderObject.h"
+#include "CPUProfiler.h"
 
 #include <iostream>
 #include <fstream>
@@ -96,6 +97,8 @@ Shader::Shader(Renderer* renderer, const char* name, const char* vertPath, const
 
 void Shader::Load(const char* vertPath, const char* fragPath, DynamicArray<char>& vertContents, DynamicArray<char>& fragContents)
 {
+	CPU_PROFILE_ZONE("Shader::Load");
+
 	if (m_name == "UNNAMED_SHADER")
 	{
 		std::string vertStr = vertPath;
@@ -47,6 +47,20 @@ layout(set = 2, binding = 0) uniform DirectionalLightArray
 #define SPECULAR_FOCUS 32
 #define SPECULAR_POWER 0.5f
 
+// Set by the subscene's G-Buffer layout, the compact layout stores octahedral encoded normals.
+layout(constant_id = 0) const bool COMPACT_GBUFFER = false;
+
+// Fold an octahedral encoded normal back onto the unit sphere.
+vec3 OctahedralDecode(vec2 e) 
+{
+    vec3 n = vec3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+
+	float t = max(-n.z, 0.0f);
+	n.xy += vec2(n.x >= 0.0f ? -t : t, n.y >= 0.0f ? -t : t);
+
+	return normalize(n);
+}
+
 layout(location = 0) out vec4 outColor;
 
 layout(location = 0) in vec2 finalTexCoords;
@@ -123,6 +137,10 @@ void main()
     // Final color output.
     vec4 color = subpassLoad(inputs[0]).rgba;
     vec4 normal = subpassLoad(inputs[1]);
+
+	if(COMPACT_GBUFFER)
+	    normal = vec4(OctahedralDecode(normal.xy), 1.0f);
+
 	vec3 emission = subpassLoad(inputs[2]).rgb;
 	
 	vec4 specRoughness = subpassLoad(inputs[3]);
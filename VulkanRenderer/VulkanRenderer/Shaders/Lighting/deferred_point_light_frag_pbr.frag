@@ -20,6 +20,20 @@ layout(input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput in
 #define DIFFUSE_POWER 1
 #define SPECULAR_POWER 1.0f
 
+// Set by the subscene's G-Buffer layout, the compact layout stores octahedral encoded normals.
+layout(constant_id = 0) const bool COMPACT_GBUFFER = false;
+
+// Fold an octahedral encoded normal back onto the unit sphere.
+vec3 OctahedralDecode(vec2 e) 
+{
+    vec3 n = vec3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+
+	float t = max(-n.z, 0.0f);
+	n.xy += vec2(n.x >= 0.0f ? -t : t, n.y >= 0.0f ? -t : t);
+
+	return normalize(n);
+}
+
 layout(location = 0) out vec4 outColor;
 
 layout(location = 0) in vec4 finalLightPosition;
@@ -98,6 +112,10 @@ void main()
     // Final color output.
     vec4 color = subpassLoad(inputs[0]);
     vec4 normal = subpassLoad(inputs[1]);
+
+	if(COMPACT_GBUFFER)
+	    normal = vec4(OctahedralDecode(normal.xy), 1.0f);
+
 	vec3 emission = subpassLoad(inputs[2]).rgb;
 
 	vec4 specRoughness = subpassLoad(inputs[3]);
@@ -16,13 +16,27 @@ layout(location = 0) in vec4 f_finalPos;
 layout(location = 1) in vec2 f_texCoords;
 layout(location = 2) in vec4 f_normal;
 
+// Set by the subscene's G-Buffer layout, the compact layout stores octahedral encoded normals.
+layout(constant_id = 0) const bool COMPACT_GBUFFER = false;
+
+// Map a unit normal onto an octahedron & unfold it into the [-1, 1] square.
+vec2 OctahedralEncode(vec3 n) 
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+
+	if(n.z < 0.0f)
+	    n.xy = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+
+	return n.xy;
+}
+
 void main() 
 {
     // Color G Buffer output.
     outColor = properties.colorTint;
 
     // Normal G Buffer output.
-    outNormal = vec4(f_normal.xyz, 1.0f);
+    outNormal = COMPACT_GBUFFER ? vec4(OctahedralEncode(normalize(f_normal.xyz)), 0.0f, 1.0f) : vec4(f_normal.xyz, 1.0f);
 
 	// Emissive output.
 	outEmission = vec4(0.0f, 0.0f, 0.0f, 1.0f);
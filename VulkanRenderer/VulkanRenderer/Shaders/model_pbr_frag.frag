@@ -20,13 +20,28 @@ layout(location = 0) in vec4 f_finalPos;
 layout(location = 1) in vec2 f_texCoords;
 layout(location = 2) in mat3 f_tbn;
 
+// Set by the subscene's G-Buffer layout, the compact layout stores octahedral encoded normals.
+layout(constant_id = 0) const bool COMPACT_GBUFFER = false;
+
+// Map a unit normal onto an octahedron & unfold it into the [-1, 1] square.
+vec2 OctahedralEncode(vec3 n) 
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+
+	if(n.z < 0.0f)
+	    n.xy = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+
+	return n.xy;
+}
+
 void main() 
 {
     // Color G Buffer output.
     outColor = texture(textures[0], f_texCoords) * properties.colorTint;
 
     // Normal G Buffer output.
-    outNormal = vec4(normalize(f_tbn * (texture(textures[1], f_texCoords).xyz * 2.0f - 1.0f)), 1.0f);
+    vec3 normal = normalize(f_tbn * (texture(textures[1], f_texCoords).xyz * 2.0f - 1.0f));
+    outNormal = COMPACT_GBUFFER ? vec4(OctahedralEncode(normal), 0.0f, 1.0f) : vec4(normal, 1.0f);
 
 	// Emissive output.
 	outEmission = vec4(texture(textures[2], f_texCoords).xyz * properties.emissionPower, 1.0f);
@@ -6,6 +6,7 @@
 #include "SubScene.h"
 #include "RenderObject.h"
 #include "Material.h"
+#include "CPUProfiler.h"
 #include "glm/include/gtc/matrix_transform.hpp"
 
 VkCommandBufferInheritanceInfo ShadowMap::m_inheritanceInfo =
@@ -13,7 +14,7 @@ VkCommandBufferInheritanceInfo ShadowMap::m_inheritanceInfo =
 	VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
 	nullptr,
 	VK_NULL_HANDLE,
-	SHADOW_MAPPING_SUBPASS_INDEX,
+	0,
 	VK_NULL_HANDLE,
 	VK_FALSE,
 	0,
@@ -28,7 +29,7 @@ VkCommandBufferBeginInfo ShadowMap::m_beginInfo =
 	&ShadowMap::m_inheritanceInfo
 };
 
-ShadowMap::ShadowMap(Renderer* renderer, Texture* shadowMap, uint32_t nWidth, uint32_t nHeight, DynamicArray<PipelineData*>* pipelines, VkCommandPool cmdPool, VkRenderPass pass, uint32_t nQueueFamilyIndex) : RenderModule(renderer, cmdPool, pass, nQueueFamilyIndex, false)
+ShadowMap::ShadowMap(Renderer* renderer, Texture* shadowMap, uint32_t nWidth, uint32_t nHeight, DynamicArray<PipelineData*>* pipelines, VkCommandPool cmdPool, VkRenderPass pass, uint32_t nSubpassIndex, uint32_t nQueueFamilyIndex) : RenderModule(renderer, cmdPool, pass, nSubpassIndex, nQueueFamilyIndex, false)
 {
 	m_shadowMap = shadowMap;
 	m_shadowMapSampler = new Sampler(renderer, FILTER_MODE_BILINEAR, REPEAT_MODE_CLAMP_TO_EDGE, 0.0f);
@@ -51,8 +52,17 @@ ShadowMap::ShadowMap(Renderer* renderer, Texture* shadowMap, uint32_t nWidth, ui
 	CreateDescriptorSets();
 	UpdateDescriptorSets();
 
-	// Create shadow mapping render pipeline.
-	CreateRenderPipeline();
+	m_shadowMapPipelineLayout = VK_NULL_HANDLE;
+	m_shadowMapPipeline = VK_NULL_HANDLE;
+
+	// The render graph culls the shadow mapping pass while nothing samples the shadow map, the camera descriptors are still used for lighting.
+	if(m_renderPass)
+	{
+		// Create shadow mapping render pipeline.
+		CreateRenderPipeline();
+
+		CreateWorkerCmdBuffers();
+	}
 }
 
 ShadowMap::~ShadowMap()
@@ -71,13 +81,9 @@ ShadowMap::~ShadowMap()
 
 	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) 
 	{
-		// Destroy staging buffers...
-		vkDestroyBuffer(device, m_shadowCamStagingBufs[i], nullptr);
-		vkFreeMemory(device, m_shadowCamStagingMemories[i], nullptr);
-
 		// Destroy device local buffers...
 		vkDestroyBuffer(device, m_shadowCamUBOs[i], nullptr);
-		vkFreeMemory(device, m_shadowCamMemories[i], nullptr);
+		m_renderer->FreeMemory(m_shadowCamMemories[i]);
 	}
 
 	delete m_vertShader;
@@ -86,61 +92,58 @@ ShadowMap::~ShadowMap()
 
 void ShadowMap::RecordCommandBuffer(const uint32_t& nPresentImageIndex, const uint32_t& nFrameIndex, const VkFramebuffer& framebuffer, const VkCommandBuffer transferCmdBuf)
 {
-	// Set inheritence framebuffer & render pass.
+	CPU_PROFILE_ZONE("ShadowMap::RecordCommandBuffer");
+
+	// Set inheritence framebuffer, render pass & subpass.
 	m_inheritanceInfo.framebuffer = framebuffer;
 	m_inheritanceInfo.renderPass = m_renderPass;
-
-	VkCommandBuffer cmdBuf = m_cmdBuffers[nFrameIndex];
+	m_inheritanceInfo.subpass = m_nSubpassIndex;
 
 	// Update camera UBO if needed.
 	if(m_nTransferCamera) 
 	{
-		// Map staging buffer & update it's contents.
-		void* ptr = nullptr;
-		RENDERER_SAFECALL(vkMapMemory(m_renderer->GetDevice(), m_shadowCamStagingMemories[nFrameIndex], 0, VK_WHOLE_SIZE, 0, &ptr), "Shadow Map Error: Failed to map camera memory for updating.");
-
-		// Copy camera data to staging buffer.
-		std::memcpy(ptr, &m_camera, sizeof(ShadowMapCamera));
-
-		vkUnmapMemory(m_renderer->GetDevice(), m_shadowCamStagingMemories[nFrameIndex]);
-
-		VkBufferCopy copyRegion = { 0, 0, sizeof(ShadowMapCamera) };
-		vkCmdCopyBuffer(transferCmdBuf, m_shadowCamStagingBufs[nFrameIndex], m_shadowCamUBOs[nFrameIndex], 1, &copyRegion);
+		// Write camera data to this frame's UBO, directly or through the upload arena.
+		m_renderer->GetUploadArena()->Write(m_shadowCamUBOs[nFrameIndex], m_shadowCamMemories[nFrameIndex], 0, &m_camera, sizeof(ShadowMapCamera), true);
 
 		m_nTransferCamera -= 1;
 	}
 
-	// Begin recording...
-	RENDERER_SAFECALL(vkBeginCommandBuffer(cmdBuf, &m_beginInfo), "GBufferPass Error: Failed to begin recording of draw commands.");
-
 	DynamicArray<PipelineData*>& pipelines = *m_pipelines;
 
-	// Only one pipeline & descriptor set needs to be bound as the same is used for all when rendering a shadow map.
-	vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, m_shadowMapPipeline);
-	vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, m_shadowMapPipelineLayout, 0, 1, &m_camDescSets[nFrameIndex], 0, nullptr);
+	// Gather the renderobjects of all pipelines for the subscene, the pipelines themselves are not used.
+	m_drawList.Clear();
 
-	// Iterate through all pipelines for the subscene and draw their renderobjects.
 	for (uint32_t i = 0; i < pipelines.Count(); ++i)
 	{
 		PipelineData& data = *pipelines[i];
 
 		for (uint32_t j = 0; j < data.m_renderObjects.Count(); ++j)
 		{
-			RenderObject& obj = *data.m_renderObjects[j];
-
-			// Draw object into shadow map.
-			obj.CommandDraw(cmdBuf);
+			// Skip objects with every instance outside of the shadow camera's view.
+			if (data.m_renderObjects[j]->VisibleInstanceCount(CULL_VIEW_SHADOW) > 0)
+				m_drawList.Push(data.m_renderObjects[j]);
 		}
 	}
 
-	// End recording...
-	RENDERER_SAFECALL(vkEndCommandBuffer(cmdBuf), "GBufferPass Error: Failed to end recording of draw commands.");
+	m_nDrawCallCount = m_drawList.Count();
+
+	// Record the draw list across the worker threads.
+	RecordParallel(nFrameIndex, m_drawList.Count(), m_beginInfo, [&](VkCommandBuffer cmdBuf, uint32_t nStart, uint32_t nEnd)
+	{
+		// Only one pipeline & descriptor set needs to be bound as the same is used for all when rendering a shadow map.
+		vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, m_shadowMapPipeline);
+		vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, m_shadowMapPipelineLayout, 0, 1, &m_camDescSets[nFrameIndex], 0, nullptr);
+
+		// Draw objects into shadow map.
+		for (uint32_t i = nStart; i < nEnd; ++i)
+			m_drawList[i]->CommandDraw(cmdBuf, CULL_VIEW_SHADOW, nFrameIndex);
+	});
 }
 
 void ShadowMap::OnOutputResize(const RenderModuleResizeData& resizeData) 
 {
-	// Update render pass handle.
-	m_renderPass = resizeData.m_renderPass;
+	// The shadow map keeps its size, only the output size is updated.
+	RenderModule::OnOutputResize(resizeData);
 }
 
 void ShadowMap::UpdateCamera(glm::vec4 v4LookDirection)
@@ -163,6 +166,11 @@ void ShadowMap::UpdateCamera(glm::vec4 v4LookDirection)
 	m_nTransferCamera = MAX_FRAMES_IN_FLIGHT;
 }
 
+glm::mat4 ShadowMap::ViewProjection() const
+{
+	return m_camera.m_projMat * m_camera.m_viewMat;
+}
+
 Texture* ShadowMap::GetShadowMapImage()
 {
 	return m_shadowMap;
@@ -180,14 +188,11 @@ VkDescriptorSet ShadowMap::GetShadowMapCamSet(const uint32_t& nFrameIndex)
 
 inline void ShadowMap::CreateShadowMapCamera()
 {
-	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) 
-	{
-		// Create staging buffers...
-		m_renderer->CreateBuffer(sizeof(ShadowMapCamera), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_shadowCamStagingBufs[i], m_shadowCamStagingMemories[i]);
+	VkMemoryPropertyFlags memoryFlags = m_renderer->GetUploadArena()->PerFrameMemoryFlags();
 
-		// Create device local buffers...
-	    m_renderer->CreateBuffer(sizeof(ShadowMapCamera), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_shadowCamUBOs[i], m_shadowCamMemories[i]);
-	}
+	// Create device local buffers, updated through the renderer's upload arena...
+	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) 
+	    m_renderer->CreateBuffer(sizeof(ShadowMapCamera), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryFlags, m_shadowCamUBOs[i], m_shadowCamMemories[i]);
 }
 
 inline void ShadowMap::CreateDescriptorPool()
@@ -451,11 +456,11 @@ inline void ShadowMap::CreateRenderPipeline()
 	pipelineInfo.pDynamicState = nullptr;
 	pipelineInfo.layout = m_shadowMapPipelineLayout;
 	pipelineInfo.renderPass = m_renderPass;
-	pipelineInfo.subpass = SHADOW_MAPPING_SUBPASS_INDEX;
+	pipelineInfo.subpass = m_nSubpassIndex;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	RENDERER_SAFECALL(vkCreateGraphicsPipelines(m_renderer->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_shadowMapPipeline), "Renderer Error: Failed to create lighting graphics pipeline.");
+	m_renderer->GetPipelineCache()->CreateGraphicsPipelines(&pipelineInfo, 1, &m_shadowMapPipeline);
 
 	delete[] attrDescriptions;
 }
@@ -19,7 +19,7 @@ class ShadowMap : public RenderModule
 {
 public:
 
-	ShadowMap(Renderer* renderer, Texture* shadowMap, uint32_t nWidth, uint32_t nHeight, DynamicArray<PipelineData*>* pipelines, VkCommandPool cmdPool, VkRenderPass pass, uint32_t nQueueFamilyIndex);
+	ShadowMap(Renderer* renderer, Texture* shadowMap, uint32_t nWidth, uint32_t nHeight, DynamicArray<PipelineData*>* pipelines, VkCommandPool cmdPool, VkRenderPass pass, uint32_t nSubpassIndex, uint32_t nQueueFamilyIndex);
 
 	~ShadowMap();
 
@@ -34,6 +34,12 @@ public:
 	*/
 	void UpdateCamera(glm::vec4 v4LookDirection);
 
+	/*
+	Description: Get the shadow map camera's projection matrix multiplied by its view matrix.
+	Return Type: glm::mat4
+	*/
+	glm::mat4 ViewProjection() const;
+
 	/*
 	Description: Get the shadow map image.
 	Return Type: Texture*
@@ -97,11 +103,8 @@ private:
 	ShadowMapCamera m_camera;
 	uint32_t m_nTransferCamera;
 
-	VkBuffer m_shadowCamStagingBufs[MAX_FRAMES_IN_FLIGHT];
-	VkDeviceMemory m_shadowCamStagingMemories[MAX_FRAMES_IN_FLIGHT];
-
 	VkBuffer m_shadowCamUBOs[MAX_FRAMES_IN_FLIGHT];
-	VkDeviceMemory m_shadowCamMemories[MAX_FRAMES_IN_FLIGHT];
+	MemAllocation m_shadowCamMemories[MAX_FRAMES_IN_FLIGHT];
 
 	// ---------------------------------------------------------------------------------
 	// Descriptors
@@ -117,5 +120,6 @@ private:
 
 	// The pipelines won't actually be used, we only want the renderobjects inside of them.
 	DynamicArray<PipelineData*>* m_pipelines;
+	DynamicArray<RenderObject*> m_drawList; // Objects drawn in the current frame, partitioned across recording threads.
 };
 
@@ -6,13 +6,18 @@
 #include "Material.h"
 #include "Texture.h"
 #include "RenderObject.h"
+#include "FrustumCuller.h"
+#include "GPUCuller.h"
+#include "CPUProfiler.h"
 #include "gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <cmath>
 
 PipelineData::PipelineData()
 {
 	m_handle = nullptr;
+	m_lateHandle = nullptr;
 	m_layout = nullptr;
-	m_material = nullptr;
 }
 
 PipelineDataPtr::PipelineDataPtr()
@@ -75,125 +80,6 @@ VkDescriptorSetAllocateInfo SubScene::m_descAllocInfo =
 	nullptr
 };
 
-VkAttachmentDescription SubScene::m_swapChainAttachmentDescription =
-{
-	0,
-	VK_FORMAT_R8G8B8A8_UNORM,
-	VK_SAMPLE_COUNT_1_BIT,
-	VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-	VK_ATTACHMENT_STORE_OP_STORE,
-	VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_IMAGE_LAYOUT_UNDEFINED,
-	VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-};
-
-VkAttachmentDescription SubScene::m_outputAttachmentDescription =
-{
-	0,
-	VK_FORMAT_R8G8B8A8_UNORM,
-	VK_SAMPLE_COUNT_1_BIT,
-	VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-	VK_ATTACHMENT_STORE_OP_STORE,
-	VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_IMAGE_LAYOUT_UNDEFINED,
-	VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL // This layout is for blitting to the swap chain image.
-};
-
-VkAttachmentDescription SubScene::m_depthAttachmentDescription =
-{
-	0,
-	VK_FORMAT_D16_UNORM_S8_UINT,
-	VK_SAMPLE_COUNT_1_BIT,
-	VK_ATTACHMENT_LOAD_OP_CLEAR,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_ATTACHMENT_LOAD_OP_CLEAR,
-	VK_ATTACHMENT_STORE_OP_STORE,
-	VK_IMAGE_LAYOUT_UNDEFINED,
-	VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-};
-
-VkAttachmentDescription SubScene::m_colorAttachmentDescription =
-{
-	0,
-	VK_FORMAT_R8G8B8A8_UNORM,
-	VK_SAMPLE_COUNT_1_BIT,
-	VK_ATTACHMENT_LOAD_OP_CLEAR,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_IMAGE_LAYOUT_UNDEFINED,
-	VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-};
-
-VkAttachmentDescription SubScene::m_colorHDRAttachmentDescription =
-{
-	0,
-	VK_FORMAT_R16G16B16A16_SFLOAT,
-	VK_SAMPLE_COUNT_1_BIT,
-	VK_ATTACHMENT_LOAD_OP_CLEAR,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_IMAGE_LAYOUT_UNDEFINED,
-	VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-};
-
-VkAttachmentDescription SubScene::m_vectorAttachmentDescription =
-{
-	0,
-	VK_FORMAT_R16G16B16A16_SFLOAT,
-	VK_SAMPLE_COUNT_1_BIT,
-	VK_ATTACHMENT_LOAD_OP_CLEAR,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-	VK_ATTACHMENT_STORE_OP_DONT_CARE,
-	VK_IMAGE_LAYOUT_UNDEFINED,
-	VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-};
-
-VkSubpassDependency SubScene::m_shadowMapDependency =
-{
-	VK_SUBPASS_EXTERNAL,
-	SHADOW_MAPPING_SUBPASS_INDEX,
-	VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-	VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-	0,
-    VK_ACCESS_SHADER_READ_BIT
-};
-
-VkSubpassDependency SubScene::m_gBufferDependency =
-{
-	SHADOW_MAPPING_SUBPASS_INDEX,
-	G_BUFFER_SUBPASS_INDEX,
-	VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-	VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-	0,
-	VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
-	| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
-};
-
-VkSubpassDependency SubScene::m_lightingDependency =
-{
-	G_BUFFER_SUBPASS_INDEX,
-	LIGHTING_SUBPASS_INDEX,
-	VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-	VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-	VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-	VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
-};
-
-VkSubpassDependency SubScene::m_postDependency =
-{
-	LIGHTING_SUBPASS_INDEX,
-	POST_SUBPASS_INDEX,
-	VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-	VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-	VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-	VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
-};
-
 VkCommandBufferBeginInfo SubScene::m_primaryCmdBeginInfo =
 {
 	VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -219,16 +105,26 @@ SubScene::SubScene(SubSceneParams& params)
 {
 	m_renderer = params.m_renderer;
 
-	m_pass = VK_NULL_HANDLE;
+	m_graph = new RenderGraph(m_renderer);
+	m_shadowMapImage = nullptr;
 	m_nQueueFamilyIndex = params.m_nQueueFamilyIndex;
 
 	m_nWidth = params.m_nFrameBufferWidth;
 	m_nHeight = params.m_nFrameBufferHeight;
+	m_nRenderWidth = m_nWidth;
+	m_nRenderHeight = m_nHeight;
 	m_bPrimary = params.m_bPrimary;
 
+	// GPU culling is off until enabled, so the render graph is first built without the occlusion culling passes.
+	m_gpuCuller = nullptr;
+	m_bGPUCulling = false;
+	m_bOcclusionCulling = true;
+
+	// Declare images that will be rendered to.
+	CreateImages(params.eAttachmentBits, params.m_eGBufferLayout, params.m_miscGAttachments);
 
-	// Create images that will be rendered to.
-	CreateImages(params.eAttachmentBits, params.m_miscGAttachments);
+	// Declare passes & create render passes, G Buffer images & framebuffers.
+	BuildRenderGraph();
 
 	// Create MVP UBO buffers
 	CreateMVPUBOBuffers();
@@ -243,15 +139,33 @@ SubScene::SubScene(SubSceneParams& params)
 
 	// Additional constructions
 
-	CreateRenderPass(); // Create subscene render pass.
-	CreateFramebuffers(); // Create subscene framebuffer.
 	CreateCmds(); // Create command pool & primary command buffers.
 	GetQueue(); // Get device queue subscene commands will be submitted to.
 
-	// Modules
+	// Render attachments are allocated at the maximum scale, the scale only changes the area rendered to.
+	m_dynamicResolution = new DynamicResolution(m_renderer->GetGPUProfiler(), MIN_RENDER_SCALE, static_cast<float>(m_renderer->MaxRenderScale()), TARGET_GPU_FRAME_TIME);
+
+	m_culler = new FrustumCuller(m_renderer);
+	m_cullWaitSemaphore = VK_NULL_HANDLE;
+
+	// Modules, each records one pass of the render graph.
+
+	m_shadowMapModule = new ShadowMap
+	(
+		m_renderer,
+		m_shadowMapImage,
+		m_shadowMapImage->GetWidth(),
+		m_shadowMapImage->GetHeight(),
+		&m_allPipelines,
+		m_commandPool,
+		m_graph->GetRenderPass(m_shadowMapGraphPass),
+		m_graph->GetSubpassIndex(m_shadowMapGraphPass),
+		m_nQueueFamilyIndex
+	);
+
+	m_gPass = new GBufferPass(m_renderer, &m_allPipelines, m_commandPool, m_graph->GetRenderPass(m_gBufferGraphPass), m_graph->GetSubpassIndex(m_gBufferGraphPass), m_mvpUBODescSets, m_nQueueFamilyIndex);
+	m_gLatePass = nullptr;
 
-	m_shadowMapModule = new ShadowMap(m_renderer, m_shadowMapImage, params.m_nFrameBufferWidth, params.m_nFrameBufferHeight, &m_allPipelines, m_commandPool, m_pass, m_nQueueFamilyIndex);
-	m_gPass = new GBufferPass(m_renderer, &m_allPipelines, m_commandPool, m_pass, m_mvpUBODescSets, m_nQueueFamilyIndex);
 	m_lightManager = new LightingManager
 	(
 		m_renderer,
@@ -259,15 +173,30 @@ SubScene::SubScene(SubSceneParams& params)
 		params.m_pointLightShader,
 		m_mvpUBODescSets,
 		m_gBufferDescSet,
+		&m_gBufferSpecInfo,
 		params.m_nFrameBufferWidth,
 		params.m_nFrameBufferHeight,
 		m_shadowMapModule,
 		m_commandPool,
-		m_pass,
+		m_graph->GetRenderPass(m_lightingGraphPass),
+		m_graph->GetSubpassIndex(m_lightingGraphPass),
 		m_mvpUBOSetLayout,
 		m_gBufferSetLayout,
 		m_nQueueFamilyIndex
 	);
+
+	// GPU timing of each pass, the frame & the blit.
+	GPUProfiler* profiler = m_renderer->GetGPUProfiler();
+
+	m_nFrameProfilerScope = profiler->AddScope("Frame");
+	m_dynamicResolution->SetProfilerScope(m_nFrameProfilerScope);
+	m_shadowMapModule->SetProfilerScope(profiler->AddScope("Shadow Map"));
+	m_gPass->SetProfilerScope(profiler->AddScope("G-Buffer"));
+	m_nLateProfilerScope = profiler->AddScope("G-Buffer Late"); // Only written while occlusion culling adds the late G-Buffer pass.
+	m_lightManager->SetProfilerScope(profiler->AddScope("Lighting"));
+	m_nBlitProfilerScope = profiler->AddScope("Blit");
+
+	SetPassModules();
 }
 
 SubScene::~SubScene() 
@@ -291,138 +220,131 @@ SubScene::~SubScene()
 	vkDestroyCommandPool(device, m_commandPool, nullptr);
 
 	// ---------------------------------------------------------------------------------
-	// Destroy framebuffer.
+	// Destroy render graph, including its render passes, framebuffers & G Buffer images.
+	delete m_graph;
 
-	vkDestroyFramebuffer(device, m_framebuffer, nullptr);
-
-	// ---------------------------------------------------------------------------------
-	// Destroy subscene render pass.
-	vkDestroyRenderPass(device, m_pass, nullptr);
+	delete m_dynamicResolution;
+	delete m_culler;
+	delete m_gpuCuller;
 
 	// ---------------------------------------------------------------------------------
 	// Destroy MVP UBO Buffers
 
 	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) 
 	{
-		vkDestroyBuffer(device, m_mvpUBOStagingBuffers[i], nullptr);
-		vkFreeMemory(device, m_mvpUBOStagingMemories[i], nullptr);
-
 		vkDestroyBuffer(device, m_mvpUBOBuffers[i], nullptr);
-		vkFreeMemory(device, m_mvpUBOMemories[i], nullptr);
+		m_renderer->FreeMemory(m_mvpUBOMemories[i]);
 	}
 
 	// ---------------------------------------------------------------------------------
-	// Destroy G Buffer images.
+	// Destroy shadow map image.
 
 	if(m_shadowMapImage)
 	    delete m_shadowMapImage;
 
-	for (uint32_t i = 0; i < m_gBufferImages.Count(); ++i)
-		delete m_gBufferImages[i];
-
-	if (m_depthImage)
-		delete m_depthImage;
-
 	m_shadowMapImage = nullptr;
-	m_colorImage = nullptr;
-	m_depthImage = nullptr;
-	m_posImage = nullptr;
-	m_normalImage = nullptr;
 
 	delete m_shadowMapModule;
 	delete m_gPass;
+	delete m_gLatePass;
 	delete m_lightManager;
 
 	delete m_outImage;
 }
 
-void SubScene::CreateImages(EGBufferAttachmentTypeBit eImageBits, const DynamicArray<MiscGBufferDesc>& miscGAttachments)
+void SubScene::CreateImages(EGBufferAttachmentTypeBit eImageBits, EGBufferLayout eLayout, const DynamicArray<MiscGBufferDesc>& miscGAttachments)
 {
-	// Remove existing images.
-	for(uint32_t i = 0; i < m_allImages.Count(); ++i) 
-		delete m_allImages[i];
+	CreateOutputImage();
 
-	// Update mvpUBO framebuffer dimensions.
-	m_localMVPData.m_v2FramebufferDim = glm::vec2(static_cast<float>(m_nWidth), static_cast<float>(m_nHeight));
+	bool bCompact = eLayout == GBUFFER_LAYOUT_COMPACT;
 
-	CreateOutputImage();
+	// Model & lighting shaders select their G-Buffer encode/decode paths with a specialization constant.
+	m_bCompactGBuffer = bCompact ? VK_TRUE : VK_FALSE;
+	m_gBufferSpecEntry = { GBUFFER_LAYOUT_CONSTANT_ID, 0, sizeof(VkBool32) };
+	m_gBufferSpecInfo = { 1, &m_gBufferSpecEntry, sizeof(VkBool32), &m_bCompactGBuffer };
 
-	m_gBufferImages.Clear();
-	m_gBufferImages.SetSize(4 + miscGAttachments.Count());
-	m_depthImage = nullptr;
+	// The output is blitted to the swap chain image after the render graph has executed.
+	m_outputAttachment = m_graph->ImportAttachment("Output", m_outImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, true, false);
 
-	m_clearValues.Clear();
+	// When rendering at the swap chain's size the lighting pass writes the swap chain image directly instead, or a headless renderer's output image.
+	if (m_bPrimary)
+		m_graph->AllowExternalOutput(m_outputAttachment, m_renderer->OutputImageLayout());
 
-	// Push output clear value.
-	m_clearValues.Push({ 0.0f, 0.0f, 0.0f, 1.0f });
+	m_gBufferAttachments.Clear();
+	m_gBufferAttachments.SetSize(4 + miscGAttachments.Count());
+	m_depthAttachment = RENDER_GRAPH_INVALID_INDEX;
 
 	// Specify pool of depth formats and find the best available format.
 	DynamicArray<VkFormat> depthFormats = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
 	VkFormat depthFormat = RendererHelper::FindBestDepthFormat(m_renderer->GetPhysDevice(), depthFormats, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
 
-	// Create shadow map image.
-	m_shadowMapImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_DEPTH_STENCIL, depthFormat, false, VK_IMAGE_USAGE_SAMPLED_BIT);
+	// Create shadow map image. It is referenced by the shadow map module's descriptors, so it is owned by the subscene & keeps its size when the output is resized.
+	if(!m_shadowMapImage)
+	    m_shadowMapImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_DEPTH_STENCIL, depthFormat, false, VK_IMAGE_USAGE_SAMPLED_BIT);
 
 	// Shadow map clear value.
 	VkClearValue shadowClearVal = { 1.0f, 1.0f, 1.0f, 1.0f };
-	m_clearValues.Push(shadowClearVal);
+	m_shadowMapAttachment = m_graph->ImportAttachment("Shadow Map", m_shadowMapImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, true, shadowClearVal);
 
-	// Create images the bit field contains...
+	// Declare images the bit field contains...
 	if (eImageBits & GBUFFER_COLOR_BIT)
 	{
-		// Create HDR image if correct bit is found.
-		if (eImageBits & GBUFFER_COLOR_HDR_BIT)
-			m_colorImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, VK_FORMAT_R16G16B16A16_SFLOAT, TEXTURE_PROPERTIES_INPUT_ATTACHMENT);
-		else
-			m_colorImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, VK_FORMAT_R8G8B8A8_UNORM, TEXTURE_PROPERTIES_INPUT_ATTACHMENT);
-
-		m_gBufferImages.Push(m_colorImage);
-
 		// Clear value
 		VkClearValue clearVal = { 0.0f, 0.0f, 0.0f, 1.0f };
-		m_clearValues.Push(clearVal);
+
+		// Use HDR format if correct bit is found. The compact HDR format drops alpha, which lighting doesn't use.
+		VkFormat colorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+		if (eImageBits & GBUFFER_COLOR_HDR_BIT)
+		{
+			// B10G11R11 color attachments are optional, the compact layout falls back to RGBA16F where they are unsupported. RGBA16F support is required.
+			DynamicArray<VkFormat> hdrFormats = { VK_FORMAT_B10G11R11_UFLOAT_PACK32, VK_FORMAT_R16G16B16A16_SFLOAT };
+			colorFormat = bCompact ? RendererHelper::FindBestDepthFormat(m_renderer->GetPhysDevice(), hdrFormats, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT) : VK_FORMAT_R16G16B16A16_SFLOAT;
+		}
+
+		m_gBufferAttachments.Push(m_graph->AddAttachment("G-Buffer Color", ATTACHMENT_COLOR, colorFormat, clearVal));
 	}
 
-	if (eImageBits & GBUFFER_POSITION_BIT)
+	// Lighting shaders reconstruct position from depth, the compact layout never stores it.
+	if ((eImageBits & GBUFFER_POSITION_BIT) && !bCompact)
 	{
-		m_posImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, VK_FORMAT_R16G16B16A16_SFLOAT, TEXTURE_PROPERTIES_INPUT_ATTACHMENT);
-		m_gBufferImages.Push(m_posImage);
-
 		// Clear value
 		VkClearValue clearVal = { 0.0f, 0.0f, 0.0f, 1.0f };
-		m_clearValues.Push(clearVal);
+
+		m_gBufferAttachments.Push(m_graph->AddAttachment("G-Buffer Position", ATTACHMENT_COLOR, VK_FORMAT_R16G16B16A16_SFLOAT, clearVal));
 	}
 
 	if (eImageBits & GBUFFER_NORMAL_BIT)
 	{
-		m_normalImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, VK_FORMAT_R16G16B16A16_SFLOAT, TEXTURE_PROPERTIES_INPUT_ATTACHMENT);
-		m_gBufferImages.Push(m_normalImage);
-
 		// Clear value
 		VkClearValue clearVal = { 0.0f, 0.0f, 0.0f, 1.0f };
-		m_clearValues.Push(clearVal);
+
+		// Unit normals are octahedral encoded to two components in the compact layout.
+		VkFormat normalFormat = bCompact ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R16G16B16A16_SFLOAT;
+
+		m_gBufferAttachments.Push(m_graph->AddAttachment("G-Buffer Normal", ATTACHMENT_COLOR, normalFormat, clearVal));
 	}
 
 	m_miscGAttachments = miscGAttachments;
 
-	// Create misc G buffer images...
+	// Declare misc G buffer images...
 	for (uint32_t i = 0; i < m_miscGAttachments.Count(); ++i)
 	{
-		Texture* miscTex = nullptr;
+		VkFormat miscFormat = VK_FORMAT_UNDEFINED;
 
-		// Create image with provided format.
+		// Declare image with provided format.
 		switch (m_miscGAttachments[i].m_eType)
 		{
 		case EMiscGBufferType::GBUFFER_MISC_8_BIT:
-			miscTex = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, VK_FORMAT_R8G8B8A8_SRGB, TEXTURE_PROPERTIES_INPUT_ATTACHMENT);
+			miscFormat = VK_FORMAT_R8G8B8A8_SRGB;
 			break;
 
 		case EMiscGBufferType::GBUFFER_MISC_16_BIT_FLOAT:
-			miscTex = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, VK_FORMAT_R16G16B16A16_SFLOAT, TEXTURE_PROPERTIES_INPUT_ATTACHMENT);
+			miscFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
 			break;
 
 		case EMiscGBufferType::GBUFFER_MISC_32_BIT_FLOAT:
-			miscTex = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, VK_FORMAT_R32G32B32_SFLOAT, TEXTURE_PROPERTIES_INPUT_ATTACHMENT);
+			miscFormat = VK_FORMAT_R32G32B32_SFLOAT;
 			break;
 
 		default:
@@ -430,42 +352,29 @@ void SubScene::CreateImages(EGBufferAttachmentTypeBit eImageBits, const DynamicA
 			break;
 		}
 
-		// Add new image to G buffer image array.
-		if (miscTex)
+		// Add new image to G buffer attachment array.
+		if (miscFormat != VK_FORMAT_UNDEFINED)
 		{
-			m_gBufferImages.Push(miscTex);
-
 			glm::vec4 v4ClearColor = m_miscGAttachments[i].m_v4ClearColor;
 
-			// Add corresponding clear value.
-			m_clearValues.Push({ v4ClearColor.x, v4ClearColor.y, v4ClearColor.z, v4ClearColor.w });
+			// Corresponding clear value.
+			VkClearValue clearVal = { v4ClearColor.x, v4ClearColor.y, v4ClearColor.z, v4ClearColor.w };
+
+			m_gBufferAttachments.Push(m_graph->AddAttachment("G-Buffer Misc", ATTACHMENT_COLOR, miscFormat, clearVal));
 		}
 	}
 
 	if (eImageBits & GBUFFER_DEPTH_BIT)
 	{
-		m_depthImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_DEPTH_STENCIL, depthFormat, TEXTURE_PROPERTIES_INPUT_ATTACHMENT);
-
 		// Clear value
 		VkClearValue clearVal = { 1.0f, 1.0f, 1.0f, 1.0f };
-		m_clearValues.Push(clearVal);
-	}
-
-	// Update images array.
-	m_allImages.Clear();
-	m_allImages.SetSize(2 + m_gBufferImages.Count());
 
-	m_allImages.Push(m_outImage);
-
-	m_allImages.Push(m_shadowMapImage);
-
-	m_allImages += m_gBufferImages;
-
-	if (m_depthImage)
-		m_allImages.Push(m_depthImage);
+		m_depthAttachment = m_graph->AddAttachment("G-Buffer Depth", ATTACHMENT_DEPTH_STENCIL, depthFormat, clearVal);
+	}
 
 	// Store image bit field information.
 	m_eGBufferImageBits = eImageBits;
+	m_eGBufferLayout = eLayout;
 }
 
 void SubScene::ResizeOutput(uint32_t nNewWidth, uint32_t nNewHeight)
@@ -473,40 +382,48 @@ void SubScene::ResizeOutput(uint32_t nNewWidth, uint32_t nNewHeight)
 	m_nWidth = nNewWidth;
 	m_nHeight = nNewHeight;
 
-	VkDevice device = m_renderer->GetDevice();
+	// ---------------------------------------------------------------------------------
+	// Re-creation
+
+	delete m_outImage;
+	CreateOutputImage(); // Re-create subscene output image.
+
+	m_graph->SetImportedTexture(m_outputAttachment, m_outImage);
+	m_graph->Resize(m_nWidth, m_nHeight); // Re-create G Buffer images & framebuffers.
+
+	// Pipelines are not re-created, their viewport & scissor are dynamic and the render graph keeps its render passes.
+	RecreateAttachmentDescriptors();
+}
 
+inline void SubScene::RecreateAttachmentDescriptors()
+{
 	// ---------------------------------------------------------------------------------
 	// Free descriptor sets.
 
-	vkResetDescriptorPool(device, m_descPool, 0);
+	vkResetDescriptorPool(m_renderer->GetDevice(), m_descPool, 0);
 
 	// ---------------------------------------------------------------------------------
 	// Re-creation
 
-	CreateImages(m_eGBufferImageBits, m_miscGAttachments); // Re-create subscene image.
-	CreateRenderPass(); // Re-create render pass.
-	CreateFramebuffers(); // Re-create framebuffers.
 	CreateMVPUBODescriptors(false); // Re-create descriptor sets for the MVP UBO buffers.
 	CreateInputAttachmentDescriptors(false); // Re-create descriptor sets for G Buffer & ouput input attachments.
 	UpdateAllDescriptorSets(); // Update descriptors in the sets.
 
-	// Re-create pipelines.
-	for (uint32_t i = 0; i < m_allPipelines.Count(); ++i)
-		m_allPipelines[i]->m_renderObjects[0]->RecreatePipeline();
-
 	// Have modules re-create resources if necessary & give them the updated descriptor sets.
 	RenderModuleResizeData resizeData;
 	resizeData.m_nWidth = m_nWidth;
 	resizeData.m_nHeight = m_nHeight;
 	resizeData.m_mvpUBOSets = m_mvpUBODescSets;
 	resizeData.m_gBufferSets = &m_gBufferDescSet;
-	resizeData.m_renderPass = m_pass;
 
 	// Resize modules.
 	if(m_shadowMapModule)
 	    m_shadowMapModule->OnOutputResize(resizeData);
 	m_gPass->OnOutputResize(resizeData);
 	m_lightManager->OnOutputResize(resizeData);
+
+	if (m_gLatePass)
+		m_gLatePass->OnOutputResize(resizeData);
 }
 
 void SubScene::UpdateCameraView(const glm::mat4& view, const glm::vec4& v4ViewPos)
@@ -525,9 +442,9 @@ VkCommandBuffer& SubScene::GetCommandBuffer(const uint32_t nIndex)
 	return m_primaryCmdBufs[nIndex];
 }
 
-const VkRenderPass& SubScene::GetRenderPass()
+RenderGraph* SubScene::GetRenderGraph()
 {
-	return m_pass;
+	return m_graph;
 }
 
 VkDescriptorSetLayout SubScene::MVPUBOLayout() 
@@ -545,9 +462,19 @@ GBufferPass* SubScene::GetGBufferPass()
 	return m_gPass;
 }
 
+GBufferPass* SubScene::GetLateGBufferPass()
+{
+	return m_gLatePass;
+}
+
 const uint32_t SubScene::GetGBufferCount() 
 {
-	return m_gBufferImages.Count();
+	return m_gBufferAttachments.Count();
+}
+
+const VkSpecializationInfo* SubScene::GetGBufferSpecializationInfo() const
+{
+	return &m_gBufferSpecInfo;
 }
 
 LightingManager* SubScene::GetLightingManager()
@@ -555,6 +482,83 @@ LightingManager* SubScene::GetLightingManager()
 	return m_lightManager;
 }
 
+DynamicResolution* SubScene::GetDynamicResolution()
+{
+	return m_dynamicResolution;
+}
+
+FrustumCuller* SubScene::GetFrustumCuller()
+{
+	return m_culler;
+}
+
+void SubScene::SetGPUCulling(bool bEnabled)
+{
+	if (bEnabled && !m_gpuCuller)
+		m_gpuCuller = new GPUCuller(m_renderer);
+
+	m_bGPUCulling = bEnabled;
+
+	if (OcclusionPassesRequired() != (m_gLatePass != nullptr))
+		RebuildRenderGraph();
+}
+
+bool SubScene::IsGPUCulling() const
+{
+	return m_bGPUCulling && m_gpuCuller && m_gpuCuller->IsAvailable();
+}
+
+GPUCuller* SubScene::GetGPUCuller()
+{
+	return m_gpuCuller;
+}
+
+void SubScene::SetOcclusionCulling(bool bEnabled)
+{
+	m_bOcclusionCulling = bEnabled;
+
+	if (OcclusionPassesRequired() != (m_gLatePass != nullptr))
+		RebuildRenderGraph();
+}
+
+bool SubScene::IsOcclusionCulling() const
+{
+	return m_bOcclusionCulling && m_gLatePass && IsGPUCulling() && m_gpuCuller->IsOcclusionAvailable();
+}
+
+VkSemaphore SubScene::CullWaitSemaphore() const
+{
+	return m_cullWaitSemaphore;
+}
+
+uint32_t SubScene::DrawCallCount() const
+{
+	uint32_t nCount = m_gPass->DrawCallCount() + m_lightManager->DrawCallCount();
+
+	if (m_gLatePass)
+		nCount += m_gLatePass->DrawCallCount();
+
+	if (m_shadowMapModule)
+		nCount += m_shadowMapModule->DrawCallCount();
+
+	return nCount;
+}
+
+DrawListStats SubScene::GBufferBindStats() const
+{
+	DrawListStats stats = m_gPass->BindStats();
+
+	if (m_gLatePass)
+		stats.Add(m_gLatePass->BindStats());
+
+	return stats;
+}
+
+uint32_t SubScene::FrameProfilerScope() const
+{
+	return m_nFrameProfilerScope;
+}
+
 Renderer* SubScene::GetRenderer()
 {
 	return m_renderer;
@@ -562,12 +566,21 @@ Renderer* SubScene::GetRenderer()
 
 inline void SubScene::CreateOutputImage()
 {
-	m_outImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, VK_FORMAT_R8G8B8A8_UNORM, TEXTURE_PROPERTIES_INPUT_ATTACHMENT | TEXTURE_PROPERTIES_TRANSFER_SRC, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+	// Update mvpUBO framebuffer dimensions.
+	m_localMVPData.m_v2FramebufferDim = glm::vec2(static_cast<float>(m_nWidth), static_cast<float>(m_nHeight));
+
+	// Primary subscenes match the swap chain format, so the render graph's output render pass is compatible with the swap chain images.
+	VkFormat outputFormat = m_bPrimary ? m_renderer->SwapChainImageFormat() : VK_FORMAT_R8G8B8A8_UNORM;
+
+	m_outImage = new Texture(m_renderer, m_nWidth, m_nHeight, ATTACHMENT_COLOR, outputFormat, TEXTURE_PROPERTIES_INPUT_ATTACHMENT | TEXTURE_PROPERTIES_TRANSFER_SRC, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 
 	if (m_bPrimary) 
 	{
 		m_swapChainImages = m_renderer->SwapChainImages();
 		m_swapchainImageViews = m_renderer->SwapChainImageViews(); // Set swap chain image view references.
+
+		VkExtent3D swapChainExtents = m_renderer->SwapChainImageExtents();
+		m_graph->SetExternalOutputImages(m_swapchainImageViews.Data(), m_swapchainImageViews.Count(), swapChainExtents.width, swapChainExtents.height);
 	}
 }
 
@@ -580,12 +593,12 @@ inline void SubScene::CreateDescriptorPool()
 	VkDescriptorPoolSize mvpUBOPoolSize = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MAX_FRAMES_IN_FLIGHT };
 
 	// Pool size for G Buffer input attachment set
-	VkDescriptorPoolSize gBufferPoolSize = { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, m_gBufferImages.Count() + 1 }; // +1 for depth.
+	VkDescriptorPoolSize gBufferPoolSize = { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, m_gBufferAttachments.Count() + 1 }; // +1 for depth.
 
 	VkDescriptorPoolSize poolSizes[] = { mvpUBOPoolSize, gBufferPoolSize };
 
 	// Set pool create info poolsizes.
-	m_poolCreateInfo.maxSets = MAX_FRAMES_IN_FLIGHT + m_gBufferImages.Count(); // Sets for: MVP UBO Buffers, G Buffer Images
+	m_poolCreateInfo.maxSets = MAX_FRAMES_IN_FLIGHT + m_gBufferAttachments.Count(); // Sets for: MVP UBO Buffers, G Buffer Images
 	m_poolCreateInfo.poolSizeCount = 2;
 	m_poolCreateInfo.pPoolSizes = poolSizes;
 
@@ -623,7 +636,7 @@ inline void SubScene::CreateInputAttachmentDescriptors(bool bCreateLayout)
 
 	if(bCreateLayout) 
 	{
-		m_inAttachLayoutBinding.descriptorCount = m_gBufferImages.Count() + 1; // +1 for depth image.
+		m_inAttachLayoutBinding.descriptorCount = m_gBufferAttachments.Count() + 1; // +1 for depth image.
 
 		// G Buffer set layout
 		RENDERER_SAFECALL(vkCreateDescriptorSetLayout(m_renderer->GetDevice(), &m_inAttachSetLayoutInfo, nullptr, &m_gBufferSetLayout), "SubScene Error: Failed to create G Buffer descriptor set layout.");
@@ -678,7 +691,7 @@ inline void SubScene::UpdateAllDescriptorSets()
 	VkWriteDescriptorSet gBufferWrite = {};
 	gBufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	gBufferWrite.dstSet = m_gBufferDescSet;
-	gBufferWrite.descriptorCount = m_gBufferImages.Count() + 1; // +1 for depth
+	gBufferWrite.descriptorCount = m_gBufferAttachments.Count() + 1; // +1 for depth
 	gBufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
 	gBufferWrite.dstArrayElement = 0;
 	gBufferWrite.pNext = nullptr;
@@ -690,14 +703,14 @@ inline void SubScene::UpdateAllDescriptorSets()
 	currentImageInfo.sampler = VK_NULL_HANDLE; // Input attachments do not need samplers.
 
 	// Add an image info for each G buffer image.
-	for (uint32_t i = 0; i < m_gBufferImages.Count(); ++i)
+	for (uint32_t i = 0; i < m_gBufferAttachments.Count(); ++i)
 	{
-		currentImageInfo.imageView = m_gBufferImages[i]->ImageView();
+		currentImageInfo.imageView = m_graph->GetTexture(m_gBufferAttachments[i])->ImageView();
 		allImageInfos.Push(currentImageInfo);
 	}
 
 	// Depth image info.
-	currentImageInfo.imageView = m_depthImage->ImageView();
+	currentImageInfo.imageView = m_graph->GetTexture(m_depthAttachment)->ImageView();
 	allImageInfos.Push(currentImageInfo);
 
 	// Set image infos.
@@ -717,252 +730,144 @@ inline void SubScene::CreateMVPUBOBuffers()
 	m_localMVPData.m_fNearPlane = NEAR_PLANE;
 	m_localMVPData.m_fFarPlane = FAR_PLANE;
 
-	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) 
-	{
-		// Create staging buffer...
-		m_renderer->CreateBuffer(sizeof(MVPUniformBuffer), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_mvpUBOStagingBuffers[i], m_mvpUBOStagingMemories[i]);
-
-		// Create device local buffer...
-		m_renderer->CreateBuffer(sizeof(MVPUniformBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_mvpUBOBuffers[i], m_mvpUBOMemories[i]);
-	}
-}
+	VkMemoryPropertyFlags memoryFlags = m_renderer->GetUploadArena()->PerFrameMemoryFlags();
 
-inline void SubScene::CreateOutputAttachmentDescription(VkAttachmentDescription& desc)
-{
-	desc = m_outputAttachmentDescription;
-	desc.format = m_outImage->Format();
+	// Create device local buffers, updated through the renderer's upload arena...
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) 
+		m_renderer->CreateBuffer(sizeof(MVPUniformBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryFlags, m_mvpUBOBuffers[i], m_mvpUBOMemories[i]);
 }
 
-inline void SubScene::CreateAttachmentDescriptions(const DynamicArray<Texture*>& targets, DynamicArray<VkAttachmentDescription>& attachments)
+inline void SubScene::BuildRenderGraph()
 {
-	// Reserve memory in array...
-	attachments.SetSize(targets.Count());
-	attachments.SetCount(attachments.GetSize());
-
-	// Assign description based on texture attachment type.
-	for (uint32_t i = 0; i < targets.Count(); ++i)
-	{
-		switch (targets[i]->GetAttachmentType())
-		{
-		case ATTACHMENT_COLOR:
-
-			// Assign HDR description if using HDR.
-			if(m_eGBufferImageBits & GBUFFER_COLOR_HDR_BIT)
-			    attachments[i] = m_colorHDRAttachmentDescription;
-			else
-				attachments[i] = m_colorAttachmentDescription;
+	// ---------------------------------------------------------------------------------
+	// Shadow mapping
 
-			break;
+	m_shadowMapGraphPass = m_graph->AddPass("Shadow Map");
+	m_graph->AddAccess(m_shadowMapGraphPass, m_shadowMapAttachment, RENDER_GRAPH_WRITE_DEPTH);
 
-		case ATTACHMENT_DEPTH_STENCIL:
-			attachments[i] = m_depthAttachmentDescription;
-			break;
+	// ---------------------------------------------------------------------------------
+	// G-Buffer
 
-		case ATTACHMENT_SWAP_CHAIN:
-			attachments[i] = m_swapChainAttachmentDescription;
-			break;
+	m_gBufferGraphPass = m_graph->AddPass("G-Buffer");
 
-		default:
-			RENDERER_SAFECALL(true, "Scene: Invalid Enum!");
-			break;
-		}
+	for (uint32_t i = 0; i < m_gBufferAttachments.Count(); ++i)
+		m_graph->AddAccess(m_gBufferGraphPass, m_gBufferAttachments[i], RENDER_GRAPH_WRITE_COLOR);
 
-		// Set format if different from default.
-		attachments[i].format = targets[i]->Format();
-	}
-}
+	if(m_depthAttachment != RENDER_GRAPH_INVALID_INDEX)
+	    m_graph->AddAccess(m_gBufferGraphPass, m_depthAttachment, RENDER_GRAPH_WRITE_DEPTH);
 
-inline void SubScene::CreateAttachmentReferences(const uint32_t& nIndexOffset, const DynamicArray<Texture*>& targets, DynamicArray<VkAttachmentReference>& references)
-{
-	references.SetSize(targets.Count());
-	references.SetCount(references.GetSize());
+	// ---------------------------------------------------------------------------------
+	// Occlusion culling
 
-	VkAttachmentReference ref = {};
+	m_occlusionGraphPass = RENDER_GRAPH_INVALID_INDEX;
+	m_gBufferLateGraphPass = RENDER_GRAPH_INVALID_INDEX;
 
-	// Set reference layouts based on attachment type.
-	for (uint32_t i = 0; i < targets.Count(); ++i)
+	// Instances not drawn by the G-Buffer pass are tested against its depth, & the visible ones drawn to the same attachments after.
+	// Only declared while occlusion culling is used, the late pass splits the G-Buffer & lighting subpasses into separate render passes.
+	if (OcclusionPassesRequired())
 	{
-		ref.attachment = nIndexOffset + i;
+		m_occlusionGraphPass = m_graph->AddComputePass("Occlusion Culling");
+		m_graph->AddAccess(m_occlusionGraphPass, m_depthAttachment, RENDER_GRAPH_READ_SAMPLED);
 
-		switch (targets[i]->GetAttachmentType())
-		{
-		case ATTACHMENT_COLOR:
-			ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			break;
-
-		case ATTACHMENT_DEPTH_STENCIL:
-			ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-			break;
-
-		case ATTACHMENT_SWAP_CHAIN:
-			ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			break;
-
-		default:
-			RENDERER_SAFECALL(true, "SubScene Error: Invalid Enum!");
-			break;
-		}
-
-		references[i] = ref;
-	}
-}
-
-inline void SubScene::CreateInputAttachmentReferences(const uint32_t& nIndexOffset, const DynamicArray<Texture*>& targets, DynamicArray<VkAttachmentReference>& references)
-{
-	references.SetSize(targets.Count());
-	references.SetCount(references.GetSize());
-
-	VkAttachmentReference ref = { nIndexOffset, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
-
-	for (uint32_t i = 0; i < targets.Count(); ++i)
-	{
-		references[i] = ref;
-		++ref.attachment;
-	}
-}
+		m_gBufferLateGraphPass = m_graph->AddPass("G-Buffer Late");
 
-inline void SubScene::CreateRenderPass()
-{
-	// ---------------------------------------------------------------------------------
-	// Delete old render pass.
+		for (uint32_t i = 0; i < m_gBufferAttachments.Count(); ++i)
+			m_graph->AddAccess(m_gBufferLateGraphPass, m_gBufferAttachments[i], RENDER_GRAPH_WRITE_COLOR);
 
-	if(m_pass) 
-	{
-		vkDestroyRenderPass(m_renderer->GetDevice(), m_pass, nullptr);
-		m_pass = VK_NULL_HANDLE;
+		m_graph->AddAccess(m_gBufferLateGraphPass, m_depthAttachment, RENDER_GRAPH_WRITE_DEPTH);
 	}
 
 	// ---------------------------------------------------------------------------------
-	// Descriptions
-
-	DynamicArray<Texture*> targetImages = { m_outImage };
-	DynamicArray<Texture*> shadowMapImages = { m_shadowMapImage };
-
-	VkAttachmentDescription targetDescription;
-
-	// Create attachment descriptions for output image.
-	CreateOutputAttachmentDescription(targetDescription);
-
-	DynamicArray<VkAttachmentDescription> shadowMapDescriptions;
-	CreateAttachmentDescriptions(shadowMapImages, shadowMapDescriptions);
-
-	DynamicArray<VkAttachmentDescription> gDescriptions;
-	CreateAttachmentDescriptions(m_gBufferImages, gDescriptions);
-
-	DynamicArray<Texture*> depthImages = { m_depthImage };
-
-	DynamicArray<VkAttachmentDescription> depthDescriptions;
-	CreateAttachmentDescriptions(depthImages, depthDescriptions);
-
-	DynamicArray<VkAttachmentDescription> allDescriptions;
-	allDescriptions.Push(targetDescription);
-	allDescriptions += shadowMapDescriptions + gDescriptions + depthDescriptions;
-
-	// ---------------------------------------------------------------------------------
-	// References
-
-	DynamicArray<VkAttachmentReference> targetRefs;
-	DynamicArray<VkAttachmentReference> targetInputRefs;
-
-	// Create attachment references for output image.
-	CreateAttachmentReferences(0, targetImages, targetRefs);
-	CreateInputAttachmentReferences(0, targetImages, targetInputRefs);
+	// Lighting
 
-	DynamicArray<VkAttachmentReference> shadowMapRefs;
-	CreateAttachmentReferences(targetImages.Count(), shadowMapImages, shadowMapRefs);
+	m_lightingGraphPass = m_graph->AddPass("Lighting");
 
-	DynamicArray<VkAttachmentReference> gBufferRefs;
-	CreateAttachmentReferences(targetImages.Count() + shadowMapImages.Count(), m_gBufferImages, gBufferRefs);
+	// Input attachment order must match the G Buffer descriptor set.
+	for (uint32_t i = 0; i < m_gBufferAttachments.Count(); ++i)
+		m_graph->AddAccess(m_lightingGraphPass, m_gBufferAttachments[i], RENDER_GRAPH_READ_INPUT);
 
-	DynamicArray<VkAttachmentReference> gBufferInputRefs;
-	CreateInputAttachmentReferences(targetImages.Count() + shadowMapImages.Count(), m_gBufferImages, gBufferInputRefs);
+	if (m_depthAttachment != RENDER_GRAPH_INVALID_INDEX)
+		m_graph->AddAccess(m_lightingGraphPass, m_depthAttachment, RENDER_GRAPH_READ_INPUT);
 
-	DynamicArray<VkAttachmentReference> depthRefs;
-	CreateAttachmentReferences(targetImages.Count() + m_gBufferImages.Count() + shadowMapImages.Count(), depthImages, depthRefs);
+	// The lighting shaders don't sample the shadow map yet, so the shadow mapping pass is culled. Once they do it must be declared here:
+	//m_graph->AddAccess(m_lightingGraphPass, m_shadowMapAttachment, RENDER_GRAPH_READ_SAMPLED);
 
-	DynamicArray<VkAttachmentReference> depthInputRefs;
-	CreateInputAttachmentReferences(targetImages.Count() + m_gBufferImages.Count() + shadowMapImages.Count(), depthImages, depthInputRefs);
+	m_graph->AddAccess(m_lightingGraphPass, m_outputAttachment, RENDER_GRAPH_WRITE_COLOR);
 
 	// ---------------------------------------------------------------------------------
-	// Subpasses
+	// Compile
 
-	VkSubpassDescription shadowMapSubpass = {};
-	shadowMapSubpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	shadowMapSubpass.colorAttachmentCount = 0;
-	shadowMapSubpass.pDepthStencilAttachment = shadowMapRefs.Data();
+	m_graph->Compile(m_nWidth, m_nHeight);
+	m_graph->PrintSummary();
+}
 
-	VkSubpassDescription gBufferSubpass = {};
-	gBufferSubpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	gBufferSubpass.colorAttachmentCount = gBufferRefs.Count();
-	gBufferSubpass.pColorAttachments = gBufferRefs.Data();
-	gBufferSubpass.pDepthStencilAttachment = depthRefs.Data();
+inline bool SubScene::OcclusionPassesRequired() const
+{
+	return m_depthAttachment != RENDER_GRAPH_INVALID_INDEX && m_bOcclusionCulling && IsGPUCulling() && m_gpuCuller->IsOcclusionAvailable();
+}
 
-	DynamicArray<VkAttachmentReference> lightingRefs = gBufferInputRefs + depthInputRefs;
+inline void SubScene::SetPassModules()
+{
+	m_graph->SetPassModule(m_shadowMapGraphPass, m_shadowMapModule);
+	m_graph->SetPassModule(m_gBufferGraphPass, m_gPass);
+	m_graph->SetPassModule(m_lightingGraphPass, m_lightManager);
 
-	VkSubpassDescription lightingSubpass = {};
-	lightingSubpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	lightingSubpass.colorAttachmentCount = 1;
-	lightingSubpass.pColorAttachments = &targetRefs[0];
-	lightingSubpass.inputAttachmentCount = lightingRefs.Count();
-	lightingSubpass.pInputAttachments = lightingRefs.Data();
-	lightingSubpass.pDepthStencilAttachment = VK_NULL_HANDLE; // No depth testing or writing needed for lighting.
+	// The late G-Buffer pass only exists while its graph pass does.
+	delete m_gLatePass;
+	m_gLatePass = nullptr;
 
-	VkSubpassDescription subpasses[SUB_PASS_COUNT] = { shadowMapSubpass, gBufferSubpass, lightingSubpass };
+	if (m_gBufferLateGraphPass == RENDER_GRAPH_INVALID_INDEX)
+		return;
 
-	// ---------------------------------------------------------------------------------
-	// Create Info
+	m_gLatePass = new GBufferPass(m_renderer, &m_allPipelines, m_commandPool, m_graph->GetRenderPass(m_gBufferLateGraphPass), m_graph->GetSubpassIndex(m_gBufferLateGraphPass), m_mvpUBODescSets,
+		m_nQueueFamilyIndex, CULL_PHASE_LATE);
+	m_gLatePass->SetProfilerScope(m_nLateProfilerScope);
 
-	VkRenderPassCreateInfo renderPassInfo = {};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.attachmentCount = allDescriptions.Count();
-	renderPassInfo.pAttachments = allDescriptions.Data();
-	renderPassInfo.subpassCount = SUB_PASS_COUNT;
-	renderPassInfo.pSubpasses = subpasses;
+	m_graph->SetPassModule(m_gBufferLateGraphPass, m_gLatePass);
 
-	// ---------------------------------------------------------------------------------
-	// Subpass Dependencies
+	// The depth of the early phase's draws is complete, test the remaining instances against it.
+	m_graph->SetPassCompute(m_occlusionGraphPass, [this](VkCommandBuffer cmdBuf, const uint32_t& nFrameIndex)
+	{
+		if (IsOcclusionCulling())
+			m_gpuCuller->CullLate(cmdBuf, m_graph->GetTexture(m_depthAttachment), nFrameIndex);
+	});
+}
 
-	const int nDependencyCount = 3;
-	VkSubpassDependency dependencies[nDependencyCount] = { m_shadowMapDependency, m_gBufferDependency, m_lightingDependency };
+void SubScene::RebuildRenderGraph()
+{
+	// Frames in flight may still be using the render passes & attachments being replaced.
+	vkDeviceWaitIdle(m_renderer->GetDevice());
 
-	renderPassInfo.dependencyCount = nDependencyCount;
-	renderPassInfo.pDependencies = dependencies;
+	// Passes can't be removed from a compiled render graph, so every pass & attachment is declared again.
+	delete m_graph;
+	delete m_outImage;
+	m_graph = new RenderGraph(m_renderer);
 
-	// ---------------------------------------------------------------------------------
-	// Create Render Pass
+	// The depth pyramid must not mistake a new depth attachment allocated at the old one's address for the old attachment.
+	if (m_gpuCuller)
+		m_gpuCuller->OnDepthAttachmentDestroyed();
 
-	RENDERER_SAFECALL(vkCreateRenderPass(m_renderer->GetDevice(), &renderPassInfo, nullptr, &m_pass), "Renderer Error: Failed to create render pass.");
-}
+	DynamicArray<MiscGBufferDesc> miscGAttachments = m_miscGAttachments;
+	CreateImages(m_eGBufferImageBits, m_eGBufferLayout, miscGAttachments);
+	BuildRenderGraph();
 
-inline void SubScene::CreateFramebuffers()
-{
-	// Destroy previous framebuffer if it exists.
-	if (m_framebuffer) 
-	{
-	    vkDestroyFramebuffer(m_renderer->GetDevice(), m_framebuffer, nullptr);
-		m_framebuffer = nullptr;
-	}
+	// Every render pass is re-created. The G-Buffer & lighting passes share a render pass only without the late G-Buffer pass,
+	// while the shadow map's render pass is declared the same way each time, so its pipeline stays compatible.
+	m_shadowMapModule->SetRenderPass(m_graph->GetRenderPass(m_shadowMapGraphPass), m_graph->GetSubpassIndex(m_shadowMapGraphPass));
+	m_gPass->SetRenderPass(m_graph->GetRenderPass(m_gBufferGraphPass), m_graph->GetSubpassIndex(m_gBufferGraphPass));
+	m_lightManager->SetRenderPass(m_graph->GetRenderPass(m_lightingGraphPass), m_graph->GetSubpassIndex(m_lightingGraphPass));
 
-	// Gather all images and extract their image views into another array.
-	DynamicArray<VkImageView> views(m_allImages.Count());
+	SetPassModules();
 
-	for (uint32_t i = 0; i < m_allImages.Count(); ++i)
+	// G-Buffer pipelines are created for the early & late G-Buffer passes, re-create them for the new ones.
+	for (uint32_t i = 0; i < m_allPipelines.Count(); ++i)
 	{
-		views.Push(m_allImages[i]->ImageView());
+		if (m_allPipelines[i]->m_renderObjects.Count() > 0)
+			m_allPipelines[i]->m_renderObjects[0]->RecreatePipeline();
 	}
 
-	VkFramebufferCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	createInfo.attachmentCount = views.Count();
-	createInfo.pAttachments = views.Data();
-	createInfo.renderPass = m_pass;
-	createInfo.layers = 1;
-	createInfo.width = m_nWidth;
-	createInfo.height = m_nHeight;
-	createInfo.flags = 0;
-	createInfo.pNext = nullptr;
-
-	RENDERER_SAFECALL(vkCreateFramebuffer(m_renderer->GetDevice(), &createInfo, nullptr, &m_framebuffer), "SubScene Error: Failed to create framebuffer.");
+	// The G-Buffer attachments are new, as after a resize.
+	RecreateAttachmentDescriptors();
 }
 
 inline void SubScene::CreateCmds()
@@ -1002,102 +907,140 @@ inline void SubScene::GetQueue()
 
 void SubScene::RecordPrimaryCmdBuffer(const uint32_t& nPresentImageIndex, const uint32_t& nFrameIndex, VkCommandBuffer& transferCmdBuf)
 {
+	CPU_PROFILE_ZONE("SubScene::RecordPrimaryCmdBuffer");
+
 	VkCommandBuffer cmdBuf = m_primaryCmdBufs[nFrameIndex];
 
 	// Begin recording...
 	RENDERER_SAFECALL(vkBeginCommandBuffer(cmdBuf, &m_primaryCmdBeginInfo), "Subscene Error: Failed to begin recording of primary command buffer.");
 
-	VkRect2D renderArea = { 0, 0, m_nWidth, m_nHeight };
+	GPUProfiler* profiler = m_renderer->GetGPUProfiler();
+
+	// Read back the GPU times of this frame index's last submission, the frame's fence has been waited on.
+	if (m_bPrimary)
+		profiler->BeginFrame(cmdBuf, nFrameIndex);
+
+	profiler->BeginScope(cmdBuf, nFrameIndex, m_nFrameProfilerScope);
+
+	// Adjust the render scale to the GPU time of the frame just read back.
+	m_dynamicResolution->BeginFrame();
+
+	// -------------------------------------------------------------------------------------
+	// Render area
+
+	VkExtent3D swapChainExtents = m_renderer->SwapChainImageExtents();
+	float fScale = m_dynamicResolution->Scale();
+
+	// Render to the top left of the images, so changing the scale never re-creates them.
+	m_nRenderWidth = std::min(std::max(static_cast<unsigned int>(swapChainExtents.width * fScale + 0.5f), 1u), m_nWidth);
+	m_nRenderHeight = std::min(std::max(static_cast<unsigned int>(swapChainExtents.height * fScale + 0.5f), 1u), m_nHeight);
 
-	VkRenderPassBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	beginInfo.clearValueCount = m_clearValues.Count();
-	beginInfo.pClearValues = m_clearValues.Data();
-	beginInfo.framebuffer = m_framebuffer;
-	beginInfo.renderArea = renderArea;
-	beginInfo.renderPass = m_pass;
-	beginInfo.pNext = nullptr;
+	m_graph->SetRenderArea(m_nRenderWidth, m_nRenderHeight);
+	m_gPass->SetRenderArea(m_nRenderWidth, m_nRenderHeight);
+	m_lightManager->SetRenderArea(m_nRenderWidth, m_nRenderHeight);
+
+	if (m_gLatePass)
+		m_gLatePass->SetRenderArea(m_nRenderWidth, m_nRenderHeight);
+
+	// At the swap chain's size there is nothing to resample, so render straight to the swap chain image & skip the blit.
+	bool bDirectOutput = m_bPrimary && m_graph->HasExternalOutput() && m_nRenderWidth == swapChainExtents.width && m_nRenderHeight == swapChainExtents.height;
 
 	// Update MVP UBO
-	UpdateMVPUBO(transferCmdBuf, nFrameIndex);
+	UpdateMVPUBO(nFrameIndex);
 
-	// Begin render pass instance.
-	vkCmdBeginRenderPass(cmdBuf, &beginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	// Cull instances for the camera & shadow map, & write the visible instances drawn by the modules this frame, or dispatch culling on the compute queue.
+	Frustum frusta[CULL_VIEW_COUNT];
+	frusta[CULL_VIEW_CAMERA] = Frustum::FromMatrix(m_localMVPData.m_proj * m_localMVPData.m_view);
+	frusta[CULL_VIEW_SHADOW] = m_shadowMapModule ? Frustum::FromMatrix(m_shadowMapModule->ViewProjection()) : frusta[CULL_VIEW_CAMERA];
 
-	// Shadow mapping subpass.
-	//if(m_shadowMapModule) 
-	//{
-	//	m_shadowMapModule->RecordCommandBuffer(nPresentImageIndex, nFrameIndex, beginInfo.framebuffer, transferCmdBuf);
-	//	vkCmdExecuteCommands(cmdBuf, 1, m_shadowMapModule->GetCommandBuffer(nFrameIndex));
-	//}
+	// Nothing draws the shadow map's instances while its pass is culled, so skip culling & uploading them.
+	uint32_t nViewMask = CULL_VIEW_MASK_ALL;
 
-	// Next subpass.
-	vkCmdNextSubpass(cmdBuf, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	if (m_graph->IsPassCulled(m_shadowMapGraphPass))
+		nViewMask &= ~CULL_VIEW_BIT(CULL_VIEW_SHADOW);
 
-	// G-Buffer Pass
-	m_gPass->RecordCommandBuffer(nPresentImageIndex, nFrameIndex, beginInfo.framebuffer, transferCmdBuf);
-	vkCmdExecuteCommands(cmdBuf, 1, m_gPass->GetCommandBuffer(nFrameIndex));
+	if(IsGPUCulling())
+	{
+		OcclusionCullView occlusionView = { m_localMVPData.m_proj * m_localMVPData.m_view, m_nRenderWidth, m_nRenderHeight };
 
-	// Next subpass.
-	vkCmdNextSubpass(cmdBuf, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		m_gpuCuller->Cull(m_allPipelines, frusta, nViewMask, IsOcclusionCulling() ? &occlusionView : nullptr, nFrameIndex);
+		m_cullWaitSemaphore = m_gpuCuller->CompleteSemaphore(nFrameIndex);
+	}
+	else
+	{
+		// Pixels per world space unit at a distance of one, for projecting LOD errors to the rendered area.
+		LODView lodView = { glm::vec3(m_localMVPData.m_v4ViewPos), 0.5f * static_cast<float>(m_nRenderHeight) * std::abs(m_localMVPData.m_proj[1][1]) };
 
-	// Execute lighting pass.
-	m_lightManager->RecordCommandBuffer(nPresentImageIndex, nFrameIndex, beginInfo.framebuffer, transferCmdBuf);
-	vkCmdExecuteCommands(cmdBuf, 1, m_lightManager->GetCommandBuffer(nFrameIndex));
+		m_culler->Cull(m_allPipelines, frusta, nViewMask, lodView, nFrameIndex);
+		m_cullWaitSemaphore = VK_NULL_HANDLE;
+	}
 
-	// End render pass instance.
-	vkCmdEndRenderPass(cmdBuf);
+	// Record the render passes of the graph, each pass' module records its own secondary command buffers.
+	m_graph->Execute(cmdBuf, nPresentImageIndex, nFrameIndex, transferCmdBuf, bDirectOutput);
 
-	// -------------------------------------------------------------------------------------
-	// Transition swap chain image layout to be optimal for transfer destination.
-
-	VkImageMemoryBarrier swapChainMembarrier = {};
-	swapChainMembarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	swapChainMembarrier.pNext = nullptr;
-	swapChainMembarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	swapChainMembarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	swapChainMembarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapChainMembarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	swapChainMembarrier.image = m_swapChainImages[nPresentImageIndex];
-	swapChainMembarrier.srcAccessMask = 0;
-	swapChainMembarrier.dstAccessMask = 0;
-	
-	VkImageSubresourceRange subresource = {};
-	subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresource.baseArrayLayer = 0;
-	subresource.baseMipLevel = 0;
-	subresource.levelCount = 1;
-	subresource.layerCount = 1;
-
-	swapChainMembarrier.subresourceRange = subresource;
-
-	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &swapChainMembarrier);
+	if(!bDirectOutput)
+	{
+		profiler->BeginScope(cmdBuf, nFrameIndex, m_nBlitProfilerScope);
 
-	// -------------------------------------------------------------------------------------
-	// Blit output image onto the swap chain image.
+		// -------------------------------------------------------------------------------------
+		// Transition swap chain image layout to be optimal for transfer destination.
 
-	VkImageSubresourceLayers subresourceLayers = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		VkImageMemoryBarrier swapChainMembarrier = {};
+		swapChainMembarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		swapChainMembarrier.pNext = nullptr;
+		swapChainMembarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		swapChainMembarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		swapChainMembarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		swapChainMembarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		swapChainMembarrier.image = m_swapChainImages[nPresentImageIndex];
+		swapChainMembarrier.srcAccessMask = 0;
+		swapChainMembarrier.dstAccessMask = 0;
 
-	VkOffset3D firstOffset = { 0, 0, 0 };
-	VkOffset3D secondOffset = { static_cast<int>(m_nWidth), static_cast<int>(m_nHeight), 1 };
-	VkOffset3D swapChainOffset = *((VkOffset3D*)&m_renderer->SwapChainImageExtents());
-	VkImageBlit blitRegion = { subresourceLayers, { firstOffset, secondOffset }, subresourceLayers, { firstOffset, swapChainOffset } };
+		VkImageSubresourceRange subresource = {};
+		subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresource.baseArrayLayer = 0;
+		subresource.baseMipLevel = 0;
+		subresource.levelCount = 1;
+		subresource.layerCount = 1;
 
-	// Blit the images with bilinear filtering, to downsample correctly.
-	vkCmdBlitImage(cmdBuf, m_outImage->ImageHandle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_swapChainImages[nPresentImageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blitRegion, VK_FILTER_LINEAR);
+		swapChainMembarrier.subresourceRange = subresource;
 
-	// -------------------------------------------------------------------------------------
-	// Transition swap chain image layout back to present layout.
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0, 0, 0, 1, &swapChainMembarrier);
+
+		// -------------------------------------------------------------------------------------
+		// Blit the rendered area of the output image onto the swap chain image.
+
+		VkImageSubresourceLayers subresourceLayers = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
 
-	swapChainMembarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		VkOffset3D firstOffset = { 0, 0, 0 };
+		VkOffset3D secondOffset = { static_cast<int>(m_nRenderWidth), static_cast<int>(m_nRenderHeight), 1 };
+		VkOffset3D swapChainOffset = { static_cast<int>(swapChainExtents.width), static_cast<int>(swapChainExtents.height), 1 };
+		VkImageBlit blitRegion = { subresourceLayers, { firstOffset, secondOffset }, subresourceLayers, { firstOffset, swapChainOffset } };
 
-	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 0, 0, 1, &swapChainMembarrier);
+		// Blit the images with bilinear filtering, to resample correctly in either direction.
+		vkCmdBlitImage(cmdBuf, m_outImage->ImageHandle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_swapChainImages[nPresentImageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blitRegion, VK_FILTER_LINEAR);
+
+		// -------------------------------------------------------------------------------------
+		// Transition swap chain image layout back to present layout, or to the readback layout when headless.
+
+		swapChainMembarrier.newLayout = m_renderer->OutputImageLayout();
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, 0, 0, 0, 1, &swapChainMembarrier);
+
+		profiler->EndScope(cmdBuf, nFrameIndex, m_nBlitProfilerScope);
+	}
+
+	profiler->EndScope(cmdBuf, nFrameIndex, m_nFrameProfilerScope);
+
+	// Copy headless output to host memory if requested, outside of the measured frame.
+	if (m_bPrimary)
+		m_renderer->RecordOutputReadback(cmdBuf, nPresentImageIndex, nFrameIndex);
 
 	// Finish recording.
 	RENDERER_SAFECALL(vkEndCommandBuffer(cmdBuf), "SubScene Error: Failed to end recording of dynamic object command buffer.");
 }
 
-inline void SubScene::UpdateMVPUBO(const VkCommandBuffer& cmdBuffer, const uint32_t& nFrameIndex)
+inline void SubScene::UpdateMVPUBO(const uint32_t& nFrameIndex)
 {
 	// Change coordinate system using this matrix.
 	glm::mat4 axisCorrection; // Inverts the Y axis to match the OpenGL coordinate system.
@@ -1106,7 +1049,10 @@ inline void SubScene::UpdateMVPUBO(const VkCommandBuffer& cmdBuffer, const uint3
 	axisCorrection[3][3] = 1.0f;
 
 	// Update local projection matrix.
-	m_localMVPData.m_proj = axisCorrection * glm::perspective(glm::radians(45.0f), static_cast<float>(m_nWidth) / static_cast<float>(m_nHeight), NEAR_PLANE, FAR_PLANE);
+	m_localMVPData.m_proj = axisCorrection * glm::perspective(glm::radians(45.0f), static_cast<float>(m_nRenderWidth) / static_cast<float>(m_nRenderHeight), NEAR_PLANE, FAR_PLANE);
+
+	// Lighting shaders map fragment coordinates to the rendered area.
+	m_localMVPData.m_v2FramebufferDim = glm::vec2(static_cast<float>(m_nRenderWidth), static_cast<float>(m_nRenderHeight));
 
 	// Update inverse of view & projection matrix, which can be used to transform clip space to world space.
 	m_localMVPData.m_invView = glm::inverse(m_localMVPData.m_view);
@@ -1114,16 +1060,6 @@ inline void SubScene::UpdateMVPUBO(const VkCommandBuffer& cmdBuffer, const uint3
 
 	uint32_t nBufferSize = sizeof(MVPUniformBuffer);
 
-	// Map & Update buffer contents...
-	void* buffer = nullptr;
-	vkMapMemory(m_renderer->GetDevice(), m_mvpUBOStagingMemories[nFrameIndex], 0, nBufferSize, 0, &buffer);
-
-	// Copy...
-	std::memcpy(buffer, &m_localMVPData, nBufferSize);
-
-	vkUnmapMemory(m_renderer->GetDevice(), m_mvpUBOStagingMemories[nFrameIndex]);
-
-	// Issue staging buffer to device local buffer copy command.
-	VkBufferCopy copyRegion = { 0, 0, nBufferSize };
-	vkCmdCopyBuffer(cmdBuffer, m_mvpUBOStagingBuffers[nFrameIndex], m_mvpUBOBuffers[nFrameIndex], 1, &copyRegion);
+	// Write to this frame's UBO, directly or through the upload arena...
+	m_renderer->GetUploadArena()->Write(m_mvpUBOBuffers[nFrameIndex], m_mvpUBOMemories[nFrameIndex], 0, &m_localMVPData, nBufferSize, true);
 }
@@ -3,9 +3,12 @@
 #include "DynamicArray.h"
 #include "VertexInfo.h"
 #include "Renderer.h"
+#include "RenderGraph.h"
+#include "DynamicResolution.h"
+#include "DrawList.h"
 
 /*
-Description: A Render Pass & collection of modules & render objects for rendering a scene to a texture or swap chain image.
+Description: A Render Graph & collection of modules & render objects for rendering a scene to a texture or swap chain image.
 Author: Nic Van Zuylen
 */
 
@@ -13,14 +16,13 @@ class RenderModule;
 class GBufferPass;
 class LightingManager;
 class ShadowMap;
+class FrustumCuller;
+class GPUCuller;
 class Texture;
 class Material;
 
 struct Shader;
 
-#define SUB_PASS_COUNT 3
-#define POST_SUBPASS_INDEX ~0
-
 #define NEAR_PLANE 0.1f
 #define FAR_PLANE 1000.0f
 
@@ -33,6 +35,16 @@ enum EGBufferAttachmentTypeBit
 	GBUFFER_NORMAL_BIT = 1 << 4,
 };
 
+// Encoding of the G-Buffer's color & normal attachments.
+enum EGBufferLayout
+{
+	GBUFFER_LAYOUT_STANDARD, // RGBA16F color & normals, optional RGBA16F position.
+	GBUFFER_LAYOUT_COMPACT // R11G11B10F HDR color, octahedral RG16F normals & position reconstructed from depth.
+};
+
+// Specialization constant ID of the compact G-Buffer switch in the model & lighting fragment shaders.
+#define GBUFFER_LAYOUT_CONSTANT_ID 0
+
 enum EMiscGBufferType 
 {
 	GBUFFER_MISC_8_BIT,
@@ -55,6 +67,7 @@ struct SubSceneParams
 	Shader* m_dirLightShader;
 	Shader* m_pointLightShader;
 	EGBufferAttachmentTypeBit eAttachmentBits;
+	EGBufferLayout m_eGBufferLayout;
 	DynamicArray<MiscGBufferDesc> m_miscGAttachments; // Misc G-Buffer attachments to add.
 	bool m_bPrimary;
 };
@@ -64,8 +77,9 @@ struct PipelineData
 {
 	PipelineData();
 
-	Material* m_material;
+	DynamicArray<Material*> m_materials; // Distinct materials of the objects using this pipeline, which share its layout & bind their own descriptor sets.
 	VkPipeline m_handle;
+	VkPipeline m_lateHandle; // Pipeline of the late G-Buffer pass, nullptr without occlusion culling's pass split.
 	VkPipelineLayout m_layout;
 	DynamicArray<EVertexAttribute> m_vertexAttributes;
 	DynamicArray<RenderObject*> m_renderObjects; // All objects using this pipeline.
@@ -100,12 +114,13 @@ public:
 	~SubScene();
 
 	/*
-	Description: Set which G Buffer images this Subscene will create & use. 
+	Description: Set which G Buffer images this Subscene will create & use, by declaring them as render graph attachments. Must be called before the render graph is compiled.
 	Param:
 	    EGBufferImageTypeBit eImageBits: Bit field of the images to create & use for rendering.
+		EGBufferLayout eLayout: Encoding of the color & normal images, the compact layout never creates a position image.
 		const DynamicArray<EMiscGBufferType>& miscGBuffers: Formats for extra g buffer images to create.
     */
-	void CreateImages(EGBufferAttachmentTypeBit eImageBits, const DynamicArray<MiscGBufferDesc>& miscGBuffers);
+	void CreateImages(EGBufferAttachmentTypeBit eImageBits, EGBufferLayout eLayout, const DynamicArray<MiscGBufferDesc>& miscGBuffers);
 
 	/*
 	Description: Resize the output framebuffer of this subscene
@@ -145,7 +160,7 @@ public:
 	*/
 	VkCommandBuffer& GetCommandBuffer(const uint32_t nIndex);
 
-	const VkRenderPass& GetRenderPass();
+	RenderGraph* GetRenderGraph();
 
 	VkDescriptorSetLayout MVPUBOLayout();
 
@@ -153,10 +168,92 @@ public:
 
 	GBufferPass* GetGBufferPass();
 
+	/*
+	Description: Get the G-Buffer pass drawing instances found visible by the late phase of occlusion culling, nullptr if the G-Buffer has no depth to cull against.
+	Return Type: GBufferPass*
+	*/
+	GBufferPass* GetLateGBufferPass();
+
 	const uint32_t GetGBufferCount();
 
+	/*
+	Description: Get the specialization info selecting the G-Buffer encoding, for fragment shaders writing or reading the G-Buffer.
+	Return Type: const VkSpecializationInfo*
+	*/
+	const VkSpecializationInfo* GetGBufferSpecializationInfo() const;
+
 	LightingManager* GetLightingManager();
 
+	/*
+	Description: Get the controller of the render scale this subscene renders at.
+	Return Type: DynamicResolution*
+	*/
+	DynamicResolution* GetDynamicResolution();
+
+	/*
+	Description: Get the culler of this subscene's render object instances.
+	Return Type: FrustumCuller*
+	*/
+	FrustumCuller* GetFrustumCuller();
+
+	/*
+	Description: Switch between culling instances on the CPU & culling them on the compute queue with indirect draws. GPU culling falls back to CPU culling if the culling shader is unavailable.
+	             Rebuilds the render graph when this adds or removes the occlusion culling passes, waiting for the device to be idle.
+	Param:
+	    bool bEnabled: Whether or not to cull on the GPU.
+	*/
+	void SetGPUCulling(bool bEnabled);
+
+	/*
+	Description: Get whether or not instances are culled on the GPU.
+	Return Type: bool
+	*/
+	bool IsGPUCulling() const;
+
+	/*
+	Description: Get the GPU culler of this subscene, nullptr if GPU culling was never enabled.
+	Return Type: GPUCuller*
+	*/
+	GPUCuller* GetGPUCuller();
+
+	/*
+	Description: Enable or disable occlusion culling of the camera's instances against the depth of the instances drawn first, only applied while culling on the GPU.
+	             Rebuilds the render graph when this adds or removes the occlusion culling passes, waiting for the device to be idle.
+	Param:
+	    bool bEnabled: Whether or not to cull occluded instances.
+	*/
+	void SetOcclusionCulling(bool bEnabled);
+
+	/*
+	Description: Get whether or not occluded instances are culled, requires GPU culling, a depth attachment & the occlusion culling shaders.
+	Return Type: bool
+	*/
+	bool IsOcclusionCulling() const;
+
+	/*
+	Description: Get the semaphore the last recorded frame's rendering must wait on before drawing, VK_NULL_HANDLE if there is nothing to wait on.
+	Return Type: VkSemaphore
+	*/
+	VkSemaphore CullWaitSemaphore() const;
+
+	/*
+	Description: Get the amount of draw commands recorded by this subscene's modules in the last recorded frame.
+	Return Type: uint32_t
+	*/
+	uint32_t DrawCallCount() const;
+
+	/*
+	Description: Get the binds issued & skipped by this subscene's G-Buffer passes in the last recorded frame.
+	Return Type: DrawListStats
+	*/
+	DrawListStats GBufferBindStats() const;
+
+	/*
+	Description: Get the GPU profiler scope timing this subscene's whole primary command buffer, GPU_PROFILER_INVALID_SCOPE if timestamps are unsupported.
+	Return Type: uint32_t
+	*/
+	uint32_t FrameProfilerScope() const;
+
 	Renderer* GetRenderer();
 
 private:
@@ -195,34 +292,32 @@ private:
 	inline void CreateMVPUBOBuffers();
 
 	/*
-	Description: Create VkAttachmentDescription structures for output images to aid in render pass creation.
-	*/
-	inline void CreateOutputAttachmentDescription(VkAttachmentDescription& desc);
-
-	/*
-	Description: Create VkAttachmentDescription structures to aid in render pass creation.
+	Description: Declare the shadow mapping, G-Buffer & lighting passes & compile the render graph into render passes. The occlusion culling & late G-Buffer passes are declared
+	             only while occlusion culling is used.
 	*/
-	inline void CreateAttachmentDescriptions(const DynamicArray<Texture*>& targets, DynamicArray<VkAttachmentDescription>& attachments);
+	inline void BuildRenderGraph();
 
 	/*
-	Description: Create VkAttachmentReference structures to aid in render pass creation.
+	Description: Get whether or not the render graph needs the occlusion culling & late G-Buffer passes, which requires occlusion culling to be enabled & available & a depth attachment.
+	Return Type: bool
 	*/
-	inline void CreateAttachmentReferences(const uint32_t& nIndexOffset, const DynamicArray<Texture*>& targets, DynamicArray<VkAttachmentReference>& references);
+	inline bool OcclusionPassesRequired() const;
 
 	/*
-	Description: Create input attachment VkAttachmentReference structures to aid in render pass creation.
+	Description: Give the render graph's passes their modules, creating the late G-Buffer pass module if the graph has its pass or deleting it if not.
 	*/
-	inline void CreateInputAttachmentReferences(const uint32_t& nIndexOffset, const DynamicArray<Texture*>& targets, DynamicArray<VkAttachmentReference>& references);
+	inline void SetPassModules();
 
 	/*
-	Description: Create render pass for this subscene.
+	Description: Re-declare & compile the render graph after the occlusion culling passes are added or removed. Modules are moved to the new render passes
+	             & the G-Buffer & lighting pipelines are re-created for them.
 	*/
-	inline void CreateRenderPass();
+	void RebuildRenderGraph();
 
 	/*
-	Description: Create the framebuffer for this subscene.
+	Description: Re-create the descriptor sets referencing the render graph's attachments & give them to the modules, after the attachments are re-created.
 	*/
-	inline void CreateFramebuffers();
+	inline void RecreateAttachmentDescriptors();
 
 	/*
 	Description: Create command pool & primary command buffers.
@@ -237,7 +332,7 @@ private:
 	// ---------------------------------------------------------------------------------
 	// Private runtime functions
 
-	inline void UpdateMVPUBO(const VkCommandBuffer& cmdBuffer, const uint32_t& nFrameIndex);
+	inline void UpdateMVPUBO(const uint32_t& nFrameIndex);
 
 	// ---------------------------------------------------------------------------------
 	// Vulkan structure templates
@@ -254,18 +349,6 @@ private:
 	
 	static VkDescriptorSetAllocateInfo m_descAllocInfo; // Descriptor alloc info for descriptors for each frame in flight.
 
-	static VkAttachmentDescription m_swapChainAttachmentDescription;
-	static VkAttachmentDescription m_outputAttachmentDescription;
-	static VkAttachmentDescription m_depthAttachmentDescription;
-	static VkAttachmentDescription m_colorAttachmentDescription;
-	static VkAttachmentDescription m_colorHDRAttachmentDescription;
-	static VkAttachmentDescription m_vectorAttachmentDescription;
-
-	static VkSubpassDependency m_shadowMapDependency; // Subpass dependency for the shadow mapping pass.
-	static VkSubpassDependency m_gBufferDependency; // Subpass dependency for g-buffer subpass.
-	static VkSubpassDependency m_lightingDependency; // Subpass dependency for lighting subpass.
-	static VkSubpassDependency m_postDependency; // Subpass dependency for all post effects.
-
 	static VkCommandBufferBeginInfo m_primaryCmdBeginInfo; // Begin info for primary command buffer recording.
 
 	static VkSubmitInfo m_renderSubmitInfo;
@@ -286,11 +369,8 @@ private:
 	MVPUniformBuffer m_localMVPData;
 
 	// Camera UBOs
-	VkBuffer m_mvpUBOStagingBuffers[MAX_FRAMES_IN_FLIGHT];
-	VkDeviceMemory m_mvpUBOStagingMemories[MAX_FRAMES_IN_FLIGHT];
-
 	VkBuffer m_mvpUBOBuffers[MAX_FRAMES_IN_FLIGHT];
-	VkDeviceMemory m_mvpUBOMemories[MAX_FRAMES_IN_FLIGHT];
+	MemAllocation m_mvpUBOMemories[MAX_FRAMES_IN_FLIGHT];
 
 	// UBO descriptors.
 	VkDescriptorSetLayout m_mvpUBOSetLayout;
@@ -301,23 +381,34 @@ private:
 
 	ShadowMap* m_shadowMapModule;
 	GBufferPass* m_gPass;
+	GBufferPass* m_gLatePass; // Draws instances of the late occlusion culling phase, nullptr while the render graph has no late G-Buffer pass.
 	LightingManager* m_lightManager;
 
+	FrustumCuller* m_culler; // Culls instances against the camera & shadow map camera before the modules record.
+	GPUCuller* m_gpuCuller; // Culls instances on the compute queue instead while GPU culling is enabled, created when first enabled.
+	bool m_bGPUCulling;
+	bool m_bOcclusionCulling;
+	VkSemaphore m_cullWaitSemaphore;
+
 	// ---------------------------------------------------------------------------------
 	// Render target images.
 
 	EGBufferAttachmentTypeBit m_eGBufferImageBits;
+	EGBufferLayout m_eGBufferLayout;
 	DynamicArray<MiscGBufferDesc> m_miscGAttachments;
 
+	// Shader specialization for the G-Buffer layout.
+	VkBool32 m_bCompactGBuffer;
+	VkSpecializationMapEntry m_gBufferSpecEntry;
+	VkSpecializationInfo m_gBufferSpecInfo;
+
 	Texture* m_shadowMapImage;
-	Texture* m_colorImage;
-	Texture* m_depthImage;
-	Texture* m_posImage;
-	Texture* m_normalImage;
 
-	DynamicArray<Texture*> m_gBufferImages;
-	DynamicArray<Texture*> m_allImages;
-	DynamicArray<VkClearValue> m_clearValues;
+	// Render graph attachments, the G-Buffer images are created & owned by the render graph.
+	RenderGraphResource m_outputAttachment;
+	RenderGraphResource m_shadowMapAttachment;
+	RenderGraphResource m_depthAttachment;
+	DynamicArray<RenderGraphResource> m_gBufferAttachments;
 
 	// ---------------------------------------------------------------------------------
 	// Render target image descriptors
@@ -332,12 +423,16 @@ private:
 
 	DynamicArray<VkImage> m_swapChainImages;
 	DynamicArray<VkImageView> m_swapchainImageViews;
-	VkFramebuffer m_framebuffer;
 
 	// ---------------------------------------------------------------------------------
-	// Render pass
-
-	VkRenderPass m_pass; // Render pass handle used to render this subscene.
+	// Render graph
+
+	RenderGraph* m_graph; // Builds the render passes & framebuffers used to render this subscene.
+	RenderGraphPass m_shadowMapGraphPass;
+	RenderGraphPass m_gBufferGraphPass;
+	RenderGraphPass m_occlusionGraphPass; // Builds the depth pyramid & runs the late culling phase.
+	RenderGraphPass m_gBufferLateGraphPass;
+	RenderGraphPass m_lightingGraphPass;
 	unsigned int m_nQueueFamilyIndex;
 
 	// ---------------------------------------------------------------------------------
@@ -348,6 +443,14 @@ private:
 
 	VkQueue m_renderQueue;
 
+	// ---------------------------------------------------------------------------------
+	// Profiling
+
+	// GPU profiler scopes of the whole primary command buffer & the blit to the swap chain image. Modules time their own passes.
+	uint32_t m_nFrameProfilerScope;
+	uint32_t m_nBlitProfilerScope;
+	uint32_t m_nLateProfilerScope; // Given to the late G-Buffer pass each time it is created.
+
 	// ---------------------------------------------------------------------------------
 	// Member objects.
 
@@ -360,6 +463,11 @@ private:
 	unsigned int m_nWidth;
 	unsigned int m_nHeight;
 
+	// Area of the output rendered to this frame, the dynamic render scale applied to the swap chain size.
+	unsigned int m_nRenderWidth;
+	unsigned int m_nRenderHeight;
+	DynamicResolution* m_dynamicResolution;
+
 	Texture* m_outImage; // Output image of this scene.
 
 	bool m_bPrimary; // Whether or not this is a primary subscene (renders to swap chain image).
@@ -1,4 +1,5 @@
 #include "Texture.h"
+#include "CPUProfiler.h"
 #include <iostream>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -6,17 +7,9 @@
 
 Texture::Texture(Renderer* renderer, const char* szFilePath) 
 {
-	m_renderer = renderer;
-	m_name = szFilePath;
-	m_name = m_name.substr(m_name.find_last_of("/") + 1); // Remove the rest of the path from the name, to reduce memory usage and hashing time.
-	m_data = nullptr;
+	CPU_PROFILE_ZONE("Texture Load");
 
-	m_nWidth = 0;
-	m_nHeight = 0;
-	m_nChannels = 0;
-	m_type = ATTACHMENT_COLOR;
-	m_bHasStencil = false;
-	m_bOwnsTexture = true;
+	InitFileTexture(renderer, szFilePath);
 
 	if (!szFilePath)
 		return;
@@ -24,21 +17,21 @@ Texture::Texture(Renderer* renderer, const char* szFilePath)
 	// Load image...
 	m_data = stbi_load(szFilePath, &m_nWidth, &m_nHeight, &m_nChannels, STBI_rgb_alpha);
 
-	if(m_data) 
-	{
-		std::cout << "Successfully loaded image: " << szFilePath << std::endl;
+	FinishFileLoad(szFilePath);
+}
 
-		// Stage the image, create the final image buffer and transfer contents, image layouts and access flags.
-		StageImage();
+Texture::Texture(Renderer* renderer, const char* szFilePath, unsigned char* data, int nWidth, int nHeight, int nChannels)
+{
+	CPU_PROFILE_ZONE("Texture Load");
 
-		// Destroy staging buffer.
-		vkDestroyBuffer(renderer->GetDevice(), m_stagingBuffer, nullptr);
-		vkFreeMemory(renderer->GetDevice(), m_stagingMemory, nullptr);
-	}
-	else
-	{
-		std::cout << "Failed to load image: " << szFilePath << std::endl;
-	}
+	InitFileTexture(renderer, szFilePath);
+
+	m_data = data;
+	m_nWidth = nWidth;
+	m_nHeight = nHeight;
+	m_nChannels = nChannels;
+
+	FinishFileLoad(szFilePath);
 }
 
 Texture::Texture(Renderer* renderer, uint32_t nWidth, uint32_t nHeight, EAttachmentType type, VkFormat format, uint32_t properties, VkImageUsageFlags additionalUsageFlags)
@@ -49,6 +42,9 @@ Texture::Texture(Renderer* renderer, uint32_t nWidth, uint32_t nHeight, EAttachm
 	m_type = type;
 	m_bHasStencil = false;
 	m_bOwnsTexture = true;
+	m_bLazilyAllocated = false;
+	m_imageMemory = {};
+	m_uploadToken = 0;
 
 	m_format = format;
 
@@ -62,6 +58,9 @@ Texture::Texture(Renderer* renderer, uint32_t nWidth, uint32_t nHeight, EAttachm
 	if (properties & TEXTURE_PROPERTIES_TRANSFER_SRC)
 		usageFlags = static_cast<VkImageUsageFlagBits>(usageFlags | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 
+	if (properties & TEXTURE_PROPERTIES_TRANSIENT)
+		usageFlags = static_cast<VkImageUsageFlagBits>(usageFlags | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT);
+
 	switch (type)
 	{
 	case ATTACHMENT_COLOR:
@@ -74,8 +73,9 @@ Texture::Texture(Renderer* renderer, uint32_t nWidth, uint32_t nHeight, EAttachm
 	    CreateImage(m_imageHandle, m_imageMemory, m_nWidth, m_nHeight, m_format, VK_IMAGE_TILING_OPTIMAL, usageFlags);
 		CreateImageView(m_imageHandle, m_imageView, m_format, aspect);
 
-		// Transition layout from undefined to optimal layout.
-		TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, m_format);
+		// Transition layout from undefined to optimal layout. Transient attachments are always cleared or discarded on load, so they are left undefined.
+		if (!(properties & TEXTURE_PROPERTIES_TRANSIENT))
+			TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, m_format);
 
 		break;
 
@@ -98,7 +98,8 @@ Texture::Texture(Renderer* renderer, uint32_t nWidth, uint32_t nHeight, EAttachm
 		CreateImageView(m_imageHandle, m_imageView, m_format, aspect);
 
 		// Transition layout from undefined to optimal layout.
-		TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, m_format);
+		if (!(properties & TEXTURE_PROPERTIES_TRANSIENT))
+			TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, m_format);
 
 		break;
 
@@ -111,12 +112,14 @@ Texture::~Texture()
 {
 	if (m_bOwnsTexture)
 	{
+		// The upload or layout transition may still be pending.
+		m_renderer->GetUploadContext()->Wait(m_uploadToken);
 		m_renderer->WaitGraphicsIdle();
 
 		// Destroy texture image.
 		vkDestroyImageView(m_renderer->GetDevice(), m_imageView, nullptr);
 		vkDestroyImage(m_renderer->GetDevice(), m_imageHandle, nullptr);
-		vkFreeMemory(m_renderer->GetDevice(), m_imageMemory, nullptr);
+		m_renderer->FreeMemory(m_imageMemory);
 	}
 }
 
@@ -165,37 +168,107 @@ bool Texture::IsPresented()
 	return m_bPresented;
 }
 
-void Texture::StageImage() 
+VkDeviceSize Texture::GetMemorySize() const
 {
-	unsigned long long textureSize = m_nWidth * m_nHeight * sizeof(unsigned int);
+	return m_imageMemory.m_nSize;
+}
 
-	// Create image staging buffer.
-	m_renderer->CreateBuffer(textureSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_stagingBuffer, m_stagingMemory);
+bool Texture::IsLazilyAllocated() const
+{
+	return m_bLazilyAllocated;
+}
 
-	// Map memory and copy image to buffer.
-	void* buffer = nullptr;
-	vkMapMemory(m_renderer->GetDevice(), m_stagingMemory, 0, textureSize, 0, &buffer);
+void Texture::LoadBatch(Renderer* renderer, const char* const* filePaths, uint32_t nCount, Texture** outTextures)
+{
+	struct DecodedImage
+	{
+		unsigned char* m_data;
+		int m_nWidth;
+		int m_nHeight;
+		int m_nChannels;
+	};
 
-	// Copy memory.
-	memcpy_s(buffer, textureSize, m_data, textureSize);
+	DecodedImage* images = new DecodedImage[nCount];
 
-	// Unmap buffer.
-	vkUnmapMemory(m_renderer->GetDevice(), m_stagingMemory);
+	// Decoding is CPU bound & independent per file, one job per image.
+	renderer->GetJobSystem()->ParallelFor(nCount, 1, [&](uint32_t nStart, uint32_t nEnd)
+	{
+		for (uint32_t i = nStart; i < nEnd; ++i)
+		{
+			DecodedImage& image = images[i];
+			image.m_data = stbi_load(filePaths[i], &image.m_nWidth, &image.m_nHeight, &image.m_nChannels, STBI_rgb_alpha);
+		}
+	});
 
-	// Host-side image data is no longer needed.
-	stbi_image_free(m_data);
+	// Image creation & uploads use renderer objects which are not thread safe.
+	for (uint32_t i = 0; i < nCount; ++i)
+	{
+		DecodedImage& image = images[i];
+		outTextures[i] = new Texture(renderer, filePaths[i], image.m_data, image.m_nWidth, image.m_nHeight, image.m_nChannels);
+	}
+
+	delete[] images;
+}
+
+inline void Texture::InitFileTexture(Renderer* renderer, const char* szFilePath)
+{
+	m_renderer = renderer;
 	m_data = nullptr;
 
+	if (szFilePath)
+	{
+		m_name = szFilePath;
+		m_name = m_name.substr(m_name.find_last_of("/") + 1); // Remove the rest of the path from the name, to reduce memory usage and hashing time.
+	}
+
+	m_nWidth = 0;
+	m_nHeight = 0;
+	m_nChannels = 0;
+	m_type = ATTACHMENT_COLOR;
+	m_bHasStencil = false;
+	m_bOwnsTexture = true;
+	m_bLazilyAllocated = false;
+	m_imageMemory = {};
+	m_uploadToken = 0;
+}
+
+inline void Texture::FinishFileLoad(const char* szFilePath)
+{
+	if(m_data) 
+	{
+		std::cout << "Successfully loaded image: " << szFilePath << std::endl;
+
+		// Create the final image and queue its contents for upload.
+		StageImage();
+	}
+	else
+	{
+		std::cout << "Failed to load image: " << szFilePath << std::endl;
+	}
+}
+
+void Texture::StageImage() 
+{
+	unsigned long long textureSize = m_nWidth * m_nHeight * sizeof(unsigned int);
+
 	m_format = VK_FORMAT_R8G8B8A8_UNORM;
 
 	// Create image.
 	m_renderer->CreateImage(m_imageHandle, m_imageMemory, m_nWidth, m_nHeight, m_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 
-	// Next step.
-	TransferContents();
+	// Copy to the upload context's staging memory, the copy & transition to shader read only layout are batched with other uploads.
+	m_uploadToken = m_renderer->GetUploadContext()->UploadImage(m_imageHandle, m_nWidth, m_nHeight, m_data, textureSize, 
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	// Host-side image data is no longer needed.
+	stbi_image_free(m_data);
+	m_data = nullptr;
+
+	// Create image view.
+	m_renderer->CreateImageView(m_imageHandle, m_imageView, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
 }
 
-void Texture::CreateImage(VkImage& image, VkDeviceMemory& imageMemory, const uint32_t& nWidth, const uint32_t& nHeight, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage)
+void Texture::CreateImage(VkImage& image, MemAllocation& imageMemory, const uint32_t& nWidth, const uint32_t& nHeight, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage)
 {
 	VkImageCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -216,21 +289,8 @@ void Texture::CreateImage(VkImage& image, VkDeviceMemory& imageMemory, const uin
 	// Create image.
 	RENDERER_SAFECALL(vkCreateImage(m_renderer->GetDevice(), &createInfo, nullptr, &image), "Texture Error: Failed to create image object.");
 
-	// Get image memory requirements.
-	VkMemoryRequirements imageMemRequirements;
-	vkGetImageMemoryRequirements(m_renderer->GetDevice(), image, &imageMemRequirements);
-
-	// Memory allocation info.
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = imageMemRequirements.size;
-	allocInfo.memoryTypeIndex = m_renderer->FindMemoryType(imageMemRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	// Allocate image buffer memory.
-	RENDERER_SAFECALL(vkAllocateMemory(m_renderer->GetDevice(), &allocInfo, nullptr, &imageMemory), "Texture Error: Failed to allocate texture image memory.");
-
-	// Bind image memory to the image.
-	vkBindImageMemory(m_renderer->GetDevice(), image, imageMemory, 0);
+	// Sub-allocate & bind image memory.
+	m_bLazilyAllocated = m_renderer->AllocateImageMemory(image, tiling, imageMemory, (usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0);
 }
 
 void Texture::CreateImageView(const VkImage& image, VkImageView& view, VkFormat format, VkImageAspectFlags aspectFlags)
@@ -251,25 +311,17 @@ void Texture::CreateImageView(const VkImage& image, VkImageView& view, VkFormat
 
 void Texture::TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkFormat format) 
 {
-	Renderer::TempCmdBuffer tmpCmdBuffer = m_renderer->CreateTempCommandBuffer();
+	UploadContext* uploadContext = m_renderer->GetUploadContext();
 
+	// Recorded on the upload context's graphics queue command buffer, which is submitted ahead of the next frame.
 	bool bStencilFormat = format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
-	RecordImageMemBarrierCmdBuffer(tmpCmdBuffer.m_handle, oldLayout, newLayout, bStencilFormat);
+	RecordImageMemBarrierCmdBuffer(uploadContext->GraphicsCmdBuffer(), oldLayout, newLayout, bStencilFormat);
 
-	m_renderer->UseAndDestroyTempCommandBuffer(tmpCmdBuffer);
+	m_uploadToken = uploadContext->PendingToken();
 }
 
 void Texture::RecordImageMemBarrierCmdBuffer(VkCommandBuffer cmdBuffer, VkImageLayout oldLayout, VkImageLayout newLayout, bool bHasStencil)
 {
-	VkCommandBufferBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-	beginInfo.pInheritanceInfo = nullptr;
-	beginInfo.pNext = nullptr;
-
-	// Begin recording.
-	RENDERER_SAFECALL(vkBeginCommandBuffer(cmdBuffer, &beginInfo), "Texture Error: Failed to begin recording of copy command buffer.");
-
 	VkPipelineStageFlags sourceStage;
 	VkPipelineStageFlags destStage;
 
@@ -332,55 +384,4 @@ void Texture::RecordImageMemBarrierCmdBuffer(VkCommandBuffer cmdBuffer, VkImageL
 
 	// Change image layout.
 	vkCmdPipelineBarrier(cmdBuffer, sourceStage, destStage, 0, 0, nullptr, 0, nullptr, 1, &memBarrier);
-
-	// End recording.
-	RENDERER_SAFECALL(vkEndCommandBuffer(cmdBuffer), "Texture Error: Failed to end copy command buffer recording.");
-}
-
-void Texture::RecordCopyCommandBuffer(VkCommandBuffer cmdBuffer)
-{
-	VkCommandBufferBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-	beginInfo.pInheritanceInfo = nullptr;
-	beginInfo.pNext = nullptr;
-
-	// Begin recording.
-	RENDERER_SAFECALL(vkBeginCommandBuffer(cmdBuffer, &beginInfo), "Texture Error: Failed to begin recording of copy command buffer.");
-
-	unsigned long long textureSize = m_nWidth * m_nHeight * sizeof(unsigned int);
-
-	VkBufferImageCopy copyRegion = {};
-	copyRegion.bufferRowLength = 0;
-	copyRegion.bufferImageHeight = 0;
-	copyRegion.bufferOffset = 0;
-	copyRegion.imageExtent = { static_cast<unsigned int>(m_nWidth), static_cast<unsigned int>(m_nHeight), 1 };
-	copyRegion.imageOffset = { 0, 0, 0 };
-	copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	copyRegion.imageSubresource.mipLevel = 0;
-	copyRegion.imageSubresource.baseArrayLayer = 0;
-	copyRegion.imageSubresource.layerCount = 1;
-
-	// Copy vertex staging buffer contents to vertex final buffer contents.
-	vkCmdCopyBufferToImage(cmdBuffer, m_stagingBuffer, m_imageHandle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
-
-	// End recording.
-	RENDERER_SAFECALL(vkEndCommandBuffer(cmdBuffer), "Texture Error: Failed to end copy command buffer recording.");
-}
-
-void Texture::TransferContents() 
-{
-	// Transition layout to transfer destination optimal layout.
-	TransitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_format);
-
-	// Copy staging buffer to image.
-	Renderer::TempCmdBuffer tmpCmdBuffer = m_renderer->CreateTempCommandBuffer();
-	RecordCopyCommandBuffer(tmpCmdBuffer.m_handle);
-	m_renderer->UseAndDestroyTempCommandBuffer(tmpCmdBuffer);
-
-	// Transition image layout to shader read only optimal layout.
-	TransitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_format);
-
-	// Create image view.
-	m_renderer->CreateImageView(m_imageHandle, m_imageView, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
 }
\ No newline at end of file
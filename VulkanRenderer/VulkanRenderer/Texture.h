@@ -8,7 +8,8 @@ enum ETextureProperties
 {
 	TEXTURE_PROPERTIES_NONE = 0,
 	TEXTURE_PROPERTIES_INPUT_ATTACHMENT = 1,
-	TEXTURE_PROPERTIES_TRANSFER_SRC = 2
+	TEXTURE_PROPERTIES_TRANSFER_SRC = 2,
+	TEXTURE_PROPERTIES_TRANSIENT = 4 // Contents never leave the render pass using it, backed by lazily allocated memory where available.
 };
 
 enum EAttachmentType 
@@ -46,6 +47,16 @@ public:
 
 	~Texture();
 
+	/*
+	Description: Load multiple textures from image files, decoding the files in parallel on the renderer's job system. Uploads are queued on the calling thread.
+	Param:
+	    Renderer* renderer: The renderer the textures will be used by.
+		const char* const* filePaths: Array of file paths of the images to load.
+		uint32_t nCount: Amount of images to load.
+		Texture** outTextures: Array the new textures are written to.
+	*/
+	static void LoadBatch(Renderer* renderer, const char* const* filePaths, uint32_t nCount, Texture** outTextures);
+
 	/*
 	Description: Get the name of the texture file.
 	*/
@@ -99,15 +110,49 @@ public:
 	*/
 	bool IsPresented();
 
+	/*
+	Description: Get the size in bytes of the memory backing this texture.
+	Return Type: VkDeviceSize
+	*/
+	VkDeviceSize GetMemorySize() const;
+
+	/*
+	Description: Get whether or not this texture is backed by lazily allocated memory, which may never be committed.
+	Return Type: bool
+	*/
+	bool IsLazilyAllocated() const;
+
 protected:
 
 	/*
-	Description: Creates a staging buffer for the texture image.
+	Constructor: Construct from image data already decoded from an image file, ownership of the data is taken.
+	Param:
+	    Renderer* renderer: The renderer this texture will by use.
+		const char* szFilePath: File path the image was loaded from.
+		unsigned char* data: The decoded RGBA image data, may be nullptr if decoding failed.
+		int nWidth: Width of the image.
+		int nHeight: Height of the image.
+		int nChannels: Amount of channels in the image file.
+	*/
+	Texture(Renderer* renderer, const char* szFilePath, unsigned char* data, int nWidth, int nHeight, int nChannels);
+
+	/*
+	Description: Initialize the members of a texture loaded from an image file.
+	*/
+	inline void InitFileTexture(Renderer* renderer, const char* szFilePath);
+
+	/*
+	Description: Queue the decoded image data for upload, or report the failure to load it.
+	*/
+	inline void FinishFileLoad(const char* szFilePath);
+
+	/*
+	Description: Create the texture image and queue its contents for upload.
 	*/
 	void StageImage();
 
 	/*
-	Description: Record image memory barrier (to transition image layout) command buffer.
+	Description: Record an image memory barrier (to transition image layout) to a command buffer.
 	Param:
 	    VkCommandBuffer cmdBuffer: The command buffer to record to.
 		VkImageLayout: oldLayout: The image layout to transition from.
@@ -120,14 +165,14 @@ protected:
 	Description: Create a VkImage object with the provided properties.
 	Param:
 	    VkImage& image: VkImage handle reference.
-		VkDeviceMemory& imageMemory: Image memory buffer handle reference.
+		MemAllocation& imageMemory: Image memory allocation reference.
 		const unsigned int& nWidth: The width of the image viewport.
 		const unsigned int& nHeight: The height of the image viewport.
 		VkFormat format: The format of the image.
 		VkImageTiling tiling: The tiling properties of the image.
-		VKImageUsageFlags usage: Flags detailing how the image will be used.
+		VKImageUsageFlags usage: Flags detailing how the image will be used, transient attachments are given lazily allocated memory if available.
 	*/
-	void CreateImage(VkImage& image, VkDeviceMemory& imageMemory, const uint32_t& nWidth, const uint32_t& nHeight, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage);
+	void CreateImage(VkImage& image, MemAllocation& imageMemory, const uint32_t& nWidth, const uint32_t& nHeight, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage);
 
 	/*
 	Description: Create an image view for the provided image, using the specified format and aspect flags.
@@ -148,32 +193,17 @@ protected:
 	*/
 	void TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkFormat format);
 
-	/*
-	Description: Record the command buffer to copy image data from the staging buffer to the image buffer.
-	Param:
-	    VkCommandBuffer cmdBuffer: The command buffer handle to record to.
-	*/
-	void RecordCopyCommandBuffer(VkCommandBuffer cmdBuffer);
-
-	/*
-	Description: Transfer staging buffer contents to the image buffer contents.
-	*/
-	void TransferContents();
-
 	unsigned char* m_data;
 	std::string m_name;
 	Renderer* m_renderer;
 
-	VkCommandBuffer m_copyCmdBuffer;
-
-	VkBuffer m_stagingBuffer;
-	VkDeviceMemory m_stagingMemory;
+	UploadToken m_uploadToken; // Completion token of the image upload or initial layout transition.
 
 	EAttachmentType m_type;
 	VkFormat m_format;
 	VkImage m_imageHandle;
 	VkImageView m_imageView;
-	VkDeviceMemory m_imageMemory;
+	MemAllocation m_imageMemory;
 
 	int m_nWidth;
 	int m_nHeight;
@@ -181,4 +211,5 @@ protected:
 	bool m_bPresented;
 	bool m_bHasStencil;
 	bool m_bOwnsTexture;
+	bool m_bLazilyAllocated;
 };
\ No newline at end of file
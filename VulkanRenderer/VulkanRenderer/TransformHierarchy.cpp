@@ -0,0 +1,475 @@
+#include "TransformHierarchy.h"
+#include "JobSystem.h"
+#include "CPUProfiler.h"
+
+#include <xmmintrin.h>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+
+// Values of each component for an identity transform, which padding holds.
+static const float s_identityComponents[TRANSFORM_COMPONENT_COUNT] =
+{
+	0.0f, 0.0f, 0.0f, // Position
+	0.0f, 0.0f, 0.0f, 1.0f, // Rotation
+	1.0f, 1.0f, 1.0f // Scale
+};
+
+// World matrix of invalid nodes.
+static const glm::mat4 s_identityMatrix;
+
+// Size of component arrays holding a number of nodes. Levels start at any node, so a load of four nodes may begin at the last node & read three past it.
+static inline uint32_t PaddedComponentCount(uint32_t nNodeCount)
+{
+	return nNodeCount + TRANSFORM_SIMD_WIDTH - 1;
+}
+
+TransformHierarchy::TransformHierarchy()
+{
+	m_nNodeCount = 0;
+	m_bRebuild = false;
+	m_nFreeSlot = UINT32_MAX;
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+
+}
+
+TransformHandle TransformHierarchy::AddNode(const glm::vec3& v3Position, const glm::quat& rotation, const glm::vec3& v3Scale)
+{
+	return AddNodeAt(UINT32_MAX, v3Position, rotation, v3Scale);
+}
+
+TransformHandle TransformHierarchy::AddNode(TransformHandle parent, const glm::vec3& v3Position, const glm::quat& rotation, const glm::vec3& v3Scale)
+{
+	if (!IsValid(parent))
+	{
+		assert(false && "Adding a child of an invalid transform node.");
+		return { UINT32_MAX, 0 };
+	}
+
+	return AddNodeAt(m_slotIndices[parent.m_nSlot], v3Position, rotation, v3Scale);
+}
+
+bool TransformHierarchy::RemoveNode(TransformHandle node)
+{
+	if (!IsValid(node))
+		return false;
+
+	// The node's handles are stale immediately, its slot is freed once the next update drops it.
+	m_nodes[m_slotIndices[node.m_nSlot]].m_bRemoved = true;
+	++m_slotGenerations[node.m_nSlot];
+
+	m_bRebuild = true;
+
+	return true;
+}
+
+bool TransformHierarchy::SetLocal(TransformHandle node, const glm::vec3& v3Position, const glm::quat& rotation, const glm::vec3& v3Scale)
+{
+	if (!IsValid(node))
+		return false;
+
+	SetComponents(m_slotIndices[node.m_nSlot], &v3Position, &rotation, &v3Scale);
+	return true;
+}
+
+bool TransformHierarchy::SetPosition(TransformHandle node, const glm::vec3& v3Position)
+{
+	if (!IsValid(node))
+		return false;
+
+	SetComponents(m_slotIndices[node.m_nSlot], &v3Position, nullptr, nullptr);
+	return true;
+}
+
+bool TransformHierarchy::SetRotation(TransformHandle node, const glm::quat& rotation)
+{
+	if (!IsValid(node))
+		return false;
+
+	SetComponents(m_slotIndices[node.m_nSlot], nullptr, &rotation, nullptr);
+	return true;
+}
+
+bool TransformHierarchy::SetScale(TransformHandle node, const glm::vec3& v3Scale)
+{
+	if (!IsValid(node))
+		return false;
+
+	SetComponents(m_slotIndices[node.m_nSlot], nullptr, nullptr, &v3Scale);
+	return true;
+}
+
+bool TransformHierarchy::BindInstance(TransformHandle node, RenderObject* object, InstanceHandle instance)
+{
+	if (!IsValid(node))
+		return false;
+
+	uint32_t nIndex = m_slotIndices[node.m_nSlot];
+
+	m_nodes[nIndex].m_object = object;
+	m_nodes[nIndex].m_instance = instance;
+
+	// Write the world matrix to the new instance on the next update.
+	m_localModified[nIndex] = 1;
+
+	return true;
+}
+
+void TransformHierarchy::Update(JobSystem* jobSystem)
+{
+	CPU_PROFILE_ZONE("TransformHierarchy::Update");
+
+	if (m_bRebuild)
+		Rebuild();
+
+	// Each level depends on the world matrices of the level before it, so levels are computed in order & only the nodes within a level in parallel.
+	for (uint32_t i = 0; i + 1 < m_levelStarts.size(); ++i)
+	{
+		uint32_t nStart = m_levelStarts[i];
+		uint32_t nEnd = m_levelStarts[i + 1];
+
+		if (!jobSystem || nEnd - nStart <= TRANSFORM_BATCH_SIZE)
+		{
+			UpdateRange(nStart, nEnd);
+			continue;
+		}
+
+		jobSystem->ParallelFor(nEnd - nStart, TRANSFORM_BATCH_SIZE, [&](uint32_t nRangeStart, uint32_t nRangeEnd)
+		{
+			UpdateRange(nStart + nRangeStart, nStart + nRangeEnd);
+		});
+	}
+
+	// Write modified world matrices to their instances on this thread.
+	for (uint32_t i = 0; i < m_nNodeCount; ++i)
+	{
+		const NodeInfo& node = m_nodes[i];
+
+		if (m_worldModified[i] && node.m_object)
+		{
+			Instance instance = { m_worldMatrices[i] };
+			node.m_object->SetInstance(node.m_instance, instance);
+		}
+	}
+
+	std::memset(m_localModified.data(), 0, m_localModified.size());
+	std::memset(m_worldModified.data(), 0, m_worldModified.size());
+}
+
+bool TransformHierarchy::IsValid(TransformHandle node) const
+{
+	return node.m_nSlot < m_slotGenerations.size() && m_slotGenerations[node.m_nSlot] == node.m_nGeneration;
+}
+
+const glm::mat4& TransformHierarchy::WorldMatrix(TransformHandle node) const
+{
+	if (!IsValid(node))
+	{
+		assert(false && "Getting the world matrix of an invalid transform node.");
+		return s_identityMatrix;
+	}
+
+	return m_worldMatrices[m_slotIndices[node.m_nSlot]];
+}
+
+uint32_t TransformHierarchy::NodeCount() const
+{
+	return m_nNodeCount;
+}
+
+uint32_t TransformHierarchy::LevelCount() const
+{
+	return m_levelStarts.empty() ? 0 : static_cast<uint32_t>(m_levelStarts.size() - 1);
+}
+
+inline TransformHandle TransformHierarchy::AddNodeAt(uint32_t nParent, const glm::vec3& v3Position, const glm::quat& rotation, const glm::vec3& v3Scale)
+{
+	uint32_t nSlot = m_nFreeSlot;
+
+	if (nSlot != UINT32_MAX)
+		m_nFreeSlot = m_slotIndices[nSlot];
+	else
+	{
+		nSlot = static_cast<uint32_t>(m_slotIndices.size());
+
+		m_slotIndices.push_back(0);
+		m_slotGenerations.push_back(0);
+	}
+
+	// New nodes are appended, after their parent. The next update sorts them into their level.
+	uint32_t nIndex = m_nNodeCount++;
+	m_slotIndices[nSlot] = nIndex;
+
+	uint32_t nPaddedCount = PaddedComponentCount(m_nNodeCount);
+
+	for (uint32_t i = 0; i < TRANSFORM_COMPONENT_COUNT; ++i)
+		m_components[i].resize(nPaddedCount, s_identityComponents[i]);
+
+	NodeInfo node = {};
+	node.m_nParent = nParent;
+	node.m_nDepth = nParent == UINT32_MAX ? 0 : m_nodes[nParent].m_nDepth + 1;
+	node.m_nSlot = nSlot;
+	node.m_bRemoved = false;
+	node.m_object = nullptr;
+
+	m_nodes.push_back(node);
+	m_worldMatrices.push_back(glm::mat4());
+	m_localModified.push_back(0);
+	m_worldModified.push_back(0);
+
+	SetComponents(nIndex, &v3Position, &rotation, &v3Scale);
+
+	m_bRebuild = true;
+
+	return { nSlot, m_slotGenerations[nSlot] };
+}
+
+inline void TransformHierarchy::SetComponents(uint32_t nIndex, const glm::vec3* v3Position, const glm::quat* rotation, const glm::vec3* v3Scale)
+{
+	if (v3Position)
+	{
+		m_components[TRANSFORM_POSITION_X][nIndex] = v3Position->x;
+		m_components[TRANSFORM_POSITION_Y][nIndex] = v3Position->y;
+		m_components[TRANSFORM_POSITION_Z][nIndex] = v3Position->z;
+	}
+
+	if (rotation)
+	{
+		m_components[TRANSFORM_ROTATION_X][nIndex] = rotation->x;
+		m_components[TRANSFORM_ROTATION_Y][nIndex] = rotation->y;
+		m_components[TRANSFORM_ROTATION_Z][nIndex] = rotation->z;
+		m_components[TRANSFORM_ROTATION_W][nIndex] = rotation->w;
+	}
+
+	if (v3Scale)
+	{
+		m_components[TRANSFORM_SCALE_X][nIndex] = v3Scale->x;
+		m_components[TRANSFORM_SCALE_Y][nIndex] = v3Scale->y;
+		m_components[TRANSFORM_SCALE_Z][nIndex] = v3Scale->z;
+	}
+
+	m_localModified[nIndex] = 1;
+}
+
+inline void TransformHierarchy::Rebuild()
+{
+	m_bRebuild = false;
+
+	// Parents precede their children, so a single pass drops the descendants of removed nodes & finds the depth of every remaining node.
+	std::vector<uint32_t> levelCounts;
+	uint32_t nRemainingCount = 0;
+
+	for (uint32_t i = 0; i < m_nNodeCount; ++i)
+	{
+		NodeInfo& node = m_nodes[i];
+
+		if (!node.m_bRemoved && node.m_nParent != UINT32_MAX && m_nodes[node.m_nParent].m_bRemoved)
+		{
+			node.m_bRemoved = true;
+			++m_slotGenerations[node.m_nSlot];
+		}
+
+		if (node.m_bRemoved)
+		{
+			// Instances of removed nodes would otherwise keep their last world matrix & be drawn indefinitely.
+			if (node.m_object)
+				node.m_object->RemoveInstance(node.m_instance);
+
+			m_slotIndices[node.m_nSlot] = m_nFreeSlot;
+			m_nFreeSlot = node.m_nSlot;
+			continue;
+		}
+
+		node.m_nDepth = node.m_nParent == UINT32_MAX ? 0 : m_nodes[node.m_nParent].m_nDepth + 1;
+
+		if (node.m_nDepth >= levelCounts.size())
+			levelCounts.resize(node.m_nDepth + 1, 0);
+
+		++levelCounts[node.m_nDepth];
+		++nRemainingCount;
+	}
+
+	m_levelStarts.resize(levelCounts.size() + 1);
+	m_levelStarts[0] = 0;
+
+	for (uint32_t i = 0; i < levelCounts.size(); ++i)
+		m_levelStarts[i + 1] = m_levelStarts[i] + levelCounts[i];
+
+	// Counting sort by depth, which keeps the order of nodes within a level so parents still precede their children.
+	std::vector<uint32_t> levelOffsets(m_levelStarts.begin(), m_levelStarts.end() - 1);
+	std::vector<uint32_t> newIndices(m_nNodeCount, UINT32_MAX);
+
+	for (uint32_t i = 0; i < m_nNodeCount; ++i)
+	{
+		if (!m_nodes[i].m_bRemoved)
+			newIndices[i] = levelOffsets[m_nodes[i].m_nDepth]++;
+	}
+
+	uint32_t nPaddedCount = PaddedComponentCount(nRemainingCount);
+
+	for (uint32_t c = 0; c < TRANSFORM_COMPONENT_COUNT; ++c)
+	{
+		std::vector<float> sorted(nPaddedCount, s_identityComponents[c]);
+
+		for (uint32_t i = 0; i < m_nNodeCount; ++i)
+		{
+			if (newIndices[i] != UINT32_MAX)
+				sorted[newIndices[i]] = m_components[c][i];
+		}
+
+		m_components[c].swap(sorted);
+	}
+
+	std::vector<NodeInfo> sortedNodes(nRemainingCount);
+	std::vector<glm::mat4> sortedMatrices(nRemainingCount);
+	std::vector<uint8_t> sortedModified(nRemainingCount);
+
+	for (uint32_t i = 0; i < m_nNodeCount; ++i)
+	{
+		uint32_t nNewIndex = newIndices[i];
+
+		if (nNewIndex == UINT32_MAX)
+			continue;
+
+		NodeInfo& node = sortedNodes[nNewIndex];
+		node = m_nodes[i];
+
+		if (node.m_nParent != UINT32_MAX)
+			node.m_nParent = newIndices[node.m_nParent];
+
+		sortedMatrices[nNewIndex] = m_worldMatrices[i];
+		sortedModified[nNewIndex] = m_localModified[i];
+
+		m_slotIndices[node.m_nSlot] = nNewIndex;
+	}
+
+	m_nodes.swap(sortedNodes);
+	m_worldMatrices.swap(sortedMatrices);
+	m_localModified.swap(sortedModified);
+	m_worldModified.assign(nRemainingCount, 0);
+
+	m_nNodeCount = nRemainingCount;
+}
+
+inline void TransformHierarchy::UpdateRange(uint32_t nStart, uint32_t nEnd)
+{
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	for (uint32_t i = nStart; i < nEnd; i += TRANSFORM_SIMD_WIDTH)
+	{
+		uint32_t nCount = std::min(nEnd - i, static_cast<uint32_t>(TRANSFORM_SIMD_WIDTH));
+
+		// A node is recomputed if its local transform changed, or its parent's world matrix did.
+		bool bModified[TRANSFORM_SIMD_WIDTH] = {};
+		bool bAnyModified = false;
+
+		for (uint32_t j = 0; j < nCount; ++j)
+		{
+			uint32_t nParent = m_nodes[i + j].m_nParent;
+
+			bModified[j] = m_localModified[i + j] || (nParent != UINT32_MAX && m_worldModified[nParent]);
+			bAnyModified |= bModified[j];
+		}
+
+		if (!bAnyModified)
+			continue;
+
+		// Local matrices of four nodes at once, the lanes past the range are computed from padding or the next level & discarded.
+		__m128 px = _mm_loadu_ps(&m_components[TRANSFORM_POSITION_X][i]);
+		__m128 py = _mm_loadu_ps(&m_components[TRANSFORM_POSITION_Y][i]);
+		__m128 pz = _mm_loadu_ps(&m_components[TRANSFORM_POSITION_Z][i]);
+		__m128 qx = _mm_loadu_ps(&m_components[TRANSFORM_ROTATION_X][i]);
+		__m128 qy = _mm_loadu_ps(&m_components[TRANSFORM_ROTATION_Y][i]);
+		__m128 qz = _mm_loadu_ps(&m_components[TRANSFORM_ROTATION_Z][i]);
+		__m128 qw = _mm_loadu_ps(&m_components[TRANSFORM_ROTATION_W][i]);
+		__m128 sx = _mm_loadu_ps(&m_components[TRANSFORM_SCALE_X][i]);
+		__m128 sy = _mm_loadu_ps(&m_components[TRANSFORM_SCALE_Y][i]);
+		__m128 sz = _mm_loadu_ps(&m_components[TRANSFORM_SCALE_Z][i]);
+
+		__m128 xx = _mm_mul_ps(qx, qx);
+		__m128 yy = _mm_mul_ps(qy, qy);
+		__m128 zz = _mm_mul_ps(qz, qz);
+		__m128 xy = _mm_mul_ps(qx, qy);
+		__m128 xz = _mm_mul_ps(qx, qz);
+		__m128 yz = _mm_mul_ps(qy, qz);
+		__m128 wx = _mm_mul_ps(qw, qx);
+		__m128 wy = _mm_mul_ps(qw, qy);
+		__m128 wz = _mm_mul_ps(qw, qz);
+
+		// Rotation matrix of each quaternion, as glm::mat4_cast() builds it, with each column scaled.
+		__m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+		__m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+		__m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+
+		__m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+		__m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+		__m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+
+		__m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+		__m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+		__m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+		__m128 c0w = _mm_setzero_ps();
+		__m128 c1w = _mm_setzero_ps();
+		__m128 c2w = _mm_setzero_ps();
+		__m128 c3w = one;
+
+		// Transpose from a component per register to a column of each node per register.
+		_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+		_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+		_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+		_MM_TRANSPOSE4_PS(px, py, pz, c3w);
+
+		__m128 localColumns[TRANSFORM_SIMD_WIDTH][4] =
+		{
+			{ c0x, c1x, c2x, px },
+			{ c0y, c1y, c2y, py },
+			{ c0z, c1z, c2z, pz },
+			{ c0w, c1w, c2w, c3w }
+		};
+
+		for (uint32_t j = 0; j < nCount; ++j)
+		{
+			if (!bModified[j])
+				continue;
+
+			uint32_t nIndex = i + j;
+			uint32_t nParent = m_nodes[nIndex].m_nParent;
+			float* world = &m_worldMatrices[nIndex][0][0];
+
+			m_worldModified[nIndex] = 1;
+
+			if (nParent == UINT32_MAX)
+			{
+				for (uint32_t c = 0; c < 4; ++c)
+					_mm_storeu_ps(&world[c * 4], localColumns[j][c]);
+
+				continue;
+			}
+
+			// World = parent world * local, each column a combination of the parent's columns weighted by the local column.
+			const float* parentWorld = &m_worldMatrices[nParent][0][0];
+
+			__m128 parent0 = _mm_loadu_ps(&parentWorld[0]);
+			__m128 parent1 = _mm_loadu_ps(&parentWorld[4]);
+			__m128 parent2 = _mm_loadu_ps(&parentWorld[8]);
+			__m128 parent3 = _mm_loadu_ps(&parentWorld[12]);
+
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				__m128 column = localColumns[j][c];
+
+				__m128 result = _mm_mul_ps(parent0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+				result = _mm_add_ps(result, _mm_mul_ps(parent1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+				result = _mm_add_ps(result, _mm_mul_ps(parent2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+				result = _mm_add_ps(result, _mm_mul_ps(parent3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+
+				_mm_storeu_ps(&world[c * 4], result);
+			}
+		}
+	}
+}
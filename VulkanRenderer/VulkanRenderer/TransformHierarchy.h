@@ -0,0 +1,180 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "glm.hpp"
+#include "gtc/quaternion.hpp"
+#include "RenderObject.h"
+
+/*
+Description: Scene graph of transforms. Local position, rotation & scale are kept in structure of arrays layout sorted by depth in the hierarchy, so
+             every parent is computed before its children. World matrices are computed a level at a time, four nodes per SSE iteration, spread across
+             the job system. Only nodes whose local transform or parent changed are recomputed, & written to the render object instances bound to them.
+Author: Nic Van Zuylen
+*/
+
+class JobSystem;
+
+// Nodes per SSE iteration, component arrays are padded with one less than this past the last node.
+#define TRANSFORM_SIMD_WIDTH 4
+
+// Nodes per job when computing a level. Levels of fewer nodes are computed on the calling thread.
+#define TRANSFORM_BATCH_SIZE 2048
+
+// Handle to a node of a transform hierarchy, which stays valid as other nodes are added & removed. Handles of removed nodes are detected as stale.
+// A slot of UINT32_MAX is never valid, & is returned when a node can't be added.
+struct TransformHandle
+{
+	uint32_t m_nSlot; // Slot mapping the handle to the node's current index.
+	uint32_t m_nGeneration; // Generation of the slot when the handle was given, slots are reused with the next generation once their node is removed.
+};
+
+// Components of local transforms, each stored in its own array.
+enum ETransformComponent
+{
+	TRANSFORM_POSITION_X,
+	TRANSFORM_POSITION_Y,
+	TRANSFORM_POSITION_Z,
+	TRANSFORM_ROTATION_X,
+	TRANSFORM_ROTATION_Y,
+	TRANSFORM_ROTATION_Z,
+	TRANSFORM_ROTATION_W,
+	TRANSFORM_SCALE_X,
+	TRANSFORM_SCALE_Y,
+	TRANSFORM_SCALE_Z,
+	TRANSFORM_COMPONENT_COUNT
+};
+
+class TransformHierarchy
+{
+public:
+
+	TransformHierarchy();
+
+	~TransformHierarchy();
+
+	/*
+	Description: Add a root node.
+	Return Type: TransformHandle
+	Param:
+	    const glm::vec3& v3Position: Local position of the node.
+		const glm::quat& rotation: Local rotation of the node, must be normalized.
+		const glm::vec3& v3Scale: Local scale of the node.
+	*/
+	TransformHandle AddNode(const glm::vec3& v3Position, const glm::quat& rotation = glm::quat(), const glm::vec3& v3Scale = glm::vec3(1.0f));
+
+	/*
+	Description: Add a child node, transformed by its parent. Returns an invalid handle if the parent is invalid, which asserts in debug builds.
+	Return Type: TransformHandle
+	Param:
+	    TransformHandle parent: The parent node.
+		const glm::vec3& v3Position: Local position of the node.
+		const glm::quat& rotation: Local rotation of the node, must be normalized.
+		const glm::vec3& v3Scale: Local scale of the node.
+	*/
+	TransformHandle AddNode(TransformHandle parent, const glm::vec3& v3Position, const glm::quat& rotation = glm::quat(), const glm::vec3& v3Scale = glm::vec3(1.0f));
+
+	/*
+	Description: Remove a node along with all of its descendants, which are removed on the next update. The next update also removes the instances bound
+	             to the removed nodes from their render objects.
+	Return Type: bool
+	Param:
+	    TransformHandle node: The node to remove.
+	*/
+	bool RemoveNode(TransformHandle node);
+
+	/*
+	Description: Set the local transform of a node.
+	Return Type: bool
+	Param:
+	    TransformHandle node: The node to modify.
+		const glm::vec3& v3Position: Local position of the node.
+		const glm::quat& rotation: Local rotation of the node, must be normalized.
+		const glm::vec3& v3Scale: Local scale of the node.
+	*/
+	bool SetLocal(TransformHandle node, const glm::vec3& v3Position, const glm::quat& rotation, const glm::vec3& v3Scale);
+
+	bool SetPosition(TransformHandle node, const glm::vec3& v3Position);
+
+	bool SetRotation(TransformHandle node, const glm::quat& rotation);
+
+	bool SetScale(TransformHandle node, const glm::vec3& v3Scale);
+
+	/*
+	Description: Bind a render object instance to a node, the instance's model matrix is set to the node's world matrix whenever it changes.
+	             The object must outlive the binding, or be unbound first. Removing the node removes the instance from the object on the next update.
+	Return Type: bool
+	Param:
+	    TransformHandle node: The node to bind to.
+		RenderObject* object: The render object of the instance, or nullptr to unbind.
+		InstanceHandle instance: The instance to write to.
+	*/
+	bool BindInstance(TransformHandle node, RenderObject* object, InstanceHandle instance);
+
+	/*
+	Description: Compute world matrices of every node whose local transform or any ancestor's local transform changed since the last update,
+	             & write them to the bound instances. Must be called on the main thread, since render object instances are not thread safe.
+	Param:
+	    JobSystem* jobSystem: Job system to spread large levels across, or nullptr to compute every level on the calling thread.
+	*/
+	void Update(JobSystem* jobSystem = nullptr);
+
+	/*
+	Description: Get whether or not a handle refers to a current node of this hierarchy, false once its node is removed.
+	Return Type: bool
+	Param:
+	    TransformHandle node: The handle to check.
+	*/
+	bool IsValid(TransformHandle node) const;
+
+	/*
+	Description: Get the world matrix of a node as of the last update. Returns an identity matrix if the node is invalid, which asserts in debug builds.
+	Return Type: const glm::mat4&
+	Param:
+	    TransformHandle node: The node, updated at least once.
+	*/
+	const glm::mat4& WorldMatrix(TransformHandle node) const;
+
+	uint32_t NodeCount() const;
+
+	uint32_t LevelCount() const;
+
+private:
+
+	// Bookkeeping of a node, in the same order as the components.
+	struct NodeInfo
+	{
+		uint32_t m_nParent; // Index of the parent node, UINT32_MAX for roots. Parents always precede their children.
+		uint32_t m_nDepth;
+		uint32_t m_nSlot;
+		bool m_bRemoved;
+
+		RenderObject* m_object;
+		InstanceHandle m_instance;
+	};
+
+	// Add a node with the provided parent index.
+	inline TransformHandle AddNodeAt(uint32_t nParent, const glm::vec3& v3Position, const glm::quat& rotation, const glm::vec3& v3Scale);
+
+	// Set the components of a node, marking it modified.
+	inline void SetComponents(uint32_t nIndex, const glm::vec3* v3Position, const glm::quat* rotation, const glm::vec3* v3Scale);
+
+	// Drop removed nodes & their descendants along with their bound instances, & sort the remaining nodes by depth.
+	inline void Rebuild();
+
+	// Compute world matrices of modified nodes of a range within a level, whose parents are already computed.
+	inline void UpdateRange(uint32_t nStart, uint32_t nEnd);
+
+	std::vector<float> m_components[TRANSFORM_COMPONENT_COUNT]; // Padded with TRANSFORM_SIMD_WIDTH - 1 identity transforms past the last node.
+	std::vector<NodeInfo> m_nodes;
+	std::vector<glm::mat4> m_worldMatrices;
+	std::vector<uint8_t> m_localModified; // Nodes whose local transform changed since the last update.
+	std::vector<uint8_t> m_worldModified; // Nodes whose world matrix changed in the current update.
+	std::vector<uint32_t> m_levelStarts; // Index of the first node of each depth, followed by the node count.
+	uint32_t m_nNodeCount;
+	bool m_bRebuild;
+
+	// Node handles, each slot maps a handle to its node's current index.
+	std::vector<uint32_t> m_slotIndices; // Node index of each used slot, or the next free slot of each free slot.
+	std::vector<uint32_t> m_slotGenerations;
+	uint32_t m_nFreeSlot; // First slot of the free list, UINT32_MAX when every slot is used.
+};
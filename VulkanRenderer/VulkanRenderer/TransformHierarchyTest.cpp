@@ -0,0 +1,252 @@
+#include "TransformHierarchyTest.h"
+#include "JobSystem.h"
+#include "gtc/matrix_transform.hpp"
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+bool TransformHierarchyTest::ParseArgs(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--transformtest") == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool TransformHierarchyTest::Run()
+{
+	std::cout << "Transform Hierarchy Test: " << TRANSFORM_SIMD_WIDTH << " nodes per SIMD iteration, batches of " << TRANSFORM_BATCH_SIZE << " nodes\n";
+
+	// Every check runs even if an earlier one fails.
+	bool bPassed = true;
+	bPassed = Report("Uneven levels", TestUnevenLevels()) && bPassed;
+	bPassed = Report("Batched levels", TestBatchedLevels()) && bPassed;
+	bPassed = Report("Node removal", TestRemoval()) && bPassed;
+
+	std::cout << "Transform Hierarchy Test: " << (bPassed ? "All checks passed" : "Checks FAILED") << "\n";
+
+	return bPassed;
+}
+
+bool TransformHierarchyTest::TestUnevenLevels()
+{
+	TransformHierarchy hierarchy;
+	TestNodes nodes;
+	std::vector<TransformHandle> handles;
+
+	// A root with three children, the four nodes of the second level's only load start at node 1.
+	AddTestNode(hierarchy, nodes, handles, UINT32_MAX);
+
+	for (uint32_t i = 0; i < 3; ++i)
+		AddTestNode(hierarchy, nodes, handles, 0);
+
+	hierarchy.Update();
+
+	if (!CheckWorldMatrices("Uneven levels", hierarchy, nodes, handles))
+		return false;
+
+	// Levels of 1, 3 & 2 nodes, starting at nodes 0, 1 & 4.
+	AddTestNode(hierarchy, nodes, handles, 2);
+	AddTestNode(hierarchy, nodes, handles, 2);
+
+	hierarchy.Update();
+
+	if (hierarchy.LevelCount() != 3)
+	{
+		std::cout << "Transform Hierarchy Test: Uneven levels: " << hierarchy.LevelCount() << " levels, expected 3\n";
+		return false;
+	}
+
+	if (!CheckWorldMatrices("Uneven levels after adding", hierarchy, nodes, handles))
+		return false;
+
+	// Modify the last node of the second level only, the lanes of its set of four past the level hold the third level.
+	nodes.m_positions[3] += glm::vec3(1.0f, -2.0f, 0.5f);
+	hierarchy.SetPosition(handles[3], nodes.m_positions[3]);
+
+	hierarchy.Update();
+
+	if (!CheckWorldMatrices("Uneven levels after modification", hierarchy, nodes, handles))
+		return false;
+
+	// Modifying the root modifies every node.
+	nodes.m_rotations[0] = glm::angleAxis(1.3f, glm::normalize(glm::vec3(0.0f, 1.0f, 1.0f)));
+	hierarchy.SetRotation(handles[0], nodes.m_rotations[0]);
+
+	hierarchy.Update();
+
+	return CheckWorldMatrices("Uneven levels after root modification", hierarchy, nodes, handles);
+}
+
+bool TransformHierarchyTest::TestBatchedLevels()
+{
+	JobSystem jobSystem(TRANSFORM_TEST_THREAD_COUNT);
+
+	TransformHierarchy hierarchy;
+	TestNodes nodes;
+	std::vector<TransformHandle> handles;
+
+	// Three roots, then levels of more than two batches whose sizes are not multiples of the SIMD width.
+	const uint32_t nRootCount = 3;
+	const uint32_t nChildCount = TRANSFORM_BATCH_SIZE * 2 + 5;
+	const uint32_t nGrandchildCount = TRANSFORM_BATCH_SIZE + 3;
+
+	for (uint32_t i = 0; i < nRootCount; ++i)
+		AddTestNode(hierarchy, nodes, handles, UINT32_MAX);
+
+	for (uint32_t i = 0; i < nChildCount; ++i)
+		AddTestNode(hierarchy, nodes, handles, i % nRootCount);
+
+	for (uint32_t i = 0; i < nGrandchildCount; ++i)
+		AddTestNode(hierarchy, nodes, handles, nRootCount + (i * 7) % nChildCount);
+
+	hierarchy.Update(&jobSystem);
+
+	if (!CheckWorldMatrices("Batched levels", hierarchy, nodes, handles))
+		return false;
+
+	// Modify one root, only its descendants are recomputed.
+	nodes.m_scales[1] = glm::vec3(2.0f, 0.5f, 1.5f);
+	hierarchy.SetScale(handles[1], nodes.m_scales[1]);
+
+	hierarchy.Update(&jobSystem);
+
+	return CheckWorldMatrices("Batched levels after modification", hierarchy, nodes, handles);
+}
+
+bool TransformHierarchyTest::TestRemoval()
+{
+	TransformHierarchy hierarchy;
+	TestNodes nodes;
+	std::vector<TransformHandle> handles;
+
+	// Two roots with three children each, the first child of each root has two children.
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		uint32_t nRoot = static_cast<uint32_t>(nodes.m_parents.size());
+		AddTestNode(hierarchy, nodes, handles, UINT32_MAX);
+
+		uint32_t nFirstChild = static_cast<uint32_t>(nodes.m_parents.size());
+
+		for (uint32_t j = 0; j < 3; ++j)
+			AddTestNode(hierarchy, nodes, handles, nRoot);
+
+		AddTestNode(hierarchy, nodes, handles, nFirstChild);
+		AddTestNode(hierarchy, nodes, handles, nFirstChild);
+	}
+
+	hierarchy.Update();
+
+	// Remove the first child of the first root, which also removes its children.
+	TransformHandle removed = handles[1];
+
+	if (!hierarchy.RemoveNode(removed) || hierarchy.IsValid(removed) || hierarchy.RemoveNode(removed))
+	{
+		std::cout << "Transform Hierarchy Test: Node removal: Removed handle still valid\n";
+		return false;
+	}
+
+#ifdef NDEBUG
+	// Invalid parents are rejected, debug builds assert instead.
+	TransformHandle orphan = hierarchy.AddNode(removed, glm::vec3(1.0f));
+
+	if (hierarchy.IsValid(orphan))
+	{
+		std::cout << "Transform Hierarchy Test: Node removal: Child of a removed node added\n";
+		return false;
+	}
+#endif
+
+	hierarchy.Update();
+
+	for (uint32_t i = 4; i < 6; ++i)
+	{
+		if (hierarchy.IsValid(handles[i]))
+		{
+			std::cout << "Transform Hierarchy Test: Node removal: Handle of a removed node's child still valid\n";
+			return false;
+		}
+	}
+
+	if (!CheckWorldMatrices("Node removal", hierarchy, nodes, handles))
+		return false;
+
+	// Add a node to a remaining child, reusing a removed node's slot, & modify a node which moved to a new index.
+	AddTestNode(hierarchy, nodes, handles, 3);
+
+	nodes.m_positions[9] = glm::vec3(-3.0f, 0.25f, 2.0f);
+	hierarchy.SetPosition(handles[9], nodes.m_positions[9]);
+
+	hierarchy.Update();
+
+	if (hierarchy.NodeCount() != 10)
+	{
+		std::cout << "Transform Hierarchy Test: Node removal: " << hierarchy.NodeCount() << " nodes, expected 10\n";
+		return false;
+	}
+
+	return CheckWorldMatrices("Node removal after adding", hierarchy, nodes, handles);
+}
+
+TransformHandle TransformHierarchyTest::AddTestNode(TransformHierarchy& hierarchy, TestNodes& nodes, std::vector<TransformHandle>& handles, uint32_t nParent)
+{
+	uint32_t nIndex = static_cast<uint32_t>(nodes.m_parents.size());
+
+	glm::vec3 v3Position((float)(nIndex % 11) * 0.5f, 1.0f - (float)(nIndex % 5) * 0.25f, (float)(nIndex % 3));
+	glm::quat rotation = glm::angleAxis((float)nIndex * 0.7f, glm::normalize(glm::vec3(1.0f, (float)(nIndex % 5), 2.0f)));
+	glm::vec3 v3Scale(1.0f + (float)(nIndex % 4) * 0.25f, 1.0f, 0.5f + (float)(nIndex % 3) * 0.25f);
+
+	nodes.m_parents.push_back(nParent);
+	nodes.m_positions.push_back(v3Position);
+	nodes.m_rotations.push_back(rotation);
+	nodes.m_scales.push_back(v3Scale);
+
+	TransformHandle handle = nParent == UINT32_MAX ? hierarchy.AddNode(v3Position, rotation, v3Scale) : hierarchy.AddNode(handles[nParent], v3Position, rotation, v3Scale);
+	handles.push_back(handle);
+
+	return handle;
+}
+
+bool TransformHierarchyTest::CheckWorldMatrices(const char* szName, const TransformHierarchy& hierarchy, const TestNodes& nodes, const std::vector<TransformHandle>& handles)
+{
+	std::vector<glm::mat4> worldMatrices(nodes.m_parents.size());
+
+	for (uint32_t i = 0; i < nodes.m_parents.size(); ++i)
+	{
+		glm::mat4 localMat = glm::scale(glm::translate(glm::mat4(), nodes.m_positions[i]) * glm::mat4_cast(nodes.m_rotations[i]), nodes.m_scales[i]);
+		worldMatrices[i] = nodes.m_parents[i] == UINT32_MAX ? localMat : worldMatrices[nodes.m_parents[i]] * localMat;
+	}
+
+	for (uint32_t i = 0; i < handles.size(); ++i)
+	{
+		if (!hierarchy.IsValid(handles[i]))
+			continue;
+
+		const glm::mat4& world = hierarchy.WorldMatrix(handles[i]);
+
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			for (uint32_t r = 0; r < 4; ++r)
+			{
+				if (std::fabs(world[c][r] - worldMatrices[i][c][r]) > TRANSFORM_TEST_TOLERANCE)
+				{
+					std::cout << "Transform Hierarchy Test: " << szName << ": Node " << i << " element [" << c << "][" << r << "] is " << world[c][r] << ", expected " << worldMatrices[i][c][r] << "\n";
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool TransformHierarchyTest::Report(const char* szName, bool bPassed)
+{
+	std::cout << "Transform Hierarchy Test: " << szName << ": " << (bPassed ? "Passed" : "FAILED") << "\n";
+
+	return bPassed;
+}
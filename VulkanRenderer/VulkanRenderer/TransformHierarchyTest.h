@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "TransformHierarchy.h"
+
+/*
+Description: Self-test of the transform hierarchy, run with --transformtest instead of the application. Checks world matrices against glm for levels
+             whose sizes & starts are not multiples of the SIMD width, levels spread across the job system & hierarchies with removed nodes,
+             printing each result & returning whether all passed.
+Author: Nic Van Zuylen
+*/
+
+// Worker threads of the job system created by the test, including the main thread.
+#define TRANSFORM_TEST_THREAD_COUNT 4
+
+// Largest difference allowed between a world matrix element & the glm reference.
+#define TRANSFORM_TEST_TOLERANCE 1e-4f
+
+class TransformHierarchyTest
+{
+public:
+
+	/*
+	Description: Get whether or not --transformtest was passed.
+	Return Type: bool
+	Param:
+	    int argc: Argument count from main().
+		char** argv: Arguments from main().
+	*/
+	static bool ParseArgs(int argc, char** argv);
+
+	/*
+	Description: Run every check, returns whether or not all of them passed.
+	Return Type: bool
+	*/
+	static bool Run();
+
+private:
+
+	// Local transforms & parents of the nodes of a test hierarchy, parents precede their children.
+	struct TestNodes
+	{
+		std::vector<uint32_t> m_parents; // Index of each node's parent, UINT32_MAX for roots.
+		std::vector<glm::vec3> m_positions;
+		std::vector<glm::quat> m_rotations;
+		std::vector<glm::vec3> m_scales;
+	};
+
+	// A root with three children, one of which has two children, so no level past the first starts or ends on a multiple of the SIMD width.
+	static bool TestUnevenLevels();
+
+	// Levels larger than a batch are spread across the job system, with batch ranges ending part way through a set of four nodes.
+	static bool TestBatchedLevels();
+
+	// Removing nodes drops their descendants & compacts the remaining nodes, whose world matrices stay correct as they are modified.
+	// Children of removed nodes can't be added.
+	static bool TestRemoval();
+
+	// Append a node with deterministic local transforms to the test nodes & the hierarchy.
+	static TransformHandle AddTestNode(TransformHierarchy& hierarchy, TestNodes& nodes, std::vector<TransformHandle>& handles, uint32_t nParent);
+
+	// Compare the world matrix of every node whose handle is valid against glm, printing the first mismatch.
+	static bool CheckWorldMatrices(const char* szName, const TransformHierarchy& hierarchy, const TestNodes& nodes, const std::vector<TransformHandle>& handles);
+
+	// Print the result of a check & pass it through.
+	static bool Report(const char* szName, bool bPassed);
+};
@@ -0,0 +1,182 @@
+#include "UploadArena.h"
+#include "Renderer.h"
+
+#define DIRECT_WRITE_MEMORY_FLAGS (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+
+UploadArena::UploadArena(Renderer* renderer, VkDeviceSize nFrameSize)
+{
+	m_renderer = renderer;
+	m_nFrameIndex = 0;
+	m_nStagedBytes = 0;
+	m_nCopyCommandCount = 0;
+	m_nWrittenBytes = 0;
+	m_nPendingWrittenBytes = 0;
+
+	m_bDirectWriteAvailable = m_renderer->GetMemoryAllocator()->HasMemoryType(DIRECT_WRITE_MEMORY_FLAGS);
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+		CreateRegionBuffer(m_frames[i], nFrameSize);
+
+	if (m_bDirectWriteAvailable)
+		std::cout << "Renderer Info: Host visible device local memory available, per-frame buffers will be written directly.\n";
+}
+
+UploadArena::~UploadArena()
+{
+	VkDevice device = m_renderer->GetDevice();
+
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		DestroyRetired(m_frames[i]);
+
+		vkDestroyBuffer(device, m_frames[i].m_buffer, nullptr);
+		m_renderer->FreeMemory(m_frames[i].m_memory);
+	}
+}
+
+void UploadArena::BeginFrame(const uint32_t& nFrameIndex)
+{
+	m_nFrameIndex = nFrameIndex;
+
+	FrameRegion& region = m_frames[m_nFrameIndex];
+
+	// The frame's previous submission is complete, so its region and outgrown buffers are free to reuse.
+	DestroyRetired(region);
+	region.m_nOffset = 0;
+
+	m_pendingCopies.Clear();
+}
+
+void UploadArena::Write(VkBuffer dstBuffer, const MemAllocation& dstMemory, VkDeviceSize nDstOffset, const void* data, VkDeviceSize nSize, bool bPerFrame)
+{
+	m_nPendingWrittenBytes += nSize;
+
+	// Direct write path. Buffers shared between frames may be mapped too (on UMA devices any memory type may be host visible), but a frame still in flight could be reading them.
+	if(bPerFrame && dstMemory.m_mappedPtr)
+	{
+		std::memcpy(static_cast<char*>(dstMemory.m_mappedPtr) + nDstOffset, data, nSize);
+		return;
+	}
+
+	FrameRegion& region = m_frames[m_nFrameIndex];
+
+	VkDeviceSize nOffset = (region.m_nOffset + UPLOAD_ARENA_ALIGNMENT - 1) & ~(UPLOAD_ARENA_ALIGNMENT - 1);
+
+	// Grow the region if it is out of space. The old buffer is kept alive until this frame index comes around again.
+	if(nOffset + nSize > region.m_nSize)
+	{
+		region.m_retiredBuffers.Push(region.m_buffer);
+		region.m_retiredMemory.Push(region.m_memory);
+
+		VkDeviceSize nNewSize = region.m_nSize * 2;
+		while (nNewSize < nSize)
+			nNewSize *= 2;
+
+		CreateRegionBuffer(region, nNewSize);
+		nOffset = 0;
+	}
+
+	std::memcpy(static_cast<char*>(region.m_memory.m_mappedPtr) + nOffset, data, nSize);
+	region.m_nOffset = nOffset + nSize;
+
+	// Merge with the previous copy if it is contiguous in both source and destination.
+	if(m_pendingCopies.Count() > 0)
+	{
+		PendingCopy& prev = m_pendingCopies[m_pendingCopies.Count() - 1];
+
+		if(prev.m_srcBuffer == region.m_buffer && prev.m_dstBuffer == dstBuffer && prev.m_region.srcOffset + prev.m_region.size == nOffset && prev.m_region.dstOffset + prev.m_region.size == nDstOffset)
+		{
+			prev.m_region.size += nSize;
+			return;
+		}
+	}
+
+	PendingCopy copy;
+	copy.m_srcBuffer = region.m_buffer;
+	copy.m_dstBuffer = dstBuffer;
+	copy.m_region = { nOffset, nDstOffset, nSize };
+
+	m_pendingCopies.Push(copy);
+}
+
+void UploadArena::Flush(VkCommandBuffer cmdBuffer)
+{
+	FrameRegion& region = m_frames[m_nFrameIndex];
+
+	m_nStagedBytes = region.m_nOffset;
+	m_nCopyCommandCount = 0;
+	m_nWrittenBytes = m_nPendingWrittenBytes;
+	m_nPendingWrittenBytes = 0;
+
+	// Group copies by source & destination buffer, so each destination receives a single copy command with multiple regions.
+	// (The source only differs when the region outgrew its buffer this frame.)
+	uint32_t nCopyCount = m_pendingCopies.Count();
+	for(uint32_t i = 0; i < nCopyCount; ++i)
+	{
+		VkBuffer srcBuffer = m_pendingCopies[i].m_srcBuffer;
+		VkBuffer dstBuffer = m_pendingCopies[i].m_dstBuffer;
+
+		if (dstBuffer == VK_NULL_HANDLE)
+			continue; // Already recorded.
+
+		m_batchRegions.Clear();
+
+		for(uint32_t j = i; j < nCopyCount; ++j)
+		{
+			PendingCopy& copy = m_pendingCopies[j];
+
+			if(copy.m_srcBuffer == srcBuffer && copy.m_dstBuffer == dstBuffer)
+			{
+				m_batchRegions.Push(copy.m_region);
+				copy.m_dstBuffer = VK_NULL_HANDLE;
+			}
+		}
+
+		vkCmdCopyBuffer(cmdBuffer, srcBuffer, dstBuffer, m_batchRegions.Count(), m_batchRegions.Data());
+		++m_nCopyCommandCount;
+	}
+
+	m_pendingCopies.Clear();
+}
+
+VkMemoryPropertyFlags UploadArena::PerFrameMemoryFlags() const
+{
+	return m_bDirectWriteAvailable ? DIRECT_WRITE_MEMORY_FLAGS : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+}
+
+VkDeviceSize UploadArena::StagedBytes() const
+{
+	return m_nStagedBytes;
+}
+
+uint32_t UploadArena::CopyCommandCount() const
+{
+	return m_nCopyCommandCount;
+}
+
+VkDeviceSize UploadArena::WrittenBytes() const
+{
+	return m_nWrittenBytes;
+}
+
+inline void UploadArena::CreateRegionBuffer(FrameRegion& region, VkDeviceSize nSize)
+{
+	m_renderer->CreateBuffer(nSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, region.m_buffer, region.m_memory);
+
+	region.m_nSize = nSize;
+	region.m_nOffset = 0;
+}
+
+inline void UploadArena::DestroyRetired(FrameRegion& region)
+{
+	VkDevice device = m_renderer->GetDevice();
+
+	for(uint32_t i = 0; i < region.m_retiredBuffers.Count(); ++i)
+	{
+		vkDestroyBuffer(device, region.m_retiredBuffers[i], nullptr);
+		m_renderer->FreeMemory(region.m_retiredMemory[i]);
+	}
+
+	region.m_retiredBuffers.Clear();
+	region.m_retiredMemory.Clear();
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "DynamicArray.h"
+#include "MemoryAllocator.h"
+
+/*
+Description: Persistently mapped, frame-indexed linear upload arena. Per-frame buffer updates are written into the current frame's region
+             and copied to their destination buffers in batched copy commands.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+
+// Initial size of each frame's upload region.
+#define UPLOAD_ARENA_FRAME_SIZE (4ull * 1024ull * 1024ull)
+
+// Alignment of each sub-allocation within the arena.
+#define UPLOAD_ARENA_ALIGNMENT 16ull
+
+#ifndef MAX_FRAMES_IN_FLIGHT
+#define MAX_FRAMES_IN_FLIGHT 2
+#endif
+
+class UploadArena
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer owning the arena.
+		VkDeviceSize nFrameSize: Initial size of each frame's upload region.
+	*/
+	UploadArena(Renderer* renderer, VkDeviceSize nFrameSize = UPLOAD_ARENA_FRAME_SIZE);
+
+	~UploadArena();
+
+	/*
+	Description: Reset the region of the provided frame for reuse, the frame's previous GPU work must be complete.
+	Param:
+	    const uint32_t& nFrameIndex: Index of the frame-in-flight about to be recorded.
+	*/
+	void BeginFrame(const uint32_t& nFrameIndex);
+
+	/*
+	Description: Write data to a destination buffer, staged in the arena and copied on Flush(). Per-frame destinations in host visible memory are written directly,
+	             since no earlier frame still in flight can be reading them. Shared destinations are always staged, so the copy is ordered after earlier frames' reads.
+	Param:
+	    VkBuffer dstBuffer: The destination buffer.
+		const MemAllocation& dstMemory: The destination buffer's memory allocation.
+		VkDeviceSize nDstOffset: Offset into the destination buffer to write to.
+		const void* data: The data to write.
+		VkDeviceSize nSize: Size in bytes of the data.
+		bool bPerFrame: Whether or not the destination is only used by the current frame-in-flight, such as one of a set of buffers duplicated per frame.
+	*/
+	void Write(VkBuffer dstBuffer, const MemAllocation& dstMemory, VkDeviceSize nDstOffset, const void* data, VkDeviceSize nSize, bool bPerFrame = false);
+
+	/*
+	Description: Record all pending copies of the current frame, one vkCmdCopyBuffer per destination buffer.
+	Param:
+	    VkCommandBuffer cmdBuffer: The transfer command buffer to record to.
+	*/
+	void Flush(VkCommandBuffer cmdBuffer);
+
+	/*
+	Description: Memory properties to use for buffers which are only updated through the arena & are duplicated per frame-in-flight.
+	             Uses host visible device local memory when available so updates skip the staging copy.
+	Return Type: VkMemoryPropertyFlags
+	*/
+	VkMemoryPropertyFlags PerFrameMemoryFlags() const;
+
+	/*
+	Description: Get the amount of bytes staged and the amount of copy commands recorded in the last flushed frame.
+	*/
+	VkDeviceSize StagedBytes() const;
+	uint32_t CopyCommandCount() const;
+
+	/*
+	Description: Get the amount of bytes written in the last flushed frame, both directly & through staging.
+	Return Type: VkDeviceSize
+	*/
+	VkDeviceSize WrittenBytes() const;
+
+private:
+
+	struct PendingCopy
+	{
+		VkBuffer m_srcBuffer;
+		VkBuffer m_dstBuffer;
+		VkBufferCopy m_region;
+	};
+
+	struct FrameRegion
+	{
+		VkBuffer m_buffer;
+		MemAllocation m_memory;
+		VkDeviceSize m_nSize;
+		VkDeviceSize m_nOffset;
+		DynamicArray<VkBuffer> m_retiredBuffers; // Outgrown buffers still referenced by this frame's copies.
+		DynamicArray<MemAllocation> m_retiredMemory;
+	};
+
+	// Create a frame region staging buffer with the provided size.
+	inline void CreateRegionBuffer(FrameRegion& region, VkDeviceSize nSize);
+
+	// Destroy buffers outgrown by the provided frame region.
+	inline void DestroyRetired(FrameRegion& region);
+
+	Renderer* m_renderer;
+	FrameRegion m_frames[MAX_FRAMES_IN_FLIGHT];
+	DynamicArray<PendingCopy> m_pendingCopies;
+	DynamicArray<VkBufferCopy> m_batchRegions;
+	uint32_t m_nFrameIndex;
+	bool m_bDirectWriteAvailable; // Whether or not host visible device local memory exists.
+
+	VkDeviceSize m_nStagedBytes;
+	uint32_t m_nCopyCommandCount;
+	VkDeviceSize m_nWrittenBytes;
+	VkDeviceSize m_nPendingWrittenBytes; // Written since the last flush.
+};
@@ -0,0 +1,387 @@
+#include "UploadContext.h"
+#include "Renderer.h"
+
+UploadContext::UploadContext(Renderer* renderer, VkQueue graphicsQueue, uint32_t nGraphicsFamilyIndex, VkQueue transferQueue, uint32_t nTransferFamilyIndex)
+{
+	m_renderer = renderer;
+	m_device = renderer->GetDevice();
+
+	m_graphicsQueue = graphicsQueue;
+	m_transferQueue = transferQueue;
+	m_nGraphicsFamilyIndex = nGraphicsFamilyIndex;
+	m_nTransferFamilyIndex = nTransferFamilyIndex;
+	m_bDedicatedTransfer = m_nTransferFamilyIndex != m_nGraphicsFamilyIndex;
+
+	m_currentBatch = nullptr;
+	m_nSubmittedToken = 0;
+	m_nCompletedToken = 0;
+
+	m_nSubmissionCount = 0;
+	m_nUploadCount = 0;
+	m_nUploadedBytes = 0;
+
+	// Command buffers are short lived and reset by freeing them with their batch.
+	VkCommandPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolCreateInfo.queueFamilyIndex = m_nGraphicsFamilyIndex;
+
+	RENDERER_SAFECALL(vkCreateCommandPool(m_device, &poolCreateInfo, nullptr, &m_graphicsCmdPool), "Upload Context Error: Failed to create graphics command pool.");
+
+	m_transferCmdPool = VK_NULL_HANDLE;
+	if(m_bDedicatedTransfer)
+	{
+		poolCreateInfo.queueFamilyIndex = m_nTransferFamilyIndex;
+
+		RENDERER_SAFECALL(vkCreateCommandPool(m_device, &poolCreateInfo, nullptr, &m_transferCmdPool), "Upload Context Error: Failed to create transfer command pool.");
+
+		std::cout << "Renderer Info: Asset uploads will use the dedicated transfer queue family: " << m_nTransferFamilyIndex << "\n";
+	}
+}
+
+UploadContext::~UploadContext()
+{
+	// Wait for all submitted uploads, an unsubmitted batch is discarded.
+	Wait(m_nSubmittedToken);
+
+	if(m_currentBatch)
+	{
+		DestroyBatch(m_currentBatch);
+		m_currentBatch = nullptr;
+	}
+
+	vkDestroyCommandPool(m_device, m_graphicsCmdPool, nullptr);
+
+	if(m_transferCmdPool)
+	    vkDestroyCommandPool(m_device, m_transferCmdPool, nullptr);
+}
+
+UploadToken UploadContext::UploadBuffer(VkBuffer dstBuffer, VkDeviceSize nDstOffset, const void* data, VkDeviceSize nSize, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+	CheckBudget(nSize);
+
+	UploadBatch* batch = CurrentBatch();
+	VkBuffer stagingBuffer = CreateStagingBuffer(batch, data, nSize);
+
+	VkBufferCopy copyRegion = { 0, nDstOffset, nSize };
+	vkCmdCopyBuffer(batch->m_transferCmdBuf, stagingBuffer, dstBuffer, 1, &copyRegion);
+
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.buffer = dstBuffer;
+	barrier.offset = nDstOffset;
+	barrier.size = nSize;
+
+	if(m_bDedicatedTransfer)
+	{
+		barrier.srcQueueFamilyIndex = m_nTransferFamilyIndex;
+		barrier.dstQueueFamilyIndex = m_nGraphicsFamilyIndex;
+
+		// Release ownership on the transfer queue...
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(batch->m_transferCmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		// ...and acquire it on the graphics queue.
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(batch->m_graphicsCmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+	else
+	{
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(batch->m_graphicsCmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	return batch->m_token;
+}
+
+UploadToken UploadContext::UploadImage(VkImage dstImage, uint32_t nWidth, uint32_t nHeight, const void* data, VkDeviceSize nSize, VkImageLayout finalLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+	CheckBudget(nSize);
+
+	UploadBatch* batch = CurrentBatch();
+	VkBuffer stagingBuffer = CreateStagingBuffer(batch, data, nSize);
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.image = dstImage;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+	// Transition to transfer destination layout, previous contents are discarded.
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(batch->m_transferCmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.bufferOffset = 0;
+	copyRegion.bufferRowLength = 0;
+	copyRegion.bufferImageHeight = 0;
+	copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copyRegion.imageSubresource.mipLevel = 0;
+	copyRegion.imageSubresource.baseArrayLayer = 0;
+	copyRegion.imageSubresource.layerCount = 1;
+	copyRegion.imageOffset = { 0, 0, 0 };
+	copyRegion.imageExtent = { nWidth, nHeight, 1 };
+
+	vkCmdCopyBufferToImage(batch->m_transferCmdBuf, stagingBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+	// Transition to the final layout, the transition happens once as part of the ownership transfer when queue families differ.
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = finalLayout;
+
+	if(m_bDedicatedTransfer)
+	{
+		barrier.srcQueueFamilyIndex = m_nTransferFamilyIndex;
+		barrier.dstQueueFamilyIndex = m_nGraphicsFamilyIndex;
+
+		// Release...
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(batch->m_transferCmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		// Acquire...
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(batch->m_graphicsCmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+	else
+	{
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(batch->m_graphicsCmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	return batch->m_token;
+}
+
+VkCommandBuffer UploadContext::GraphicsCmdBuffer()
+{
+	return CurrentBatch()->m_graphicsCmdBuf;
+}
+
+UploadToken UploadContext::PendingToken()
+{
+	return m_currentBatch ? m_currentBatch->m_token : m_nSubmittedToken;
+}
+
+UploadToken UploadContext::Submit()
+{
+	if (!m_currentBatch)
+		return m_nSubmittedToken;
+
+	UploadBatch* batch = m_currentBatch;
+	m_currentBatch = nullptr;
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+
+	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	if(m_bDedicatedTransfer)
+	{
+		RENDERER_SAFECALL(vkEndCommandBuffer(batch->m_transferCmdBuf), "Upload Context Error: Failed to end recording of transfer command buffer.");
+
+		submitInfo.pCommandBuffers = &batch->m_transferCmdBuf;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &batch->m_transferSemaphore;
+
+		RENDERER_SAFECALL(vkQueueSubmit(m_transferQueue, 1, &submitInfo, VK_NULL_HANDLE), "Upload Context Error: Failed to submit transfer commands.");
+		++m_nSubmissionCount;
+
+		// Graphics side acquires must wait for the copies.
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &batch->m_transferSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.signalSemaphoreCount = 0;
+		submitInfo.pSignalSemaphores = nullptr;
+	}
+
+	RENDERER_SAFECALL(vkEndCommandBuffer(batch->m_graphicsCmdBuf), "Upload Context Error: Failed to end recording of graphics command buffer.");
+
+	submitInfo.pCommandBuffers = &batch->m_graphicsCmdBuf;
+
+	RENDERER_SAFECALL(vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, batch->m_fence), "Upload Context Error: Failed to submit graphics commands.");
+	++m_nSubmissionCount;
+
+	m_nSubmittedToken = batch->m_token;
+	m_inFlightBatches.Push(batch);
+
+	return batch->m_token;
+}
+
+void UploadContext::Poll()
+{
+	for(int i = static_cast<int>(m_inFlightBatches.Count()) - 1; i >= 0; --i)
+	{
+		UploadBatch* batch = m_inFlightBatches[i];
+
+		if (vkGetFenceStatus(m_device, batch->m_fence) != VK_SUCCESS)
+			continue;
+
+		DestroyBatch(batch);
+
+		// Swap with the last batch and pop.
+		m_inFlightBatches[i] = m_inFlightBatches[m_inFlightBatches.Count() - 1];
+		m_inFlightBatches.Pop();
+	}
+
+	// Batches may be retired out of order, everything before the oldest remaining batch has completed.
+	m_nCompletedToken = m_nSubmittedToken;
+	for (uint32_t i = 0; i < m_inFlightBatches.Count(); ++i)
+	{
+		if (m_inFlightBatches[i]->m_token <= m_nCompletedToken)
+			m_nCompletedToken = m_inFlightBatches[i]->m_token - 1;
+	}
+}
+
+bool UploadContext::IsComplete(UploadToken token)
+{
+	if (token <= m_nCompletedToken)
+		return true;
+
+	Poll();
+
+	return token <= m_nCompletedToken;
+}
+
+void UploadContext::Wait(UploadToken token)
+{
+	if (token <= m_nCompletedToken)
+		return;
+
+	// The token belongs to the batch still being recorded.
+	if (token > m_nSubmittedToken)
+		Submit();
+
+	for(uint32_t i = 0; i < m_inFlightBatches.Count(); ++i)
+	{
+		UploadBatch* batch = m_inFlightBatches[i];
+
+		if (batch->m_token <= token)
+			RENDERER_SAFECALL(vkWaitForFences(m_device, 1, &batch->m_fence, VK_TRUE, ~(0ULL)), "Upload Context Error: Failed to wait for upload fence.");
+	}
+
+	Poll();
+}
+
+uint32_t UploadContext::SubmissionCount() const
+{
+	return m_nSubmissionCount;
+}
+
+uint32_t UploadContext::UploadCount() const
+{
+	return m_nUploadCount;
+}
+
+VkDeviceSize UploadContext::UploadedBytes() const
+{
+	return m_nUploadedBytes;
+}
+
+inline UploadContext::UploadBatch* UploadContext::CurrentBatch()
+{
+	if (m_currentBatch)
+		return m_currentBatch;
+
+	UploadBatch* batch = new UploadBatch;
+	batch->m_nStagingBytes = 0;
+	batch->m_token = m_nSubmittedToken + 1;
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	allocInfo.commandPool = m_graphicsCmdPool;
+
+	RENDERER_SAFECALL(vkAllocateCommandBuffers(m_device, &allocInfo, &batch->m_graphicsCmdBuf), "Upload Context Error: Failed to allocate graphics command buffer.");
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = nullptr;
+
+	RENDERER_SAFECALL(vkBeginCommandBuffer(batch->m_graphicsCmdBuf, &beginInfo), "Upload Context Error: Failed to begin recording of graphics command buffer.");
+
+	batch->m_transferSemaphore = VK_NULL_HANDLE;
+
+	if(m_bDedicatedTransfer)
+	{
+		allocInfo.commandPool = m_transferCmdPool;
+		RENDERER_SAFECALL(vkAllocateCommandBuffers(m_device, &allocInfo, &batch->m_transferCmdBuf), "Upload Context Error: Failed to allocate transfer command buffer.");
+		RENDERER_SAFECALL(vkBeginCommandBuffer(batch->m_transferCmdBuf, &beginInfo), "Upload Context Error: Failed to begin recording of transfer command buffer.");
+
+		VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0 };
+		RENDERER_SAFECALL(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &batch->m_transferSemaphore), "Upload Context Error: Failed to create transfer semaphore.");
+	}
+	else
+		batch->m_transferCmdBuf = batch->m_graphicsCmdBuf; // Copies are recorded directly on the graphics queue.
+
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = 0;
+
+	RENDERER_SAFECALL(vkCreateFence(m_device, &fenceInfo, nullptr, &batch->m_fence), "Upload Context Error: Failed to create upload fence.");
+
+	m_currentBatch = batch;
+	return batch;
+}
+
+inline VkBuffer UploadContext::CreateStagingBuffer(UploadBatch* batch, const void* data, VkDeviceSize nSize)
+{
+	VkBuffer stagingBuffer;
+	MemAllocation stagingMemory;
+	m_renderer->CreateBuffer(nSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory);
+
+	// Staging memory is persistently mapped.
+	std::memcpy(stagingMemory.m_mappedPtr, data, nSize);
+
+	batch->m_stagingBuffers.Push(stagingBuffer);
+	batch->m_stagingMemory.Push(stagingMemory);
+	batch->m_nStagingBytes += nSize;
+
+	++m_nUploadCount;
+	m_nUploadedBytes += nSize;
+
+	return stagingBuffer;
+}
+
+inline void UploadContext::CheckBudget(VkDeviceSize nSize)
+{
+	if (m_currentBatch && m_currentBatch->m_nStagingBytes > 0 && m_currentBatch->m_nStagingBytes + nSize > UPLOAD_CONTEXT_BATCH_BUDGET)
+		Submit();
+}
+
+inline void UploadContext::DestroyBatch(UploadBatch* batch)
+{
+	for(uint32_t i = 0; i < batch->m_stagingBuffers.Count(); ++i)
+	{
+		vkDestroyBuffer(m_device, batch->m_stagingBuffers[i], nullptr);
+		m_renderer->FreeMemory(batch->m_stagingMemory[i]);
+	}
+
+	vkFreeCommandBuffers(m_device, m_graphicsCmdPool, 1, &batch->m_graphicsCmdBuf);
+
+	if(m_bDedicatedTransfer)
+	{
+		vkFreeCommandBuffers(m_device, m_transferCmdPool, 1, &batch->m_transferCmdBuf);
+		vkDestroySemaphore(m_device, batch->m_transferSemaphore, nullptr);
+	}
+
+	vkDestroyFence(m_device, batch->m_fence, nullptr);
+
+	delete batch;
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "DynamicArray.h"
+#include "MemoryAllocator.h"
+
+/*
+Description: Batched asset upload context. Staging copies are recorded on the dedicated transfer queue and handed to the graphics queue
+             with queue family ownership transfers, many uploads share a single submission.
+Author: Nic Van Zuylen
+*/
+
+class Renderer;
+
+// Staging memory a batch may reference before it is submitted automatically.
+#define UPLOAD_CONTEXT_BATCH_BUDGET (128ull * 1024ull * 1024ull)
+
+// Completion token of an upload, complete once IsComplete() returns true. Zero is always complete.
+typedef uint64_t UploadToken;
+
+class UploadContext
+{
+public:
+
+	/*
+	Constructor:
+	Param:
+	    Renderer* renderer: The renderer owning the context.
+		VkQueue graphicsQueue: Queue the uploaded resources will be used on.
+		uint32_t nGraphicsFamilyIndex: Queue family index of the graphics queue.
+		VkQueue transferQueue: Queue to record copies on, may be the graphics queue.
+		uint32_t nTransferFamilyIndex: Queue family index of the transfer queue.
+	*/
+	UploadContext(Renderer* renderer, VkQueue graphicsQueue, uint32_t nGraphicsFamilyIndex, VkQueue transferQueue, uint32_t nTransferFamilyIndex);
+
+	~UploadContext();
+
+	/*
+	Description: Stage data to be copied into a device local buffer.
+	Return Type: UploadToken
+	Param:
+	    VkBuffer dstBuffer: The destination buffer.
+		VkDeviceSize nDstOffset: Offset into the destination buffer.
+		const void* data: The data to upload, it is copied immediately.
+		VkDeviceSize nSize: Size in bytes of the data.
+		VkPipelineStageFlags dstStage: Pipeline stages which will consume the buffer.
+		VkAccessFlags dstAccess: Access types which will consume the buffer.
+	*/
+	UploadToken UploadBuffer(VkBuffer dstBuffer, VkDeviceSize nDstOffset, const void* data, VkDeviceSize nSize, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+	/*
+	Description: Stage data to be copied into the first mip level of a color image, and transition it to its final layout.
+	Return Type: UploadToken
+	Param:
+	    VkImage dstImage: The destination image, in an undefined layout.
+		uint32_t nWidth: Width in pixels of the image.
+		uint32_t nHeight: Height in pixels of the image.
+		const void* data: The data to upload, it is copied immediately.
+		VkDeviceSize nSize: Size in bytes of the data.
+		VkImageLayout finalLayout: Layout the image will be used in.
+		VkPipelineStageFlags dstStage: Pipeline stages which will consume the image.
+		VkAccessFlags dstAccess: Access types which will consume the image.
+	*/
+	UploadToken UploadImage(VkImage dstImage, uint32_t nWidth, uint32_t nHeight, const void* data, VkDeviceSize nSize, VkImageLayout finalLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+	/*
+	Description: Get the graphics queue command buffer of the current batch, for commands which must run on the graphics queue. (e.g. attachment layout transitions)
+	Return Type: VkCommandBuffer
+	*/
+	VkCommandBuffer GraphicsCmdBuffer();
+
+	/*
+	Description: Get the token the current batch will complete with.
+	Return Type: UploadToken
+	*/
+	UploadToken PendingToken();
+
+	/*
+	Description: Submit the current batch, resources uploaded in it may be used by any later graphics queue submission.
+	Return Type: UploadToken
+	*/
+	UploadToken Submit();
+
+	/*
+	Description: Retire completed batches and free their staging memory.
+	*/
+	void Poll();
+
+	/*
+	Description: Get whether or not the upload with the provided token has completed.
+	Return Type: bool
+	Param:
+	    UploadToken token: The upload token.
+	*/
+	bool IsComplete(UploadToken token);
+
+	/*
+	Description: Block until the upload with the provided token has completed, submitting its batch if necessary.
+	Param:
+	    UploadToken token: The upload token.
+	*/
+	void Wait(UploadToken token);
+
+	/*
+	Description: Get the amount of queue submissions, uploads and bytes uploaded since creation.
+	*/
+	uint32_t SubmissionCount() const;
+	uint32_t UploadCount() const;
+	VkDeviceSize UploadedBytes() const;
+
+private:
+
+	struct UploadBatch
+	{
+		VkCommandBuffer m_transferCmdBuf;
+		VkCommandBuffer m_graphicsCmdBuf;
+		VkSemaphore m_transferSemaphore; // Signaled by the transfer submission, waited on by the graphics submission.
+		VkFence m_fence; // Signaled once the whole batch has executed.
+		DynamicArray<VkBuffer> m_stagingBuffers;
+		DynamicArray<MemAllocation> m_stagingMemory;
+		VkDeviceSize m_nStagingBytes;
+		UploadToken m_token;
+	};
+
+	// Get the current batch, opening a new one if none is being recorded.
+	inline UploadBatch* CurrentBatch();
+
+	// Create a staging buffer holding a copy of the provided data in the current batch.
+	inline VkBuffer CreateStagingBuffer(UploadBatch* batch, const void* data, VkDeviceSize nSize);
+
+	// Submit the current batch early if the upload would exceed its staging budget.
+	inline void CheckBudget(VkDeviceSize nSize);
+
+	// Free a completed batch's resources.
+	inline void DestroyBatch(UploadBatch* batch);
+
+	Renderer* m_renderer;
+	VkDevice m_device;
+
+	VkQueue m_graphicsQueue;
+	VkQueue m_transferQueue;
+	uint32_t m_nGraphicsFamilyIndex;
+	uint32_t m_nTransferFamilyIndex;
+	bool m_bDedicatedTransfer; // Whether or not copies run on a separate queue family, requiring ownership transfers.
+
+	VkCommandPool m_graphicsCmdPool;
+	VkCommandPool m_transferCmdPool;
+
+	UploadBatch* m_currentBatch;
+	DynamicArray<UploadBatch*> m_inFlightBatches;
+	UploadToken m_nSubmittedToken;
+	UploadToken m_nCompletedToken;
+
+	uint32_t m_nSubmissionCount;
+	uint32_t m_nUploadCount;
+	VkDeviceSize m_nUploadedBytes;
+};
@@ -1,10 +1,37 @@
 #include <crtdbg.h>
 #include "Application.h"
+#include "Renderer.h"
+#include "Benchmark.h"
+#include "JobSystemTest.h"
+#include "TransformHierarchyTest.h"
 
-int main() 
+int main(int argc, char** argv) 
 {
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
+	// Run the job system self-test if --jobtest is passed, exiting with a non-zero code if any check fails.
+	if (JobSystemTest::ParseArgs(argc, argv))
+		return JobSystemTest::Run() ? 0 : 1;
+
+	// Run the transform hierarchy self-test if --transformtest is passed, exiting with a non-zero code if any check fails.
+	if (TransformHierarchyTest::ParseArgs(argc, argv))
+		return TransformHierarchyTest::Run() ? 0 : 1;
+
+	// Run the scripted benchmark on a headless renderer if --benchmark is passed, instead of the application.
+	BenchmarkParams benchmarkParams;
+	if(Benchmark::ParseArgs(argc, argv, benchmarkParams))
+	{
+		Renderer* renderer = new Renderer(benchmarkParams.m_nWidth, benchmarkParams.m_nHeight);
+
+		Benchmark* benchmark = new Benchmark(renderer, benchmarkParams);
+		bool bWritten = benchmark->Run();
+
+		delete benchmark;
+		delete renderer;
+
+		return bWritten ? 0 : 1;
+	}
+
 	Application* game = new Application();
 	game->Init();
 
@@ -13,4 +40,4 @@ int main()
 	delete game;
 
 	return 0;
-}
+}
\ No newline at end of file